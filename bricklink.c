@@ -467,69 +467,209 @@ static const size_t blPriceGuideOffsetTable[2][6] =
   }
 };
 
-static int blHtmlParsePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *string, int stringlength )
+static const char * const blPriceGuideSectionString[2] = { "Past 6 Months Sales", "Current Items for Sale" };
+static const char * const blPriceGuideTableString[2] = { "New", "Used" };
+static const char blPriceGuideValueString[] = "SIZE=\"2\">&nbsp;";
+
+#define BL_PRICEGUIDE_SECTION_WAITING (0)
+#define BL_PRICEGUIDE_SECTION_OPEN (1)
+#define BL_PRICEGUIDE_SECTION_CLOSED (2)
+
+/* None of the patterns repeat their first character, a mismatch can only restart a match at that character */
+static inline int blPriceGuideMatchStep( const char *pattern, int matchlength, char c )
 {
-  int section, sub, value;
-  int64_t curtime;
-  char *sectionstr[2], *substr[2];
-  char *valstr;
+  if( c == pattern[matchlength] )
+    return matchlength + 1;
+  return ( c == pattern[0] ? 1 : 0 );
+}
+
+static void blPriceGuideParseValue( blPriceGuideExtractor *extractor, int section, int sub )
+{
+  blPriceGuideTable *table;
   void *writeaddr;
-  bsxPriceGuide *pg;
-  bsxPriceGuide pgdummy;
-
-  if( !( pgnew ) )
-    pgnew = &pgdummy;
-  if( !( pgused ) )
-    pgused = &pgdummy;
-
-  memset( pgnew, 0, sizeof(bsxPriceGuide) );
-  memset( pgused, 0, sizeof(bsxPriceGuide) );
-  sectionstr[0] = ccSeqFindStrSkip( string, stringlength, "Past 6 Months Sales" );
-  sectionstr[1] = ccSeqFindStrSkip( string, stringlength, "Current Items for Sale" );
-  string[stringlength-1] = 0;
-  if( sectionstr[0] )
-    sectionstr[0][-1] = 0;
-  if( sectionstr[1] )
-    sectionstr[1][-1] = 0;
 
+  table = &extractor->tablelist[section][sub];
+  table->captureflag = 0;
+  table->capture[ table->capturelength ] = 0;
+  writeaddr = ADDRESS( &extractor->pg[sub], blPriceGuideOffsetTable[section][ table->valueindex ] );
+  if( table->valueindex < 2 )
+  {
+    if( sscanf( table->capture, "%d", (int *)writeaddr ) != 1 )
+      extractor->errorflag = 1;
+  }
+  else
+  {
+    if( sscanf( table->capture, "$%f", (float *)writeaddr ) != 1 )
+      extractor->errorflag = 1;
+  }
+  table->valueindex++;
+  return;
+}
+
+static void blPriceGuideFeedTable( blPriceGuideExtractor *extractor, int section, int sub, char c )
+{
+  blPriceGuideTable *table;
+
+  table = &extractor->tablelist[section][sub];
+  if( table->valueindex >= 6 )
+    return;
+  if( table->valueindex < 0 )
+  {
+    table->matchlength = blPriceGuideMatchStep( blPriceGuideTableString[sub], table->matchlength, c );
+    if( !( blPriceGuideTableString[sub][ table->matchlength ] ) )
+    {
+      table->valueindex = 0;
+      table->matchlength = 0;
+    }
+    return;
+  }
+  /* Capture the text following a value marker, a value never extends past the next tag */
+  if( table->captureflag )
+  {
+    if( ( c == '<' ) || ( table->capturelength >= BL_PRICEGUIDE_CAPTURE_SIZE-1 ) )
+      blPriceGuideParseValue( extractor, section, sub );
+    else if( c != ',' )
+    {
+      /* Drop thousands separators, "10,846" or "$1,876.844" */
+      table->capture[ table->capturelength++ ] = c;
+    }
+  }
+  table->matchlength = blPriceGuideMatchStep( blPriceGuideValueString, table->matchlength, c );
+  if( !( blPriceGuideValueString[ table->matchlength ] ) )
+  {
+    if( table->captureflag )
+      blPriceGuideParseValue( extractor, section, sub );
+    if( table->valueindex < 6 )
+    {
+      table->captureflag = 1;
+      table->capturelength = 0;
+    }
+    table->matchlength = 0;
+  }
+  return;
+}
+
+/* A table whose header was found must hold all of its values */
+static void blPriceGuideCloseSection( blPriceGuideExtractor *extractor, int section )
+{
+  int sub;
+  blPriceGuideTable *table;
+
+  for( sub = 0 ; sub < 2 ; sub++ )
+  {
+    table = &extractor->tablelist[section][sub];
+    if( ( table->captureflag ) && !( extractor->errorflag ) )
+      blPriceGuideParseValue( extractor, section, sub );
+    if( ( table->valueindex >= 0 ) && ( table->valueindex < 6 ) )
+      extractor->errorflag = 1;
+  }
+  extractor->sectionstate[section] = BL_PRICEGUIDE_SECTION_CLOSED;
+  return;
+}
+
+
+void blPriceGuideExtractorInit( blPriceGuideExtractor *extractor )
+{
+  int section, sub;
+
+  memset( extractor, 0, sizeof(blPriceGuideExtractor) );
   for( section = 0 ; section < 2 ; section++ )
   {
-    /* Get sale numbers out */
-    if( !( sectionstr[section] ) )
-      continue;
-    substr[0] = ccStrFindStrSkip( sectionstr[section], "New" );
-    substr[1] = ccStrFindStrSkip( sectionstr[section], "Used" );
+    extractor->sectionstate[section] = BL_PRICEGUIDE_SECTION_WAITING;
     for( sub = 0 ; sub < 2 ; sub++ )
+      extractor->tablelist[section][sub].valueindex = -1;
+  }
+  return;
+}
+
+/* Returns non-zero once all four tables are captured or on error, no further data is needed */
+int blPriceGuideExtractorFeed( blPriceGuideExtractor *extractor, char *data, int datasize )
+{
+  int index, section, sub, foundmask, completecount;
+  char c;
+
+  for( index = 0 ; index < datasize ; index++ )
+  {
+    c = data[index];
+    foundmask = 0;
+    for( section = 0 ; section < 2 ; section++ )
     {
-      valstr = substr[sub];
-      if( !( valstr ) )
+      if( extractor->sectionstate[section] != BL_PRICEGUIDE_SECTION_WAITING )
         continue;
-      pg = ( sub ? pgused : pgnew );
-      for( value = 0 ; value < 2 ; value++ )
+      extractor->sectionmatch[section] = blPriceGuideMatchStep( blPriceGuideSectionString[section], extractor->sectionmatch[section], c );
+      if( !( blPriceGuideSectionString[section][ extractor->sectionmatch[section] ] ) )
+        foundmask |= 1 << section;
+    }
+    /* The header of one section ends the text of the other */
+    for( section = 0 ; section < 2 ; section++ )
+    {
+      if( extractor->sectionstate[section] != BL_PRICEGUIDE_SECTION_OPEN )
+        continue;
+      if( foundmask & ( 1 << ( section ^ 1 ) ) )
+        blPriceGuideCloseSection( extractor, section );
+      else
       {
-        writeaddr = ADDRESS( pg, blPriceGuideOffsetTable[section][value] );
-        valstr = ccStrFindStrSkip( valstr, "SIZE=\"2\">&nbsp;" );
-        if( !( valstr ) )
-          return 0;
-        if( sscanf( valstr, "%d", (int *)writeaddr ) != 1 )
-          return 0;
+        for( sub = 0 ; sub < 2 ; sub++ )
+          blPriceGuideFeedTable( extractor, section, sub, c );
       }
-      for( ; value < 6 ; value++ )
+    }
+    for( section = 0 ; section < 2 ; section++ )
+    {
+      if( foundmask & ( 1 << section ) )
+        extractor->sectionstate[section] = BL_PRICEGUIDE_SECTION_OPEN;
+    }
+    if( extractor->errorflag )
+      return 1;
+    completecount = 0;
+    for( section = 0 ; section < 2 ; section++ )
+    {
+      for( sub = 0 ; sub < 2 ; sub++ )
       {
-        writeaddr = ADDRESS( pg, blPriceGuideOffsetTable[section][value] );
-        valstr = ccStrFindStrSkip( valstr, "SIZE=\"2\">&nbsp;" );
-        if( !( valstr ) )
-          return 0;
-        if( sscanf( valstr, "$%f", (float *)writeaddr ) != 1 )
-          return 0;
+        if( extractor->tablelist[section][sub].valueindex >= 6 )
+          completecount++;
       }
     }
+    if( completecount == 4 )
+      return 1;
   }
 
+  return 0;
+}
+
+/* Returns 1 on success, missing sections leave their fields cleared */
+int blPriceGuideExtractorFinish( blPriceGuideExtractor *extractor, bsxPriceGuide *pgnew, bsxPriceGuide *pgused )
+{
+  int section;
+  int64_t curtime;
+
+  for( section = 0 ; section < 2 ; section++ )
+  {
+    if( extractor->sectionstate[section] == BL_PRICEGUIDE_SECTION_OPEN )
+      blPriceGuideCloseSection( extractor, section );
+  }
   curtime = time( 0 );
-  pgnew->modtime = curtime;
-  pgused->modtime = curtime;
-  return 1;
+  extractor->pg[0].modtime = curtime;
+  extractor->pg[1].modtime = curtime;
+  if( pgnew )
+    *pgnew = extractor->pg[0];
+  if( pgused )
+    *pgused = extractor->pg[1];
+
+  return !( extractor->errorflag );
+}
+
+
+int blHtmlParsePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *string, int stringlength )
+{
+  blPriceGuideExtractor extractor;
+
+  DEBUG_SET_TRACKER();
+
+  blPriceGuideExtractorInit( &extractor );
+  /* The last byte was historically overwritten by a terminator, keep it out of the scan */
+  if( stringlength > 0 )
+    blPriceGuideExtractorFeed( &extractor, string, stringlength - 1 );
+  return blPriceGuideExtractorFinish( &extractor, pgnew, pgused );
 }
 
 
@@ -1279,7 +1419,7 @@ void blFreeOrderList( bsOrderList *orderlist )
 ////
 
 
-static int blParseItemValue( jsonParser *parser, jsonToken *token, bsxItem *item )
+static int blParseItemValue( jsonParser *parser, jsonToken *token, bsxInventory *inv, bsxItem *item )
 {
   char *name;
   int namelen;
@@ -1295,14 +1435,14 @@ static int blParseItemValue( jsonParser *parser, jsonToken *token, bsxItem *item
     if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
       return 0;
     valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemId( item, valuestring, valuetoken->length );
+    bsxSetInvItemId( inv, item, valuestring, valuetoken->length );
   }
   else if( blParseCheckName( name, namelen, "name" ) )
   {
     if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
       return 0;
     valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemName( item, valuestring, valuetoken->length );
+    bsxSetInvItemName( inv, item, valuestring, valuetoken->length );
   }
   else if( blParseCheckName( name, namelen, "type" ) )
   {
@@ -1380,7 +1520,7 @@ static int blParseItemValue( jsonParser *parser, jsonToken *token, bsxItem *item
 
 
 /* We accepted a '{' */
-static int blParseLotItem( jsonParser *parser, bsxItem *item )
+static int blParseLotItem( jsonParser *parser, bsxInventory *inv, bsxItem *item )
 {
   jsonToken *nametoken;
 
@@ -1409,7 +1549,7 @@ static int blParseLotItem( jsonParser *parser, bsxItem *item )
     ioPrintf( parser->log, 0, " : \"%.*s\"\n", (int)token->length, &parser->codestring[ token->offset ] );
 #endif
 
-    if( !( blParseItemValue( parser, nametoken, item ) ) )
+    if( !( blParseItemValue( parser, nametoken, inv, item ) ) )
       return 0;
 
     if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
@@ -1428,7 +1568,7 @@ static int blParseLotItem( jsonParser *parser, bsxItem *item )
 }
 
 
-static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item )
+static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxInventory *inv, bsxItem *item )
 {
   char *name;
   int namelen;
@@ -1451,7 +1591,7 @@ static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item
   {
     if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
       return 0;
-    if( !( blParseLotItem( parser, item ) ) )
+    if( !( blParseLotItem( parser, inv, item ) ) )
       return 0;
     jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
   }
@@ -1466,7 +1606,7 @@ static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item
     if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
       return 0;
     valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemColorName( item, valuestring, valuetoken->length );
+    bsxSetInvItemColorName( inv, item, valuestring, valuetoken->length );
   }
   else if( blParseCheckName( name, namelen, "quantity" ) )
   {
@@ -1536,7 +1676,7 @@ static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item
       decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
       if( decodedstring )
       {
-        bsxSetItemComments( item, decodedstring, strlen( decodedstring ) );
+        bsxSetInvItemComments( inv, item, decodedstring, strlen( decodedstring ) );
         free( decodedstring );
       }
     }
@@ -1551,7 +1691,7 @@ static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item
       decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
       if( decodedstring )
       {
-        bsxSetItemRemarks( item, decodedstring, strlen( decodedstring ) );
+        bsxSetInvItemRemarks( inv, item, decodedstring, strlen( decodedstring ) );
         free( decodedstring );
       }
     }
@@ -1705,7 +1845,7 @@ static int blParseLot( jsonParser *parser, void *uservalue )
     ioPrintf( parser->log, 0, " : \"%.*s\"\n", (int)token->length, &parser->codestring[ token->offset ] );
 #endif
 
-    if( !( blParseLotValue( parser, nametoken, item ) ) )
+    if( !( blParseLotValue( parser, nametoken, inv, item ) ) )
       return 0;
 
     if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
@@ -33,6 +33,41 @@ int blFetchPriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtyp
 ////
 
 
+#define BL_PRICEGUIDE_CAPTURE_SIZE (32)
+
+typedef struct
+{
+  int matchlength;
+  /* Count of values read, -1 until the table header is found */
+  int valueindex;
+  int captureflag;
+  int capturelength;
+  char capture[BL_PRICEGUIDE_CAPTURE_SIZE];
+} blPriceGuideTable;
+
+/* Incremental extractor of the summary tables of a priceGuide.asp page, fed with body fragments in order */
+typedef struct
+{
+  int sectionstate[2];
+  int sectionmatch[2];
+  blPriceGuideTable tablelist[2][2];
+  int errorflag;
+  bsxPriceGuide pg[2];
+} blPriceGuideExtractor;
+
+void blPriceGuideExtractorInit( blPriceGuideExtractor *extractor );
+/* Returns non-zero once all four tables are captured or on error, no further data is needed */
+int blPriceGuideExtractorFeed( blPriceGuideExtractor *extractor, char *data, int datasize );
+/* Returns 1 on success, missing sections leave their fields cleared */
+int blPriceGuideExtractorFinish( blPriceGuideExtractor *extractor, bsxPriceGuide *pgnew, bsxPriceGuide *pgused );
+
+/* Parse a whole buffered priceGuide.asp page */
+int blHtmlParsePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *string, int stringlength );
+
+
+////
+
+
 /* Read orderlist, return value is count of orders */
 int blReadOrderList( bsOrderList *orderlist, char *string, ioLog *log );
 void blFreeOrderList( bsOrderList *orderlist );
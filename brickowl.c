@@ -1327,6 +1327,217 @@ int boReadLookup( int64_t *retboid, char *string, ioLog *log )
 ////
 
 
+/*
+Catalog export, BrickLink item numbers are listed in "ids" with a type of "bl_item_no"
+[
+{"boid":"771344","type":"Part","name":"LEGO Brick 2 x 4 (3001)","ids":[{"id":"3001","type":"design_id"},{"id":"3001","type":"bl_item_no"},{"id":"771344","type":"boid"}]},
+{"boid":"549373","type":"Minifigure","ids":[{"id":"sw0001a","type":"bl_item_no"}]}
+]
+*/
+
+#define BO_CATALOG_BLID_MAX (8)
+
+typedef struct
+{
+  void *uservalue;
+  void (*callback)( void *uservalue, boCatalogEntry *entry );
+} boCatalogState;
+
+typedef struct
+{
+  char *id;
+  int idlen;
+  int blidflag;
+} boCatalogId;
+
+static char boParseCatalogType( char *typestring, int typelength )
+{
+  if( ccStrMatchSeq( "Part", typestring, typelength ) || ccStrMatchSeq( "Sticker", typestring, typelength ) )
+    return 'P';
+  else if( ccStrMatchSeq( "Set", typestring, typelength ) )
+    return 'S';
+  else if( ccStrMatchSeq( "Minifigure", typestring, typelength ) )
+    return 'M';
+  else if( ccStrMatchSeq( "Gear", typestring, typelength ) )
+    return 'G';
+  else if( ccStrMatchSeq( "Instructions", typestring, typelength ) )
+    return 'I';
+  else if( ccStrMatchSeq( "Packaging", typestring, typelength ) )
+    return 'O';
+  /* Minibuilds and other types have no single matching BrickLink type */
+  return 0;
+}
+
+/* We accepted a '{' */
+static int boParseCatalogId( jsonParser *parser, boCatalogId *catid )
+{
+  jsonToken *nametoken, *valuetoken;
+
+  catid->id = 0;
+  catid->idlen = 0;
+  catid->blidflag = 0;
+  if( parser->tokentype == JSON_TOKEN_RBRACE )
+    return 1;
+  for( ; ; )
+  {
+    if( !( nametoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+      return 0;
+    if( !( jsonTokenExpect( parser, JSON_TOKEN_COLON ) ) )
+      return 0;
+    if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "id" ) )
+    {
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      catid->id = &parser->codestring[ valuetoken->offset ];
+      catid->idlen = valuetoken->length;
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "type" ) )
+    {
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      catid->blidflag = ( ccStrMatchSeq( "bl_item_no", &parser->codestring[ valuetoken->offset ], valuetoken->length ) ? 1 : 0 );
+    }
+    else
+    {
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+    }
+    if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+      break;
+  }
+  return ( parser->errorcount ? 0 : 1 );
+}
+
+/* We accepted a '{' */
+static int boParseCatalogItem( jsonParser *parser, void *uservalue )
+{
+  int blidindex, blidcount;
+  jsonToken *nametoken, *valuetoken;
+  boCatalogState *state;
+  boCatalogId catid;
+  boCatalogEntry entry;
+  char *blidlist[BO_CATALOG_BLID_MAX];
+  int blidlenlist[BO_CATALOG_BLID_MAX];
+
+  state = uservalue;
+  if( parser->tokentype == JSON_TOKEN_RBRACE )
+    return 1;
+
+  entry.boid = -1;
+  entry.bltypeid = 0;
+  blidcount = 0;
+  for( ; ; )
+  {
+    if( !( nametoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+      return 0;
+    if( !( jsonTokenExpect( parser, JSON_TOKEN_COLON ) ) )
+      return 0;
+    if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "boid" ) )
+    {
+      if( !( boReadIntegerBOID( parser, &entry.boid ) ) )
+        return 0;
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "type" ) )
+    {
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      entry.bltypeid = boParseCatalogType( &parser->codestring[ valuetoken->offset ], valuetoken->length );
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "bl_item_no" ) )
+    {
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      if( blidcount < BO_CATALOG_BLID_MAX )
+      {
+        blidlist[ blidcount ] = &parser->codestring[ valuetoken->offset ];
+        blidlenlist[ blidcount ] = valuetoken->length;
+        blidcount++;
+      }
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "ids" ) )
+    {
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACKET ) ) )
+        return 0;
+      while( jsonTokenAccept( parser, JSON_TOKEN_LBRACE ) )
+      {
+        if( !( boParseCatalogId( parser, &catid ) ) )
+          return 0;
+        if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACE ) ) )
+          return 0;
+        if( ( catid.blidflag ) && ( catid.id ) && ( blidcount < BO_CATALOG_BLID_MAX ) )
+        {
+          blidlist[ blidcount ] = catid.id;
+          blidlenlist[ blidcount ] = catid.idlen;
+          blidcount++;
+        }
+        if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+          break;
+      }
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+        return 0;
+    }
+    else
+    {
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+    }
+    if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+      break;
+  }
+
+  if( parser->errorcount )
+    return 0;
+  for( blidindex = 0 ; blidindex < blidcount ; blidindex++ )
+  {
+    entry.blid = blidlist[ blidindex ];
+    entry.blidlen = blidlenlist[ blidindex ];
+    state->callback( state->uservalue, &entry );
+  }
+
+  return 1;
+}
+
+
+/* Read catalog export and call callback for every BLID found */
+int boReadCatalog( void *uservalue, void (*callback)( void *uservalue, boCatalogEntry *entry ), char *string, ioLog *log )
+{
+  int retval;
+  jsonTokenBuffer *tokenbuf;
+  jsonParser parser;
+  boCatalogState state;
+
+  DEBUG_SET_TRACKER();
+
+  tokenbuf = jsonLexParse( string, log );
+  if( !( tokenbuf ) )
+    return 0;
+  jsonTokenInit( &parser, string, tokenbuf, log );
+
+  state.uservalue = uservalue;
+  state.callback = callback;
+
+  if( jsonTokenExpect( &parser, JSON_TOKEN_LBRACKET ) )
+  {
+    jsonParserListObjects( &parser, (void *)&state, boParseCatalogItem, 0 );
+    jsonTokenExpect( &parser, JSON_TOKEN_RBRACKET );
+  }
+
+  retval = 1;
+  if( parser.errorcount )
+  {
+    ioPrintf( parser.log, 0, "JSON Parse Errors Encountered\n" );
+    retval = 0;
+  }
+
+  jsonLexFree( tokenbuf );
+
+  return retval;
+}
+
+
+////
+
+
 /* We accepted a '{' */
 static int boParseLotID( jsonParser *parser, int64_t *retlotid )
 {
@@ -64,6 +64,14 @@ typedef struct
   int bl2bo[BO_COLOR_TABLE_RANGE];
 } boColorTable;
 
+typedef struct
+{
+  int64_t boid;
+  char bltypeid;
+  char *blid;
+  int blidlen;
+} boCatalogEntry;
+
 #define BO_USER_DETAILS_NAME_LENGTH (256)
 
 typedef struct
@@ -86,6 +94,9 @@ int boReadColorTable( boColorTable *colortable, char *string, ioLog *log );
 /* Read BLID lookup */
 int boReadLookup( int64_t *retboid, char *string, ioLog *log );
 
+/* Read catalog export and call callback for every BLID found */
+int boReadCatalog( void *uservalue, void (*callback)( void *uservalue, boCatalogEntry *entry ), char *string, ioLog *log );
+
 /* Read lotID for a single lot, as reply to a lot creation */
 int boReadLotID( int64_t *retlotid, char *string, ioLog *log );
 
@@ -81,9 +81,9 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
     /* Create a new item with sparse information, the bolotid and little else */
     item = bsxNewItem( invstate->orderinv );
     if( blid[0] )
-      bsxSetItemId( item, blid, strlen( blid ) );
+      bsxSetInvItemId( invstate->orderinv, item, blid, strlen( blid ) );
     if( boitem->name )
-      bsxSetItemName( item, boitem->name, boitem->namelen );
+      bsxSetInvItemName( invstate->orderinv, item, boitem->name, boitem->namelen );
     item->typeid = bltypeid;
     item->colorid = blcolorid;
     item->origquantity = 0;
@@ -119,7 +119,7 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
   bsxVerifyItem( item );
 
   if( boitem->name )
-    bsxSetItemName( item, boitem->name, boitem->namelen );
+    bsxSetInvItemName( invstate->orderinv, item, boitem->name, boitem->namelen );
   else if( boitem->url )
   {
     urloffset = ccSeqFindCharLast( boitem->url, boitem->urllen, '/' );
@@ -127,14 +127,14 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
       urloffset = 0;
     else
       urloffset++;
-    bsxSetItemName( item, boitem->url + urloffset, boitem->urllen - urloffset );
+    bsxSetInvItemName( invstate->orderinv, item, boitem->url + urloffset, boitem->urllen - urloffset );
   }
   if( ( boitem->publicnote ) && ( boitem->publicnotelen ) )
   {
     decodedstring = jsonDecodeEscapeString( boitem->publicnote, boitem->publicnotelen, 0 );
     if( decodedstring )
     {
-      bsxSetItemComments( item, decodedstring, strlen( decodedstring ) );
+      bsxSetInvItemComments( invstate->orderinv, item, decodedstring, strlen( decodedstring ) );
       free( decodedstring );
     }
     else
@@ -147,7 +147,7 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
     decodedstring = jsonDecodeEscapeString( boitem->personalnote, boitem->personalnotelen, 0 );
     if( decodedstring )
     {
-      bsxSetItemRemarks( item, decodedstring, strlen( decodedstring ) );
+      bsxSetInvItemRemarks( invstate->orderinv, item, decodedstring, strlen( decodedstring ) );
       free( decodedstring );
     }
     else
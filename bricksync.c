@@ -166,6 +166,46 @@ void bsFatalError( bsContext *context )
 ////
 
 
+static int bsApiServerIsLoopback( char *server )
+{
+  return ( ccStrCmpEqual( server, "127.0.0.1" ) || ccStrCmpEqual( server, "::1" ) || ccStrCmpEqual( server, "localhost" ) );
+}
+
+/* Credentials are only ever sent in clear text to the local host, or when the configuration explicitly asks for it */
+static void bsSetupApiServer( bsContext *context, char *name, char **apiserver, int *apiport, int apissl, int *apihttpflags, char *defaultserver )
+{
+  *apihttpflags = HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING;
+  if( !( *apiserver ) || !( (*apiserver)[0] ) )
+  {
+    if( *apiserver )
+      free( *apiserver );
+    *apiserver = strdup( defaultserver );
+    *apiport = 443;
+    *apihttpflags |= HTTP_CONNECTION_FLAGS_SSL;
+    return;
+  }
+  if( apissl < 0 )
+    apissl = !( bsApiServerIsLoopback( *apiserver ) );
+  if( apissl )
+  {
+    if( *apiport <= 0 )
+      *apiport = 443;
+    *apihttpflags |= HTTP_CONNECTION_FLAGS_SSL;
+    ioPrintf( &context->output, 0, BSMSG_INFO "%s API queries are sent to " IO_CYAN "%s:%d" IO_DEFAULT " over SSL.\n", name, *apiserver, *apiport );
+  }
+  else
+  {
+    if( *apiport <= 0 )
+      *apiport = 80;
+    ioPrintf( &context->output, 0, BSMSG_WARNING "%s API queries and credentials are sent to " IO_YELLOW "%s:%d" IO_WHITE " over plain HTTP.\n", name, *apiserver, *apiport );
+  }
+  return;
+}
+
+
+////
+
+
 bsContext *bsInit( char *statepath, int *retstateloaded )
 {
   int stateloaded, conferrorcount;
@@ -246,6 +286,7 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->bricklink.apicountquantitylimit = BS_BRICKLINK_APICOUNT_QUANTITYLIMIT_DEFAULT;
   context->bricklink.apicountsyncresume = BS_BRICKLINK_APICOUNT_SYNCRESUME_DEFAULT;
   context->bricklink.xmluploadindex = 0;
+  context->bricklink.apissl = -1;
   context->bricklink.xmlupdateindex = 0;
   context->brickowl.pipelinequeuesize = BS_BRICKLINK_PIPELINED_FETCH;
   context->brickowl.orderinitdate = 0;
@@ -254,6 +295,8 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->brickowl.failinterval = BS_POLL_FAIL_INTERVAL_DEFAULT;
   context->brickowl.pollinterval = BS_POLL_SUCCESS_INTERVAL_DEFAULT;
   context->brickowl.reuseemptyflag = 0;
+  context->brickowl.apissl = -1;
+  context->brickowl.lookupretry = BS_BRICKOWL_LOOKUP_RETRY_DEFAULT;
   context->backupindex = 0;
   context->errorindex = 0;
   context->priceguidepath = 0;
@@ -267,6 +310,11 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->lastmessagetimestamp = 0;
   context->diskspacechecktime = 0;
   context->findordertime = 7 * (24*60*60);
+  context->findorderskiptime = 0;
+  context->httptracerecordpath = 0;
+  context->httptracereplaypath = 0;
+  context->httptracereplaytime = 100;
+  context->httptrace = 0;
 #if BS_ENABLE_MATHPUZZLE
   context->puzzleanswer.i = 8;
 #endif
@@ -293,6 +341,10 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
     context->bricklink.failinterval = BS_POLL_FAIL_INTERVAL_MIN;
   if( context->brickowl.failinterval < BS_POLL_FAIL_INTERVAL_MIN )
     context->brickowl.failinterval = BS_POLL_FAIL_INTERVAL_MIN;
+  if( context->brickowl.lookupretry < 0 )
+    context->brickowl.lookupretry = 0;
+  if( context->pgrefresh.hourlybudget < 0 )
+    context->pgrefresh.hourlybudget = 0;
   if( !( context->priceguidepath ) )
     context->priceguidepath = BS_PRICEGUIDE_DIR;
   if( context->bricklink.pipelinequeuesize < 1 )
@@ -303,6 +355,9 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
     context->brickowl.pipelinequeuesize = 1;
   else if( context->brickowl.pipelinequeuesize > BS_BRICKOWL_PIPELINED_FETCH_MAX )
     context->brickowl.pipelinequeuesize = BS_BRICKOWL_PIPELINED_FETCH_MAX;
+  /* A configured API server is spoken to over SSL, unless it is a loopback simulator or plain HTTP was explicitly requested */
+  bsSetupApiServer( context, "BrickLink", &context->bricklink.apiserver, &context->bricklink.apiport, context->bricklink.apissl, &context->bricklink.apihttpflags, BS_BRICKLINK_API_SERVER );
+  bsSetupApiServer( context, "BrickOwl", &context->brickowl.apiserver, &context->brickowl.apiport, context->brickowl.apissl, &context->brickowl.apihttpflags, BS_BRICKOWL_API_SERVER );
 
   /* Verify configuration variables */
   conferrorcount = 0;
@@ -412,13 +467,13 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->bricksyncwebaddress = strdup( "199.58.80.33" );
 #else
   ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INIT "Resolving IP addresses for API and WEB services.\n" );
-  context->bricklink.apiaddress = tcpResolveName( BS_BRICKLINK_API_SERVER, 0 );
+  context->bricklink.apiaddress = tcpResolveName( context->bricklink.apiserver, 0 );
   if( !( context->bricklink.apiaddress ) )
   {
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKLINK_API_SERVER );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", context->bricklink.apiserver );
     goto error;
   }
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKLINK_API_SERVER, context->bricklink.apiaddress );
+  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", context->bricklink.apiserver, context->bricklink.apiaddress );
   context->bricklink.webaddress = tcpResolveName( BS_BRICKLINK_WEB_SERVER, 0 );
   if( !( context->bricklink.webaddress ) )
   {
@@ -426,13 +481,13 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
     goto error;
   }
   ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKLINK_WEB_SERVER, context->bricklink.webaddress );
-  context->brickowl.apiaddress = tcpResolveName( BS_BRICKOWL_API_SERVER, 0 );
+  context->brickowl.apiaddress = tcpResolveName( context->brickowl.apiserver, 0 );
   if( !( context->brickowl.apiaddress ) )
   {
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKOWL_API_SERVER );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", context->brickowl.apiserver );
     goto error;
   }
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKOWL_API_SERVER, context->brickowl.apiaddress );
+  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", context->brickowl.apiserver, context->brickowl.apiaddress );
   if( context->checkmessageflag )
   {
     context->bricksyncwebaddress = tcpResolveName( BS_BRICKSYNC_WEB_SERVER, 0 );
@@ -452,12 +507,40 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   /* Create empty tracked inventory */
   context->inventory = bsxNewInventory();
 
+  /* Optional HTTP traffic trace, recorded from or replayed to the BrickLink and BrickOwl connections */
+  if( ( context->httptracerecordpath ) && ( context->httptracereplaypath ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "The settings httptrace.record and httptrace.replay can not be used together.\n" );
+    goto error;
+  }
+  if( context->httptracerecordpath )
+  {
+    context->httptrace = httpTraceOpenRecord( context->httptracerecordpath );
+    if( !( context->httptrace ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to create the HTTP trace file \"" IO_RED "%s" IO_WHITE "\".\n", context->httptracerecordpath );
+      goto error;
+    }
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Recording HTTP traffic to \"" IO_YELLOW "%s" IO_WHITE "\", credentials are masked but replies are recorded in full.\n", context->httptracerecordpath );
+  }
+  else if( context->httptracereplaypath )
+  {
+    context->httptrace = httpTraceOpenReplay( context->httptracereplaypath, context->httptracereplaytime );
+    if( !( context->httptrace ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to load the HTTP trace file \"" IO_RED "%s" IO_WHITE "\".\n", context->httptracereplaypath );
+      goto error;
+    }
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Replaying HTTP traffic from \"" IO_YELLOW "%s" IO_WHITE "\" at " IO_CYAN "%d%%" IO_WHITE " of the recorded delays, no query reaches BrickLink or BrickOwl.\n", context->httptracereplaypath, context->httptracereplaytime );
+  }
+
   /* Define HTTP connections to BrickLink and BrickOwl */
-  context->bricklink.http = httpOpen( &context->tcp, context->bricklink.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
+  context->bricklink.http = httpOpen( &context->tcp, context->bricklink.apiaddress, context->bricklink.apiport, context->bricklink.apihttpflags );
   context->bricklink.webhttp = httpOpen( &context->tcp, context->bricklink.webaddress, 80, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
-  context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
+  context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, context->brickowl.apiport, context->brickowl.apihttpflags );
   if( ( context->checkmessageflag ) && ( context->bricksyncwebaddress ) )
     context->bricksyncwebhttp = httpOpen( &context->tcp, context->bricksyncwebaddress, 80, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
+  bsAttachHttpStats( context );
 
   /* Increase BrickOwl timeout due to absurd times required to download inventory */
   httpSetTimeout( context->brickowl.http, 120*1000, 120*1000 );
@@ -490,7 +573,22 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   mmListDualInit( &context->replylist );
 
   /* Initialize BLID <->BOID translation database */
-  translationTableInit( &context->translationtable, BS_TRANSLATION_FILE );
+  translationTableInit( &context->translationtable, BS_TRANSLATION_FILE, BS_TRANSLATION_INDEX_FILE );
+  translationNegativeInit( &context->translationnegative, BS_TRANSLATION_NEGATIVE_FILE );
+
+  /* Open the single-file price guide cache */
+  context->priceguidedbpath = ccStrAllocPrintf( "%s.db", context->priceguidepath );
+  if( ( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_DATABASE ) && !( bsxPriceGuideDbOpen( &context->priceguidedb, context->priceguidedbpath ) ) )
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to open the price guide cache at \"" IO_RED "%s" IO_WHITE "\".\n", context->priceguidedbpath );
+
+  /* Optional metrics endpoint, a failure to listen isn't fatal */
+  bsMetricsInit( context );
+
+#if ENABLE_DEBUG_TRACKING
+  /* Optional sampling of the debug tracker by the watchdog thread */
+  if( context->samplerate > 0 )
+    debugTrackerSetSampleRate( context->samplerate );
+#endif
 
   *retstateloaded = stateloaded;
   return context;
@@ -510,8 +608,9 @@ int bsSaveState( bsContext *context, journalDef *journal )
 {
   bsFileState state;
   journalEntry journalentry;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "save_state" );
 
   /* Build state file data */
   memset( &state, 0, sizeof(bsFileState) );
@@ -538,6 +637,7 @@ int bsSaveState( bsContext *context, journalDef *journal )
   if( !( ccFileStore( BS_STATE_TEMP_FILE, &state, sizeof(bsFileState), 1 ) ) )
   {
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write state file as \"" IO_RED "%s" CC_DIR_SEPARATOR_STRING "%s" IO_WHITE "\".\n", context->cwd, BS_STATE_TEMP_FILE );
+    DEBUG_PROFILE_END( &profile );
     return 0;
   }
   /* Add to journal if any, otherwise update straight away */
@@ -548,9 +648,13 @@ int bsSaveState( bsContext *context, journalDef *journal )
     journalentry.oldpath = BS_STATE_TEMP_FILE;
     journalentry.newpath = BS_STATE_FILE;
     if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, &journalentry, 1 ) ) )
+    {
+      DEBUG_PROFILE_END( &profile );
       return 0;
+    }
   }
   context->contextflags &= ~BS_CONTEXT_FLAGS_UPDATED_STATE;
+  DEBUG_PROFILE_END( &profile );
   return 1;
 }
 
@@ -558,13 +662,15 @@ int bsSaveState( bsContext *context, journalDef *journal )
 int bsSaveInventory( bsContext *context, journalDef *journal )
 {
   journalEntry journalentry;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "save_inventory" );
 
   /* Store temporary file with fsync and record journal entry */
   if( !( bsxSaveInventory( BS_INVENTORY_TEMP_FILE, context->inventory, 1, 0 ) ) )
   {
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write inventory file as \"" IO_RED "%s" CC_DIR_SEPARATOR_STRING "%s" IO_WHITE "\".\n", context->cwd, BS_INVENTORY_TEMP_FILE );
+    DEBUG_PROFILE_END( &profile );
     return 0;
   }
   /* Add to journal if any, otherwise update straight away */
@@ -575,9 +681,224 @@ int bsSaveInventory( bsContext *context, journalDef *journal )
     journalentry.oldpath = BS_INVENTORY_TEMP_FILE;
     journalentry.newpath = BS_INVENTORY_FILE;
     if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, &journalentry, 1 ) ) )
+    {
+      DEBUG_PROFILE_END( &profile );
       return 0;
+    }
   }
   context->contextflags &= ~BS_CONTEXT_FLAGS_UPDATED_INVENTORY;
+  DEBUG_PROFILE_END( &profile );
+  return 1;
+}
+
+
+////
+
+
+/* Rewrite the translation database with only its live entries, atomically swapped through the journal */
+int bsCompactTranslationTable( ioLog *log, translationTable *table )
+{
+  journalEntry journalentry[2];
+  translationCompactStats stats;
+
+  DEBUG_SET_TRACKER();
+
+  ioPrintf( log, IO_MODEBIT_FLUSH, BSMSG_INFO "Compacting the translation database \"" IO_CYAN "%s" IO_DEFAULT "\"...\n", BS_TRANSLATION_FILE );
+  if( !( translationTableCompact( table, BS_TRANSLATION_TEMP_FILE, BS_TRANSLATION_INDEX_TEMP_FILE, &stats ) ) )
+  {
+    ioPrintf( log, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write the compacted translation database as \"" IO_RED "%s" IO_WHITE "\".\n", BS_TRANSLATION_TEMP_FILE );
+    remove( BS_TRANSLATION_TEMP_FILE );
+    remove( BS_TRANSLATION_INDEX_TEMP_FILE );
+    return 0;
+  }
+  if( stats.compactcount == stats.storagecount )
+  {
+    remove( BS_TRANSLATION_TEMP_FILE );
+    remove( BS_TRANSLATION_INDEX_TEMP_FILE );
+    ioPrintf( log, 0, BSMSG_INFO "The translation database is already compact, " IO_GREEN "%d" IO_DEFAULT " entries.\n", stats.storagecount );
+    return 1;
+  }
+  /* Replace the storage file and its index in the same transaction, the old index must not survive the compaction */
+  journalentry[0].oldpath = BS_TRANSLATION_TEMP_FILE;
+  journalentry[0].newpath = BS_TRANSLATION_FILE;
+  journalentry[1].oldpath = BS_TRANSLATION_INDEX_TEMP_FILE;
+  journalentry[1].newpath = BS_TRANSLATION_INDEX_FILE;
+  if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, log, journalentry, 2 ) ) )
+    return 0;
+  translationTableReload( table );
+
+  ioPrintf( log, 0, BSMSG_INFO "Translation entries : " IO_GREEN "%d" IO_DEFAULT " -> " IO_GREEN "%d" IO_DEFAULT ".\n", stats.storagecount, stats.compactcount );
+  ioPrintf( log, 0, BSMSG_INFO "Translation file size : " IO_GREEN "%.1f" IO_DEFAULT " kB -> " IO_GREEN "%.1f" IO_DEFAULT " kB.\n", (double)stats.storagesize / 1024.0, (double)stats.compactsize / 1024.0 );
+  ioPrintf( log, 0, BSMSG_INFO "Full load time : " IO_GREEN "%.3f" IO_DEFAULT " ms -> " IO_GREEN "%.3f" IO_DEFAULT " ms.\n", (double)stats.loadtime / 1000.0, (double)stats.compactloadtime / 1000.0 );
+  return 1;
+}
+
+
+/* Split a CSV line in up to fieldmax fields, trimmed and unquoted, return the count of fields */
+static int bsImportSplitCsv( char *line, int linelength, char **fieldlist, int *fieldlenlist, int fieldmax )
+{
+  int fieldcount, offset, start, end;
+
+  fieldcount = 0;
+  for( offset = 0 ; ( offset <= linelength ) && ( fieldcount < fieldmax ) ; offset++ )
+  {
+    for( start = offset ; ( offset < linelength ) && ( line[offset] != ',' ) && ( line[offset] != ';' ) && ( line[offset] != '\t' ) ; offset++ );
+    for( end = offset ; ( start < end ) && ( ( line[start] == ' ' ) || ( line[start] == '"' ) ) ; start++ );
+    for( ; ( end > start ) && ( ( line[end-1] == ' ' ) || ( line[end-1] == '"' ) || ( line[end-1] == '\r' ) ) ; end-- );
+    fieldlist[fieldcount] = &line[start];
+    fieldlenlist[fieldcount] = end - start;
+    fieldcount++;
+  }
+  return fieldcount;
+}
+
+static char bsImportParseType( char *typestring, int typelength )
+{
+  if( typelength == 1 )
+  {
+    switch( typestring[0] )
+    {
+      case 'P': case 'S': case 'M': case 'G': case 'B': case 'C': case 'I': case 'O':
+        return typestring[0];
+      default:
+        return 0;
+    }
+  }
+  if( ccStrMatchSeq( "Part", typestring, typelength ) || ccStrMatchSeq( "Sticker", typestring, typelength ) )
+    return 'P';
+  else if( ccStrMatchSeq( "Set", typestring, typelength ) )
+    return 'S';
+  else if( ccStrMatchSeq( "Minifigure", typestring, typelength ) || ccStrMatchSeq( "Minifig", typestring, typelength ) )
+    return 'M';
+  else if( ccStrMatchSeq( "Gear", typestring, typelength ) )
+    return 'G';
+  else if( ccStrMatchSeq( "Book", typestring, typelength ) )
+    return 'B';
+  else if( ccStrMatchSeq( "Instructions", typestring, typelength ) )
+    return 'I';
+  else if( ccStrMatchSeq( "Packaging", typestring, typelength ) || ccStrMatchSeq( "Original Box", typestring, typelength ) )
+    return 'O';
+  return 0;
+}
+
+typedef struct
+{
+  translationBatch batch;
+  int readcount;
+  int invalidcount;
+} bsImportState;
+
+static void bsImportAddEntry( bsImportState *state, char bltypeid, char *blid, int blidlen, int64_t boid )
+{
+  char blidbuffer[64];
+
+  state->readcount++;
+  if( ( blidlen <= 0 ) || ( blidlen >= sizeof(blidbuffer) ) )
+  {
+    state->invalidcount++;
+    return;
+  }
+  memcpy( blidbuffer, blid, blidlen );
+  blidbuffer[blidlen] = 0;
+  if( !( translationBatchAdd( &state->batch, bltypeid, blidbuffer, boid ) ) )
+    state->invalidcount++;
+  return;
+}
+
+static void bsImportCatalogCallback( void *uservalue, boCatalogEntry *entry )
+{
+  bsImportAddEntry( uservalue, entry->bltypeid, entry->blid, entry->blidlen, entry->boid );
+  return;
+}
+
+/* Lines are "type,BLID,BOID" or "BLID,BOID" for parts, header and comment lines are skipped */
+static void bsImportCsv( bsImportState *state, char *string )
+{
+  int fieldcount, linelength, boidlength;
+  char bltypeid;
+  char *line, *nextline;
+  char *fieldlist[3];
+  int fieldlenlist[3];
+  int64_t boid;
+
+  for( line = string ; *line ; line = nextline )
+  {
+    nextline = ccStrNextLine( line );
+    linelength = (int)( nextline - line );
+    if( ( linelength ) && ( line[ linelength - 1 ] == '\n' ) )
+      linelength--;
+    if( ( linelength <= 0 ) || ( line[0] == '#' ) )
+      continue;
+    fieldcount = bsImportSplitCsv( line, linelength, fieldlist, fieldlenlist, 3 );
+    if( fieldcount < 2 )
+      continue;
+    bltypeid = 'P';
+    if( fieldcount == 3 )
+    {
+      bltypeid = bsImportParseType( fieldlist[0], fieldlenlist[0] );
+      fieldlist[0] = fieldlist[1];
+      fieldlenlist[0] = fieldlenlist[1];
+      fieldlist[1] = fieldlist[2];
+      fieldlenlist[1] = fieldlenlist[2];
+    }
+    /* BOIDs may carry a color suffix as in "771344-21" */
+    for( boidlength = 0 ; ( boidlength < fieldlenlist[1] ) && ( fieldlist[1][boidlength] != '-' ) ; boidlength++ );
+    if( !( ccSeqParseInt64( fieldlist[1], boidlength, &boid ) ) )
+      continue;
+    bsImportAddEntry( state, bltypeid, fieldlist[0], fieldlenlist[0], boid );
+  }
+
+  return;
+}
+
+
+/* Import a BLID <-> BOID mapping from a BrickOwl catalog export (JSON) or a CSV file */
+int bsImportTranslationTable( ioLog *log, translationTable *table, char *path )
+{
+  int newcount;
+  size_t filesize;
+  char *string, *scan;
+  int64_t importtime;
+  bsImportState state;
+
+  DEBUG_SET_TRACKER();
+
+  importtime = ccGetMillisecondsTime();
+  string = ccFileLoad( path, 1024*1048576, &filesize );
+  if( !( string ) )
+  {
+    ioPrintf( log, 0, BSMSG_ERROR "Failed to read the file \"" IO_RED "%s" IO_WHITE "\".\n", path );
+    return 0;
+  }
+  ioPrintf( log, IO_MODEBIT_FLUSH, BSMSG_INFO "Importing BLID <-> BOID mappings from \"" IO_CYAN "%s" IO_DEFAULT "\"...\n", path );
+
+  translationBatchInit( &state.batch );
+  state.readcount = 0;
+  state.invalidcount = 0;
+  for( scan = string ; ( *scan == ' ' ) || ( *scan == '\t' ) || ( *scan == '\r' ) || ( *scan == '\n' ) ; scan++ );
+  if( *scan == '[' )
+  {
+    if( !( boReadCatalog( &state, bsImportCatalogCallback, string, log ) ) )
+    {
+      ioPrintf( log, 0, BSMSG_ERROR "Failed to parse the catalog JSON of \"" IO_RED "%s" IO_WHITE "\".\n", path );
+      translationBatchFree( &state.batch );
+      free( string );
+      return 0;
+    }
+  }
+  else
+    bsImportCsv( &state, string );
+  free( string );
+
+  newcount = translationTableImport( table, &state.batch );
+  translationBatchFree( &state.batch );
+  if( newcount < 0 )
+  {
+    ioPrintf( log, 0, BSMSG_ERROR "Failed to write to the translation database \"" IO_RED "%s" IO_WHITE "\".\n", BS_TRANSLATION_FILE );
+    return 0;
+  }
+
+  ioPrintf( log, 0, BSMSG_INFO "Read " IO_GREEN "%d" IO_DEFAULT " mappings, " IO_GREEN "%d" IO_DEFAULT " new or updated, " IO_GREEN "%d" IO_DEFAULT " already known or repeated, " IO_YELLOW "%d" IO_DEFAULT " invalid, in " IO_GREEN "%.3f" IO_DEFAULT " seconds.\n", state.readcount, newcount, state.readcount - state.invalidcount - newcount, state.invalidcount, (double)( ccGetMillisecondsTime() - importtime ) / 1000.0 );
   return 1;
 }
 
@@ -683,6 +1004,11 @@ int bsBrickLinkSaveOrder( bsContext *context, bsOrder *order, bsxInventory *inv,
   newpath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_PATH, (long long)order->id );
   journalAddEntry( journal, oldpath, newpath, 1, 1 );
   retval = bsxSaveInventory( oldpath, inv, 1, 0 );
+  if( retval )
+  {
+    bsOrderManifestQueue( context, BS_ORDER_DIR_ORDER_TYPE_BRICKLINK, order, inv );
+    bsOrderIndexQueue( context, BS_ORDER_DIR_ORDER_TYPE_BRICKLINK, order->id, inv );
+  }
   if( retval )
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickLink order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " at \"" IO_CYAN "%s" IO_DEFAULT "\".\n", (long long)order->id, newpath );
   else
@@ -717,6 +1043,11 @@ int bsBrickOwlSaveOrder( bsContext *context, bsOrder *order, bsxInventory *inv,
   newpath = ccStrAllocPrintf( BS_BRICKOWL_ORDER_PATH, (long long)order->id );
   journalAddEntry( journal, oldpath, newpath, 1, 1 );
   retval = bsxSaveInventory( oldpath, inv, 1, 0 );
+  if( retval )
+  {
+    bsOrderManifestQueue( context, BS_ORDER_DIR_ORDER_TYPE_BRICKOWL, order, inv );
+    bsOrderIndexQueue( context, BS_ORDER_DIR_ORDER_TYPE_BRICKOWL, order->id, inv );
+  }
   if( retval )
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickOwl order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " at \"" IO_CYAN "%s" IO_DEFAULT "\".\n", (long long)order->id, newpath );
   else
@@ -945,6 +1276,9 @@ void bsDiskFreeSpaceCheck( bsContext *context )
 ////
 
 
+/* The benchmark build links every module and provides its own main() */
+#ifndef BS_BENCH_BUILD
+
 #if CC_UNIX
 
 volatile int unixSignalSIGUSR1 = 0;
@@ -1009,15 +1343,56 @@ static void windowsInitConsole()
 #endif
 
 
+/* One log line with the phases timed since the last cycle */
+static void bsLogProfileCycle( bsContext *context )
+{
+  int phaseindex, phasecount;
+  ccGrowth growth;
+  debugProfileStat *stat;
+  debugProfileStat statlist[BS_PROFILE_PHASE_MAX];
+
+  DEBUG_SET_TRACKER();
+
+  phasecount = debugProfileGetStats( statlist, BS_PROFILE_PHASE_MAX );
+  for( phaseindex = 0 ; phaseindex < phasecount ; phaseindex++ )
+  {
+    if( statlist[ phaseindex ].cyclecount )
+      break;
+  }
+  if( phaseindex == phasecount )
+    return;
+  if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_INFO ) )
+  {
+    ccGrowthInit( &growth, 512 );
+    for( phaseindex = 0 ; phaseindex < phasecount ; phaseindex++ )
+    {
+      stat = &statlist[ phaseindex ];
+      if( !( stat->cyclecount ) )
+        continue;
+      ccGrowthPrintf( &growth, "%s%s %.3f s", ( growth.offset ? ", " : "" ), stat->name, (double)stat->cycletotal / 1000000000.0 );
+      if( stat->cyclecount > 1 )
+        ccGrowthPrintf( &growth, " (" CC_LLD " runs)", (long long)stat->cyclecount );
+    }
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Cycle profile : %s.\n", growth.data );
+    ccGrowthFree( &growth );
+  }
+  debugProfileCycleReset();
+
+  return;
+}
+
+
 int main( int argc, char **argv )
 {
   int stateloaded, milliseconds, actionflag, workloop;
+  debugProfileScope profile;
   bsContext *context;
   void *exclperm;
   journalDef journal;
   bsxInventory *diffinv;
   cpuInfo cpuinfo;
   boUserDetails userdetails;
+  int64_t tracequerycount, tracemisscount;
 #if BS_ENABLE_ANTIDEBUG
   int statusflag;
   int (*volatile antidebuginit)( bsContext *context, cpuInfo *cpuinfo );
@@ -1041,6 +1416,9 @@ int main( int argc, char **argv )
 #if ENABLE_DEBUG_TRACKING
   debugTrackerInit( BS_DEBUG_TRACKER_WATCH_MILLISECONDS, BS_DEBUG_TRACKER_STALL_MILLISECONDS );
 #endif
+#if ENABLE_DEBUG_PROFILE
+  debugProfileInit();
+#endif
 
   /* Initiate threaded stdin */
   /* The only way to read from the keyboard with buffering without blocking on Windows. Blarggghhh */
@@ -1117,6 +1495,28 @@ int main( int argc, char **argv )
   /* Replay the journal and any pending operation */
   journalReplay( BS_JOURNAL_FILE );
 
+  /* Offline maintenance, performed without initializing any service */
+  if( ( argc >= 2 ) && ( ccStrLowCmpWord( argv[1], "compacttrs" ) ) )
+  {
+    int retval;
+    translationTable translationtable;
+    translationTableInit( &translationtable, BS_TRANSLATION_FILE, BS_TRANSLATION_INDEX_FILE );
+    retval = bsCompactTranslationTable( 0, &translationtable );
+    translationTableEnd( &translationtable );
+    exclPermStop( exclperm, BS_LOCK_FILE );
+    return ( retval ? 0 : 1 );
+  }
+  if( ( argc >= 3 ) && ( ccStrLowCmpWord( argv[1], "importtrs" ) ) )
+  {
+    int retval;
+    translationTable translationtable;
+    translationTableInit( &translationtable, BS_TRANSLATION_FILE, BS_TRANSLATION_INDEX_FILE );
+    retval = bsImportTranslationTable( 0, &translationtable, argv[2] );
+    translationTableEnd( &translationtable );
+    exclPermStop( exclperm, BS_LOCK_FILE );
+    return ( retval ? 0 : 1 );
+  }
+
 #if BS_ENABLE_LIMITS
   bsAntiDebugUnpack();
 #endif
@@ -1128,6 +1528,7 @@ int main( int argc, char **argv )
     bsFatalError( context );
     return 0;
   }
+  context->cpucorecount = cpuinfo.totalcorecount;
 
   DEBUG_SET_TRACKER();
 
@@ -1438,6 +1839,7 @@ int main( int argc, char **argv )
       /* BrickLink and/or BrickOwl order check */
       if( context->stateflags & ( BS_STATE_FLAGS_BRICKLINK_MUST_CHECK | BS_STATE_FLAGS_BRICKOWL_MUST_CHECK ) )
       {
+        DEBUG_PROFILE_BEGIN( &profile, "check" );
 #if BS_ENABLE_REGISTRATION
         if( !( context->contextflags & BS_CONTEXT_FLAGS_REGISTERED ) )
           bsCheckGlobal( context );
@@ -1451,6 +1853,7 @@ int main( int argc, char **argv )
 #else
         bsCheckGlobal( context );
 #endif
+        DEBUG_PROFILE_END( &profile );
       }
 
 #if BS_ENABLE_ANTIDEBUG
@@ -1505,6 +1908,7 @@ int main( int argc, char **argv )
         if( ( context->stateflags & ( BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE | BS_STATE_FLAGS_BRICKLINK_MUST_SYNC ) ) == BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE )
         {
           diffinv = context->bricklink.diffinv;
+          DEBUG_PROFILE_BEGIN( &profile, "bricklink_update" );
 #if BS_ENABLE_ANTIDEBUG
           if( blapplydiff( context, diffinv, 0 ) )
 #else
@@ -1530,6 +1934,7 @@ int main( int argc, char **argv )
           /* Empty the diff inventory, it's either fully applied or we need a deep sync */
           bsxEmptyInventory( context->bricklink.diffinv );
           context->stateflags &= ~BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE;
+          DEBUG_PROFILE_END( &profile );
           /* Save updated state flags */
           if( !( bsSaveState( context, 0 ) ) )
           {
@@ -1542,6 +1947,7 @@ int main( int argc, char **argv )
         if( ( context->stateflags & ( BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE | BS_STATE_FLAGS_BRICKOWL_MUST_SYNC | BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE | BS_STATE_FLAGS_BRICKLINK_MUST_SYNC ) ) == BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE )
         {
           diffinv = context->brickowl.diffinv;
+          DEBUG_PROFILE_BEGIN( &profile, "brickowl_update" );
 #if BS_ENABLE_ANTIDEBUG
           if( boapplydiff( context, diffinv, 0 ) )
 #else
@@ -1563,6 +1969,7 @@ int main( int argc, char **argv )
           /* Empty the diff inventory, it's either fully applied or we need a deep sync */
           bsxEmptyInventory( context->brickowl.diffinv );
           context->stateflags &= ~BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE;
+          DEBUG_PROFILE_END( &profile );
           /* Save updated state flags */
           if( !( bsSaveState( context, 0 ) ) )
           {
@@ -1579,6 +1986,7 @@ int main( int argc, char **argv )
         if( ( context->curtime > context->bricklink.synctime ) && ( context->stateflags & BS_STATE_FLAGS_BRICKLINK_MUST_SYNC ) )
         {
           bsClearBrickLinkXML( context );
+          DEBUG_PROFILE_BEGIN( &profile, "bricklink_sync" );
           if( bsSyncBrickLink( context, 0 ) )
           {
             context->stateflags &= ~( BS_STATE_FLAGS_BRICKLINK_MUST_SYNC | BS_STATE_FLAGS_BRICKLINK_PARTIAL_SYNC );
@@ -1592,6 +2000,7 @@ int main( int argc, char **argv )
             if( context->bricklink.syncdelay > BS_SYNC_DELAY_MAX )
               context->bricklink.syncdelay = BS_SYNC_DELAY_MAX;
           }
+          DEBUG_PROFILE_END( &profile );
           context->curtime = time( 0 );
           context->bricklink.synctime = context->curtime + context->bricklink.syncdelay;
           context->bricklink.lastsynctime = context->curtime;
@@ -1600,6 +2009,7 @@ int main( int argc, char **argv )
         /* BrickOwl inventory deep sync, only when none of BL_MUST_UPDATE | BL_MUST_SYNC is pending */
         if( ( context->curtime > context->brickowl.synctime ) && ( ( context->stateflags & ( BS_STATE_FLAGS_BRICKOWL_MUST_SYNC | BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE | BS_STATE_FLAGS_BRICKLINK_MUST_SYNC ) ) == BS_STATE_FLAGS_BRICKOWL_MUST_SYNC ) )
         {
+          DEBUG_PROFILE_BEGIN( &profile, "brickowl_sync" );
           if( bsSyncBrickOwl( context, 0 ) )
           {
             context->stateflags &= ~( BS_STATE_FLAGS_BRICKOWL_MUST_SYNC | BS_STATE_FLAGS_BRICKOWL_PARTIAL_SYNC );
@@ -1613,6 +2023,7 @@ int main( int argc, char **argv )
             if( context->brickowl.syncdelay > BS_SYNC_DELAY_MAX )
               context->brickowl.syncdelay = BS_SYNC_DELAY_MAX;
           }
+          DEBUG_PROFILE_END( &profile );
           context->curtime = time( 0 );
           context->brickowl.synctime = context->curtime + context->brickowl.syncdelay;
           context->brickowl.lastsynctime = context->curtime;
@@ -1620,6 +2031,13 @@ int main( int argc, char **argv )
 
       } while( workloop );
 
+      /* Background price guide refresh, only when no check, update or sync is pending */
+      if( !( context->stateflags & ( BS_STATE_FLAGS_BRICKLINK_MUST_CHECK | BS_STATE_FLAGS_BRICKOWL_MUST_CHECK | BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE | BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE | BS_STATE_FLAGS_BRICKLINK_MUST_SYNC | BS_STATE_FLAGS_BRICKOWL_MUST_SYNC ) ) )
+        bsPriceGuideRefreshTick( context );
+
+      /* Log where the time of this check/sync cycle went */
+      bsLogProfileCycle( context );
+
 #if BS_ENABLE_ANTIDEBUG
       /* Initialize some anti-debugging stuff */
       if( !( antidebuginit( context, &cpuinfo ) ) )
@@ -1631,7 +2049,8 @@ int main( int argc, char **argv )
 
     }
 
-    /* Make sure we have double line breaks before input */
+    /* Make sure we have double line breaks before input, wait for the log writer to update the console state */
+    ioLogFlush( &context->output );
     if( !( context->output.linemarker ) )
     {
       if( context->output.endlinecount < 2 )
@@ -1674,11 +2093,26 @@ int main( int argc, char **argv )
   bsxFreeInventory( context->bricklink.diffinv );
   bsxFreeInventory( context->brickowl.diffinv );
 
+  translationNegativeSave( &context->translationnegative );
+  translationNegativeEnd( &context->translationnegative );
   translationTableEnd( &context->translationtable );
+  bsPriceGuideRefreshFree( context );
+  bsOrderDirDiscard( context );
+  bsxPriceGuideDbClose( &context->priceguidedb );
+  free( context->priceguidedbpath );
 
   httpClose( context->bricklink.http );
   httpClose( context->bricklink.webhttp );
   httpClose( context->brickowl.http );
+  if( context->httptrace )
+  {
+    httpTraceGetCounts( context->httptrace, &tracequerycount, &tracemisscount );
+    if( context->httptracereplaypath )
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Replayed " IO_CYAN "%lld" IO_WHITE " HTTP queries, " IO_CYAN "%lld" IO_WHITE " had no recorded reply.\n", (long long)tracequerycount, (long long)tracemisscount );
+    else
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Recorded " IO_CYAN "%lld" IO_WHITE " HTTP queries to \"" IO_CYAN "%s" IO_WHITE "\".\n", (long long)tracequerycount, context->httptracerecordpath );
+    httpTraceClose( context->httptrace );
+  }
 
 #if BS_ENABLE_ANTIDEBUG
   if( !( statusflag ) )
@@ -1687,10 +2121,12 @@ int main( int argc, char **argv )
   ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Exiting now.\n" );
 
   ioLogEnd( &context->output );
+  bsMetricsEnd( context );
   tcpEnd( &context->tcp );
   exclPermStop( exclperm, BS_LOCK_FILE );
 
   return 1;
 }
+#endif
 
 
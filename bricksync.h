@@ -60,6 +60,8 @@
 #define BS_BRICKOWL_API_SERVER "api.brickowl.com"
 #define BS_BRICKSYNC_WEB_SERVER "www.bricksync.net"
 
+#define BS_METRICS_ADDRESS_DEFAULT "127.0.0.1"
+
 #define BS_GLOBAL_PATH "data" CC_DIR_SEPARATOR_STRING
 
 /* BrickSync file paths */
@@ -71,6 +73,10 @@
 #define BS_JOURNAL_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.journal"
 #define BS_LOCK_FILE BS_GLOBAL_PATH "bricksync.lock"
 #define BS_TRANSLATION_FILE BS_GLOBAL_PATH "bricksync.trs"
+#define BS_TRANSLATION_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.trs"
+#define BS_TRANSLATION_INDEX_FILE BS_GLOBAL_PATH "bricksync.trs.idx"
+#define BS_TRANSLATION_INDEX_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.trs.idx"
+#define BS_TRANSLATION_NEGATIVE_FILE BS_GLOBAL_PATH "bricksync.trs.neg"
 #define BS_CONFIGURATION_FILE BS_GLOBAL_PATH "bricksync.conf.txt"
 
 /* BrickSync directories and custom paths */
@@ -83,6 +89,10 @@
 #define BS_BRICKOWL_ORDER_DIR BS_GLOBAL_PATH "orders"
 #define BS_BRICKOWL_ORDER_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING "brickowl-%lld.bsx"
 #define BS_BRICKOWL_ORDER_TEMP_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING".temp.brickowl-%lld.bsx"
+#define BS_ORDER_INDEX_FILE BS_GLOBAL_PATH "bricksync.orders.idx"
+#define BS_ORDER_INDEX_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.orders.idx"
+#define BS_ORDER_MANIFEST_FILE BS_GLOBAL_PATH "bricksync.orders.manifest"
+#define BS_ORDER_MANIFEST_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.orders.manifest"
 #define BS_PRICEGUIDE_DIR BS_GLOBAL_PATH "pgcache"
 
 /* BrickSync XML output */
@@ -109,6 +119,10 @@
 #define BS_POLL_FAIL_INTERVAL_DEFAULT (5*60)
 #define BS_POLL_FAIL_INTERVAL_MIN (2*60)
 
+/* Retry delay of failed BOID lookups, doubled for each consecutive failure */
+#define BS_BRICKOWL_LOOKUP_RETRY_DEFAULT (12*60*60)
+#define BS_BRICKOWL_LOOKUP_RETRY_MAX (16*24*60*60)
+
 #define BS_SYNC_DELAY_BASE (30)
 #define BS_SYNC_DELAY_MAX (60*30)
 #define BS_SYNC_DELAY_FAIL_FACTOR (3)
@@ -121,6 +135,22 @@
 
 #define BS_PRICEGUIDE_CACHETIME_DEFAULT (5*24*60*60)
 
+/* Price guide cache lookups are spread over threads, each handling at least so many items */
+#define BS_PRICEGUIDE_LOOKUP_THREAD_MAX (16)
+#define BS_PRICEGUIDE_LOOKUP_THREAD_ITEMS (256)
+
+/* Background price guide refresh, entries are refreshed once older than a percentage of the cache time */
+#define BS_PRICEGUIDE_REFRESH_AGE_PERCENT (75)
+#define BS_PRICEGUIDE_REFRESH_TICK_INTERVAL (60)
+#define BS_PRICEGUIDE_REFRESH_SCAN_INTERVAL (60*60)
+#define BS_PRICEGUIDE_REFRESH_SCAN_CHUNK (1024)
+/* Fetches block the main loop, keep each tick short */
+#define BS_PRICEGUIDE_REFRESH_BATCH_MAX (16)
+/* Entries served stale to a command are refreshed first, within the same hourly budget */
+#define BS_PRICEGUIDE_REFRESH_PRIORITY_STALE (1.0e12)
+/* Hourly budget for entries served stale when priceguide.refreshbudget is zero */
+#define BS_PRICEGUIDE_REFRESH_STALE_BUDGET (240)
+
 /* Secret offset to be decrypted by registration key */
 #define BS_REGISTRATION_SECRET_OFFSET (0x9a6fc)
 
@@ -174,6 +204,34 @@
 #define BS_DEBUG_TRACKER_WATCH_MILLISECONDS (30*1000) /* check each 30 seconds */
 #define BS_DEBUG_TRACKER_STALL_MILLISECONDS (15*60*1000) /* 15 minutes */
 
+/* Maximum count of profiled phases reported by "profile", the cycle log and the metrics endpoint */
+#define BS_PROFILE_PHASE_MAX (64)
+
+/* Locations listed by "samples", and the file written by "samples save" */
+#define BS_SAMPLE_PRINT_MAX (40)
+#define BS_SAMPLE_LOCATION_MAX (4096)
+#define BS_SAMPLE_PROFILE_FILE "sampleprofile.txt"
+
+
+////
+
+
+/* Per-endpoint HTTP statistics, ranges are attached to bricklink.http, bricklink.webhttp and brickowl.http in that order */
+enum
+{
+  BS_HTTP_ENDPOINT_BRICKLINK_INVENTORIES,
+  BS_HTTP_ENDPOINT_BRICKLINK_ORDERS,
+  BS_HTTP_ENDPOINT_BRICKLINK_OTHER,
+
+  BS_HTTP_ENDPOINT_BRICKLINK_PRICEGUIDE,
+
+  BS_HTTP_ENDPOINT_BRICKOWL_INVENTORY_UPDATE,
+  BS_HTTP_ENDPOINT_BRICKOWL_ID_LOOKUP,
+  BS_HTTP_ENDPOINT_BRICKOWL_OTHER,
+
+  BS_HTTP_ENDPOINT_COUNT
+};
+
 
 ////
 
@@ -209,6 +267,12 @@ typedef struct
   char *consumersecret;
   char *token;
   char *tokensecret;
+  /* API server, only overridden to point at a simulator */
+  char *apiserver;
+  int apiport;
+  /* SSL to a configured API server : -1 for loopback hosts only, 0 never, 1 always */
+  int apissl;
+  int apihttpflags;
   /* IP text strings */
   char *apiaddress;
   char *webaddress;
@@ -252,6 +316,12 @@ typedef struct
 {
   /* Access credentials */
   char *key;
+  /* API server, only overridden to point at a simulator */
+  char *apiserver;
+  int apiport;
+  /* SSL to a configured API server : -1 for loopback hosts only, 0 never, 1 always */
+  int apissl;
+  int apihttpflags;
   /* IP text strings */
   char *apiaddress;
   /* API HTTP connection */
@@ -271,6 +341,8 @@ typedef struct
   time_t lastsynctime;
   /* Reuse BrickOwl existing lots with quantities of zero */
   int reuseemptyflag;
+  /* Base delay before retrying a failed BOID lookup, zero to always retry */
+  int lookupretry;
   /* Count of pending queries */
   int querycount;
   /* Update diff inventory when PENDING_UPDATE flag is set */
@@ -279,6 +351,50 @@ typedef struct
   bsApiHistory apihistory;
 } bsBrickOwl;
 
+
+typedef struct
+{
+  double priority;
+  /* Entry is refreshed unless the cached price guide is at least as recent */
+  int64_t updatetime;
+  int colorid;
+  char typeid;
+  char *id;
+} bsPriceGuideRefreshEntry;
+
+/* Background price guide refresh, entrylist is a binary heap ordered by priority */
+typedef struct
+{
+  /* Count of price guide fetches allowed per hour, zero disables */
+  int hourlybudget;
+  double budget;
+  int64_t budgettime;
+  int64_t ticktime;
+  int64_t scantime;
+  /* Inventory scan in progress, resumed at scanindex on the next tick */
+  int scanactiveflag;
+  int scanindex;
+  int entrycount;
+  int entryalloc;
+  bsPriceGuideRefreshEntry *entrylist;
+  /* Count of queued entries with BS_PRICEGUIDE_REFRESH_PRIORITY_STALE */
+  int stalecount;
+  int refreshcount;
+} bsPriceGuideRefresh;
+
+/* Counters for the Prometheus metrics endpoint */
+typedef struct
+{
+  /* Listening interface address and port, zero disables the endpoint */
+  char *address;
+  int port;
+  tcpLink *listenlink;
+  int64_t scrapecount;
+  /* Query results by HTTP_RESULT_* code, and connection errors */
+  int64_t resultcount[HTTP_RESULT_COUNT];
+  int64_t connerrorcount;
+} bsMetrics;
+
 #define BS_CWD_PATH_MAX (1024)
 
 typedef struct
@@ -304,6 +420,16 @@ typedef struct
   char *priceguidepath;
   int priceguideflags;
   int priceguidecachetime;
+  /* Serve outdated cache entries immediately and refresh them in the background */
+  int priceguideservestaleflag;
+  /* Single-file cache, with BSX_PRICEGUIDE_FLAGS_DATABASE */
+  char *priceguidedbpath;
+  bsxPriceGuideDb priceguidedb;
+  /* Idle-time refresh of the cache for tracked lots */
+  bsPriceGuideRefresh pgrefresh;
+
+  /* Count of CPU cores for worker threads */
+  int cpucorecount;
 
   /* User options */
   int retainemptylotsflag;
@@ -358,6 +484,8 @@ typedef struct
 
   /* BLID <-> BOID Translation Table */
   translationTable translationtable;
+  /* Failed BLID -> BOID lookups */
+  translationNegative translationnegative;
 
 #if BS_ENABLE_ANTIDEBUG
   int64_t antidebugtimediff;
@@ -394,8 +522,33 @@ typedef struct
   /* Free disk space check */
   time_t diskspacechecktime;
 
-  /* Search time for "findorder" */
+  /* Search time for "findorder", orders saved more recently than findorderskiptime are skipped */
   int64_t findordertime;
+  int64_t findorderskiptime;
+
+  /* Order index and manifest records of saved orders, appended by bsOrderDirCommit() once the journal moved the order files in place */
+  ccGrowth orderindexpending;
+  ccGrowth ordermanifestpending;
+  /* Size of the order index when last checked or written, records appended since and orders indexed at the check */
+  size_t orderindexsize;
+  int orderindexappendcount;
+  int orderindexlivecount;
+
+  /* Metrics endpoint */
+  bsMetrics metrics;
+
+  /* Sampling profiler rate in samples per second, zero disables it */
+  int samplerate;
+
+  /* Per-endpoint HTTP statistics, BS_HTTP_ENDPOINT_xxx */
+  httpEndpointStats httpstats[BS_HTTP_ENDPOINT_COUNT];
+
+  /* HTTP traffic trace being recorded or replayed, httptrace.record or httptrace.replay */
+  char *httptracerecordpath;
+  char *httptracereplaypath;
+  /* Percentage of the recorded reply delays applied when replaying */
+  int httptracereplaytime;
+  httpTrace *httptrace;
 
 #if BS_ENABLE_MATHPUZZLE
   bsPuzzleAnswer puzzleanswer;
@@ -522,9 +675,15 @@ void bsFreeReply( bsContext *context, bsQueryReply *reply );
 void bsBrickLinkAddQuery( bsContext *context, char *methodstring, char *pathstring, char *paramstring, char *bodystring, void *uservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ) );
 void bsBrickOwlAddQuery( bsContext *context, char *querystring, int httpflags, void *uservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ) );
 
+/* Attach per-endpoint statistics and the HTTP trace to the BrickLink and BrickOwl HTTP connections */
+void bsAttachHttpStats( bsContext *context );
+
 /* Flush tcp callbacks and process all http connections */
 void bsFlushTcpProcessHttp( bsContext *context );
 
+/* Wait for network events, or until the next replayed HTTP reply is due */
+void bsWaitTcp( bsContext *context );
+
 /* Wait until pending HTTP queries have been completed */
 void bsWaitBrickLinkQueries( bsContext *context, int maxpending );
 void bsWaitBrickLinkWebQueries( bsContext *context, int maxpending );
@@ -582,6 +741,11 @@ int bsStoreError( bsContext *context, char *errortype, char *header, size_t head
 int bsSaveInventory( bsContext *context, journalDef *journal );
 int bsSaveState( bsContext *context, journalDef *journal );
 
+/* Rewrite the translation database with only its live entries */
+int bsCompactTranslationTable( ioLog *log, translationTable *table );
+/* Import a BLID <-> BOID mapping from a BrickOwl catalog export (JSON) or a CSV file */
+int bsImportTranslationTable( ioLog *log, translationTable *table, char *path );
+
 
 
 /* Defined in bricsyncinit.c */
@@ -794,6 +958,14 @@ int bsApiHistoryCountPeriod( bsApiHistory *history, int64_t seconds );
 
 
 
+/* Defined in bsmetrics.c */
+
+/* Open the metrics listener if metrics.port is set */
+int bsMetricsInit( bsContext *context );
+void bsMetricsEnd( bsContext *context );
+
+
+
 /* Defined in bsfetchset.c */
 
 /* Fetch the inventory for a set ID */
@@ -818,19 +990,17 @@ int bsOutputBrickLinkXML( bsContext *context, bsxInventory *inv, int apiwarningf
 
 typedef struct
 {
-  int quantity;
   double value;
-  double sale;
-  double price;
-  double pgq;
-  double pgp;
-  int stockflag;
   int itemindex;
+  /* Row of the accepted alternate, dropped if a cheaper one replaces it */
+  int rowindex;
 } bsPriceGuideAlt;
 
 typedef struct
 {
   bsxInventory *inv;
+  /* Cache time of the command, older price guide data is reported as stale */
+  int cachetime;
   int showaltflag;
   int removealtflag;
   int altcount;
@@ -857,11 +1027,42 @@ typedef struct
   double totalprice;
   double totalpgq;
   double totalpgp;
+
+  /* Lots evaluated with price guide data older than the cache time */
+  int stalelots;
+
+  /* One row per lot summed, reduced to the totals above by bsPriceGuideFinishState() */
+  int rowcount;
+  int rowalloc;
+  int *rowquantity;
+  char *rowcategory;
+  double *rowvalue;
+  double *rowsale;
+  double *rowprice;
+  /* Value-weighted pgq and pgp */
+  double *rowpgq;
+  double *rowpgp;
 } bsPriceGuideState;
 
+/* Callback pointer of bsPriceGuideListRangeCallback() */
+typedef struct
+{
+  float listrange[2];
+  int cachetime;
+} bsPriceGuideListRange;
+
 int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cachetime, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) );
 
-void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int showaltflag, int removealtflag );
+/* Read or write the price guide of item in the cache, whatever its storage format */
+int bsPriceGuideCacheRead( bsContext *context, bsxItem *item, bsxPriceGuide *pg );
+int bsPriceGuideCacheWrite( bsContext *context, bsxItem *item, bsxPriceGuide *pgnew, bsxPriceGuide *pgused );
+
+/* Refresh a few stale price guide entries of tracked lots, called from the main loop when idle */
+void bsPriceGuideRefreshTick( bsContext *context );
+void bsPriceGuideRefreshQueueItem( bsContext *context, bsxItem *item, int cachetime );
+void bsPriceGuideRefreshFree( bsContext *context );
+
+void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int cachetime, int showaltflag, int removealtflag );
 void bsPriceGuideFinishState( bsPriceGuideState *pgstate );
 void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
 void bsPriceGuideListRangeCallback( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
@@ -950,6 +1151,10 @@ typedef struct
   time_t filetime;
   int ordertype;
   int orderid;
+  /* From the manifest, -1 when unknown */
+  int lotcount;
+  int partcount;
+  double grandtotal;
 } bsOrderDirEntry;
 
 typedef struct
@@ -959,10 +1164,49 @@ typedef struct
   int entryalloc;
 } bsOrderDir;
 
+/* Read entries of saved orders from the manifest, the first call scans the orders directory to create it */
 int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime );
+/* Same, only orders saved after ordermintime and up to ordermaxtime, zero for no upper limit */
+int bsReadOrderDirRange( bsContext *context, bsOrderDir *orderdir, time_t ordermintime, time_t ordermaxtime );
+/* Queue a saved order for the manifest, the record is held until bsOrderDirCommit() */
+int bsOrderManifestQueue( bsContext *context, int ordertype, bsOrder *order, bsxInventory *inv );
 void bsFreeOrderDir( bsContext *context, bsOrderDir *orderdir );
 void bsSortOrderDir( bsContext *context, bsOrderDir *orderdir );
 
+/* Search index of saved orders, records are appended as orders are saved and the last one for an order prevails */
+typedef struct
+{
+  void *data;
+  size_t datasize;
+  void **slottable;
+  uint32_t hashmask;
+  /* Count of orders indexed, and of stored records including superseded ones */
+  int recordcount;
+  int storedcount;
+} bsOrderIndex;
+
+enum
+{
+  /* Order can not match the search terms */
+  BS_ORDER_INDEX_NOMATCH,
+  /* Order may match, the inventory must be searched */
+  BS_ORDER_INDEX_CANDIDATE,
+  /* Order is not indexed */
+  BS_ORDER_INDEX_MISSING
+};
+
+/* Append a record for the order inventory to the search index */
+int bsOrderIndexAdd( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv );
+/* Same, for an order file queued in a journal, the record is held until bsOrderDirCommit() */
+int bsOrderIndexQueue( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv );
+/* Append the records held for saved orders once their journal is executed, or discard them */
+void bsOrderDirCommit( bsContext *context );
+void bsOrderDirDiscard( bsContext *context );
+int bsOrderIndexLoad( bsOrderIndex *orderindex, char *path );
+void bsOrderIndexFree( bsOrderIndex *orderindex );
+/* Returns a BS_ORDER_INDEX_* code for the search terms, a negative int or float term is ignored */
+int bsOrderIndexMatch( bsOrderIndex *orderindex, int ordertype, int64_t orderid, int termcount, char **termstring, int64_t *termint, float *termfloat );
+
 enum
 {
   BS_ORDER_DIR_ORDER_TYPE_BRICKLINK,
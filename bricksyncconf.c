@@ -273,7 +273,7 @@ static int bsConfReadInteger( bsContext *context, bsConfParser *parser, int *ret
 
 static int bsConfParse( bsContext *context, bsConfParser *parser )
 {
-  int linecount, lineoffset, readint;
+  int linecount, lineoffset, readint, logcategory, loglevel;
   char *tokenstring;
   char *readstring;
   vtToken *token;
@@ -347,6 +347,23 @@ static int bsConfParse( bsContext *context, bsConfParser *parser )
             goto error;
           context->bricklink.pipelinequeuesize = (int)readint;
         }
+        else if( ccStrMatchSeq( "apiserver", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadString( context, parser, &context->bricklink.apiserver ) ) )
+            goto error;
+        }
+        else if( ccStrMatchSeq( "apiport", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->bricklink.apiport = (int)readint;
+        }
+        else if( ccStrMatchSeq( "apissl", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->bricklink.apissl = ( readint ? 1 : 0 );
+        }
         else
         {
           bsConfErrorUnknownScopeMember( context, parser, token );
@@ -389,12 +406,35 @@ static int bsConfParse( bsContext *context, bsConfParser *parser )
             goto error;
           context->brickowl.pipelinequeuesize = (int)readint;
         }
+        else if( ccStrMatchSeq( "apiserver", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadString( context, parser, &context->brickowl.apiserver ) ) )
+            goto error;
+        }
+        else if( ccStrMatchSeq( "apiport", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->brickowl.apiport = (int)readint;
+        }
+        else if( ccStrMatchSeq( "apissl", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->brickowl.apissl = ( readint ? 1 : 0 );
+        }
         else if( ccStrMatchSeq( "reuseempty", tokenstring, token->length ) )
         {
           if( !( bsConfReadInteger( context, parser, &readint ) ) )
             goto error;
           context->brickowl.reuseemptyflag = (int)readint;
         }
+        else if( ccStrMatchSeq( "lookupretry", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->brickowl.lookupretry = (int)readint;
+        }
         else
         {
           bsConfErrorUnknownScopeMember( context, parser, token );
@@ -428,6 +468,8 @@ static int bsConfParse( bsContext *context, bsConfParser *parser )
             context->priceguideflags = BSX_PRICEGUIDE_FLAGS_BRICKSTORE;
           else if( ccStrLowCmpWord( readstring, "brickstock" ) )
             context->priceguideflags = BSX_PRICEGUIDE_FLAGS_BRICKSTOCK;
+          else if( ccStrLowCmpWord( readstring, "bricksync" ) )
+            context->priceguideflags = BSX_PRICEGUIDE_FLAGS_DATABASE;
           else
           {
             linecount = bsConfResolveLine( context, parser, &lineoffset );
@@ -443,6 +485,149 @@ static int bsConfParse( bsContext *context, bsConfParser *parser )
             goto error;
           context->priceguidecachetime = 24*60*60 * (int)readint;
         }
+        else if( ccStrMatchSeq( "servestale", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->priceguideservestaleflag = (int)readint;
+        }
+        else if( ccStrMatchSeq( "refreshbudget", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->pgrefresh.hourlybudget = (int)readint;
+        }
+        else
+        {
+          bsConfErrorUnknownScopeMember( context, parser, token );
+          goto error;
+        }
+      }
+      else if( ccStrMatchSeq( "log", tokenstring, token->length ) )
+      {
+        if( !( vtTokenExpect( parser, VT_TOKEN_DOT ) ) )
+        {
+          bsConfErrorScopeEntryFailure( context, parser );
+          goto error;
+        }
+        if( !( token = vtTokenExpect( parser, VT_TOKEN_IDENTIFIER ) ) )
+        {
+          bsConfErrorScopeMemberFailure( context, parser );
+          goto error;
+        }
+        tokenstring = &parser->codestring[ token->offset ];
+        if( ccStrMatchSeq( "level", tokenstring, token->length ) )
+          logcategory = -1;
+        else if( ccStrMatchSeq( "sync", tokenstring, token->length ) )
+          logcategory = IO_LOG_CATEGORY_SYNC;
+        else if( ccStrMatchSeq( "apply", tokenstring, token->length ) )
+          logcategory = IO_LOG_CATEGORY_APPLY;
+        else if( ccStrMatchSeq( "net", tokenstring, token->length ) )
+          logcategory = IO_LOG_CATEGORY_NET;
+        else if( ccStrMatchSeq( "order", tokenstring, token->length ) )
+          logcategory = IO_LOG_CATEGORY_ORDER;
+        else
+        {
+          bsConfErrorUnknownScopeMember( context, parser, token );
+          goto error;
+        }
+        readstring = 0;
+        if( !( bsConfReadString( context, parser, &readstring ) ) )
+          goto error;
+        loglevel = ioLogParseLevel( readstring );
+        free( readstring );
+        if( loglevel < -1 )
+        {
+          linecount = bsConfResolveLine( context, parser, &lineoffset );
+          ioPrintf( &context->output, 0, BSMSG_ERROR "Unknown log level at " IO_CYAN "%d" IO_WHITE ", offset " IO_CYAN "%d" IO_WHITE ", expected \"off\", \"error\", \"warning\", \"info\", \"verbose\" or \"debug\".\n", linecount, lineoffset );
+          goto error;
+        }
+        ioLogSetLevel( &context->output, logcategory, loglevel );
+      }
+      else if( ccStrMatchSeq( "metrics", tokenstring, token->length ) )
+      {
+        if( !( vtTokenExpect( parser, VT_TOKEN_DOT ) ) )
+        {
+          bsConfErrorScopeEntryFailure( context, parser );
+          goto error;
+        }
+        if( !( token = vtTokenExpect( parser, VT_TOKEN_IDENTIFIER ) ) )
+        {
+          bsConfErrorScopeMemberFailure( context, parser );
+          goto error;
+        }
+        tokenstring = &parser->codestring[ token->offset ];
+        if( ccStrMatchSeq( "port", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->metrics.port = (int)readint;
+        }
+        else if( ccStrMatchSeq( "address", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadString( context, parser, &context->metrics.address ) ) )
+            goto error;
+        }
+        else
+        {
+          bsConfErrorUnknownScopeMember( context, parser, token );
+          goto error;
+        }
+      }
+      else if( ccStrMatchSeq( "httptrace", tokenstring, token->length ) )
+      {
+        if( !( vtTokenExpect( parser, VT_TOKEN_DOT ) ) )
+        {
+          bsConfErrorScopeEntryFailure( context, parser );
+          goto error;
+        }
+        if( !( token = vtTokenExpect( parser, VT_TOKEN_IDENTIFIER ) ) )
+        {
+          bsConfErrorScopeMemberFailure( context, parser );
+          goto error;
+        }
+        tokenstring = &parser->codestring[ token->offset ];
+        if( ccStrMatchSeq( "record", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadString( context, parser, &context->httptracerecordpath ) ) )
+            goto error;
+        }
+        else if( ccStrMatchSeq( "replay", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadString( context, parser, &context->httptracereplaypath ) ) )
+            goto error;
+        }
+        else if( ccStrMatchSeq( "replaytime", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->httptracereplaytime = (int)CC_MIN( CC_MAX( readint, 0 ), 1000 );
+        }
+        else
+        {
+          bsConfErrorUnknownScopeMember( context, parser, token );
+          goto error;
+        }
+      }
+      else if( ccStrMatchSeq( "debug", tokenstring, token->length ) )
+      {
+        if( !( vtTokenExpect( parser, VT_TOKEN_DOT ) ) )
+        {
+          bsConfErrorScopeEntryFailure( context, parser );
+          goto error;
+        }
+        if( !( token = vtTokenExpect( parser, VT_TOKEN_IDENTIFIER ) ) )
+        {
+          bsConfErrorScopeMemberFailure( context, parser );
+          goto error;
+        }
+        tokenstring = &parser->codestring[ token->offset ];
+        if( ccStrMatchSeq( "samplerate", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->samplerate = (int)CC_MIN( CC_MAX( readint, 0 ), 1000 );
+        }
         else
         {
           bsConfErrorUnknownScopeMember( context, parser, token );
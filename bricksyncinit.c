@@ -107,6 +107,7 @@ int bsInitBrickLink( bsContext *context )
     return 0;
   }
   bsxFreeInventory( context->inventory );
+  bsxDetachInventoryArena( inv );
   context->inventory = inv;
 
   /* BrickLink inventory is now the tracked inventory */
@@ -137,6 +138,8 @@ int bsInitBrickLink( bsContext *context )
 
   /* Execute the journal's pending rename() operations for all BrickLink orders */
   retval = journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, journal.entryarray, journal.entrycount );
+  if( retval )
+    bsOrderDirCommit( context );
 
 #if BS_ENABLE_DEBUG_OUTPUT
   ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Pending journal executed.\n" );
@@ -168,6 +171,7 @@ int bsInitBrickLink( bsContext *context )
   error:
   journalFree( &journal );
   error2:
+  bsOrderDirDiscard( context );
   blFreeOrderList( &orderlist );
   return 0;
 }
@@ -428,6 +432,7 @@ int bsInitBrickOwl( bsContext *context )
       goto error;
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "BrickOwl ApplyDiff() did not complete successfully, starting over.\n" );
     journalFree( &journal );
+    bsOrderDirDiscard( context );
     boFreeOrderList( &orderlist );
   }
 
@@ -436,6 +441,7 @@ int bsInitBrickOwl( bsContext *context )
   journalFree( &journal );
   if( !( retval ) )
     goto error3;
+  bsOrderDirCommit( context );
   if( context->brickowl.ordertopdate <= orderlist.topdate )
     context->brickowl.ordertopdate = orderlist.topdate + 1;
   boFreeOrderList( &orderlist );
@@ -450,6 +456,7 @@ int bsInitBrickOwl( bsContext *context )
   error2:
   boFreeOrderList( &orderlist );
   error3:
+  bsOrderDirDiscard( context );
   if( inv )
     bsxFreeInventory( inv );
   if( deltainv )
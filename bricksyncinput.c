@@ -331,6 +331,9 @@ typedef struct
   float findfloat[BS_COMMAND_FIND_MAX];
   char *findstring[BS_COMMAND_FIND_MAX];
   int activeitemindex;
+  /* Candidate items from the text index, -1 to scan all items */
+  int candidatecount;
+  int *candidatelist;
 } bsCmdFind;
 
 static void bsCmdFindInit( bsCmdFind *cmdfind, int findcount, char **findterms )
@@ -355,6 +358,25 @@ static void bsCmdFindInit( bsCmdFind *cmdfind, int findcount, char **findterms )
   }
   cmdfind->findcount = findindex;
   cmdfind->activeitemindex = 0;
+  cmdfind->candidatecount = -1;
+  cmdfind->candidatelist = 0;
+  return;
+}
+
+/* Narrow the search to candidates from the inventory's text index, only the non-numerical terms can be used */
+static void bsCmdFindPlan( bsCmdFind *cmdfind, bsxInventory *inv )
+{
+  int findindex, termcount;
+  char *termlist[BS_COMMAND_FIND_MAX];
+
+  termcount = 0;
+  for( findindex = 0 ; findindex < cmdfind->findcount ; findindex++ )
+  {
+    if( ( cmdfind->findint[findindex] < 0 ) && ( cmdfind->findfloat[findindex] < 0.0 ) )
+      termlist[ termcount++ ] = cmdfind->findstring[findindex];
+  }
+  if( termcount )
+    cmdfind->candidatecount = bsxTextIndexQuery( inv, termcount, termlist, &cmdfind->candidatelist );
   return;
 }
 
@@ -364,64 +386,88 @@ static void bsCmdFindReset( bsCmdFind *cmdfind )
   return;
 }
 
+static void bsCmdFindFree( bsCmdFind *cmdfind )
+{
+  if( cmdfind->candidatelist )
+    free( cmdfind->candidatelist );
+  cmdfind->candidatelist = 0;
+  cmdfind->candidatecount = -1;
+  return;
+}
+
+static int bsCmdFindItem( bsCmdFind *cmdfind, bsxItem *item )
+{
+  int findindex, matchmask, matchpartmask;
+
+  matchmask = 0;
+  for( findindex = 0 ; findindex < cmdfind->findcount ; findindex++ )
+  {
+    matchpartmask = 0;
+    if( ccStrFindStr( item->id, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_BLID;
+    if( ccStrFindStr( item->name, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_NAME;
+    if( ccStrFindStr( item->typename, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_TYPENAME;
+    if( ccStrFindStr( item->colorname, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_COLORNAME;
+    if( ccStrFindStr( item->categoryname, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_CATEGORYNAME;
+    if( ccStrFindStr( item->comments, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_COMMENTS;
+    if( ccStrFindStr( item->remarks, cmdfind->findstring[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_REMARKS;
+    if( cmdfind->findint[findindex] >= 0 )
+    {
+      if( item->boid == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_BOID;
+      if( item->colorid == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_BLCOLORID;
+      if( bsTranslateColorBl2Bo( item->colorid ) == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_BOCOLORID;
+      if( item->quantity == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_QUANTITY;
+      if( item->lotid == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_BLLOTID;
+      if( item->bolotid == cmdfind->findint[findindex] )
+        matchpartmask |= BS_PRINT_ITEM_BOLD_BOLOTID;
+    }
+    if( ( cmdfind->findfloat[findindex] >= 0.0 ) && bsInvPriceEqual( item->price, cmdfind->findfloat[findindex] ) )
+      matchpartmask |= BS_PRINT_ITEM_BOLD_PRICE;
+    if( !( matchpartmask ) )
+      return 0;
+    matchmask |= matchpartmask;
+  }
+
+  return matchmask;
+}
+
 static bsxItem *bsCmdFindInv( bsCmdFind *cmdfind, bsxInventory *inv, int *retmatchmask )
 {
-  int itemindex, findindex, matchcount, matchmask, matchpartmask;
+  int itemindex, matchmask;
   bsxItem *item;
 
-  itemindex = cmdfind->activeitemindex;
-
-  item = &inv->itemlist[ itemindex ];
-  for( ; itemindex < inv->itemcount ; itemindex++, item++ )
+  for( ; ; cmdfind->activeitemindex++ )
   {
-    if( item->flags & BSX_ITEM_FLAGS_DELETED )
-      continue;
-    matchcount = 0;
-
-    matchmask = 0;
-    for( findindex = 0 ; findindex < cmdfind->findcount ; findindex++ )
+    if( cmdfind->candidatecount >= 0 )
     {
-      matchpartmask = 0;
-      if( ccStrFindStr( item->id, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_BLID;
-      if( ccStrFindStr( item->name, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_NAME;
-      if( ccStrFindStr( item->typename, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_TYPENAME;
-      if( ccStrFindStr( item->colorname, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_COLORNAME;
-      if( ccStrFindStr( item->categoryname, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_CATEGORYNAME;
-      if( ccStrFindStr( item->comments, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_COMMENTS;
-      if( ccStrFindStr( item->remarks, cmdfind->findstring[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_REMARKS;
-      if( cmdfind->findint[findindex] >= 0 )
-      {
-        if( item->boid == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_BOID;
-        if( item->colorid == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_BLCOLORID;
-        if( bsTranslateColorBl2Bo( item->colorid ) == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_BOCOLORID;
-        if( item->quantity == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_QUANTITY;
-        if( item->lotid == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_BLLOTID;
-        if( item->bolotid == cmdfind->findint[findindex] )
-          matchpartmask |= BS_PRINT_ITEM_BOLD_BOLOTID;
-      }
-      if( ( cmdfind->findfloat[findindex] >= 0.0 ) && bsInvPriceEqual( item->price, cmdfind->findfloat[findindex] ) )
-        matchpartmask |= BS_PRINT_ITEM_BOLD_PRICE;
-      if( !( matchpartmask ) )
+      if( cmdfind->activeitemindex >= cmdfind->candidatecount )
         break;
-      matchmask |= matchpartmask;
-      matchcount++;
+      itemindex = cmdfind->candidatelist[ cmdfind->activeitemindex ];
     }
-
-    if( ( matchcount == cmdfind->findcount ) && ( matchmask ) )
+    else
+    {
+      if( cmdfind->activeitemindex >= inv->itemcount )
+        break;
+      itemindex = cmdfind->activeitemindex;
+    }
+    item = &inv->itemlist[ itemindex ];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    matchmask = bsCmdFindItem( cmdfind, item );
+    if( matchmask )
     {
-      cmdfind->activeitemindex = itemindex + 1;
+      cmdfind->activeitemindex++;
       if( retmatchmask )
         *retmatchmask = matchmask;
       return item;
@@ -871,14 +917,23 @@ void bsSetStartupTime() {
     assert(ret);
 }
 
+static double bsStatusAverageMsecs( httpTimeStats *stats )
+{
+  return ( stats->count ? (double)stats->total / ( 1000000.0 * (double)stats->count ) : 0.0 );
+}
+
 void bsCommandStatus( bsContext *context, int argc, char **argv )
 {
-  int cmdflags;
+  int cmdflags, index;
   int64_t freediskspace;
   bsxInventory *inv, *deltainv;
   ccGrowth growth;
   char *colorstring;
   float apihistoryratio;
+  httpEndpointStats *endpoint;
+#if MM_ACCOUNT
+  mmAccountStats accountstats;
+#endif
 
 
   if( !( bsCmdArgStdParse( context, argc, argv, 0, 0, 0, &cmdflags, BS_COMMAND_ARGSTD_FLAG_SHORT ) ) )
@@ -941,6 +996,25 @@ void bsCommandStatus( bsContext *context, int argc, char **argv )
     colorstring = IO_GREEN;
   ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink API usage : " "%s" "%d" IO_DEFAULT " (" "%s" "%.2f%%" IO_DEFAULT ") in the past 24 hours; " "%s" "%d" IO_DEFAULT " in the past hour.\n", colorstring, (int)context->bricklink.apihistory.total, colorstring, 100.0 * apihistoryratio, colorstring, bsApiHistoryCountPeriod( &context->bricklink.apihistory, 3600 ) );
   ioPrintf( &context->output, 0, BSMSG_INFO "BrickOwl API usage  : " IO_GREEN "%d" IO_DEFAULT " in the past 24 hours; " IO_GREEN "%d" IO_DEFAULT " in the past hour.\n", (int)context->brickowl.apihistory.total, bsApiHistoryCountPeriod( &context->brickowl.apihistory, 3600 ) );
+  if( ( context->metrics.listenlink ) && !( cmdflags & BS_COMMAND_ARGSTD_FLAG_SHORT ) )
+    ioPrintf( &context->output, 0, BSMSG_INFO "Metrics endpoint : port " IO_GREEN "%d" IO_DEFAULT ", " IO_GREEN CC_LLD IO_DEFAULT " scrapes served.\n", context->metrics.port, (long long)context->metrics.scrapecount );
+  if( !( cmdflags & BS_COMMAND_ARGSTD_FLAG_SHORT ) )
+  {
+    for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    {
+      endpoint = &context->httpstats[index];
+      if( !( endpoint->querycount ) )
+        continue;
+      ioPrintf( &context->output, 0, BSMSG_INFO "HTTP " IO_CYAN "%s" IO_DEFAULT " : " IO_GREEN CC_LLD IO_DEFAULT " queries, " IO_GREEN CC_LLD IO_DEFAULT " failed; wait " IO_GREEN "%.0f ms" IO_DEFAULT ", first byte " IO_GREEN "%.0f ms" IO_DEFAULT " (max %.0f ms), transfer " IO_GREEN "%.0f ms" IO_DEFAULT "; body " IO_GREEN "%.1f kB" IO_DEFAULT "; 2xx " CC_LLD ", 4xx " CC_LLD ", 5xx " CC_LLD ".\n", endpoint->name, (long long)endpoint->querycount, (long long)( endpoint->querycount - endpoint->resultcount[HTTP_RESULT_SUCCESS] ), bsStatusAverageMsecs( &endpoint->queuewait ), bsStatusAverageMsecs( &endpoint->firstbyte ), (double)endpoint->firstbyte.max / 1000000.0, bsStatusAverageMsecs( &endpoint->transfer ), ( endpoint->resultcount[HTTP_RESULT_SUCCESS] ? (double)endpoint->bodysizetotal / ( 1024.0 * (double)endpoint->resultcount[HTTP_RESULT_SUCCESS] ) : 0.0 ), (long long)endpoint->httpclasscount[2], (long long)endpoint->httpclasscount[4], (long long)endpoint->httpclasscount[5] );
+    }
+#if MM_ACCOUNT
+    for( index = 0 ; index < MM_ACCOUNT_COUNT ; index++ )
+    {
+      mmAccountGetStats( index, &accountstats );
+      ioPrintf( &context->output, 0, BSMSG_INFO "Memory " IO_CYAN "%s" IO_DEFAULT " : " IO_GREEN "%.1f kB" IO_DEFAULT " live, peak " IO_GREEN "%.1f kB" IO_DEFAULT ".\n", mmAccountGetName( index ), (double)accountstats.livebytes / 1024.0, (double)accountstats.peakbytes / 1024.0 );
+    }
+#endif
+  }
 
   freediskspace = ccGetFreeDiskSpace( BS_BACKUP_DIR );
   if( freediskspace >= 0 )
@@ -972,7 +1046,7 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "General commands:\n" IO_DEFAULT );
     //ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about message runfile backup quit prunebackups resetapihistory" IO_DEFAULT "\n" );
-    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about runfile backup quit prunebackups resetapihistory" IO_DEFAULT "\n" );
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about runfile backup quit prunebackups resetapihistory compacttrs importtrs importpg exportpg profile samples" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Inventory management commands:\n" IO_DEFAULT );
     ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "sort blmaster add sub loadprices loadnotes loadmycost loadall merge invblxml invmycost setallremarksfromblid" IO_DEFAULT "\n" );
@@ -1072,6 +1146,40 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "The command resets the history of API calls to zero.\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink claims to have a limit of 5000 calls per day, although some experiments suggest otherwise. Use with caution.\n" );
   }
+  else if( ccStrLowCmpWord( argv[1], "profile" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "profile " IO_MAGENTA "[reset]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command lists the time spent in each phase of BrickSync's operation : count of runs, total time, median, 95th percentile and maximum duration.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Use \"" IO_CYAN "profile reset" IO_DEFAULT "\" to clear all accumulated timings.\n" );
+  }
+  else if( ccStrLowCmpWord( argv[1], "samples" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "samples " IO_MAGENTA "[start [rate]|stop|reset|save]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The sampling profiler periodically records the source location each thread of BrickSync last reported, building a flat profile of where time is spent.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Without argument, the command lists the most sampled locations. Use " IO_MAGENTA "start" IO_DEFAULT " with an optional count of samples per second, " IO_MAGENTA "stop" IO_DEFAULT " to pause sampling, " IO_MAGENTA "reset" IO_DEFAULT " to clear the samples and " IO_MAGENTA "save" IO_DEFAULT " to write all locations to \"" IO_CYAN BS_SAMPLE_PROFILE_FILE IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The sampling rate can be set at startup with the " IO_GREEN "debug.samplerate" IO_DEFAULT " configuration option.\n" );
+  }
+  else if( ccStrLowCmpWord( argv[1], "compacttrs" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "compacttrs" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command rewrites BrickSync's translation cache with only its live " IO_GREEN "BLID" IO_DEFAULT " <-> " IO_GREEN "BOID" IO_DEFAULT " entries, dropping superseded records.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The same operation can be performed offline by launching BrickSync as \"" IO_CYAN "bricksync compacttrs" IO_DEFAULT "\".\n" );
+  }
+  else if( ccStrLowCmpWord( argv[1], "importpg" ) || ccStrLowCmpWord( argv[1], "exportpg" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "importpg [brickstore|brickstock] [PriceGuideCachePath]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "exportpg [brickstore|brickstock] [PriceGuideCachePath]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The commands copy price guide data between BrickSync's single-file price guide cache and a BrickStore or BrickStock price guide cache directory.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The single-file cache is used when " IO_WHITE "priceguide.cacheformat" IO_DEFAULT " is set to \"" IO_CYAN "BrickSync" IO_DEFAULT "\", the directory defaults to " IO_WHITE "priceguide.cachepath" IO_DEFAULT ".\n" );
+  }
+  else if( ccStrLowCmpWord( argv[1], "importtrs" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "importtrs SomeMappingFile" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command imports " IO_GREEN "BLID" IO_DEFAULT " <-> " IO_GREEN "BOID" IO_DEFAULT " mappings into BrickSync's translation cache, so that these BLIDs don't need to be looked up through the BrickOwl API.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The file can be a BrickOwl catalog export in JSON, with BLIDs listed as " IO_WHITE "bl_item_no" IO_DEFAULT " ids.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "It can also be a CSV file with lines of \"" IO_WHITE "type,BLID,BOID" IO_DEFAULT "\" or \"" IO_WHITE "BLID,BOID" IO_DEFAULT "\" for parts.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The same operation can be performed offline by launching BrickSync as \"" IO_CYAN "bricksync importtrs SomeMappingFile" IO_DEFAULT "\".\n" );
+  }
   else if( ccStrLowCmpWord( argv[1], "sort" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "sort SomeBsxFile.bsx" IO_DEFAULT "\".\n" );
@@ -1280,8 +1388,9 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
   }
   else if( ccStrLowCmpWord( argv[1], "findordertime" ) )
   {
-    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "findordertime CountOfDays" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "findordertime CountOfDays " IO_MAGENTA "[SkipDays]" IO_DEFAULT "\".\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "The command sets the count of days that subsequent invocations of \"" IO_GREEN "findordertime" IO_DEFAULT "\" will search.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "If " IO_MAGENTA "SkipDays" IO_DEFAULT " is specified, orders saved more recently than that count of days are skipped, the default is " IO_WHITE "0" IO_DEFAULT ".\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "The search time considers the last time the order's inventory was updated on disk.\n" );
   }
   else if( ccStrLowCmpWord( argv[1], "saveorderlist" ) )
@@ -1355,6 +1464,8 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
       pgcacheformat = "BrickStore";
     if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
       pgcacheformat = "BrickStock";
+    if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_DATABASE )
+      pgcacheformat = "BrickSync";
     ioPrintf( &context->output, 0, BSMSG_INFO "Price Guide Format : " IO_CYAN "%s" IO_DEFAULT ".\n", pgcacheformat );
   }
   else if( ccStrLowCmpWord( argv[1], "sysinfo" ) )
@@ -1386,17 +1497,25 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ccGrowthFree( &growth );
     ioPrintf( &context->output, 0, BSMSG_INFO "Retaining empty lots : " IO_GREEN "%s" IO_DEFAULT ".\n", ( context->retainemptylotsflag ? "True" : "False" ) );
     ioPrintf( &context->output, 0, BSMSG_INFO "Reusing empty matching BrickOwl lots : " IO_GREEN "%s" IO_DEFAULT ".\n", ( context->brickowl.reuseemptyflag ? "True" : "False" ) );
+    ioPrintf( &context->output, 0, BSMSG_INFO "BLIDs unknown to BrickOwl pending a lookup retry : " IO_GREEN "%d" IO_DEFAULT ".\n", translationNegativeCount( &context->translationnegative, context->curtime ) );
     ioPrintf( &context->output, 0, BSMSG_INFO "Checking for BrickSync broadcast messages : " IO_GREEN "%s" IO_DEFAULT ".\n", ( context->checkmessageflag ? IO_GREEN "True" IO_DEFAULT : IO_YELLOW "False" IO_DEFAULT ) );
     pgcacheformat = "Unknown";
     if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_BRICKSTORE )
       pgcacheformat = "BrickStore";
     if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
       pgcacheformat = "BrickStock";
+    if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_DATABASE )
+      pgcacheformat = "BrickSync";
     ioPrintf( &context->output, 0, BSMSG_INFO "Format of Price Guide storage : " IO_GREEN "%s" IO_DEFAULT ".\n", pgcacheformat );
     ccGrowthInit( &growth, 512 );
     ccGrowthElapsedTimeString( &growth, (int64_t)context->priceguidecachetime, 4 );
     ioPrintf( &context->output, 0, BSMSG_INFO "Caching time for Price Guide data : " IO_GREEN "%s" IO_DEFAULT ".\n", growth.data );
     ccGrowthFree( &growth );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Serving outdated Price Guide data while refreshing : " IO_GREEN "%s" IO_DEFAULT ".\n", ( context->priceguideservestaleflag ? "True" : "False" ) );
+    if( context->pgrefresh.hourlybudget )
+      ioPrintf( &context->output, 0, BSMSG_INFO "Background Price Guide refresh : " IO_GREEN "%d" IO_DEFAULT " per hour, " IO_GREEN "%d" IO_DEFAULT " refreshed, " IO_GREEN "%d" IO_DEFAULT " queued.\n", context->pgrefresh.hourlybudget, context->pgrefresh.refreshcount, context->pgrefresh.entrycount );
+    else
+      ioPrintf( &context->output, 0, BSMSG_INFO "Background Price Guide refresh : " IO_YELLOW "Disabled" IO_DEFAULT ".\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "Size of BrickLink HTTP pipeline queue : " IO_GREEN "%d requests" IO_DEFAULT ".\n", context->bricklink.pipelinequeuesize );
     ioPrintf( &context->output, 0, BSMSG_INFO "Size of BrickOwl HTTP pipeline queue  : " IO_GREEN "%d requests" IO_DEFAULT ".\n", context->brickowl.pipelinequeuesize );
   }
@@ -1589,6 +1708,7 @@ static void bsCommandFind( bsContext *context, int argc, char **argv )
   ioPrintf( &context->output, IO_MODEBIT_NODATE, "\n" );
 
   inv = context->inventory;
+  bsCmdFindPlan( &cmdfind, inv );
   resultindex = 0;
   for( ; ; )
   {
@@ -1599,6 +1719,7 @@ static void bsCommandFind( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO IO_GREEN "Search Result #%d:" IO_DEFAULT "\n", resultindex );
     bsCmdPrintItem( context, item, matchmask );
   }
+  bsCmdFindFree( &cmdfind );
 
   if( !( resultindex ) )
     ioPrintf( &context->output, 0, BSMSG_INFO IO_RED "No result for search." IO_DEFAULT "\n" );
@@ -3287,6 +3408,213 @@ void bsCommandPruneBackups( bsContext *context, int argc, char **argv )
 }
 
 
+static void bsCommandProfile( bsContext *context, int argc, char **argv )
+{
+#if ENABLE_DEBUG_PROFILE
+  int index, phasecount;
+  debugProfileStat statlist[BS_PROFILE_PHASE_MAX];
+  debugProfileStat *stat;
+
+  if( ( argc == 2 ) && ( ccStrLowCmpWord( argv[1], "reset" ) ) )
+  {
+    debugProfileReset();
+    ioPrintf( &context->output, 0, BSMSG_INFO "All profiling timings have been reset.\n" );
+    return;
+  }
+  if( argc != 1 )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "profile " IO_MAGENTA "[reset]" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+  phasecount = debugProfileGetStats( statlist, BS_PROFILE_PHASE_MAX );
+  if( !( phasecount ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "No phase has been timed yet.\n" );
+    return;
+  }
+  ioPrintf( &context->output, 0, BSMSG_INFO "Phase timings, " IO_GREEN "count" IO_DEFAULT " / " IO_GREEN "total" IO_DEFAULT " / " IO_GREEN "p50" IO_DEFAULT " / " IO_GREEN "p95" IO_DEFAULT " / " IO_GREEN "max" IO_DEFAULT ".\n" );
+  for( index = 0 ; index < phasecount ; index++ )
+  {
+    stat = &statlist[index];
+    if( !( stat->count ) )
+      continue;
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, IO_CYAN "%-20s" IO_DEFAULT " : " IO_GREEN "%6d" IO_DEFAULT " runs, " IO_GREEN "%10.3f s" IO_DEFAULT ", " IO_GREEN "%9.1f ms" IO_DEFAULT ", " IO_GREEN "%9.1f ms" IO_DEFAULT ", " IO_GREEN "%9.1f ms" IO_DEFAULT " (%s:%d)\n", stat->name, (int)stat->count, (double)stat->total / 1000000000.0, (double)stat->p50 / 1000000.0, (double)stat->p95 / 1000000.0, (double)stat->max / 1000000.0, stat->file, stat->line );
+  }
+#else
+  ioPrintf( &context->output, 0, BSMSG_ERROR "Profiling support was disabled at compile time.\n" );
+#endif
+  return;
+}
+
+
+static void bsCommandSamples( bsContext *context, int argc, char **argv )
+{
+#if ENABLE_DEBUG_TRACKING
+  int index, samplecount, samplerate;
+  int64_t totalcount;
+  int32_t readint;
+  FILE *file;
+  debugTrackerSample *samplelist, *sample;
+
+  if( argc >= 2 )
+  {
+    if( ( argc <= 3 ) && ( ccStrLowCmpWord( argv[1], "start" ) ) )
+    {
+      samplerate = ( context->samplerate > 0 ? context->samplerate : 100 );
+      if( argc == 3 )
+      {
+        if( !( ccStrParseInt32( argv[2], &readint ) ) || ( readint < 1 ) || ( readint > 1000 ) )
+        {
+          ioPrintf( &context->output, 0, BSMSG_ERROR "The sampling rate must be between " IO_CYAN "1" IO_WHITE " and " IO_CYAN "1000" IO_WHITE " samples per second.\n" );
+          return;
+        }
+        samplerate = (int)readint;
+      }
+      context->samplerate = samplerate;
+      debugTrackerSetSampleRate( samplerate );
+      ioPrintf( &context->output, 0, BSMSG_INFO "Sampling profiler running at " IO_GREEN "%d" IO_DEFAULT " samples per second.\n", samplerate );
+      return;
+    }
+    else if( ( argc == 2 ) && ( ccStrLowCmpWord( argv[1], "stop" ) ) )
+    {
+      debugTrackerSetSampleRate( 0 );
+      ioPrintf( &context->output, 0, BSMSG_INFO "Sampling profiler stopped, collected samples are kept.\n" );
+      return;
+    }
+    else if( ( argc == 2 ) && ( ccStrLowCmpWord( argv[1], "reset" ) ) )
+    {
+      debugTrackerResetSamples();
+      ioPrintf( &context->output, 0, BSMSG_INFO "All collected samples have been cleared.\n" );
+      return;
+    }
+    else if( !( argc == 2 ) || !( ccStrLowCmpWord( argv[1], "save" ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "samples " IO_MAGENTA "[start [rate]|stop|reset|save]" IO_WHITE "\"" IO_DEFAULT ".\n" );
+      return;
+    }
+  }
+
+  samplelist = malloc( BS_SAMPLE_LOCATION_MAX * sizeof(debugTrackerSample) );
+  samplecount = debugTrackerGetSamples( samplelist, BS_SAMPLE_LOCATION_MAX, &totalcount );
+  if( argc == 2 )
+  {
+    file = fopen( BS_SAMPLE_PROFILE_FILE, "w" );
+    if( !( file ) )
+      ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to open \"" IO_RED "%s" IO_WHITE "\" for writing.\n", BS_SAMPLE_PROFILE_FILE );
+    else
+    {
+      fprintf( file, "Samples " CC_LLD ", rate %d per second\n", (long long)totalcount, debugTrackerGetSampleRate() );
+      fprintf( file, "Percent\tCount\tThread\tFile\tLine\n" );
+      for( index = 0 ; index < samplecount ; index++ )
+      {
+        sample = &samplelist[ index ];
+        fprintf( file, "%.2f\t" CC_LLD "\t%d\t%s\t%d\n", ( 100.0 * (double)sample->count ) / (double)totalcount, (long long)sample->count, sample->threadindex, sample->file, sample->line );
+      }
+      fclose( file );
+      ioPrintf( &context->output, 0, BSMSG_INFO "Saved " IO_GREEN "%d" IO_DEFAULT " sampled locations to \"" IO_CYAN "%s" IO_DEFAULT "\".\n", samplecount, BS_SAMPLE_PROFILE_FILE );
+    }
+    free( samplelist );
+    return;
+  }
+
+  if( !( totalcount ) )
+  {
+    if( debugTrackerGetSampleRate() )
+      ioPrintf( &context->output, 0, BSMSG_INFO "No samples collected yet.\n" );
+    else
+      ioPrintf( &context->output, 0, BSMSG_INFO "The sampling profiler is not running, use \"" IO_CYAN "samples start" IO_DEFAULT "\" to start it.\n" );
+    free( samplelist );
+    return;
+  }
+  ioPrintf( &context->output, 0, BSMSG_INFO IO_GREEN CC_LLD IO_DEFAULT " samples over " IO_GREEN "%d" IO_DEFAULT " locations, sampling %s.\n", (long long)totalcount, samplecount, ( debugTrackerGetSampleRate() ? "running" : "stopped" ) );
+  for( index = 0 ; index < CC_MIN( samplecount, BS_SAMPLE_PRINT_MAX ) ; index++ )
+  {
+    sample = &samplelist[ index ];
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, IO_GREEN "%6.2f%%" IO_DEFAULT " %8d  thread %d  " IO_CYAN "%s:%d" IO_DEFAULT "\n", ( 100.0 * (double)sample->count ) / (double)totalcount, (int)sample->count, sample->threadindex, sample->file, sample->line );
+  }
+  free( samplelist );
+#else
+  ioPrintf( &context->output, 0, BSMSG_ERROR "Debug tracking was disabled at compile time.\n" );
+#endif
+  return;
+}
+
+
+static void bsCommandCompactTrs( bsContext *context, int argc, char **argv )
+{
+  if( argc != 1 )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "compacttrs" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+  if( !( bsCompactTranslationTable( &context->output, &context->translationtable ) ) )
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Compaction of the translation database failed.\n" );
+  return;
+}
+
+
+static void bsCommandPriceGuideCache( bsContext *context, int argc, char **argv, int exportflag )
+{
+  int count, flags, openflag;
+  char *path;
+
+  if( ( argc < 2 ) || ( argc > 3 ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "%s [brickstore|brickstock] [PriceGuideCachePath]" IO_WHITE "\"" IO_DEFAULT ".\n", argv[0] );
+    return;
+  }
+  if( ccStrLowCmpWord( argv[1], "brickstore" ) )
+    flags = BSX_PRICEGUIDE_FLAGS_BRICKSTORE;
+  else if( ccStrLowCmpWord( argv[1], "brickstock" ) )
+    flags = BSX_PRICEGUIDE_FLAGS_BRICKSTOCK;
+  else
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Unknown price guide cache format \"" IO_RED "%s" IO_WHITE "\", expected " IO_CYAN "brickstore" IO_WHITE " or " IO_CYAN "brickstock" IO_WHITE ".\n", argv[1] );
+    return;
+  }
+  path = ( argc >= 3 ? argv[2] : context->priceguidepath );
+
+  /* The cache is only kept open when it's the configured format */
+  openflag = 0;
+  if( !( context->priceguidedb.map.data ) )
+  {
+    if( !( bsxPriceGuideDbOpen( &context->priceguidedb, context->priceguidedbpath ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_ERROR "Failed to open the price guide cache at \"" IO_RED "%s" IO_WHITE "\".\n", context->priceguidedbpath );
+      return;
+    }
+    openflag = 1;
+  }
+
+  ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "%s price guide data %s \"" IO_CYAN "%s" IO_DEFAULT "\"...\n", ( exportflag ? "Exporting" : "Importing" ), ( exportflag ? "to" : "from" ), path );
+  if( exportflag )
+    count = bsxPriceGuideDbExport( &context->priceguidedb, path, flags );
+  else
+    count = bsxPriceGuideDbImport( &context->priceguidedb, path, flags );
+  if( count < 0 )
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Failed to write the price guide cache at \"" IO_RED "%s" IO_WHITE "\".\n", path );
+  else
+    ioPrintf( &context->output, 0, BSMSG_INFO "%s " IO_GREEN "%d" IO_DEFAULT " price guides, the single-file cache holds " IO_GREEN "%d" IO_DEFAULT " price guides.\n", ( exportflag ? "Exported" : "Imported" ), count, bsxPriceGuideDbCount( &context->priceguidedb ) );
+
+  if( openflag )
+    bsxPriceGuideDbClose( &context->priceguidedb );
+  return;
+}
+
+
+static void bsCommandImportTrs( bsContext *context, int argc, char **argv )
+{
+  if( argc != 2 )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "importtrs SomeMappingFile" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+  if( !( bsImportTranslationTable( &context->output, &context->translationtable, argv[1] ) ) )
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Import into the translation database failed.\n" );
+  return;
+}
+
+
 static void bsCommandResetApiHistory( bsContext *context, int argc, char **argv )
 {
   bsApiHistoryReset( context, &context->bricklink.apihistory );
@@ -3350,9 +3678,10 @@ static int bsCommandEvalSetInternal( bsContext *context, int argc, char **argv,
     removealtflag = 0;
   }
 
-  bsPriceGuideInitState( &pgstate, inv, showaltflag, removealtflag );
+  bsPriceGuideInitState( &pgstate, inv, cachetime, showaltflag, removealtflag );
   if( !( bsProcessInventoryPriceGuide( context, inv, cachetime, (void *)&pgstate, bsPriceGuideSumCallback ) ) )
   {
+    bsPriceGuideFinishState( &pgstate );
     bsxFreeInventory( inv );
     ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to fetch price guide information for the inventory.\n" );
     return 1;
@@ -3399,6 +3728,8 @@ static int bsCommandEvalSetInternal( bsContext *context, int argc, char **argv,
   ioPrintf( &context->output, 0, BSMSG_INFO "Sale and supply prices are based on quantity averages.\n" );
   ioPrintf( &context->output, 0, BSMSG_INFO "Demand/supply and sale/price ratios are value-averaged.\n" );
   ioPrintf( &context->output, 0, BSMSG_INFO "For parts with alternates, calculations are made assuming the lowest value alternate.\n" );
+  if( pgstate.stalelots )
+    ioPrintf( &context->output, 0, BSMSG_INFO "The price guide data of " IO_YELLOW "%d" IO_DEFAULT " lots was outdated, their comments are marked " IO_YELLOW "Stale" IO_DEFAULT ".\n", pgstate.stalelots );
   ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
 
   if( params[1] )
@@ -3451,9 +3782,10 @@ static void bsCommandEvalInv( bsContext *context, int argc, char **argv )
 
 static void bsCommandCheckPrices( bsContext *context, int argc, char **argv )
 {
-  int cmdflags, cachetime;
+  int cmdflags;
   char *params[3];
-  float listrange[2];
+  float *listrange;
+  bsPriceGuideListRange range;
   bsxInventory *inv;
 
   if( !( bsCmdArgStdParse( context, argc, argv, 0, 3, params, &cmdflags, 0 ) ) )
@@ -3463,6 +3795,7 @@ static void bsCommandCheckPrices( bsContext *context, int argc, char **argv )
     return;
   }
 
+  listrange = range.listrange;
   listrange[0] = 0.5;
   listrange[1] = 1.5;
   if( ( params[0] ) && !( ccStrParseFloat( params[0], &listrange[0] ) ) )
@@ -3485,8 +3818,8 @@ static void bsCommandCheckPrices( bsContext *context, int argc, char **argv )
 
   ioPrintf( &context->output, 0, BSMSG_INFO "Listing all inventory items with relative pricing outside of the " IO_GREEN "%.2f" IO_DEFAULT " - " IO_GREEN "%.2f" IO_DEFAULT " range.\n", listrange[0], listrange[1] );
 
-  cachetime = context->priceguidecachetime;
-  if( !( bsProcessInventoryPriceGuide( context, inv, cachetime, (void *)listrange, bsPriceGuideListRangeCallback ) ) )
+  range.cachetime = context->priceguidecachetime;
+  if( !( bsProcessInventoryPriceGuide( context, inv, range.cachetime, (void *)&range, bsPriceGuideListRangeCallback ) ) )
     ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to fetch price guide information for the inventory.\n" );
 
   if( inv != context->inventory )
@@ -3499,9 +3832,11 @@ static void bsCommandCheckPrices( bsContext *context, int argc, char **argv )
 static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
 {
   int entryindex, findindex, resultindex, resultcount, matchmask;
+  int indexstatus, skipcount, backfillcount;
   time_t filetime;
   struct tm timeinfo;
   bsOrderDir orderdir;
+  bsOrderIndex orderindex;
   bsOrderDirEntry *entry;
   bsxItem *item;
   bsxInventory *inv;
@@ -3516,7 +3851,7 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
     return;
   }
 
-  if( !( bsReadOrderDir( context, &orderdir, context->curtime - context->findordertime ) ) )
+  if( !( bsReadOrderDirRange( context, &orderdir, context->curtime - context->findordertime, ( context->findorderskiptime ? context->curtime - context->findorderskiptime : 0 ) ) ) )
     return;
   bsSortOrderDir( context, &orderdir );
 
@@ -3530,16 +3865,39 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
   ccGrowthElapsedTimeString( &growth, (int64_t)context->findordertime, 4 );
   ioPrintf( &context->output, 0, BSMSG_INFO "Searching orders saved to disk in the past: " IO_MAGENTA "%s" IO_DEFAULT "\n", growth.data );
   ccGrowthFree( &growth );
+  if( context->findorderskiptime )
+  {
+    ccGrowthInit( &growth, 512 );
+    ccGrowthElapsedTimeString( &growth, (int64_t)context->findorderskiptime, 4 );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Skipping orders saved to disk in the past: " IO_MAGENTA "%s" IO_DEFAULT "\n", growth.data );
+    ccGrowthFree( &growth );
+  }
 
   inv = bsxNewInventory();
 
+  /* Only orders which may match according to the search index are loaded, orders missing from it are indexed */
+  bsOrderIndexLoad( &orderindex, BS_ORDER_INDEX_FILE );
+  skipcount = 0;
+  backfillcount = 0;
+
   resultcount = 0;
   for( entryindex = 0 ; entryindex < orderdir.entrycount ; entryindex++ )
   {
     entry = &orderdir.entrylist[ entryindex ];
 
+    indexstatus = bsOrderIndexMatch( &orderindex, entry->ordertype, entry->orderid, cmdfind.findcount, cmdfind.findstring, cmdfind.findint, cmdfind.findfloat );
+    if( indexstatus == BS_ORDER_INDEX_NOMATCH )
+    {
+      skipcount++;
+      continue;
+    }
     if( !( bsxLoadInventory( inv, entry->filepath ) ) )
       continue;
+    if( ( indexstatus == BS_ORDER_INDEX_MISSING ) && ( entry->ordertype != BS_ORDER_DIR_ORDER_TYPE_UNKNOWN ) && ( entry->orderid ) )
+    {
+      bsOrderIndexAdd( context, entry->ordertype, entry->orderid, inv );
+      backfillcount++;
+    }
 
     bsCmdFindReset( &cmdfind );
     filetime = entry->filetime;
@@ -3563,6 +3921,9 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
         strftime( timebuf, 64, "%Y-%m-%d %H:%M:%S", &timeinfo );
         ioPrintf( &context->output, 0, BSMSG_INFO IO_CYAN "%s" IO_DEFAULT " Order #" IO_GREEN "%d" IO_DEFAULT ", saved to disk on " IO_CYAN "%s" IO_DEFAULT " (%s ago)\n", servicename, entry->orderid, timebuf, growth.data );
         ccGrowthFree( &growth );
+        /* Orders only found by a directory scan have no manifest figures */
+        if( entry->lotcount >= 0 )
+          ioPrintf( &context->output, 0, BSMSG_INFO "Order of " IO_GREEN "%d" IO_DEFAULT " lots, " IO_GREEN "%d" IO_DEFAULT " parts, grand total " IO_GREEN "%.2f" IO_DEFAULT ".\n", entry->lotcount, entry->partcount, entry->grandtotal );
       }
       resultindex++;
       ioPrintf( &context->output, 0, BSMSG_INFO IO_GREEN "Search Result #%d:" IO_DEFAULT "\n", resultindex );
@@ -3580,6 +3941,8 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
   }
 
   bsxFreeInventory( inv );
+  bsOrderIndexFree( &orderindex );
+  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Order search index skipped %d of %d orders, %d orders added to index.\n", skipcount, orderdir.entrycount, backfillcount );
 
   if( !( resultcount ) )
     ioPrintf( &context->output, 0, BSMSG_INFO IO_RED "No result for search." IO_DEFAULT "\n" );
@@ -3591,25 +3954,41 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
 
 static void bsCommandFindOrderTime( bsContext *context, int argc, char **argv )
 {
-  float findordertime;
+  float findordertime, findorderskiptime;
   ccGrowth growth;
 
-  if( argc != 2 )
+  if( ( argc < 2 ) || ( argc > 3 ) )
   {
     syntaxerror:
-    ioPrintf( &context->output, 0, BSMSG_ERROR "Incorrect parameter count, usage is \"findordertime CountOfDays\"" IO_DEFAULT ".\n" );
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Incorrect parameter count, usage is \"findordertime CountOfDays [SkipDays]\"" IO_DEFAULT ".\n" );
     return;
   }
 
   if( !( ccStrParseFloat( argv[1], &findordertime ) ) )
     goto syntaxerror;
+  findorderskiptime = 0.0;
+  if( ( argc == 3 ) && !( ccStrParseFloat( argv[2], &findorderskiptime ) ) )
+    goto syntaxerror;
+  if( ( findorderskiptime < 0.0 ) || ( findorderskiptime >= findordertime ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "The count of days to skip must be smaller than the count of days to search.\n" );
+    return;
+  }
 
   context->findordertime = (int64_t)( findordertime * (float)(24*60*60) );
+  context->findorderskiptime = (int64_t)( findorderskiptime * (float)(24*60*60) );
 
   ccGrowthInit( &growth, 512 );
   ccGrowthElapsedTimeString( &growth, (int64_t)context->findordertime, 4 );
   ioPrintf( &context->output, 0, BSMSG_INFO "Find order time is now set to : " IO_GREEN "%s" IO_DEFAULT ".\n", growth.data );
   ccGrowthFree( &growth );
+  if( context->findorderskiptime )
+  {
+    ccGrowthInit( &growth, 512 );
+    ccGrowthElapsedTimeString( &growth, (int64_t)context->findorderskiptime, 4 );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Orders saved to disk in the past " IO_GREEN "%s" IO_DEFAULT " are skipped.\n", growth.data );
+    ccGrowthFree( &growth );
+  }
 
   return;
 }
@@ -3997,6 +4376,18 @@ static int bsRunCommand( bsContext *context, char *input, int runfileflag )
     bsCommandPruneBackups( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "resetapihistory" ) )
     bsCommandResetApiHistory( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "compacttrs" ) )
+    bsCommandCompactTrs( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "profile" ) )
+    bsCommandProfile( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "samples" ) )
+    bsCommandSamples( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "importtrs" ) )
+    bsCommandImportTrs( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "importpg" ) )
+    bsCommandPriceGuideCache( context, argc, argv, 0 );
+  else if( ccStrLowCmpWord( argv[0], "exportpg" ) )
+    bsCommandPriceGuideCache( context, argc, argv, 1 );
   else if( ccStrLowCmpWord( argv[0], "quit" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Quit command issued. Exiting.\n" );
@@ -4027,6 +4418,7 @@ int bsParseInput( bsContext *context, int *retactionflag )
     return 1;
 
   /* Remove line marker, user already entered a '\n' */
+  ioLogFlush( &context->output );
   context->output.linemarker = 0;
 
   /* Execute command */
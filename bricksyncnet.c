@@ -82,7 +82,7 @@ bsQueryReply *bsAllocReply( bsContext *context, int type, int64_t extid, void *e
 
   DEBUG_SET_TRACKER();
 
-  reply = malloc( sizeof(bsQueryReply) );
+  reply = mmAccountAlloc( MM_ACCOUNT_REPLY, sizeof(bsQueryReply) );
   reply->context = context;
   reply->opaquepointer = opaquepointer;
   reply->type = type;
@@ -128,7 +128,7 @@ void bsFreeReply( bsContext *context, bsQueryReply *reply )
       BS_INTERNAL_ERROR_EXIT();
   }
   mmListDualRemove( &context->replylist, reply, offsetof(bsQueryReply,list) );
-  free( reply );
+  mmAccountFree( MM_ACCOUNT_REPLY, reply );
   return;
 }
 
@@ -201,6 +201,45 @@ void bsBrickOwlAddQuery( bsContext *context, char *querystring, int httpflags, v
 ////
 
 
+static const struct
+{
+  char *name;
+  char *pathprefix;
+} bsHttpEndpointDef[BS_HTTP_ENDPOINT_COUNT] =
+{
+  [BS_HTTP_ENDPOINT_BRICKLINK_INVENTORIES] = { "bricklink_inventories", "/api/store/v1/inventories" },
+  [BS_HTTP_ENDPOINT_BRICKLINK_ORDERS] = { "bricklink_orders", "/api/store/v1/orders" },
+  [BS_HTTP_ENDPOINT_BRICKLINK_OTHER] = { "bricklink_other", "/" },
+  [BS_HTTP_ENDPOINT_BRICKLINK_PRICEGUIDE] = { "bricklink_priceguide", "/priceGuide.asp" },
+  [BS_HTTP_ENDPOINT_BRICKOWL_INVENTORY_UPDATE] = { "brickowl_inventory_update", "/v1/inventory/update" },
+  [BS_HTTP_ENDPOINT_BRICKOWL_ID_LOOKUP] = { "brickowl_id_lookup", "/v1/catalog/id_lookup" },
+  [BS_HTTP_ENDPOINT_BRICKOWL_OTHER] = { "brickowl_other", "/" }
+};
+
+/* Counters and the trace are preserved, connections may be reopened after too many errors */
+void bsAttachHttpStats( bsContext *context )
+{
+  int index;
+
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+  {
+    context->httpstats[index].name = bsHttpEndpointDef[index].name;
+    context->httpstats[index].pathprefix = bsHttpEndpointDef[index].pathprefix;
+  }
+  httpSetEndpointStats( context->bricklink.http, &context->httpstats[BS_HTTP_ENDPOINT_BRICKLINK_INVENTORIES], BS_HTTP_ENDPOINT_BRICKLINK_PRICEGUIDE - BS_HTTP_ENDPOINT_BRICKLINK_INVENTORIES );
+  httpSetEndpointStats( context->bricklink.webhttp, &context->httpstats[BS_HTTP_ENDPOINT_BRICKLINK_PRICEGUIDE], BS_HTTP_ENDPOINT_BRICKOWL_INVENTORY_UPDATE - BS_HTTP_ENDPOINT_BRICKLINK_PRICEGUIDE );
+  httpSetEndpointStats( context->brickowl.http, &context->httpstats[BS_HTTP_ENDPOINT_BRICKOWL_INVENTORY_UPDATE], BS_HTTP_ENDPOINT_COUNT - BS_HTTP_ENDPOINT_BRICKOWL_INVENTORY_UPDATE );
+  /* Channels tell apart the connections sharing a trace */
+  if( context->httptrace )
+  {
+    httpSetTrace( context->bricklink.http, context->httptrace, 0 );
+    httpSetTrace( context->brickowl.http, context->httptrace, 1 );
+    httpSetTrace( context->bricklink.webhttp, context->httptrace, 2 );
+  }
+  return;
+}
+
+
 void bsFlushTcpProcessHttp( bsContext *context )
 {
   tcpFlush( &context->tcp );
@@ -213,6 +252,30 @@ void bsFlushTcpProcessHttp( bsContext *context )
 }
 
 
+void bsWaitTcp( bsContext *context )
+{
+  int timeout, replaywait, index;
+  httpConnection *httplist[3];
+
+  timeout = 0;
+  if( context->httptrace )
+  {
+    /* Replayed replies arrive without network events, wake up when the next one is due */
+    httplist[0] = context->bricklink.http;
+    httplist[1] = context->brickowl.http;
+    httplist[2] = context->bricklink.webhttp;
+    for( index = 0 ; index < 3 ; index++ )
+    {
+      replaywait = httpGetReplayWait( httplist[index] );
+      if( ( replaywait > 0 ) && ( !( timeout ) || ( replaywait < timeout ) ) )
+        timeout = replaywait;
+    }
+  }
+  tcpWait( &context->tcp, timeout );
+  return;
+}
+
+
 ////
 
 
@@ -222,18 +285,18 @@ void bsWaitBrickLinkQueries( bsContext *context, int maxpending )
   DEBUG_SET_TRACKER();
 
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickLinkQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickLinkQueries().\n" );
 #endif
   for( ; ; )
   {
     bsFlushTcpProcessHttp( context );
     if( httpGetQueryQueueCount( context->bricklink.http ) > maxpending )
-      tcpWait( &context->tcp, 0 );
+      bsWaitTcp( context );
     else
       break;
   }
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickLinkQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickLinkQueries().\n" );
 #endif
   return;
 }
@@ -244,18 +307,18 @@ void bsWaitBrickLinkWebQueries( bsContext *context, int maxpending )
   DEBUG_SET_TRACKER();
 
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickLinkWebQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickLinkWebQueries().\n" );
 #endif
   for( ; ; )
   {
     bsFlushTcpProcessHttp( context );
     if( httpGetQueryQueueCount( context->bricklink.webhttp ) > maxpending )
-      tcpWait( &context->tcp, 0 );
+      bsWaitTcp( context );
     else
       break;
   }
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickLinkWebQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickLinkWebQueries().\n" );
 #endif
   return;
 }
@@ -266,18 +329,18 @@ void bsWaitBrickOwlQueries( bsContext *context, int maxpending )
   DEBUG_SET_TRACKER();
 
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickOwlQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Enter bsWaitBrickOwlQueries().\n" );
 #endif
   for( ; ; )
   {
     bsFlushTcpProcessHttp( context );
     if( httpGetQueryQueueCount( context->brickowl.http ) > maxpending )
-      tcpWait( &context->tcp, 0 );
+      bsWaitTcp( context );
     else
       break;
   }
 #if BS_ENABLE_DEBUG_OUTPUT && 0
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickOwlQueries().\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Exit bsWaitBrickOwlQueries().\n" );
 #endif
   return;
 }
@@ -291,7 +354,7 @@ void bsWaitBrickSyncWebQueries( bsContext *context, int maxpending )
   {
     bsFlushTcpProcessHttp( context );
     if( httpGetQueryQueueCount( context->bricksyncwebhttp ) > maxpending )
-      tcpWait( &context->tcp, 0 );
+      bsWaitTcp( context );
     else
       break;
   }
@@ -322,10 +385,16 @@ void bsTrackerInit( bsTracker *tracker, httpConnection *http )
 /* Accumulate httpresults, return failure flag */
 int bsTrackerAccumResult( bsContext *context, bsTracker *tracker, int httpresult, int accumflags )
 {
+  int errorcount;
+
   DEBUG_SET_TRACKER();
 
   /* Accumulate count of connection errors */
-  tracker->errorcount += httpGetClearErrorCount( tracker->http );
+  errorcount = httpGetClearErrorCount( tracker->http );
+  tracker->errorcount += errorcount;
+  context->metrics.connerrorcount += errorcount;
+  if( (unsigned)httpresult < HTTP_RESULT_COUNT )
+    context->metrics.resultcount[ httpresult ]++;
 
   if( tracker->failureflag )
     return tracker->failureflag;
@@ -345,16 +414,16 @@ int bsTrackerAccumResult( bsContext *context, bsTracker *tracker, int httpresult
       }
       break;
     case HTTP_RESULT_CONNECT_ERROR:
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to connect to server, trying again shortly...\n" );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to connect to server, trying again shortly...\n" );
       break;
     case HTTP_RESULT_TRYAGAIN_ERROR:
     case HTTP_RESULT_NOREPLY_ERROR:
       if( accumflags & BS_TRACKER_ACCUM_FLAGS_CANSYNC )
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "No reply received for query, we will retry and later perform a deep sync.\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "No reply received for query, we will retry and later perform a deep sync.\n" );
       else if( accumflags & BS_TRACKER_ACCUM_FLAGS_CANRETRY )
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "No reply received for query, we will retry.\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "No reply received for query, we will retry.\n" );
       else
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "No reply received for query.\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, IO_MODEBIT_FLUSH, BSMSG_ERROR "No reply received for query.\n" );
       tracker->mustsyncflag = 1;
       break;
     /* Problems handling the reply */
@@ -362,9 +431,9 @@ int bsTrackerAccumResult( bsContext *context, bsTracker *tracker, int httpresult
     case HTTP_RESULT_CODE_ERROR:
     case HTTP_RESULT_PARSE_ERROR:
       if( accumflags & BS_TRACKER_ACCUM_FLAGS_CANRETRY )
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Bad reply from server, trying again shortly...\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Bad reply from server, trying again shortly...\n" );
       else
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Bad reply from server.\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Bad reply from server.\n" );
       if( !( accumflags & BS_TRACKER_ACCUM_FLAGS_NO_ERROR ) )
         tracker->errorcount++;
       break;
@@ -384,36 +453,37 @@ int bsTrackerAccumResult( bsContext *context, bsTracker *tracker, int httpresult
     /* Flag all still pending queries to abort */
     httpAbortQueue( tracker->http );
     /* Abort */
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Too many connection errors, giving up.\n" );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, IO_MODEBIT_FLUSH, BSMSG_ERROR "Too many connection errors, giving up.\n" );
 
     /* Resolve IPs again after too many connection errors */
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INIT "Resolving IP addresses for API and WEB services.\n" );
-    context->bricklink.apiaddress = tcpResolveName( BS_BRICKLINK_API_SERVER, 0 );
+    context->bricklink.apiaddress = tcpResolveName( context->bricklink.apiserver, 0 );
     if( !( context->bricklink.apiaddress ) )
     {
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKLINK_API_SERVER );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", context->bricklink.apiserver );
       goto error;
     }
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKLINK_API_SERVER, context->bricklink.apiaddress );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", context->bricklink.apiserver, context->bricklink.apiaddress );
     context->bricklink.webaddress = tcpResolveName( BS_BRICKLINK_WEB_SERVER, 0 );
     if( !( context->bricklink.webaddress ) )
     {
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKLINK_WEB_SERVER );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKLINK_WEB_SERVER );
       goto error;
     }
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKLINK_WEB_SERVER, context->bricklink.webaddress );
-    context->brickowl.apiaddress = tcpResolveName( BS_BRICKOWL_API_SERVER, 0 );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKLINK_WEB_SERVER, context->bricklink.webaddress );
+    context->brickowl.apiaddress = tcpResolveName( context->brickowl.apiserver, 0 );
     if( !( context->brickowl.apiaddress ) )
     {
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", BS_BRICKOWL_API_SERVER );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to resolve IP address for " IO_RED "%s" IO_WHITE ".\n", context->brickowl.apiserver );
       goto error;
     }
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", BS_BRICKOWL_API_SERVER, context->brickowl.apiaddress );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Resolved %s as %s\n", context->brickowl.apiserver, context->brickowl.apiaddress );
     
     /* Define HTTP connections to BrickLink and BrickOwl */
-    context->bricklink.http = httpOpen( &context->tcp, context->bricklink.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
+    context->bricklink.http = httpOpen( &context->tcp, context->bricklink.apiaddress, context->bricklink.apiport, context->bricklink.apihttpflags );
     context->bricklink.webhttp = httpOpen( &context->tcp, context->bricklink.webaddress, 80, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
-    context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
+    context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, context->brickowl.apiport, context->brickowl.apihttpflags );
+    bsAttachHttpStats( context );
     
     error:
 
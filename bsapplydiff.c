@@ -195,7 +195,7 @@ static void bsBrickLinkApplyDiffCreate( bsContext *context, bsxItem *item, int i
 
   if( !( item->id ) )
   {
-    ioPrintf( &context->output, 0, BSMSG_WARNING "Unknown item ID ( BOID " IO_RED CC_LLD IO_WHITE " ), ignored.\n", (long long)item->boid );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "Unknown item ID ( BOID " IO_RED CC_LLD IO_WHITE " ), ignored.\n", (long long)item->boid );
     return;
   }
   switch( item->typeid )
@@ -225,7 +225,7 @@ static void bsBrickLinkApplyDiffCreate( bsContext *context, bsxItem *item, int i
       typestring = "ORIGINAL_BOX";
       break;
     default:
-      ioPrintf( &context->output, 0, BSMSG_WARNING "Unknown item type '" IO_RED "%c" IO_WHITE "' for \"" IO_CYAN "%s" IO_WHITE "\" ( " IO_CYAN "%s" IO_WHITE " ), ignored.\n", item->typeid, item->name, item->id );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "Unknown item type '" IO_RED "%c" IO_WHITE "' for \"" IO_CYAN "%s" IO_WHITE "\" ( " IO_CYAN "%s" IO_WHITE " ), ignored.\n", item->typeid, item->name, item->id );
       return;
   }
   ccGrowthInit( &postgrowth, 1024 );
@@ -280,7 +280,7 @@ static void bsBrickLinkApplyDiffCreate( bsContext *context, bsxItem *item, int i
   ccGrowthFree( &postgrowth );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Create item \"%s\", color %d, quantity %d\n", ( item->id ? item->id : item->name ), item->colorid, item->quantity );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Create item \"%s\", color %d, quantity %d\n", ( item->id ? item->id : item->name ), item->colorid, item->quantity );
 #endif
 
   return;
@@ -300,7 +300,7 @@ static void bsBrickLinkApplyDiffDelete( bsContext *context, bsxItem *item, int i
   free( pathstring );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Delete item \"%s\", LotID "CC_LLD"\n", ( item->id ? item->id : item->name ), (long long)item->lotid );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Delete item \"%s\", LotID "CC_LLD"\n", ( item->id ? item->id : item->name ), (long long)item->lotid );
 #endif
 
   return;
@@ -368,24 +368,27 @@ static void bsBrickLinkApplyDiffUpdate( bsContext *context, bsxItem *item, int i
   ccGrowthFree( &postgrowth );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Update item \"%s\", color %d", ( item->id ? item->id : item->name ), item->colorid );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_QUANTITY )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Quantity adjust by %+d", item->quantity );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set comments to \"%s\"", ( item->comments ? item->comments : "" ) );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set remarks to \"%s\"", ( item->remarks ? item->remarks : "" ) );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set price to %.3f", item->price );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_BULK )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set bulk to %d", item->bulk );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set mycost to %.3f", item->mycost );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set tierprices to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3 );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_STOCKROOM )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Move to Stockroom" );
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "\n" );
+  if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickLink Query: Update item \"%s\", color %d", ( item->id ? item->id : item->name ), item->colorid );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_QUANTITY )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Quantity adjust by %+d", item->quantity );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set comments to \"%s\"", ( item->comments ? item->comments : "" ) );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set remarks to \"%s\"", ( item->remarks ? item->remarks : "" ) );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set price to %.3f", item->price );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_BULK )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set bulk to %d", item->bulk );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set mycost to %.3f", item->mycost );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set tierprices to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3 );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_STOCKROOM )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Move to Stockroom" );
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "\n" );
+  }
 #endif
 
   return;
@@ -422,7 +425,7 @@ static int bsQueueBrickLinkApplyDiff( bsContext *context, bsWorkList *worklist,
       apilimit = context->bricklink.apicountpricelimit;
     if( context->bricklink.apihistory.total >= apilimit )
     {
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: API pool too low, skipping BrickLink item \"%s\", color %d.\n", ( item->id ? item->id : item->name ), item->colorid );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: API pool too low, skipping BrickLink item \"%s\", color %d.\n", ( item->id ? item->id : item->name ), item->colorid );
       continue;
     }
 
@@ -498,9 +501,9 @@ int BS_FUNCTION_ALIGN16 bsQueryBrickLinkApplyDiff( bsContext *context, bsxInvent
       accumflags = BS_TRACKER_ACCUM_FLAGS_CANSYNC;
       if( reply->result != HTTP_RESULT_SUCCESS )
       {
-        ioPrintf( &context->output, 0, BSMSG_WARNING "Error %s BrickLink item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "Error %s BrickLink item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
         if( item->flags & BSX_ITEM_XFLAGS_TO_CREATE )
-          ioPrintf( &context->output, 0, BSMSG_WARNING "If the BLID for the item has changed, consider using the command " IO_CYAN "setblid" IO_WHITE " to fix this lot.\n" );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "If the BLID for the item has changed, consider using the command " IO_CYAN "setblid" IO_WHITE " to fix this lot.\n" );
         if( ( ( reply->result == HTTP_RESULT_CODE_ERROR ) || ( reply->result == HTTP_RESULT_PARSE_ERROR ) ) )
         {
           if( item->flags & BSX_ITEM_XFLAGS_TO_UPDATE )
@@ -520,35 +523,38 @@ int BS_FUNCTION_ALIGN16 bsQueryBrickLinkApplyDiff( bsContext *context, bsxInvent
             if( itemdiscardflags )
             {
               accumflags |= BS_TRACKER_ACCUM_FLAGS_NO_ERROR;
-              ioPrintf( &context->output, 0, BSMSG_WARNING "An update was rejected by BrickLink. A further " IO_CYAN "sync" IO_WHITE " will attempt the update again.\n" );
-              ioPrintf( &context->output, 0, BSMSG_WARNING "We are dropping the following updates:" IO_YELLOW );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_BULK )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Bulk" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " MyCost" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " UsedGrade" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " TierPrices" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Price" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Comments" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Remarks" );
-              ioPrintf( &context->output, IO_MODEBIT_NODATE, "\n" );
+              if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING ) )
+              {
+                ioPrintf( &context->output, 0, BSMSG_WARNING "An update was rejected by BrickLink. A further " IO_CYAN "sync" IO_WHITE " will attempt the update again.\n" );
+                ioPrintf( &context->output, 0, BSMSG_WARNING "We are dropping the following updates:" IO_YELLOW );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_BULK )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Bulk" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " MyCost" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " UsedGrade" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " TierPrices" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Price" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Comments" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Remarks" );
+                ioPrintf( &context->output, IO_MODEBIT_NODATE, "\n" );
+              }
             }
             if( item->flags & BSX_ITEM_XFLAGS_UPDATEMASK )
               goto tryagain;
           }
-          ioPrintf( &context->output, 0, BSMSG_WARNING "The operation was rejected by BrickLink. A further " IO_CYAN "sync" IO_WHITE " will attempt the operation again.\n" );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "The operation was rejected by BrickLink. A further " IO_CYAN "sync" IO_WHITE " will attempt the operation again.\n" );
           bsxRemoveItem( diffinv, item );
           reply->result = HTTP_RESULT_SUCCESS;
         }
         else
         {
           /* Clear bit to attempt item again */
-          ioPrintf( &context->output, 0, BSMSG_WARNING "The operation will be attempted again.\n" );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "The operation will be attempted again.\n" );
           tryagain:
           mmBitMapDirectClear( &worklist.bitmap, itemlistindex );
           if( itemlistindex < worklist.liststart )
@@ -559,7 +565,7 @@ int BS_FUNCTION_ALIGN16 bsQueryBrickLinkApplyDiff( bsContext *context, bsxInvent
       {
         itemflags = item->flags;
         item->flags &= ~( BSX_ITEM_XFLAGS_TO_CREATE | BSX_ITEM_XFLAGS_TO_DELETE | BSX_ITEM_XFLAGS_TO_UPDATE );
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success %s BrickLink item \"%s\", color %d\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success %s BrickLink item \"%s\", color %d\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
         /* Update tracked inventory LotID */
         if( ( itemflags & BSX_ITEM_XFLAGS_TO_CREATE ) && ( item->lotid != -1 ) )
         {
@@ -597,7 +603,7 @@ int BS_FUNCTION_ALIGN16 bsQueryBrickLinkApplyDiff( bsContext *context, bsxInvent
 
   if( tracker.failureflag )
   {
-    ioPrintf( &context->output, 0, BSMSG_WARNING "BrickLink update did not complete successfully!\n" );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "BrickLink update did not complete successfully!\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink flagged " IO_MAGENTA "MUST_SYNC" IO_DEFAULT " for deep synchronization.\n" );
     return 0;
   }
@@ -699,8 +705,8 @@ static void bsBrickOwlApplyDiffCreate( bsContext *context, bsxItem *item, int it
   bocolor = bsTranslateColorBl2Bo( item->colorid );
   if( bocolor == -1 )
   {
-    ioPrintf( &context->output, 0, BSMSG_WARNING "We failed to translate the BL color %d to a BO color code.\n", item->colorid );
-    ioPrintf( &context->output, 0, BSMSG_WARNING "The lot \"%s\" ( %s ) in color \"%s\" will not be uploaded to BrickOwl.\n", item->name, item->id, item->colorname );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "We failed to translate the BL color %d to a BO color code.\n", item->colorid );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "The lot \"%s\" ( %s ) in color \"%s\" will not be uploaded to BrickOwl.\n", item->name, item->id, item->colorname );
     return;
   }
 
@@ -761,7 +767,7 @@ static void bsBrickOwlApplyDiffCreate( bsContext *context, bsxItem *item, int it
   ccGrowthFree( &postgrowth );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Create item \"%s\", BOID "CC_LLD", color %d, quantity %d\n", ( item->id ? item->id : item->name ), (long long)item->boid, item->colorid, item->quantity );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Create item \"%s\", BOID "CC_LLD", color %d, quantity %d\n", ( item->id ? item->id : item->name ), (long long)item->boid, item->colorid, item->quantity );
 #endif
 
   return;
@@ -787,7 +793,7 @@ static void bsBrickOwlApplyDiffDelete( bsContext *context, bsxItem *item, int it
   free( poststring );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Delete item \"%s\", BOID "CC_LLD", LotID "CC_LLD", OwlLotID "CC_LLD"\n", ( item->id ? item->id : item->name ), (long long)item->boid, (long long)item->lotid, (long long)item->bolotid );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Delete item \"%s\", BOID "CC_LLD", LotID "CC_LLD", OwlLotID "CC_LLD"\n", ( item->id ? item->id : item->name ), (long long)item->boid, (long long)item->lotid, (long long)item->bolotid );
 #endif
 
   return;
@@ -868,24 +874,27 @@ static void bsBrickOwlApplyDiffUpdate( bsContext *context, bsxItem *item, int it
   ccGrowthFree( &postgrowth );
 
 #if 1
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Update item \"%s\", color %d", ( item->id ? item->id : item->name ), item->colorid );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_QUANTITY )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Quantity adjust by %+d", item->quantity );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set comments to \"%s\"", ( item->comments ? item->comments : "" ) );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set remarks to \"%s\"", ( item->remarks ? item->remarks : "" ) );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set price to %.3f", item->price );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_BULK )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set bulk to %d", item->bulk );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set mycost to %.3f", item->mycost );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set usedgrade to %c", item->usedgrade );
-  if( item->flags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set tierprices to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3 );
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "\n" );
+  if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued BrickOwl Query: Update item \"%s\", color %d", ( item->id ? item->id : item->name ), item->colorid );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_QUANTITY )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Quantity adjust by %+d", item->quantity );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set comments to \"%s\"", ( item->comments ? item->comments : "" ) );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set remarks to \"%s\"", ( item->remarks ? item->remarks : "" ) );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set price to %.3f", item->price );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_BULK )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set bulk to %d", item->bulk );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set mycost to %.3f", item->mycost );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set usedgrade to %c", item->usedgrade );
+    if( item->flags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "; Set tierprices to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3 );
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "\n" );
+  }
 #endif
 
   return;
@@ -973,9 +982,9 @@ static int bsQueryBrickOwlApplyDiffPass( bsContext *context, bsxInventory *diffi
       accumflags = BS_TRACKER_ACCUM_FLAGS_CANSYNC;
       if( reply->result != HTTP_RESULT_SUCCESS )
       {
-        ioPrintf( &context->output, 0, BSMSG_WARNING "Error %s BrickOwl item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "Error %s BrickOwl item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
         if( ( item->flags & BSX_ITEM_XFLAGS_TO_CREATE ) && ( item->id ) )
-          ioPrintf( &context->output, 0, BSMSG_WARNING "It's possible we may have cached an old BOID for this BLID. Try updating the BLID<->BOID translation cache by typing " IO_CYAN "owlqueryblid -f %s" IO_WHITE ".\n", item->id );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "It's possible we may have cached an old BOID for this BLID. Try updating the BLID<->BOID translation cache by typing " IO_CYAN "owlqueryblid -f %s" IO_WHITE ".\n", item->id );
         if( ( ( reply->result == HTTP_RESULT_CODE_ERROR ) || ( reply->result == HTTP_RESULT_PARSE_ERROR ) ) )
         {
           if( item->flags & BSX_ITEM_XFLAGS_TO_UPDATE )
@@ -995,35 +1004,38 @@ static int bsQueryBrickOwlApplyDiffPass( bsContext *context, bsxInventory *diffi
             if( itemdiscardflags )
             {
               accumflags |= BS_TRACKER_ACCUM_FLAGS_NO_ERROR;
-              ioPrintf( &context->output, 0, BSMSG_WARNING "An update was rejected by BrickOwl. A further " IO_CYAN "sync" IO_WHITE " will attempt the update again.\n" );
-              ioPrintf( &context->output, 0, BSMSG_WARNING "We are dropping the following updates:" IO_YELLOW );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_BULK )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Bulk" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " MyCost" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " UsedGrade" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " TierPrices" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Price" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Comments" );
-              if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
-                ioPrintf( &context->output, IO_MODEBIT_NODATE, " Remarks" );
-              ioPrintf( &context->output, IO_MODEBIT_NODATE, "\n" );
+              if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING ) )
+              {
+                ioPrintf( &context->output, 0, BSMSG_WARNING "An update was rejected by BrickOwl. A further " IO_CYAN "sync" IO_WHITE " will attempt the update again.\n" );
+                ioPrintf( &context->output, 0, BSMSG_WARNING "We are dropping the following updates:" IO_YELLOW );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_BULK )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Bulk" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_MYCOST )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " MyCost" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_USEDGRADE )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " UsedGrade" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_TIERPRICES )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " TierPrices" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_PRICE )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Price" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_COMMENTS )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Comments" );
+                if( itemdiscardflags & BSX_ITEM_XFLAGS_UPDATE_REMARKS )
+                  ioPrintf( &context->output, IO_MODEBIT_NODATE, " Remarks" );
+                ioPrintf( &context->output, IO_MODEBIT_NODATE, "\n" );
+              }
             }
             if( item->flags & BSX_ITEM_XFLAGS_UPDATEMASK )
               goto tryagain;
           }
-          ioPrintf( &context->output, 0, BSMSG_WARNING "The operation was rejected by BrickOwl. A further " IO_CYAN "sync" IO_WHITE " will attempt the operation again.\n" );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "The operation was rejected by BrickOwl. A further " IO_CYAN "sync" IO_WHITE " will attempt the operation again.\n" );
           bsxRemoveItem( diffinv, item );
           reply->result = HTTP_RESULT_SUCCESS;
         }
         else
         {
           /* Clear bit to attempt item again */
-          ioPrintf( &context->output, 0, BSMSG_WARNING "The operation will be attempted again.\n" );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "The operation will be attempted again.\n" );
           tryagain:
           mmBitMapDirectClear( &worklist.bitmap, itemlistindex );
           if( itemlistindex < worklist.liststart )
@@ -1034,7 +1046,7 @@ static int bsQueryBrickOwlApplyDiffPass( bsContext *context, bsxInventory *diffi
       {
         itemflags = item->flags;
         item->flags &= ~( BSX_ITEM_XFLAGS_TO_CREATE | BSX_ITEM_XFLAGS_TO_DELETE | BSX_ITEM_XFLAGS_TO_UPDATE );
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success %s BrickOwl item \"%s\", color %d\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success %s BrickOwl item \"%s\", color %d\n", actionstring, ( item->id ? item->id : item->name ), item->colorid );
         if( itemflags & BSX_ITEM_XFLAGS_TO_CREATE )
         {
           /* Update tracked inventory BoLotID */
@@ -1126,7 +1138,7 @@ int BS_FUNCTION_ALIGN16 bsQueryBrickOwlApplyDiff( bsContext *context, bsxInvento
   return 1;
 
   error:
-  ioPrintf( &context->output, 0, BSMSG_WARNING "BrickOwl update did not complete successfully!\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_APPLY, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "BrickOwl update did not complete successfully!\n" );
   ioPrintf( &context->output, 0, BSMSG_INFO "BrickOwl flagged " IO_MAGENTA "MUST_SYNC" IO_DEFAULT " for deep synchronization.\n" );
   return 0;
 }
@@ -0,0 +1,821 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "mmatomic.h"
+#include "mmbitmap.h"
+#include "iolog.h"
+#include "debugtrack.h"
+#include "rand.h"
+
+#if CC_UNIX
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#elif CC_WINDOWS
+ #include <windows.h>
+ #include <direct.h>
+#else
+ #error Unknown/Unsupported platform!
+#endif
+
+#include "tcp.h"
+#include "tcphttp.h"
+#include "oauth.h"
+#include "exclperm.h"
+#include "journal.h"
+
+#include "bsx.h"
+#include "bsxpg.h"
+#include "json.h"
+#include "bsorder.h"
+#include "bricklink.h"
+#include "brickowl.h"
+#include "colortable.h"
+#include "bstranslation.h"
+
+#include "bricksync.h"
+
+
+////
+
+
+/*
+Synthetic inventory generator and benchmarks of the inventory hot paths.
+Built by ./compile-bench, which links every BrickSync module with BS_BENCH_BUILD defined to drop BrickSync's main().
+
+Each benchmark prints one JSON object per line on stdout or the -o file, timings in nanoseconds :
+{"bench":"bsxSortInventory","variant":"id","lots":20000,"ops":20000,"iterations":5,"min_ns":...,"median_ns":...,"mean_ns":...,"ns_per_op":...}
+The first line describes the generated inventory, so results of different runs can be compared.
+*/
+
+
+#define BS_BENCH_TEMP_FILE "bsbench.tmp.bsx"
+
+enum
+{
+  BS_BENCH_LOTID_SEQUENTIAL,
+  BS_BENCH_LOTID_RANDOM,
+  BS_BENCH_LOTID_NONE
+};
+
+static const char *bsBenchLotIdModeName[] = { "sequential", "random", "none" };
+
+typedef struct
+{
+  int lotcount;
+  int idlength;
+  int namelength;
+  int commentslength;
+  int remarkslength;
+  /* Percentage of lots sharing ID, color and condition with an earlier lot */
+  int duplicatepercent;
+  int lotidmode;
+  uint64_t seed;
+  int iterations;
+  int lookupcount;
+  /* Run only the benchmarks whose name begins with this string */
+  char *only;
+  /* Write the generated inventory there and exit */
+  char *generatepath;
+  /* Log like BrickSync does at default levels in that directory, logging is disabled otherwise */
+  char *logpath;
+  /* Results, stdout unless a path is given with -o */
+  char *outputpath;
+  FILE *output;
+} bsBenchConfig;
+
+
+////
+
+
+static const char *bsBenchWordList[] =
+{
+  "Brick", "Plate", "Tile", "Slope", "Round", "Modified", "Technic", "Pin", "Axle", "Bracket",
+  "Hinge", "Wedge", "Curved", "Inverted", "Panel", "Window", "Door", "Minifigure", "Torso", "Legs",
+  "Head", "with", "Hole", "Stud", "Groove", "Clip", "Bar", "Arm", "Pattern", "Printed",
+  "1 x 1", "1 x 2", "1 x 4", "2 x 2", "2 x 4", "2 x 6", "4 x 4", "6 x 8", "45", "33"
+};
+
+static const struct
+{
+  int colorid;
+  char *name;
+} bsBenchColorList[] =
+{
+  { 1, "White" }, { 11, "Black" }, { 5, "Red" }, { 7, "Blue" }, { 3, "Yellow" },
+  { 86, "Light Bluish Gray" }, { 85, "Dark Bluish Gray" }, { 6, "Green" }, { 2, "Tan" },
+  { 88, "Reddish Brown" }, { 4, "Orange" }, { 69, "Dark Tan" }, { 12, "Trans-Clear" }, { 0, "(Not Applicable)" }
+};
+
+#define BS_BENCH_WORD_COUNT ( sizeof(bsBenchWordList) / sizeof(bsBenchWordList[0]) )
+#define BS_BENCH_COLOR_COUNT ( sizeof(bsBenchColorList) / sizeof(bsBenchColorList[0]) )
+
+
+static int bsBenchRandRange( randState *randstate, int range )
+{
+  return (int)( randInt( randstate ) % (intrand)range );
+}
+
+/* Words from the vocabulary up to about length chars */
+static void bsBenchRandWords( randState *randstate, char *buffer, int length )
+{
+  int offset;
+  const char *word;
+
+  offset = 0;
+  buffer[0] = 0;
+  while( offset < length )
+  {
+    word = bsBenchWordList[ bsBenchRandRange( randstate, BS_BENCH_WORD_COUNT ) ];
+    offset += snprintf( &buffer[ offset ], 256 - offset, "%s%s", ( offset ? " " : "" ), word );
+    if( offset >= 255 )
+      break;
+  }
+  return;
+}
+
+/* Storage bin location followed by random characters up to length chars */
+static void bsBenchRandRemarks( randState *randstate, char *buffer, int length )
+{
+  int offset;
+
+  offset = snprintf( buffer, 256, "%c%02d-%02d", 'A' + bsBenchRandRange( randstate, 26 ), bsBenchRandRange( randstate, 100 ), bsBenchRandRange( randstate, 100 ) );
+  for( ; ( offset < length ) && ( offset < 255 ) ; offset++ )
+    buffer[ offset ] = 'a' + bsBenchRandRange( randstate, 26 );
+  buffer[ CC_MIN( length, offset ) ] = 0;
+  return;
+}
+
+/* Catalog-like item ID, part numbers with print or mold suffixes, minifigures and sets */
+static char bsBenchRandItemId( randState *randstate, char *buffer, int length )
+{
+  int offset, kind;
+  char typeid;
+
+  kind = bsBenchRandRange( randstate, 100 );
+  if( kind < 85 )
+  {
+    typeid = 'P';
+    offset = snprintf( buffer, 256, "%d", 2000 + bsBenchRandRange( randstate, 98000 ) );
+    if( bsBenchRandRange( randstate, 4 ) == 0 )
+      offset += snprintf( &buffer[ offset ], 256 - offset, "pb%03d", bsBenchRandRange( randstate, 1000 ) );
+  }
+  else if( kind < 95 )
+  {
+    typeid = 'M';
+    offset = snprintf( buffer, 256, "%s%04d", ( kind & 1 ? "sw" : "cty" ), bsBenchRandRange( randstate, 10000 ) );
+  }
+  else
+  {
+    typeid = 'S';
+    offset = snprintf( buffer, 256, "%d-1", 1000 + bsBenchRandRange( randstate, 79000 ) );
+  }
+  /* Pad with mold variant letters to reach the configured length */
+  for( ; ( offset < length ) && ( offset < 255 ) ; offset++ )
+    buffer[ offset ] = 'a' + bsBenchRandRange( randstate, 26 );
+  buffer[ offset ] = 0;
+  return typeid;
+}
+
+
+static bsxInventory *bsBenchGenerateInventory( bsBenchConfig *config )
+{
+  int itemindex, colorindex;
+  int64_t lotidbase;
+  bsxItem item;
+  bsxItem *dupitem, *newitem;
+  bsxInventory *inv;
+  randState randstate;
+  char idbuffer[256], namebuffer[256], commentsbuffer[256], remarksbuffer[256];
+
+  randSeed( &randstate, config->seed );
+  inv = bsxNewInventory();
+  lotidbase = 100000000;
+  for( itemindex = 0 ; itemindex < config->lotcount ; itemindex++ )
+  {
+    bsxClearItem( &item );
+    dupitem = 0;
+    if( ( inv->itemcount ) && ( bsBenchRandRange( &randstate, 100 ) < config->duplicatepercent ) )
+      dupitem = &inv->itemlist[ bsBenchRandRange( &randstate, inv->itemcount ) ];
+    if( dupitem )
+    {
+      strcpy( idbuffer, dupitem->id );
+      item.typeid = dupitem->typeid;
+      item.colorid = dupitem->colorid;
+      item.condition = dupitem->condition;
+      item.boid = dupitem->boid;
+      strcpy( namebuffer, ( dupitem->name ? dupitem->name : "" ) );
+      colorindex = -1;
+    }
+    else
+    {
+      item.typeid = bsBenchRandItemId( &randstate, idbuffer, config->idlength );
+      colorindex = bsBenchRandRange( &randstate, BS_BENCH_COLOR_COUNT );
+      item.colorid = bsBenchColorList[ colorindex ].colorid;
+      item.condition = ( bsBenchRandRange( &randstate, 5 ) ? 'N' : 'U' );
+      /* A few items were never resolved to a BOID */
+      item.boid = ( bsBenchRandRange( &randstate, 20 ) ? 100000 + bsBenchRandRange( &randstate, 900000 ) : -1 );
+      bsBenchRandWords( &randstate, namebuffer, config->namelength );
+    }
+    /* Most lots hold a few parts, some hold hundreds */
+    item.quantity = 1 + ( bsBenchRandRange( &randstate, 10 ) ? bsBenchRandRange( &randstate, 20 ) : bsBenchRandRange( &randstate, 500 ) );
+    item.price = (float)( 1 + bsBenchRandRange( &randstate, 5000 ) ) / 100.0f;
+    item.usedgrade = ( item.condition == 'U' ? 'G' : 0 );
+    item.categoryid = 1 + bsBenchRandRange( &randstate, 500 );
+    switch( config->lotidmode )
+    {
+      case BS_BENCH_LOTID_SEQUENTIAL:
+        item.lotid = lotidbase + itemindex;
+        item.bolotid = 2 * lotidbase + itemindex;
+        break;
+      case BS_BENCH_LOTID_RANDOM:
+        item.lotid = (int64_t)( randInt64( &randstate ) & 0x7fffffffffLL );
+        item.bolotid = (int64_t)( randInt64( &randstate ) & 0x7fffffffffLL );
+        break;
+      default:
+        break;
+    }
+    item.extid = (int64_t)( randInt64( &randstate ) & 0x7fffffffffffffffLL );
+    item.id = idbuffer;
+    item.name = namebuffer;
+    if( colorindex >= 0 )
+      item.colorname = bsBenchColorList[ colorindex ].name;
+    if( config->commentslength )
+    {
+      bsBenchRandWords( &randstate, commentsbuffer, config->commentslength );
+      item.comments = commentsbuffer;
+    }
+    if( config->remarkslength )
+    {
+      bsBenchRandRemarks( &randstate, remarksbuffer, config->remarkslength );
+      item.remarks = remarksbuffer;
+    }
+    newitem = bsxAddCopyItem( inv, &item );
+    newitem->extid = item.extid;
+  }
+
+  return inv;
+}
+
+
+static bsxInventory *bsBenchCopyInventory( bsxInventory *inv )
+{
+  int itemindex;
+  bsxItem *item, *newitem;
+  bsxInventory *newinv;
+
+  newinv = bsxNewInventory();
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[ itemindex ];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    newitem = bsxAddCopyItem( newinv, item );
+    newitem->extid = item->extid;
+  }
+  return newinv;
+}
+
+/* What a service would return for the tracked inventory : some quantities changed, some lots missing, some extra */
+static bsxInventory *bsBenchMutateInventory( bsxInventory *inv, uint64_t seed )
+{
+  int itemindex, change;
+  bsxItem *item;
+  bsxInventory *newinv;
+  randState randstate;
+
+  randSeed( &randstate, seed );
+  newinv = bsBenchCopyInventory( inv );
+  for( itemindex = 0 ; itemindex < newinv->itemcount ; itemindex++ )
+  {
+    item = &newinv->itemlist[ itemindex ];
+    change = bsBenchRandRange( &randstate, 100 );
+    if( change < 5 )
+      bsxSetItemQuantity( newinv, item, item->quantity + 1 + bsBenchRandRange( &randstate, 5 ) );
+    else if( change < 6 )
+      bsxRemoveItem( newinv, item );
+    else if( change < 7 )
+    {
+      item = bsxAddCopyItem( newinv, item );
+      item->lotid = -1;
+      item->bolotid = -1;
+      item->colorid++;
+    }
+  }
+  bsxPackInventory( newinv );
+  return newinv;
+}
+
+/* Order inventory with negative quantities, as merged by bsMergeInv() after a sale */
+static bsxInventory *bsBenchOrderInventory( bsxInventory *inv, int lotcount, uint64_t seed )
+{
+  int lotindex;
+  bsxItem *item;
+  bsxInventory *orderinv;
+  randState randstate;
+
+  randSeed( &randstate, seed );
+  orderinv = bsxNewInventory();
+  for( lotindex = 0 ; lotindex < lotcount ; lotindex++ )
+  {
+    item = bsxAddCopyItem( orderinv, &inv->itemlist[ bsBenchRandRange( &randstate, inv->itemcount ) ] );
+    bsxSetItemQuantity( orderinv, item, -1 );
+  }
+  return orderinv;
+}
+
+
+////
+
+
+typedef struct
+{
+  bsBenchConfig *config;
+  const char *name;
+  const char *variant;
+  int iterations;
+  int64_t ops;
+  uint64_t *timelist;
+  uint64_t starttime;
+} bsBenchRun;
+
+static int bsBenchBegin( bsBenchRun *run, bsBenchConfig *config, const char *name, const char *variant, int64_t ops )
+{
+  if( ( config->only ) && ( strncmp( name, config->only, strlen( config->only ) ) ) )
+    return 0;
+  run->config = config;
+  run->name = name;
+  run->variant = variant;
+  run->iterations = 0;
+  run->ops = ops;
+  run->timelist = malloc( config->iterations * sizeof(uint64_t) );
+  return 1;
+}
+
+static inline void bsBenchStart( bsBenchRun *run )
+{
+  run->starttime = ccGetNanosecondsTime();
+  return;
+}
+
+static inline void bsBenchStop( bsBenchRun *run )
+{
+  run->timelist[ run->iterations++ ] = ccGetNanosecondsTime() - run->starttime;
+  return;
+}
+
+static int bsBenchTimeCmp( const void *p0, const void *p1 )
+{
+  uint64_t t0, t1;
+  t0 = *(const uint64_t *)p0;
+  t1 = *(const uint64_t *)p1;
+  return ( t0 < t1 ? -1 : ( t0 > t1 ? 1 : 0 ) );
+}
+
+static void bsBenchEnd( bsBenchRun *run )
+{
+  int index;
+  uint64_t total;
+
+  qsort( run->timelist, run->iterations, sizeof(uint64_t), bsBenchTimeCmp );
+  total = 0;
+  for( index = 0 ; index < run->iterations ; index++ )
+    total += run->timelist[ index ];
+  fprintf( run->config->output, "{\"bench\":\"%s\",\"variant\":\"%s\",\"lots\":%d,\"ops\":" CC_LLD ",\"iterations\":%d,\"min_ns\":" CC_LLD ",\"median_ns\":" CC_LLD ",\"mean_ns\":" CC_LLD ",\"ns_per_op\":%.1f}\n", run->name, ( run->variant ? run->variant : "" ), run->config->lotcount, (long long)run->ops, run->iterations, (long long)run->timelist[0], (long long)run->timelist[ run->iterations >> 1 ], (long long)( total / run->iterations ), (double)run->timelist[ run->iterations >> 1 ] / (double)CC_MAX( run->ops, 1 ) );
+  fflush( run->config->output );
+  free( run->timelist );
+  return;
+}
+
+
+////
+
+
+static const char *bsBenchSortName[BSX_SORT_COUNT] =
+{
+  [BSX_SORT_ID] = "id",
+  [BSX_SORT_NAME] = "name",
+  [BSX_SORT_TYPENAME] = "typename",
+  [BSX_SORT_COLORNAME] = "colorname",
+  [BSX_SORT_CATEGORYNAME] = "categoryname",
+  [BSX_SORT_COLORID] = "colorid",
+  [BSX_SORT_QUANTITY] = "quantity",
+  [BSX_SORT_PRICE] = "price",
+  [BSX_SORT_ORIGPRICE] = "origprice",
+  [BSX_SORT_COMMENTS] = "comments",
+  [BSX_SORT_REMARKS] = "remarks",
+  [BSX_SORT_LOTID] = "lotid",
+  [BSX_SORT_ID_COLOR_CONDITION_REMARKS_COMMENTS_QUANTITY] = "id_color_condition_remarks_comments_quantity",
+  [BSX_SORT_COLORNAME_NAME_CONDITION] = "colorname_name_condition",
+  [BSX_SORT_UPDATE_PRIORITY] = "update_priority",
+  [BSX_SORT_CHECK_LIST_ORDER] = "check_list_order"
+};
+
+static void bsBenchLoadSave( bsBenchConfig *config, bsxInventory *inv )
+{
+  int iteration;
+  bsxInventory *loadinv;
+  bsBenchRun run;
+
+  if( bsBenchBegin( &run, config, "bsxSaveInventory", 0, inv->itemcount ) )
+  {
+    for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+    {
+      bsBenchStart( &run );
+      bsxSaveInventory( BS_BENCH_TEMP_FILE, inv, 0, -1 );
+      bsBenchStop( &run );
+    }
+    bsBenchEnd( &run );
+  }
+  if( bsBenchBegin( &run, config, "bsxLoadInventory", 0, inv->itemcount ) )
+  {
+    bsxSaveInventory( BS_BENCH_TEMP_FILE, inv, 0, -1 );
+    for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+    {
+      loadinv = bsxNewInventory();
+      bsBenchStart( &run );
+      bsxLoadInventory( loadinv, BS_BENCH_TEMP_FILE );
+      bsBenchStop( &run );
+      bsxFreeInventory( loadinv );
+    }
+    bsBenchEnd( &run );
+  }
+  remove( BS_BENCH_TEMP_FILE );
+  return;
+}
+
+static void bsBenchSort( bsBenchConfig *config, bsxInventory *inv )
+{
+  int iteration, sortfield;
+  bsxInventory *sortinv;
+  bsBenchRun run;
+
+  for( sortfield = 0 ; sortfield < BSX_SORT_COUNT ; sortfield++ )
+  {
+    if( !( bsBenchBegin( &run, config, "bsxSortInventory", bsBenchSortName[ sortfield ], inv->itemcount ) ) )
+      return;
+    for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+    {
+      /* Sort a copy in generation order each time, sorting sorted data measures nothing */
+      sortinv = bsBenchCopyInventory( inv );
+      bsBenchStart( &run );
+      bsxSortInventory( sortinv, sortfield, 0 );
+      bsBenchStop( &run );
+      bsxFreeInventory( sortinv );
+    }
+    bsBenchEnd( &run );
+  }
+  return;
+}
+
+enum
+{
+  BS_BENCH_FIND_MATCH,
+  BS_BENCH_FIND_ITEM,
+  BS_BENCH_FIND_LOTID,
+  BS_BENCH_FIND_OWLLOTID,
+  BS_BENCH_FIND_EXTID,
+
+  BS_BENCH_FIND_COUNT
+};
+
+static const char *bsBenchFindName[BS_BENCH_FIND_COUNT] =
+{
+  [BS_BENCH_FIND_MATCH] = "bsxFindMatchItem",
+  [BS_BENCH_FIND_ITEM] = "bsxFindItem",
+  [BS_BENCH_FIND_LOTID] = "bsxFindLotID",
+  [BS_BENCH_FIND_OWLLOTID] = "bsxFindOwlLotID",
+  [BS_BENCH_FIND_EXTID] = "bsxFindExtID"
+};
+
+static void bsBenchFind( bsBenchConfig *config, bsxInventory *inv )
+{
+  int iteration, findindex, lookupindex, foundcount;
+  int *lookuplist;
+  bsxItem *item;
+  bsBenchRun run;
+  randState randstate;
+
+  randSeed( &randstate, config->seed + 1 );
+  lookuplist = malloc( config->lookupcount * sizeof(int) );
+  for( lookupindex = 0 ; lookupindex < config->lookupcount ; lookupindex++ )
+    lookuplist[ lookupindex ] = bsBenchRandRange( &randstate, inv->itemcount );
+  for( findindex = 0 ; findindex < BS_BENCH_FIND_COUNT ; findindex++ )
+  {
+    if( ( config->lotidmode == BS_BENCH_LOTID_NONE ) && ( ( findindex == BS_BENCH_FIND_LOTID ) || ( findindex == BS_BENCH_FIND_OWLLOTID ) ) )
+      continue;
+    if( !( bsBenchBegin( &run, config, bsBenchFindName[ findindex ], 0, config->lookupcount ) ) )
+      continue;
+    foundcount = 0;
+    for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+    {
+      bsBenchStart( &run );
+      for( lookupindex = 0 ; lookupindex < config->lookupcount ; lookupindex++ )
+      {
+        item = &inv->itemlist[ lookuplist[ lookupindex ] ];
+        switch( findindex )
+        {
+          case BS_BENCH_FIND_MATCH:
+            item = bsxFindMatchItem( inv, item );
+            break;
+          case BS_BENCH_FIND_ITEM:
+            item = bsxFindItem( inv, item->typeid, item->id, item->colorid, item->condition );
+            break;
+          case BS_BENCH_FIND_LOTID:
+            item = bsxFindLotID( inv, item->lotid );
+            break;
+          case BS_BENCH_FIND_OWLLOTID:
+            item = bsxFindOwlLotID( inv, item->bolotid );
+            break;
+          default:
+            item = bsxFindExtID( inv, item->extid );
+            break;
+        }
+        foundcount += ( item ? 1 : 0 );
+      }
+      bsBenchStop( &run );
+    }
+    bsBenchEnd( &run );
+    if( foundcount != config->iterations * config->lookupcount )
+      fprintf( stderr, "WARNING: %s found only %d of %d items.\n", bsBenchFindName[ findindex ], foundcount, config->iterations * config->lookupcount );
+  }
+  free( lookuplist );
+  return;
+}
+
+static void bsBenchDiff( bsBenchConfig *config, bsxInventory *inv )
+{
+  int iteration;
+  bsxInventory *stockinv, *diffinv;
+  bsBenchRun run;
+
+  if( !( bsBenchBegin( &run, config, "bsxDiffInventory", 0, inv->itemcount ) ) )
+    return;
+  stockinv = bsBenchMutateInventory( inv, config->seed + 2 );
+  for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+  {
+    bsBenchStart( &run );
+    diffinv = bsxDiffInventory( stockinv, inv );
+    bsBenchStop( &run );
+    bsxFreeInventory( diffinv );
+  }
+  bsBenchEnd( &run );
+  bsxFreeInventory( stockinv );
+  return;
+}
+
+static void bsBenchSyncDelta( bsBenchConfig *config, bsContext *context, bsxInventory *inv )
+{
+  int iteration, deltamode;
+  bsxInventory *remoteinv, *stockinv, *deltainv;
+  bsSyncStats stats;
+  bsBenchRun run;
+
+  remoteinv = bsBenchMutateInventory( inv, config->seed + 3 );
+  for( deltamode = 0 ; deltamode < BS_SYNC_DELTA_MODE_COUNT ; deltamode++ )
+  {
+    if( !( bsBenchBegin( &run, config, "bsSyncComputeDeltaInv", ( deltamode == BS_SYNC_DELTA_MODE_BRICKLINK ? "bricklink" : "brickowl" ), inv->itemcount ) ) )
+      break;
+    for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+    {
+      /* The stock inventory is modified, assigned ExtIDs and such */
+      stockinv = bsBenchCopyInventory( remoteinv );
+      bsBenchStart( &run );
+      deltainv = bsSyncComputeDeltaInv( context, stockinv, inv, &stats, deltamode );
+      bsBenchStop( &run );
+      bsxFreeInventory( deltainv );
+      bsxFreeInventory( stockinv );
+    }
+    bsBenchEnd( &run );
+  }
+  bsxFreeInventory( remoteinv );
+  return;
+}
+
+static void bsBenchMerge( bsBenchConfig *config, bsContext *context, bsxInventory *inv )
+{
+  int iteration;
+  bsxInventory *orderinv;
+  bsMergeInvStats stats;
+  bsBenchRun run;
+
+  orderinv = bsBenchOrderInventory( inv, CC_MAX( inv->itemcount / 100, 1 ), config->seed + 4 );
+  if( !( bsBenchBegin( &run, config, "bsMergeInv", 0, orderinv->itemcount ) ) )
+  {
+    bsxFreeInventory( orderinv );
+    return;
+  }
+  for( iteration = 0 ; iteration < config->iterations ; iteration++ )
+  {
+    context->inventory = bsBenchCopyInventory( inv );
+    context->bricklink.diffinv = bsxNewInventory();
+    context->brickowl.diffinv = bsxNewInventory();
+    bsBenchStart( &run );
+    bsMergeInv( context, orderinv, &stats, BS_MERGE_FLAGS_UPDATE_BRICKLINK | BS_MERGE_FLAGS_UPDATE_BRICKOWL );
+    bsBenchStop( &run );
+    bsxFreeInventory( context->inventory );
+    bsxFreeInventory( context->bricklink.diffinv );
+    bsxFreeInventory( context->brickowl.diffinv );
+    context->inventory = 0;
+    context->bricklink.diffinv = 0;
+    context->brickowl.diffinv = 0;
+  }
+  bsBenchEnd( &run );
+  bsxFreeInventory( orderinv );
+  return;
+}
+
+
+////
+
+
+static void bsBenchUsage( char *progname )
+{
+  fprintf( stderr, "Usage: %s [options]\n", progname );
+  fprintf( stderr, "  -lots N          Count of lots to generate (default 20000)\n" );
+  fprintf( stderr, "  -idlen N         Minimum length of item IDs (default 0)\n" );
+  fprintf( stderr, "  -namelen N       Length of item names (default 32)\n" );
+  fprintf( stderr, "  -commentslen N   Length of comments, zero for none (default 16)\n" );
+  fprintf( stderr, "  -remarkslen N    Length of remarks, zero for none (default 8)\n" );
+  fprintf( stderr, "  -dup PERCENT     Lots duplicating the ID, color and condition of another (default 2)\n" );
+  fprintf( stderr, "  -lotid MODE      LotID distribution : sequential, random or none (default sequential)\n" );
+  fprintf( stderr, "  -seed N          Seed of the generator (default 1)\n" );
+  fprintf( stderr, "  -iter N          Timed iterations per benchmark (default 5)\n" );
+  fprintf( stderr, "  -lookups N       Lookups per iteration of the bsxFind benchmarks (default 1000)\n" );
+  fprintf( stderr, "  -only NAME       Run only the benchmarks whose name begins with NAME\n" );
+  fprintf( stderr, "  -log DIR         Log to DIR at BrickSync's default levels, logging is disabled otherwise\n" );
+  fprintf( stderr, "  -o PATH          Write results to PATH instead of stdout, where logging also prints\n" );
+  fprintf( stderr, "  -g PATH          Save the generated inventory to PATH and exit\n" );
+  return;
+}
+
+static int bsBenchParseArgs( bsBenchConfig *config, int argc, char **argv )
+{
+  int argindex;
+  int32_t readint;
+  int64_t readint64;
+  char *arg, *value;
+
+  for( argindex = 1 ; argindex < argc ; argindex++ )
+  {
+    arg = argv[ argindex ];
+    if( argindex + 1 >= argc )
+      return 0;
+    value = argv[ ++argindex ];
+    if( !( strcmp( arg, "-lotid" ) ) )
+    {
+      if( !( strcmp( value, "sequential" ) ) )
+        config->lotidmode = BS_BENCH_LOTID_SEQUENTIAL;
+      else if( !( strcmp( value, "random" ) ) )
+        config->lotidmode = BS_BENCH_LOTID_RANDOM;
+      else if( !( strcmp( value, "none" ) ) )
+        config->lotidmode = BS_BENCH_LOTID_NONE;
+      else
+        return 0;
+    }
+    else if( !( strcmp( arg, "-only" ) ) )
+      config->only = value;
+    else if( !( strcmp( arg, "-g" ) ) )
+      config->generatepath = value;
+    else if( !( strcmp( arg, "-log" ) ) )
+      config->logpath = value;
+    else if( !( strcmp( arg, "-o" ) ) )
+      config->outputpath = value;
+    else if( !( strcmp( arg, "-seed" ) ) )
+    {
+      if( !( ccStrParseInt64( value, &readint64 ) ) )
+        return 0;
+      config->seed = (uint64_t)readint64;
+    }
+    else
+    {
+      if( !( ccStrParseInt32( value, &readint ) ) || ( readint < 0 ) )
+        return 0;
+      if( !( strcmp( arg, "-lots" ) ) )
+        config->lotcount = (int)readint;
+      else if( !( strcmp( arg, "-idlen" ) ) )
+        config->idlength = CC_MIN( (int)readint, 200 );
+      else if( !( strcmp( arg, "-namelen" ) ) )
+        config->namelength = CC_MIN( (int)readint, 200 );
+      else if( !( strcmp( arg, "-commentslen" ) ) )
+        config->commentslength = CC_MIN( (int)readint, 200 );
+      else if( !( strcmp( arg, "-remarkslen" ) ) )
+        config->remarkslength = CC_MIN( (int)readint, 200 );
+      else if( !( strcmp( arg, "-dup" ) ) )
+        config->duplicatepercent = CC_MIN( (int)readint, 100 );
+      else if( !( strcmp( arg, "-iter" ) ) )
+        config->iterations = CC_MAX( (int)readint, 1 );
+      else if( !( strcmp( arg, "-lookups" ) ) )
+        config->lookupcount = CC_MAX( (int)readint, 1 );
+      else
+        return 0;
+    }
+  }
+  if( config->lotcount < 1 )
+    return 0;
+  return 1;
+}
+
+
+int main( int argc, char **argv )
+{
+  bsBenchConfig config;
+  bsContext *context;
+  bsxInventory *inv;
+
+  memset( &config, 0, sizeof(bsBenchConfig) );
+  config.lotcount = 20000;
+  config.namelength = 32;
+  config.commentslength = 16;
+  config.remarkslength = 8;
+  config.duplicatepercent = 2;
+  config.lotidmode = BS_BENCH_LOTID_SEQUENTIAL;
+  config.seed = 1;
+  config.iterations = 5;
+  config.lookupcount = 1000;
+  if( !( bsBenchParseArgs( &config, argc, argv ) ) )
+  {
+    bsBenchUsage( argv[0] );
+    return 1;
+  }
+
+  mmInit();
+
+  inv = bsBenchGenerateInventory( &config );
+  if( config.generatepath )
+  {
+    if( !( bsxSaveInventory( config.generatepath, inv, 0, -1 ) ) )
+      return 1;
+    fprintf( stderr, "Generated %d lots, %d parts in %s\n", inv->itemcount, inv->partcount, config.generatepath );
+    bsxFreeInventory( inv );
+    return 0;
+  }
+
+  config.output = stdout;
+  if( ( config.outputpath ) && !( config.output = fopen( config.outputpath, "w" ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to open %s for writing\n", config.outputpath );
+    return 1;
+  }
+
+  /* Just what bsSyncComputeDeltaInv() and bsMergeInv() look at */
+  context = malloc( sizeof(bsContext) );
+  memset( context, 0, sizeof(bsContext) );
+  randSeed( &context->randstate, config.seed );
+  if( ( config.logpath ) && !( ioLogInit( &context->output, config.logpath, 10 ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to open log in %s\n", config.logpath );
+    return 1;
+  }
+
+  fprintf( config.output, "{\"bsbench\":\"%s\",\"lots\":%d,\"parts\":%d,\"idlen\":%d,\"namelen\":%d,\"commentslen\":%d,\"remarkslen\":%d,\"dup\":%d,\"lotid\":\"%s\",\"seed\":" CC_LLD ",\"iterations\":%d,\"logging\":%d}\n", BS_VERSION_STRING, inv->itemcount, inv->partcount, config.idlength, config.namelength, config.commentslength, config.remarkslength, config.duplicatepercent, bsBenchLotIdModeName[ config.lotidmode ], (long long)config.seed, config.iterations, ( config.logpath ? 1 : 0 ) );
+
+  bsBenchLoadSave( &config, inv );
+  bsBenchSort( &config, inv );
+  bsBenchFind( &config, inv );
+  bsBenchDiff( &config, inv );
+  bsBenchSyncDelta( &config, context, inv );
+  bsBenchMerge( &config, context, inv );
+
+  if( config.logpath )
+    ioLogEnd( &context->output );
+  if( config.outputpath )
+    fclose( config.output );
+  free( context );
+  bsxFreeInventory( inv );
+
+  return 0;
+}
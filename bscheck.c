@@ -181,6 +181,7 @@ static int bsCheckBrickLinkOrder( bsContext *context, bsOrder *order, bsxInvento
       return 0;
     }
     journalFree( &journal );
+    bsOrderDirCommit( context );
 
     ioPrintf( &context->output, 0, BSMSG_INFO "Tracked inventory adjusted for BrickLink Order " IO_GREEN "#"CC_LLD"" IO_DEFAULT ".\n", (long long)order->id );
   }
@@ -382,6 +383,7 @@ static int bsCheckBrickOwlOrder( bsContext *context, bsOrder *order, bsxInventor
     return 0;
   }
   journalFree( &journal );
+  bsOrderDirCommit( context );
 
   ioPrintf( &context->output, 0, BSMSG_INFO "Tracked inventory adjusted for BrickOwl Order " IO_GREEN "#"CC_LLD"" IO_DEFAULT ".\n", (long long)order->id );
 
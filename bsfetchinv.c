@@ -122,7 +122,7 @@ bsxInventory *bsQueryBrickLinkInventory( bsContext *context )
   DEBUG_SET_TRACKER();
 
   bsTrackerInit( &tracker, context->bricklink.http );
-  inv = bsxNewInventory();
+  inv = bsxNewArenaInventory();
   ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Fetching the BrickLink Inventory...\n" );
   for( ; ; )
   {
@@ -158,8 +158,9 @@ bsxInventory *bsQueryBrickLinkFullState( bsContext *context, bsOrderList *orderl
   bsOrderList orderlistcheck;
   bsxInventory *inv;
   time_t synctime;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "bricklink_fullstate" );
 
   /* Get past orders in respect to inventory */
   /* Loop over if order list changed while retrieving inventory */
@@ -199,7 +200,7 @@ bsxInventory *bsQueryBrickLinkFullState( bsContext *context, bsOrderList *orderl
 
     /* An order arrived while we were fetching the inventory, isn't that neat? Yeah, start over. */
     ioPrintf( &context->output, 0, BSMSG_INFO "An order arrived while we were retrieving the inventory.\n" );
-    bsxEmptyInventory( inv );
+    bsxFreeInventory( inv );
     blFreeOrderList( &orderlistcheck );
   }
 
@@ -207,6 +208,7 @@ bsxInventory *bsQueryBrickLinkFullState( bsContext *context, bsOrderList *orderl
   if( !( inv->itemcount - inv->itemfreecount ) )
     ioPrintf( &context->output, 0, BSMSG_WARNING "Is your BrickLink store closed? The inventory of a closed store appears totally empty from the API.\n" );
   blFreeOrderList( &orderlistcheck );
+  DEBUG_PROFILE_END( &profile );
   return inv;
 
   errorstep2:
@@ -214,6 +216,7 @@ bsxInventory *bsQueryBrickLinkFullState( bsContext *context, bsOrderList *orderl
   errorstep1:
   blFreeOrderList( orderlist );
   errorstep0:
+  DEBUG_PROFILE_END( &profile );
   return 0;
 }
 
@@ -273,7 +276,7 @@ bsxInventory *bsQueryBrickOwlInventory( bsContext *context )
   DEBUG_SET_TRACKER();
 
   bsTrackerInit( &tracker, context->brickowl.http );
-  inv = bsxNewInventory();
+  inv = bsxNewArenaInventory();
   for( ; ; )
   {
     ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Fetching the BrickOwl Inventory...\n" );
@@ -305,8 +308,9 @@ bsxInventory *bsQueryBrickOwlFullState( bsContext *context, bsOrderList *orderli
   bsOrderList orderlistcheck;
   time_t synctime;
   bsxInventory *inv;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "brickowl_fullstate" );
 
   /* Get past orders in respect to inventory */
   /* Loop over if order list changed while retrieving inventory */
@@ -352,6 +356,7 @@ bsxInventory *bsQueryBrickOwlFullState( bsContext *context, bsOrderList *orderli
 
   ioPrintf( &context->output, 0, BSMSG_INFO "BrickOwl inventory has " IO_CYAN "%d" IO_DEFAULT " items in " IO_CYAN "%d" IO_DEFAULT " lots.\n", inv->partcount, inv->itemcount );
   boFreeOrderList( &orderlistcheck );
+  DEBUG_PROFILE_END( &profile );
   return inv;
 
   errorstep2:
@@ -359,6 +364,7 @@ bsxInventory *bsQueryBrickOwlFullState( bsContext *context, bsOrderList *orderli
   errorstep1:
   boFreeOrderList( orderlist );
   errorstep0:
+  DEBUG_PROFILE_END( &profile );
   return 0;
 }
 
@@ -89,7 +89,7 @@ static void bsBrickLinkReplyOrderInventory( void *uservalue, int resultcode, htt
   {
     bsOrder *order;
     order = (bsOrder *)reply->extpointer;
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Saving the raw data of inventory for BrickLink order #"CC_LLD" as \"rawdataorder.txt\".\n", (long long)order->id );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Saving the raw data of inventory for BrickLink order #"CC_LLD" as \"rawdataorder.txt\".\n", (long long)order->id );
     ccFileStore( "rawdataorder.txt", response->body, response->bodysize, 0 );
   }
 #endif
@@ -110,7 +110,7 @@ static void bsBrickLinkReplyOrderInventory( void *uservalue, int resultcode, htt
 #if BS_ENABLE_DEBUG_OUTPUT
     bsOrder *order;
     order = (bsOrder *)reply->extpointer;
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Received inventory data for BrickLink order #"CC_LLD", parsing now.\n", (long long)order->id );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Received inventory data for BrickLink order #"CC_LLD", parsing now.\n", (long long)order->id );
 #endif
     if( !( blReadInventory( inv, (char *)response->body, &context->output ) ) )
     {
@@ -151,10 +151,10 @@ int bsQueueBrickLinkFetchOrders( bsContext *context, bsOrderList *bsOrderlist, b
       continue;
 
 #if BS_ENABLE_DEBUG_OUTPUT
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Queue query to fetch BrickLink order #"CC_LLD".\n", (long long)order->id );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Queue query to fetch BrickLink order #"CC_LLD".\n", (long long)order->id );
 #endif
 
-    inv = bsxNewInventory();
+    inv = bsxNewArenaInventory();
     pathstring = ccStrAllocPrintf( "/api/store/v1/orders/"CC_LLD"/items", (long long)order->id );
     reply = bsAllocReply( context, BS_QUERY_TYPE_BRICKLINK, orderindex, (void *)order, (void *)inv );
     bsBrickLinkAddQuery( context, "GET", pathstring, 0, 0, (void *)reply, bsBrickLinkReplyOrderInventory );
@@ -175,11 +175,12 @@ int bsFetchBrickLinkOrders( bsContext *context, bsOrderList *orderlist, int64_t
   bsQueryReply *reply, *replynext;
   bsWorkList worklist;
   bsTracker tracker;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "bricklink_orderinv" );
 
 #if BS_ENABLE_DEBUG_OUTPUT
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Fetching inventory of BrickLink orders, refps : "CC_LLD" "CC_LLD".\n", (long long)basetimestamp, (long long)pendingtimestamp );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Fetching inventory of BrickLink orders, refps : "CC_LLD" "CC_LLD".\n", (long long)basetimestamp, (long long)pendingtimestamp );
 #endif
 
   /* Put that loop in a function somewhere? */
@@ -198,7 +199,7 @@ int bsFetchBrickLinkOrders( bsContext *context, bsOrderList *orderlist, int64_t
       waitcount = context->bricklink.querycount - 1;
 
 #if BS_ENABLE_DEBUG_SPECIAL
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "We have %d BrickLink API queries in queue.\n", context->bricklink.querycount );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "We have %d BrickLink API queries in queue.\n", context->bricklink.querycount );
 #endif
 
     /* Wait for replies */
@@ -213,7 +214,7 @@ int bsFetchBrickLinkOrders( bsContext *context, bsOrderList *orderlist, int64_t
       bsTrackerAccumResult( context, &tracker, reply->result, BS_TRACKER_ACCUM_FLAGS_CANRETRY );
 
 #if BS_ENABLE_DEBUG_SPECIAL
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Reply result code : %d\n", reply->result );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Reply result code : %d\n", reply->result );
 #endif
 
       /* If query wasn't successfull, clear bit to ask for it again */
@@ -228,7 +229,7 @@ int bsFetchBrickLinkOrders( bsContext *context, bsOrderList *orderlist, int64_t
         order = (bsOrder *)reply->extpointer;
 
 #if BS_ENABLE_DEBUG_SPECIAL
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "bsFetchBrickLinkOrders(), calling processorder(%p,%p) on order %d\n", order, inv, (int)order->id );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "bsFetchBrickLinkOrders(), calling processorder(%p,%p) on order %d\n", order, inv, (int)order->id );
 #endif
 
         if( !( processorder( context, order, inv, uservalue ) ) )
@@ -240,6 +241,7 @@ int bsFetchBrickLinkOrders( bsContext *context, bsOrderList *orderlist, int64_t
   }
 
   mmBitMapFree( &worklist.bitmap );
+  DEBUG_PROFILE_END( &profile );
   return ( tracker.failureflag ? 0 : 1 );
 }
 
@@ -314,10 +316,10 @@ int bsQueueBrickOwlFetchOrders( bsContext *context, bsOrderList *bsOrderlist, bs
       continue;
 
 #if BS_ENABLE_DEBUG_OUTPUT
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Queue query to fetch BrickOwl order #"CC_LLD".\n", (long long)order->id );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Queue query to fetch BrickOwl order #"CC_LLD".\n", (long long)order->id );
 #endif
 
-    inv = bsxNewInventory();
+    inv = bsxNewArenaInventory();
     querystring = ccStrAllocPrintf( "GET /v1/order/items?key=%s&order_id="CC_LLD" HTTP/1.1\r\nHost: api.brickowl.com\r\nConnection: Keep-Alive\r\n\r\n", context->brickowl.key, (long long)order->id );
     reply = bsAllocReply( context, BS_QUERY_TYPE_BRICKOWL, orderindex, (void *)order, (void *)inv );
     bsBrickOwlAddQuery( context, querystring, HTTP_QUERY_FLAGS_RETRY, (void *)reply, bsBrickOwlReplyOrderInventory );
@@ -338,11 +340,12 @@ int bsFetchBrickOwlOrders( bsContext *context, bsOrderList *orderlist, int64_t b
   bsQueryReply *reply, *replynext;
   bsWorkList worklist;
   bsTracker tracker;
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "brickowl_orderinv" );
 
 #if BS_ENABLE_DEBUG_OUTPUT
-  ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Fetching inventory of BrickOwl orders, reference timestamps : "CC_LLD" "CC_LLD".\n", (long long)basetimestamp, (long long)pendingtimestamp );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Fetching inventory of BrickOwl orders, reference timestamps : "CC_LLD" "CC_LLD".\n", (long long)basetimestamp, (long long)pendingtimestamp );
 #endif
 
   /* Put that loop in a function somewhere? */
@@ -361,7 +364,7 @@ int bsFetchBrickOwlOrders( bsContext *context, bsOrderList *orderlist, int64_t b
       waitcount = context->brickowl.querycount - 1;
 
 #if BS_ENABLE_DEBUG_SPECIAL
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "We have %d BrickOwl API queries in queue.\n", context->brickowl.querycount );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "We have %d BrickOwl API queries in queue.\n", context->brickowl.querycount );
 #endif
 
     /* Wait for replies */
@@ -376,7 +379,7 @@ int bsFetchBrickOwlOrders( bsContext *context, bsOrderList *orderlist, int64_t b
       bsTrackerAccumResult( context, &tracker, reply->result, BS_TRACKER_ACCUM_FLAGS_CANRETRY );
 
 #if BS_ENABLE_DEBUG_SPECIAL
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Reply result code : %d\n", reply->result );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_DEBUG, IO_MODEBIT_FLUSH | IO_MODEBIT_LOGONLY, BSMSG_DEBUG "Reply result code : %d\n", reply->result );
 #endif
 
       /* If query wasn't successfull, clear bit to ask for it again */
@@ -398,6 +401,7 @@ int bsFetchBrickOwlOrders( bsContext *context, bsOrderList *orderlist, int64_t b
   }
 
   mmBitMapFree( &worklist.bitmap );
+  DEBUG_PROFILE_END( &profile );
   return ( tracker.failureflag ? 0 : 1 );
 }
 
@@ -128,11 +128,12 @@ int bsQueryBickLinkOrderList( bsContext *context, bsOrderList *orderlist, int64_
 {
   bsQueryReply *reply;
   bsTracker tracker;
+  debugProfileScope profile;
   // Set the current date and time for printout in the fetch message
   char bl_fetch_date_time[64];
   getFetchTimeStamp(bl_fetch_date_time, 64);
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "bricklink_orderlist" );
 
   bsTrackerInit( &tracker, context->bricklink.http );
   ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Fetching the BrickLink Order List (" IO_CYAN "%s" IO_DEFAULT ")...\n", bl_fetch_date_time);
@@ -147,7 +148,10 @@ int bsQueryBickLinkOrderList( bsContext *context, bsOrderList *orderlist, int64_
     if( bsTrackerProcessGenericReplies( context, &tracker, 1 ) )
       break;
     if( tracker.failureflag )
+    {
+      DEBUG_PROFILE_END( &profile );
       return 0;
+    }
   }
 
   if( ( minimumorderdate | minimumchangedate ) )
@@ -155,6 +159,7 @@ int bsQueryBickLinkOrderList( bsContext *context, bsOrderList *orderlist, int64_
 
   orderlist->infolevel = BS_ORDER_INFOLEVEL_DETAILS;
 
+  DEBUG_PROFILE_END( &profile );
   return 1;
 }
 
@@ -164,7 +169,7 @@ int bsQueryUpgradeBickLinkOrderList( bsContext *context, bsOrderList *orderlist,
 {
   if( infolevel >= BS_ORDER_INFOLEVEL_FULL )
   {
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Not yet supported! %s:%d\n", __FILE__, __LINE__ );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Not yet supported! %s:%d\n", __FILE__, __LINE__ );
 
     orderlist->infolevel = BS_ORDER_INFOLEVEL_FULL;
   }
@@ -263,11 +268,12 @@ int bsQueryBickOwlOrderList( bsContext *context, bsOrderList *orderlist, int64_t
   char *querystring;
   bsTracker tracker;
   bsOrder *order;
+  debugProfileScope profile;
   // Set the current date and time for printout in the fetch message
   char bo_fetch_date_time[64];
   getFetchTimeStamp(bo_fetch_date_time, 64);
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "brickowl_orderlist" );
 
   bsTrackerInit( &tracker, context->brickowl.http );
   ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Fetching the BrickOwl Order List (" IO_CYAN "%s" IO_DEFAULT ")...\n", bo_fetch_date_time);
@@ -284,7 +290,10 @@ int bsQueryBickOwlOrderList( bsContext *context, bsOrderList *orderlist, int64_t
     if( bsTrackerProcessGenericReplies( context, &tracker, 1 ) )
       break;
     if( tracker.failureflag )
+    {
+      DEBUG_PROFILE_END( &profile );
       return 0;
+    }
   }
 
   if( ( minimumorderdate | minimumchangedate ) )
@@ -292,6 +301,7 @@ int bsQueryBickOwlOrderList( bsContext *context, bsOrderList *orderlist, int64_t
 
   orderlist->infolevel = BS_ORDER_INFOLEVEL_BASE;
 
+  DEBUG_PROFILE_END( &profile );
   return 1;
 }
 
@@ -314,7 +324,7 @@ int bsQueryUpgradeBickOwlOrderList( bsContext *context, bsOrderList *orderlist,
     for( orderindex = 0 ; orderindex < orderlist->ordercount ; orderindex++ )
     {
       order = &orderlist->orderarray[ orderindex ];
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_FLUSH, "LOG: Fetching details for BrickOwl order #" CC_LLD ".\n", (long long)order->id );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_FLUSH, "LOG: Fetching details for BrickOwl order #" CC_LLD ".\n", (long long)order->id );
       /* Add an OrderView query */
       querystring = ccStrAllocPrintf( "GET /v1/order/view?key=%s&order_id=" CC_LLD " HTTP/1.1\r\nHost: api.brickowl.com\r\nConnection: Keep-Alive\r\n\r\n", context->brickowl.key, (long long)order->id );
       reply = bsAllocReply( context, BS_QUERY_TYPE_BRICKOWL, 0, 0, (void *)order );
@@ -325,10 +335,10 @@ int bsQueryUpgradeBickOwlOrderList( bsContext *context, bsOrderList *orderlist,
 
       /* Free all queued replies */
       if( !( bsTrackerProcessGenericReplies( context, &tracker, 1 ) ) )
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to fetch details for BrickOwl Order " IO_RED "#" CC_LLD IO_WHITE ", skipping.\n", (long long)order->id );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to fetch details for BrickOwl Order " IO_RED "#" CC_LLD IO_WHITE ", skipping.\n", (long long)order->id );
       if( tracker.failureflag )
       {
-        ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Giving up on fetching BrickOwl order details.\n" );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_ORDER, IO_LOG_LEVEL_WARNING, IO_MODEBIT_FLUSH, BSMSG_WARNING "Giving up on fetching BrickOwl order details.\n" );
         break;
       }
     }
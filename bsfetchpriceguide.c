@@ -72,112 +72,105 @@
 ////
 
 
-static const size_t blPriceGuideOffsetTable[2][6] =
+typedef struct
 {
-  {
-    offsetof(bsxPriceGuide,salecount), offsetof(bsxPriceGuide,saleqty),
-    offsetof(bsxPriceGuide,saleminimum), offsetof(bsxPriceGuide,saleaverage),
-    offsetof(bsxPriceGuide,saleqtyaverage), offsetof(bsxPriceGuide,salemaximum)
-  },
-  {
-    offsetof(bsxPriceGuide,stockcount), offsetof(bsxPriceGuide,stockqty),
-    offsetof(bsxPriceGuide,stockminimum), offsetof(bsxPriceGuide,stockaverage),
-    offsetof(bsxPriceGuide,stockqtyaverage), offsetof(bsxPriceGuide,stockmaximum)
-  }
-};
+  bsxInventory *inv;
+  void *callbackpointer;
+  void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
+  /* Chain of other flagged items sharing the same type, id and color, -1 terminated */
+  int *nextlist;
+} bsFetchPriceGuideCallback;
 
-static int blHtmlParsePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *string, int stringlength )
+/* Per query state, the summary tables are extracted as the page arrives */
+typedef struct
 {
-  int section, sub, value;
-  int64_t curtime;
-  char *sectionstr[2], *substr[2];
-  char *valstr;
-  void *writeaddr;
-  bsxPriceGuide *pg;
-  bsxPriceGuide pgdummy;
+  bsQueryReply *reply;
+  blPriceGuideExtractor extractor;
+} bsFetchPriceGuideQuery;
+
+
+/* Link all flagged items with the same (type, id, color) to the first one, return count of unique keys */
+static int bsPlanBrickLinkPriceGuide( bsxInventory *inv, int *nextlist, mmBitMap *skipmap )
+{
+  int itemindex, keycount, lastindex;
+  uint32_t hashmask, hashindex;
+  int *hashtable, *lastlist;
+  bsxItem *item, *leader;
 
   DEBUG_SET_TRACKER();
 
-  if( !( pgnew ) )
-    pgnew = &pgdummy;
-  if( !( pgused ) )
-    pgused = &pgdummy;
-
-  memset( pgnew, 0, sizeof(bsxPriceGuide) );
-  memset( pgused, 0, sizeof(bsxPriceGuide) );
-  sectionstr[0] = ccSeqFindStrSkip( string, stringlength, "Past 6 Months Sales" );
-  sectionstr[1] = ccSeqFindStrSkip( string, stringlength, "Current Items for Sale" );
-  string[stringlength-1] = 0;
-  if( sectionstr[0] )
-    sectionstr[0][-1] = 0;
-  if( sectionstr[1] )
-    sectionstr[1][-1] = 0;
-
-  for( section = 0 ; section < 2 ; section++ )
+  for( hashmask = 255 ; hashmask < 2 * (uint32_t)inv->itemcount ; hashmask = ( hashmask << 1 ) | 0x1 );
+  hashtable = malloc( ( hashmask + 1 ) * sizeof(int) );
+  memset( hashtable, -1, ( hashmask + 1 ) * sizeof(int) );
+  lastlist = malloc( ( inv->itemcount + 1 ) * sizeof(int) );
+  keycount = 0;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
   {
-    /* Get sale numbers out */
-    if( !( sectionstr[section] ) )
+    nextlist[itemindex] = -1;
+    item = &inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || !( item->flags & BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE ) || !( item->id ) )
       continue;
-    substr[0] = ccStrFindStrSkip( sectionstr[section], "New" );
-    substr[1] = ccStrFindStrSkip( sectionstr[section], "Used" );
-    for( sub = 0 ; sub < 2 ; sub++ )
+    for( hashindex = ( ccHash32Data( item->id, strlen( item->id ) ) ^ ccHash32Int32Inline( ( item->colorid << 8 ) | (unsigned char)item->typeid ) ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
     {
-      valstr = substr[sub];
-      if( !( valstr ) )
-        continue;
-      pg = ( sub ? pgused : pgnew );
-      for( value = 0 ; value < 2 ; value++ )
+      if( hashtable[hashindex] == -1 )
       {
-        writeaddr = ADDRESS( pg, blPriceGuideOffsetTable[section][value] );
-        valstr = ccStrFindStrSkip( valstr, "SIZE=\"2\">&nbsp;" );
-        if( !( valstr ) )
-          return 0;
-        if( sscanf( valstr, "%d", (int *)writeaddr ) != 1 )
-          return 0;
+        hashtable[hashindex] = itemindex;
+        lastlist[itemindex] = itemindex;
+        keycount++;
+        break;
       }
-      for( ; value < 6 ; value++ )
+      leader = &inv->itemlist[ hashtable[hashindex] ];
+      if( ( leader->typeid == item->typeid ) && ( leader->colorid == item->colorid ) && ( strcmp( leader->id, item->id ) == 0 ) )
       {
-        writeaddr = ADDRESS( pg, blPriceGuideOffsetTable[section][value] );
-        valstr = ccStrFindStrSkip( valstr, "SIZE=\"2\">&nbsp;" );
-        if( !( valstr ) )
-          return 0;
-        if( sscanf( valstr, "$%f", (float *)writeaddr ) != 1 )
-          return 0;
+        /* Append to the chain of the first item, only that one gets queried */
+        lastindex = lastlist[ hashtable[hashindex] ];
+        nextlist[lastindex] = itemindex;
+        lastlist[ hashtable[hashindex] ] = itemindex;
+        mmBitMapDirectSet( skipmap, itemindex );
+        break;
       }
     }
   }
+  free( lastlist );
+  free( hashtable );
 
-  curtime = time( 0 );
-  pgnew->modtime = curtime;
-  pgused->modtime = curtime;
-  return 1;
+  return keycount;
 }
 
 
-////
-
-
-typedef struct
+/* Feed body fragments to the extractor, the rest of the page isn't needed once it has the tables */
+static int bsBrickLinkStreamPriceGuide( void *uservalue, void *data, size_t datasize )
 {
-  bsxInventory *inv;
-  void *callbackpointer;
-  void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
-} bsFetchPriceGuideCallback;
+  bsFetchPriceGuideQuery *pgquery;
+
+  DEBUG_SET_TRACKER();
 
+  pgquery = uservalue;
+  if( !( data ) )
+  {
+    blPriceGuideExtractorInit( &pgquery->extractor );
+    return 0;
+  }
+  return blPriceGuideExtractorFeed( &pgquery->extractor, data, (int)datasize );
+}
 
 static void bsBrickLinkReplyPriceGuide( void *uservalue, int resultcode, httpResponse *response )
 {
+  int itemindex, parseflag;
   bsContext *context;
   bsQueryReply *reply;
   bsxItem *item;
   bsxPriceGuide pgnew, pgused;
   bsFetchPriceGuideCallback *pgcallback;
-  char *pgpath;
+  bsFetchPriceGuideQuery *pgquery;
 
   DEBUG_SET_TRACKER();
 
-  reply = uservalue;
+  pgquery = uservalue;
+  reply = pgquery->reply;
   context = reply->context;
+  parseflag = blPriceGuideExtractorFinish( &pgquery->extractor, &pgnew, &pgused );
+  free( pgquery );
 
 #if 0
   ccFileStore( "zzz.txt", data, datasize, 0 );
@@ -194,21 +187,23 @@ static void bsBrickLinkReplyPriceGuide( void *uservalue, int resultcode, httpRes
 
   if( ( reply->result == HTTP_RESULT_SUCCESS ) && ( response->body ) )
   {
-    if( blHtmlParsePriceGuide( &pgnew, &pgused, response->body, response->bodysize ) )
+    if( parseflag )
     {
       item = reply->extpointer;
       /* Save to price guide cache */
-      pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags | BSX_PRICEGUIDE_FLAGS_MKDIR );
-      if( !( bsxWritePriceGuide( &pgnew, &pgused, pgpath, item->typeid, item->id, item->colorid ) ) )
-      {
-        ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", pgpath );
+      if( !( bsPriceGuideCacheWrite( context, item, &pgnew, &pgused ) ) )
         reply->result = HTTP_RESULT_PROCESS_ERROR;
-      }
-      free( pgpath );
-      /* Call callback if any */
+      /* Call callback if any, for the queried item and all others sharing its price guide */
       pgcallback = (bsFetchPriceGuideCallback *)reply->opaquepointer;
       if( ( pgcallback ) && ( pgcallback->callback ) )
+      {
         pgcallback->callback( context, pgcallback->inv, item, ( item->condition == 'N' ? &pgnew : &pgused ), pgcallback->callbackpointer );
+        for( itemindex = pgcallback->nextlist[ reply->extid ] ; itemindex >= 0 ; itemindex = pgcallback->nextlist[itemindex] )
+        {
+          item = &pgcallback->inv->itemlist[itemindex];
+          pgcallback->callback( context, pgcallback->inv, item, ( item->condition == 'N' ? &pgnew : &pgused ), pgcallback->callbackpointer );
+        }
+      }
     }
     else
     {
@@ -228,6 +223,7 @@ static int bsQueueBrickLinkPriceGuide( bsContext *context, bsWorkList *worklist,
   char *querystring;
   bsxItem *item;
   bsQueryReply *reply;
+  bsFetchPriceGuideQuery *pgquery;
 
   DEBUG_SET_TRACKER();
 
@@ -245,10 +241,13 @@ static int bsQueueBrickLinkPriceGuide( bsContext *context, bsWorkList *worklist,
     if( !( item->flags & BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE ) )
       continue;
     reply = bsAllocReply( context, BS_QUERY_TYPE_WEBBRICKLINK, itemindex, (void *)item, (void *)pgcallback );
+    pgquery = malloc( sizeof(bsFetchPriceGuideQuery) );
+    pgquery->reply = reply;
+    blPriceGuideExtractorInit( &pgquery->extractor );
     querystring = ccStrAllocPrintf( "GET /priceGuide.asp?a=%c&viewType=N&colorID=%d&itemID=%s&viewDec=3 HTTP/1.1\r\nHost: www.bricklink.com\r\nConnection: Keep-Alive\r\n\r\n", item->typeid, item->colorid, item->id );
-    httpAddQuery( context->bricklink.webhttp, querystring, strlen( querystring ), HTTP_QUERY_FLAGS_RETRY, (void *)reply, bsBrickLinkReplyPriceGuide );
+    httpAddStreamQuery( context->bricklink.webhttp, querystring, strlen( querystring ), HTTP_QUERY_FLAGS_RETRY, (void *)pgquery, bsBrickLinkReplyPriceGuide, bsBrickLinkStreamPriceGuide );
     free( querystring );
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued price guide query for item \"%s\", color %d\n", ( item->id ? item->id : item->name ), item->colorid );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Queued price guide query for item \"%s\", color %d\n", ( item->id ? item->id : item->name ), item->colorid );
   }
   worklist->liststart = itemindex;
 
@@ -259,7 +258,7 @@ static int bsQueueBrickLinkPriceGuide( bsContext *context, bsWorkList *worklist,
 /* Populate the price guide cache with all items flagged BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE */
 int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) )
 {
-  int waitcount, itemlistindex;
+  int waitcount, itemlistindex, itemindex, keycount;
   bsxItem *item;
   bsQueryReply *reply, *replynext;
   bsWorkList worklist;
@@ -272,12 +271,17 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
   pgcallback.inv = inv;
   pgcallback.callbackpointer = callbackpointer;
   pgcallback.callback = callback;
+  pgcallback.nextlist = malloc( ( inv->itemcount + 1 ) * sizeof(int) );
+
+  /* Query each (type, id, color) only once, the page holds both new and used data */
+  worklist.liststart = 0;
+  mmBitMapInit( &worklist.bitmap, inv->itemcount, 0 );
+  keycount = bsPlanBrickLinkPriceGuide( inv, pgcallback.nextlist, &worklist.bitmap );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Price guide fetch planned with %d unique queries.\n", keycount );
 
   /* Keep pushing price guide fetches until we are done */
   bsTrackerInit( &tracker, context->bricklink.webhttp );
   waitcount = context->bricklink.pipelinequeuesize;
-  worklist.liststart = 0;
-  mmBitMapInit( &worklist.bitmap, inv->itemcount, 0 );
   for( ; ; )
   {
     /* Queue updates for the "diff" inventory */
@@ -300,10 +304,10 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
       if( reply->result != HTTP_RESULT_SUCCESS )
       {
         if( ( reply->result == HTTP_RESULT_CODE_ERROR ) || ( reply->result == HTTP_RESULT_PARSE_ERROR ) )
-          ioPrintf( &context->output, 0, BSMSG_ERROR "Bad reply from server when fetching price guide for item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", ( item->id ? item->id : item->name ), item->colorid );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_ERROR, 0, BSMSG_ERROR "Bad reply from server when fetching price guide for item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", ( item->id ? item->id : item->name ), item->colorid );
         else if( reply->result != HTTP_RESULT_PROCESS_ERROR )
         {
-          ioPrintf( &context->output, 0, BSMSG_WARNING "Price guide fetching failure, attempting again for item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", ( item->id ? item->id : item->name ), item->colorid );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_WARNING, 0, BSMSG_WARNING "Price guide fetching failure, attempting again for item \"" IO_MAGENTA "%s" IO_WHITE "\", color " IO_MAGENTA "%d" IO_WHITE ".\n", ( item->id ? item->id : item->name ), item->colorid );
           /* Clear bit to attempt item again */
           mmBitMapDirectClear( &worklist.bitmap, itemlistindex );
           if( itemlistindex < worklist.liststart )
@@ -314,7 +318,9 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
       {
         item->flags &= ~BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
         if( !( item->flags & BSX_ITEM_FLAGS_DELETED ) )
-          ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success fetching price guide for item \"%s\", color %d\n", ( item->id ? item->id : item->name ), item->colorid );
+          IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_NET, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success fetching price guide for item \"%s\", color %d\n", ( item->id ? item->id : item->name ), item->colorid );
+        for( itemindex = pgcallback.nextlist[itemlistindex] ; itemindex >= 0 ; itemindex = pgcallback.nextlist[itemindex] )
+          inv->itemlist[itemindex].flags &= ~BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
       }
       bsTrackerAccumResult( context, &tracker, reply->result, BS_TRACKER_ACCUM_FLAGS_CANRETRY );
       bsFreeReply( context, reply );
@@ -322,6 +328,7 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
   }
 
   mmBitMapFree( &worklist.bitmap );
+  free( pgcallback.nextlist );
   if( !( tracker.failureflag ) )
   {
     /* Flag inventory for minor updates, LotIDs and such */
@@ -212,7 +212,7 @@ bsxInventory *bsBrickLinkFetchSetInventory( bsContext *context, char itemtypeid,
   {
     bsFlushTcpProcessHttp( context );
     if( httpGetQueryQueueCount( context->bricklink.webhttp ) > 0 )
-      tcpWait( &context->tcp, 0 );
+      bsWaitTcp( context );
     else
       break;
   }
@@ -176,6 +176,7 @@ void bsExitBrickLinkMasterMode( bsContext *context )
   context->bricklink.lastsynctime = context->curtime;
   context->brickowl.synctime = context->curtime - 1;
   bsxFreeInventory( context->inventory );
+  bsxDetachInventoryArena( inv );
   context->inventory = inv;
 
   /* Update state, with fsync() and journaling */
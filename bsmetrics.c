@@ -0,0 +1,435 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "mmatomic.h"
+#include "mmbitmap.h"
+#include "iolog.h"
+#include "debugtrack.h"
+#include "rand.h"
+
+#if CC_UNIX
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#elif CC_WINDOWS
+ #include <windows.h>
+ #include <direct.h>
+#else
+ #error Unknown/Unsupported platform!
+#endif
+
+#include "tcp.h"
+#include "tcphttp.h"
+#include "oauth.h"
+#include "exclperm.h"
+#include "journal.h"
+
+#include "bsx.h"
+#include "bsxpg.h"
+#include "json.h"
+#include "bsorder.h"
+#include "bricklink.h"
+#include "brickowl.h"
+#include "colortable.h"
+#include "bstranslation.h"
+
+#include "bricksync.h"
+
+
+////
+
+
+/*
+Prometheus text exposition served over a tcp.c listening link.
+All callbacks run from tcpFlush()/tcpWait() on the main thread, the response is built from the context
+without locking and queued in one send buffer, a scrape never waits on anything.
+*/
+
+#define BS_METRICS_REQUEST_MAX (4096)
+#define BS_METRICS_TIMEOUT (10000)
+
+typedef struct
+{
+  bsContext *context;
+  tcpLink *link;
+  int replyflag;
+  int requestsize;
+  char request[BS_METRICS_REQUEST_MAX];
+} bsMetricsLink;
+
+static const char *bsMetricsResultName[HTTP_RESULT_COUNT] =
+{
+  [HTTP_RESULT_SUCCESS] = "success",
+  [HTTP_RESULT_CONNECT_ERROR] = "connect_error",
+  [HTTP_RESULT_TRYAGAIN_ERROR] = "tryagain_error",
+  [HTTP_RESULT_NOREPLY_ERROR] = "noreply_error",
+  [HTTP_RESULT_BADFORMAT_ERROR] = "badformat_error",
+  [HTTP_RESULT_CODE_ERROR] = "code_error",
+  [HTTP_RESULT_PARSE_ERROR] = "parse_error",
+  [HTTP_RESULT_PROCESS_ERROR] = "process_error",
+  [HTTP_RESULT_SYSTEM_ERROR] = "system_error"
+};
+
+
+////
+
+
+static void bsMetricsPrintHelp( ccGrowth *growth, char *name, char *type, char *help )
+{
+  ccGrowthPrintf( growth, "# HELP bricksync_%s %s\n", name, help );
+  ccGrowthPrintf( growth, "# TYPE bricksync_%s %s\n", name, type );
+  return;
+}
+
+static void bsMetricsPrintTimeStats( ccGrowth *growth, char *name, char *endpointname, httpTimeStats *stats )
+{
+  int bucketindex;
+  int64_t cumulative;
+
+  cumulative = 0;
+  for( bucketindex = 0 ; bucketindex < HTTP_STATS_BUCKET_COUNT-1 ; bucketindex++ )
+  {
+    cumulative += stats->bucket[ bucketindex ];
+    ccGrowthPrintf( growth, "bricksync_%s_bucket{endpoint=\"%s\",le=\"%g\"} " CC_LLD "\n", name, endpointname, (double)httpStatsBucketLimit[ bucketindex ] / 1000000000.0, (long long)cumulative );
+  }
+  ccGrowthPrintf( growth, "bricksync_%s_bucket{endpoint=\"%s\",le=\"+Inf\"} " CC_LLD "\n", name, endpointname, (long long)stats->count );
+  ccGrowthPrintf( growth, "bricksync_%s_sum{endpoint=\"%s\"} %.6f\n", name, endpointname, (double)stats->total / 1000000000.0 );
+  ccGrowthPrintf( growth, "bricksync_%s_count{endpoint=\"%s\"} " CC_LLD "\n", name, endpointname, (long long)stats->count );
+  return;
+}
+
+static void bsMetricsBuild( bsContext *context, ccGrowth *growth )
+{
+  int index, resultindex, phasecount;
+  bsMetrics *metrics;
+  bsxInventory *inv;
+  debugProfileStat *stat;
+  httpEndpointStats *endpoint;
+  debugProfileStat statlist[BS_PROFILE_PHASE_MAX];
+
+  DEBUG_SET_TRACKER();
+
+  metrics = &context->metrics;
+  inv = context->inventory;
+
+  bsMetricsPrintHelp( growth, "api_calls_24h", "gauge", "API calls made over the last 24 hours." );
+  ccGrowthPrintf( growth, "bricksync_api_calls_24h{service=\"bricklink\"} %d\n", context->bricklink.apihistory.total );
+  ccGrowthPrintf( growth, "bricksync_api_calls_24h{service=\"brickowl\"} %d\n", context->brickowl.apihistory.total );
+  bsMetricsPrintHelp( growth, "api_calls_1h", "gauge", "API calls made over the last hour." );
+  ccGrowthPrintf( growth, "bricksync_api_calls_1h{service=\"bricklink\"} %d\n", bsApiHistoryCountPeriod( &context->bricklink.apihistory, 60*60 ) );
+  ccGrowthPrintf( growth, "bricksync_api_calls_1h{service=\"brickowl\"} %d\n", bsApiHistoryCountPeriod( &context->brickowl.apihistory, 60*60 ) );
+
+  bsMetricsPrintHelp( growth, "queries_total", "counter", "Queries issued since startup." );
+  ccGrowthPrintf( growth, "bricksync_queries_total{service=\"bricklink\"} " CC_LLD "\n", (long long)context->bricklink.querycount );
+  ccGrowthPrintf( growth, "bricksync_queries_total{service=\"bricklink_web\"} " CC_LLD "\n", (long long)context->bricklink.webquerycount );
+  ccGrowthPrintf( growth, "bricksync_queries_total{service=\"brickowl\"} " CC_LLD "\n", (long long)context->brickowl.querycount );
+
+  bsMetricsPrintHelp( growth, "pipeline_depth", "gauge", "Queries queued or in flight on the connection." );
+  ccGrowthPrintf( growth, "bricksync_pipeline_depth{service=\"bricklink\"} %d\n", ( context->bricklink.http ? httpGetQueryQueueCount( context->bricklink.http ) : 0 ) );
+  ccGrowthPrintf( growth, "bricksync_pipeline_depth{service=\"bricklink_web\"} %d\n", ( context->bricklink.webhttp ? httpGetQueryQueueCount( context->bricklink.webhttp ) : 0 ) );
+  ccGrowthPrintf( growth, "bricksync_pipeline_depth{service=\"brickowl\"} %d\n", ( context->brickowl.http ? httpGetQueryQueueCount( context->brickowl.http ) : 0 ) );
+  bsMetricsPrintHelp( growth, "pipeline_queue_size", "gauge", "Configured pipeline queue size." );
+  ccGrowthPrintf( growth, "bricksync_pipeline_queue_size{service=\"bricklink\"} %d\n", context->bricklink.pipelinequeuesize );
+  ccGrowthPrintf( growth, "bricksync_pipeline_queue_size{service=\"brickowl\"} %d\n", context->brickowl.pipelinequeuesize );
+
+  bsMetricsPrintHelp( growth, "query_results_total", "counter", "Query results by outcome." );
+  for( index = 0 ; index < HTTP_RESULT_COUNT ; index++ )
+    ccGrowthPrintf( growth, "bricksync_query_results_total{result=\"%s\"} " CC_LLD "\n", bsMetricsResultName[ index ], (long long)metrics->resultcount[ index ] );
+  bsMetricsPrintHelp( growth, "connection_errors_total", "counter", "Connection errors reported by the HTTP layer." );
+  ccGrowthPrintf( growth, "bricksync_connection_errors_total " CC_LLD "\n", (long long)metrics->connerrorcount );
+
+  phasecount = debugProfileGetStats( statlist, BS_PROFILE_PHASE_MAX );
+  bsMetricsPrintHelp( growth, "phase_duration_seconds", "summary", "Duration of profiled phases." );
+  for( index = 0 ; index < phasecount ; index++ )
+  {
+    stat = &statlist[ index ];
+    ccGrowthPrintf( growth, "bricksync_phase_duration_seconds{phase=\"%s\",quantile=\"0.5\"} %.6f\n", stat->name, (double)stat->p50 / 1000000000.0 );
+    ccGrowthPrintf( growth, "bricksync_phase_duration_seconds{phase=\"%s\",quantile=\"0.95\"} %.6f\n", stat->name, (double)stat->p95 / 1000000000.0 );
+    ccGrowthPrintf( growth, "bricksync_phase_duration_seconds_sum{phase=\"%s\"} %.6f\n", stat->name, (double)stat->total / 1000000000.0 );
+    ccGrowthPrintf( growth, "bricksync_phase_duration_seconds_count{phase=\"%s\"} " CC_LLD "\n", stat->name, (long long)stat->count );
+  }
+  bsMetricsPrintHelp( growth, "phase_duration_max_seconds", "gauge", "Longest run of each profiled phase." );
+  for( index = 0 ; index < phasecount ; index++ )
+    ccGrowthPrintf( growth, "bricksync_phase_duration_max_seconds{phase=\"%s\"} %.6f\n", statlist[ index ].name, (double)statlist[ index ].max / 1000000000.0 );
+
+  bsMetricsPrintHelp( growth, "http_requests_total", "counter", "Completed HTTP queries by endpoint and outcome." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+  {
+    endpoint = &context->httpstats[ index ];
+    for( resultindex = 0 ; resultindex < HTTP_RESULT_COUNT ; resultindex++ )
+    {
+      if( ( endpoint->resultcount[ resultindex ] ) || ( resultindex == HTTP_RESULT_SUCCESS ) )
+        ccGrowthPrintf( growth, "bricksync_http_requests_total{endpoint=\"%s\",result=\"%s\"} " CC_LLD "\n", endpoint->name, bsMetricsResultName[ resultindex ], (long long)endpoint->resultcount[ resultindex ] );
+    }
+  }
+  bsMetricsPrintHelp( growth, "http_responses_total", "counter", "HTTP replies by endpoint and class of status code." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+  {
+    endpoint = &context->httpstats[ index ];
+    for( resultindex = 1 ; resultindex <= 5 ; resultindex++ )
+      ccGrowthPrintf( growth, "bricksync_http_responses_total{endpoint=\"%s\",code=\"%dxx\"} " CC_LLD "\n", endpoint->name, resultindex, (long long)endpoint->httpclasscount[ resultindex ] );
+  }
+  bsMetricsPrintHelp( growth, "http_queue_wait_seconds", "histogram", "Time HTTP queries waited before being sent." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    bsMetricsPrintTimeStats( growth, "http_queue_wait_seconds", context->httpstats[ index ].name, &context->httpstats[ index ].queuewait );
+  bsMetricsPrintHelp( growth, "http_first_byte_seconds", "histogram", "Time from sending an HTTP query to the first byte of its reply." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    bsMetricsPrintTimeStats( growth, "http_first_byte_seconds", context->httpstats[ index ].name, &context->httpstats[ index ].firstbyte );
+  bsMetricsPrintHelp( growth, "http_transfer_seconds", "histogram", "Time from the first byte of an HTTP reply to its completion." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    bsMetricsPrintTimeStats( growth, "http_transfer_seconds", context->httpstats[ index ].name, &context->httpstats[ index ].transfer );
+  bsMetricsPrintHelp( growth, "http_response_body_bytes_total", "counter", "Bytes of HTTP reply bodies received." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    ccGrowthPrintf( growth, "bricksync_http_response_body_bytes_total{endpoint=\"%s\"} " CC_LLD "\n", context->httpstats[ index ].name, (long long)context->httpstats[ index ].bodysizetotal );
+  bsMetricsPrintHelp( growth, "http_response_body_max_bytes", "gauge", "Largest HTTP reply body received." );
+  for( index = 0 ; index < BS_HTTP_ENDPOINT_COUNT ; index++ )
+    ccGrowthPrintf( growth, "bricksync_http_response_body_max_bytes{endpoint=\"%s\"} " CC_LLD "\n", context->httpstats[ index ].name, (long long)context->httpstats[ index ].bodysizemax );
+
+  bsMetricsPrintHelp( growth, "last_check_timestamp_seconds", "gauge", "Time of the latest order check." );
+  ccGrowthPrintf( growth, "bricksync_last_check_timestamp_seconds{service=\"bricklink\"} " CC_LLD "\n", (long long)context->bricklink.lastchecktime );
+  ccGrowthPrintf( growth, "bricksync_last_check_timestamp_seconds{service=\"brickowl\"} " CC_LLD "\n", (long long)context->brickowl.lastchecktime );
+  bsMetricsPrintHelp( growth, "last_sync_timestamp_seconds", "gauge", "Time of the latest deep sync." );
+  ccGrowthPrintf( growth, "bricksync_last_sync_timestamp_seconds{service=\"bricklink\"} " CC_LLD "\n", (long long)context->bricklink.lastsynctime );
+  ccGrowthPrintf( growth, "bricksync_last_sync_timestamp_seconds{service=\"brickowl\"} " CC_LLD "\n", (long long)context->brickowl.lastsynctime );
+  bsMetricsPrintHelp( growth, "sync_pending", "gauge", "Deep sync pending for the service." );
+  ccGrowthPrintf( growth, "bricksync_sync_pending{service=\"bricklink\"} %d\n", ( context->stateflags & BS_STATE_FLAGS_BRICKLINK_MUST_SYNC ? 1 : 0 ) );
+  ccGrowthPrintf( growth, "bricksync_sync_pending{service=\"brickowl\"} %d\n", ( context->stateflags & BS_STATE_FLAGS_BRICKOWL_MUST_SYNC ? 1 : 0 ) );
+
+  bsMetricsPrintHelp( growth, "inventory_lots", "gauge", "Lots in the tracked inventory." );
+  ccGrowthPrintf( growth, "bricksync_inventory_lots %d\n", ( inv ? inv->itemcount - inv->itemfreecount : 0 ) );
+  bsMetricsPrintHelp( growth, "inventory_parts", "gauge", "Parts in the tracked inventory." );
+  ccGrowthPrintf( growth, "bricksync_inventory_parts %d\n", ( inv ? inv->partcount : 0 ) );
+  bsMetricsPrintHelp( growth, "pending_diff_lots", "gauge", "Lots waiting in the update queue of the service." );
+  inv = context->bricklink.diffinv;
+  ccGrowthPrintf( growth, "bricksync_pending_diff_lots{service=\"bricklink\"} %d\n", ( inv ? inv->itemcount - inv->itemfreecount : 0 ) );
+  inv = context->brickowl.diffinv;
+  ccGrowthPrintf( growth, "bricksync_pending_diff_lots{service=\"brickowl\"} %d\n", ( inv ? inv->itemcount - inv->itemfreecount : 0 ) );
+
+  bsMetricsPrintHelp( growth, "metrics_scrapes_total", "counter", "Requests served by the metrics endpoint." );
+  ccGrowthPrintf( growth, "bricksync_metrics_scrapes_total " CC_LLD "\n", (long long)metrics->scrapecount );
+
+  return;
+}
+
+
+////
+
+
+static void bsMetricsLinkClose( bsMetricsLink *mlink )
+{
+  DEBUG_SET_TRACKER();
+
+  if( mlink->link )
+  {
+    tcpClose( &mlink->context->tcp, mlink->link );
+    mlink->link = 0;
+  }
+  free( mlink );
+  return;
+}
+
+static void bsMetricsReply( bsMetricsLink *mlink )
+{
+  int status;
+  char *statusstring;
+  size_t headersize;
+  char header[256];
+  ccGrowth body;
+  tcpDataBuffer *sendbuf;
+  bsContext *context;
+
+  DEBUG_SET_TRACKER();
+
+  context = mlink->context;
+  mlink->replyflag = 1;
+  ccGrowthInit( &body, 16384 );
+  if( !( ccStrCmpSeq( mlink->request, "GET ", 4 ) ) )
+  {
+    status = 405;
+    statusstring = "Method Not Allowed";
+    ccGrowthPrintf( &body, "Method not allowed.\n" );
+  }
+  else if( !( ccStrCmpSeq( &mlink->request[4], "/metrics ", 9 ) ) && !( ccStrCmpSeq( &mlink->request[4], "/ ", 2 ) ) )
+  {
+    status = 404;
+    statusstring = "Not Found";
+    ccGrowthPrintf( &body, "Not found, metrics are served at /metrics\n" );
+  }
+  else
+  {
+    status = 200;
+    statusstring = "OK";
+    context->metrics.scrapecount++;
+    bsMetricsBuild( context, &body );
+  }
+
+  headersize = snprintf( header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", status, statusstring, (int)body.offset );
+  sendbuf = tcpAllocSendBuffer( &context->tcp, mlink->link, headersize + body.offset );
+  memcpy( sendbuf->pointer, header, headersize );
+  memcpy( ADDRESS( sendbuf->pointer, headersize ), body.data, body.offset );
+  tcpQueueSendBuffer( &context->tcp, mlink->link, sendbuf, headersize + body.offset );
+  ccGrowthFree( &body );
+
+  return;
+}
+
+
+static void *bsMetricsIncoming( void *link, void *listenvalue )
+{
+  bsContext *context;
+  bsMetricsLink *mlink;
+
+  DEBUG_SET_TRACKER();
+
+  context = listenvalue;
+  mlink = malloc( sizeof(bsMetricsLink) );
+  mlink->context = context;
+  mlink->link = link;
+  mlink->replyflag = 0;
+  mlink->requestsize = 0;
+  tcpSetTimeout( &context->tcp, link, BS_METRICS_TIMEOUT );
+  return mlink;
+}
+
+static void bsMetricsRecv( void *uservalue, tcpDataBuffer *recvbuf )
+{
+  int copysize;
+  bsMetricsLink *mlink;
+
+  DEBUG_SET_TRACKER();
+
+  mlink = uservalue;
+  if( !( mlink->replyflag ) )
+  {
+    copysize = CC_MIN( (int)recvbuf->size, ( BS_METRICS_REQUEST_MAX - 1 ) - mlink->requestsize );
+    memcpy( &mlink->request[ mlink->requestsize ], recvbuf->pointer, copysize );
+    mlink->requestsize += copysize;
+    mlink->request[ mlink->requestsize ] = 0;
+    /* Reply once the request header is complete, the body of a GET is irrelevant */
+    if( ( ccStrFindStr( mlink->request, "\r\n\r\n" ) ) || ( ccStrFindStr( mlink->request, "\n\n" ) ) || ( mlink->requestsize >= BS_METRICS_REQUEST_MAX - 1 ) )
+      bsMetricsReply( mlink );
+  }
+  tcpFreeRecvBuffer( &mlink->context->tcp, mlink->link, recvbuf );
+  return;
+}
+
+static void bsMetricsSendReady( void *uservalue, size_t sendbuffered )
+{
+  return;
+}
+
+static void bsMetricsSendFinished( void *uservalue )
+{
+  bsMetricsLink *mlink;
+
+  DEBUG_SET_TRACKER();
+
+  mlink = uservalue;
+  if( mlink->replyflag )
+    bsMetricsLinkClose( mlink );
+  return;
+}
+
+static void bsMetricsTimeout( void *uservalue )
+{
+  DEBUG_SET_TRACKER();
+
+  bsMetricsLinkClose( uservalue );
+  return;
+}
+
+static void bsMetricsClosed( void *uservalue )
+{
+  DEBUG_SET_TRACKER();
+
+  bsMetricsLinkClose( uservalue );
+  return;
+}
+
+static tcpCallbackSet bsMetricsIO =
+{
+  .incoming = bsMetricsIncoming,
+  .recv = bsMetricsRecv,
+  .sendready = bsMetricsSendReady,
+  .sendwait = 0,
+  .sendfinished = bsMetricsSendFinished,
+  .timeout = bsMetricsTimeout,
+  .closed = bsMetricsClosed,
+  .wake = 0
+};
+
+
+////
+
+
+int bsMetricsInit( bsContext *context )
+{
+  DEBUG_SET_TRACKER();
+
+  if( context->metrics.port <= 0 )
+    return 1;
+  if( !( context->metrics.address ) || !( context->metrics.address[0] ) )
+  {
+    if( context->metrics.address )
+      free( context->metrics.address );
+    context->metrics.address = strdup( BS_METRICS_ADDRESS_DEFAULT );
+  }
+  context->metrics.listenlink = tcpListen( &context->tcp, context->metrics.address, context->metrics.port, context, &bsMetricsIO, 0 );
+  if( !( context->metrics.listenlink ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to open the metrics endpoint on " IO_RED "%s:%d" IO_WHITE ".\n", context->metrics.address, context->metrics.port );
+    return 0;
+  }
+  ioPrintf( &context->output, 0, BSMSG_INIT "Serving metrics on " IO_GREEN "%s:%d" IO_DEFAULT ".\n", context->metrics.address, context->metrics.port );
+  return 1;
+}
+
+
+void bsMetricsEnd( bsContext *context )
+{
+  DEBUG_SET_TRACKER();
+
+  /* tcpEnd() waits until the listening link has been closed */
+  if( context->metrics.listenlink )
+  {
+    tcpClose( &context->tcp, context->metrics.listenlink );
+    context->metrics.listenlink = 0;
+  }
+  free( context->metrics.address );
+  context->metrics.address = 0;
+  return;
+}
+
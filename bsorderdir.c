@@ -116,21 +116,197 @@ static int bsOrderDirAddEntry( bsOrderDir *dir, char *filepath, time_t filetime
     if( ( stroffset > 0 ) && ( ccSeqParseInt32( str, stroffset, &readint ) ) )
       entry->orderid = (int)readint;
   }
+  entry->lotcount = -1;
+  entry->partcount = -1;
+  entry->grandtotal = 0.0;
   dir->entrycount++;
   return 1;
 }
 
 
-int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime )
+#define BS_ORDER_MANIFEST_MAGIC (0x334d4f42)
+
+/* Fixed size manifest record, the last record of an order prevails */
+typedef struct
+{
+  uint32_t magic;
+  int32_t ordertype;
+  int64_t orderid;
+  int64_t filetime;
+  int32_t lotcount;
+  int32_t partcount;
+  double grandtotal;
+  uint32_t reserved;
+  uint32_t checksum;
+} bsOrderManifestRecord;
+
+static uint32_t bsOrderManifestChecksum( bsOrderManifestRecord *record )
+{
+  return ccHash32Data( record, offsetof(bsOrderManifestRecord,checksum) );
+}
+
+static void bsOrderManifestSeal( bsOrderManifestRecord *record )
+{
+  record->magic = BS_ORDER_MANIFEST_MAGIC;
+  record->reserved = 0;
+  record->checksum = bsOrderManifestChecksum( record );
+  return;
+}
+
+int bsOrderManifestQueue( bsContext *context, int ordertype, bsOrder *order, bsxInventory *inv )
+{
+  bsOrderManifestRecord record;
+
+  memset( &record, 0, sizeof(bsOrderManifestRecord) );
+  record.ordertype = ordertype;
+  record.orderid = order->id;
+  record.filetime = (int64_t)time( 0 );
+  record.lotcount = inv->itemcount;
+  record.partcount = inv->partcount;
+  record.grandtotal = order->grandtotal;
+  bsOrderManifestSeal( &record );
+  ccGrowthData( &context->ordermanifestpending, &record, sizeof(bsOrderManifestRecord) );
+  return 1;
+}
+
+/* Append records to the manifest, cutting a torn record first so that later records stay aligned */
+static int bsOrderManifestAppend( bsContext *context, void *data, size_t datasize )
+{
+  int retval;
+  size_t filesize, validsize;
+  void *filedata;
+  FILE *file;
+
+  /* Without a manifest, the first read scans the orders directory and finds this order */
+  if( !( ccFileStat( BS_ORDER_MANIFEST_FILE, &filesize, 0 ) ) )
+    return 1;
+  if( filesize % sizeof(bsOrderManifestRecord) )
+  {
+    validsize = filesize - ( filesize % sizeof(bsOrderManifestRecord) );
+    filedata = ccFileLoad( BS_ORDER_MANIFEST_FILE, 0, &filesize );
+    if( ( filedata ) && ( filesize >= validsize ) && ( ccFileStore( BS_ORDER_MANIFEST_TEMP_FILE, filedata, validsize, 1 ) ) )
+      ccRenameFile( BS_ORDER_MANIFEST_TEMP_FILE, BS_ORDER_MANIFEST_FILE );
+    free( filedata );
+  }
+
+  retval = 0;
+  file = fopen( BS_ORDER_MANIFEST_FILE, "ab" );
+  if( file )
+  {
+    if( fwrite( data, 1, datasize, file ) == datasize )
+      retval = 1;
+    fclose( file );
+  }
+  if( !( retval ) )
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to update the orders manifest at \"" IO_RED "%s" IO_WHITE "\".\n", BS_ORDER_MANIFEST_FILE );
+  return retval;
+}
+
+
+/* Single sequential read of the manifest, returns 0 if there is no usable manifest */
+static int bsReadOrderManifest( bsOrderDir *orderdir, time_t ordermintime, time_t ordermaxtime )
+{
+  int recordindex, recordcount, entryindex;
+  uint32_t hashmask, hashindex;
+  int *hashtable;
+  size_t datasize, offset;
+  char *data;
+  char *filepath;
+  bsOrderManifestRecord readrecord;
+  bsOrderManifestRecord *recordlist, *record, *slotrecord;
+  bsOrderDirEntry *entry;
+
+  data = ccFileLoad( BS_ORDER_MANIFEST_FILE, 0, &datasize );
+  if( !( data ) )
+    return 0;
+
+  /* Gather valid records, resynchronizing on the magic past any torn record */
+  recordlist = (bsOrderManifestRecord *)data;
+  recordcount = 0;
+  for( offset = 0 ; offset + sizeof(bsOrderManifestRecord) <= datasize ; )
+  {
+    memcpy( &readrecord, &data[offset], sizeof(bsOrderManifestRecord) );
+    if( ( readrecord.magic != BS_ORDER_MANIFEST_MAGIC ) || ( readrecord.checksum != bsOrderManifestChecksum( &readrecord ) ) )
+    {
+      offset++;
+      continue;
+    }
+    /* Records are only moved backwards, over data already read */
+    recordlist[ recordcount++ ] = readrecord;
+    offset += sizeof(bsOrderManifestRecord);
+  }
+  if( ( datasize ) && !( recordcount ) )
+  {
+    free( data );
+    return 0;
+  }
+
+  /* Find the latest record of each order */
+  for( hashmask = 255 ; hashmask < 2 * (uint32_t)recordcount ; hashmask = ( hashmask << 1 ) | 0x1 );
+  hashtable = malloc( ( hashmask + 1 ) * sizeof(int) );
+  memset( hashtable, -1, ( hashmask + 1 ) * sizeof(int) );
+  for( recordindex = 0 ; recordindex < recordcount ; recordindex++ )
+  {
+    record = &recordlist[recordindex];
+    for( hashindex = ccHash32Int64Inline( ( (uint64_t)record->orderid << 2 ) | (uint64_t)( record->ordertype & 0x3 ) ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+    {
+      if( hashtable[hashindex] == -1 )
+      {
+        hashtable[hashindex] = recordindex;
+        break;
+      }
+      slotrecord = &recordlist[ hashtable[hashindex] ];
+      if( ( slotrecord->ordertype == record->ordertype ) && ( slotrecord->orderid == record->orderid ) )
+      {
+        hashtable[hashindex] = recordindex;
+        break;
+      }
+    }
+  }
+
+  for( hashindex = 0 ; hashindex <= hashmask ; hashindex++ )
+  {
+    if( hashtable[hashindex] == -1 )
+      continue;
+    record = &recordlist[ hashtable[hashindex] ];
+    if( ( (time_t)record->filetime <= ordermintime ) || ( ( ordermaxtime ) && ( (time_t)record->filetime > ordermaxtime ) ) )
+      continue;
+    if( record->ordertype == BS_ORDER_DIR_ORDER_TYPE_BRICKLINK )
+      filepath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_PATH, (long long)record->orderid );
+    else if( record->ordertype == BS_ORDER_DIR_ORDER_TYPE_BRICKOWL )
+      filepath = ccStrAllocPrintf( BS_BRICKOWL_ORDER_PATH, (long long)record->orderid );
+    else
+      continue;
+    entryindex = orderdir->entrycount;
+    if( !( bsOrderDirAddEntry( orderdir, filepath, (time_t)record->filetime ) ) )
+    {
+      free( filepath );
+      break;
+    }
+    entry = &orderdir->entrylist[entryindex];
+    entry->lotcount = record->lotcount;
+    entry->partcount = record->partcount;
+    entry->grandtotal = record->grandtotal;
+  }
+
+  free( hashtable );
+  free( data );
+  return 1;
+}
+
+
+/* Scan the orders directory and create the manifest from what is found */
+static int bsScanOrderDir( bsContext *context, bsOrderDir *orderdir )
 {
+  int entryindex;
   ccDir *dir;
   char *filename;
   char *filepath;
   time_t filetime;
+  bsOrderDirEntry *entry;
+  bsOrderManifestRecord record;
+  ccGrowth growth;
 
-  orderdir->entrylist = 0;
-  orderdir->entrycount = 0;
-  orderdir->entryalloc = 0;
   dir = ccOpenDir( BS_BRICKLINK_ORDER_DIR );
   if( !( dir ) )
     return 0;
@@ -142,7 +318,7 @@ int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintim
     if( filename[0] == '.' )
       continue;
     filepath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%s", BS_BRICKLINK_ORDER_DIR, filename );
-    if( !( ccFileStat( filepath, 0, &filetime ) ) || ( filetime <= ordermintime ) )
+    if( !( ccFileStat( filepath, 0, &filetime ) ) )
     {
       free( filepath );
       continue;
@@ -155,10 +331,69 @@ int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintim
   }
   ccCloseDir( dir );
 
+  /* Replace any unusable manifest */
+  ccGrowthInit( &growth, ( orderdir->entrycount + 1 ) * sizeof(bsOrderManifestRecord) );
+  for( entryindex = 0 ; entryindex < orderdir->entrycount ; entryindex++ )
+  {
+    entry = &orderdir->entrylist[entryindex];
+    if( ( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_UNKNOWN ) || !( entry->orderid ) )
+      continue;
+    memset( &record, 0, sizeof(bsOrderManifestRecord) );
+    record.ordertype = entry->ordertype;
+    record.orderid = entry->orderid;
+    record.filetime = (int64_t)entry->filetime;
+    record.lotcount = -1;
+    record.partcount = -1;
+    bsOrderManifestSeal( &record );
+    ccGrowthData( &growth, &record, sizeof(bsOrderManifestRecord) );
+  }
+  if( ( ccFileStore( BS_ORDER_MANIFEST_TEMP_FILE, growth.data, growth.offset, 1 ) ) && ( ccRenameFile( BS_ORDER_MANIFEST_TEMP_FILE, BS_ORDER_MANIFEST_FILE ) ) )
+    ioPrintf( &context->output, 0, BSMSG_INFO "Created the orders manifest with " IO_GREEN "%d" IO_DEFAULT " orders.\n", orderdir->entrycount );
+  ccGrowthFree( &growth );
+
+  return 1;
+}
+
+
+int bsReadOrderDirRange( bsContext *context, bsOrderDir *orderdir, time_t ordermintime, time_t ordermaxtime )
+{
+  int entryindex, entrycount;
+  bsOrderDirEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  orderdir->entrylist = 0;
+  orderdir->entrycount = 0;
+  orderdir->entryalloc = 0;
+  if( bsReadOrderManifest( orderdir, ordermintime, ordermaxtime ) )
+    return 1;
+
+  /* No manifest yet, scan the directory once */
+  if( !( bsScanOrderDir( context, orderdir ) ) )
+    return 0;
+  entrycount = 0;
+  for( entryindex = 0 ; entryindex < orderdir->entrycount ; entryindex++ )
+  {
+    entry = &orderdir->entrylist[entryindex];
+    if( ( entry->filetime <= ordermintime ) || ( ( ordermaxtime ) && ( entry->filetime > ordermaxtime ) ) )
+    {
+      free( entry->filepath );
+      continue;
+    }
+    orderdir->entrylist[ entrycount++ ] = *entry;
+  }
+  orderdir->entrycount = entrycount;
+
   return 1;
 }
 
 
+int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime )
+{
+  return bsReadOrderDirRange( context, orderdir, ordermintime, 0 );
+}
+
+
 void bsFreeOrderDir( bsContext *context, bsOrderDir *orderdir )
 {
   int entryindex;
@@ -201,3 +436,488 @@ void bsSortOrderDir( bsContext *context, bsOrderDir *orderdir )
   return;
 }
 
+
+
+////
+
+
+#define BS_ORDER_INDEX_MAGIC (0x58494f42)
+#define BS_ORDER_INDEX_BLOOM_SHIFT_MIN (8)
+#define BS_ORDER_INDEX_BLOOM_SHIFT_MAX (20)
+#define BS_ORDER_INDEX_BLOOM_HASHES (3)
+/* Minimum count of stored records before the index is compacted */
+#define BS_ORDER_INDEX_COMPACT_MIN (64)
+
+/* Record header, followed by the bloom filter of text trigrams, the sorted integer values and the sorted prices */
+typedef struct
+{
+  uint32_t magic;
+  int32_t ordertype;
+  int64_t orderid;
+  int32_t bloomshift;
+  int32_t intcount;
+  int32_t floatcount;
+  int32_t reserved;
+} bsOrderIndexHeader;
+
+static size_t bsOrderIndexRecordSize( bsOrderIndexHeader *header )
+{
+  size_t recordsize;
+  recordsize = sizeof(bsOrderIndexHeader) + ( ( (size_t)1 << header->bloomshift ) >> 3 ) + ( header->intcount * sizeof(int64_t) ) + ( header->floatcount * sizeof(float) );
+  /* Keep the next header aligned */
+  return ( recordsize + 0x7 ) & ~(size_t)0x7;
+}
+
+static inline uint32_t bsOrderIndexTrigram( char *str )
+{
+  return (uint32_t)( (unsigned char)str[0] ) | ( (uint32_t)( (unsigned char)str[1] ) << 8 ) | ( (uint32_t)( (unsigned char)str[2] ) << 16 );
+}
+
+static void bsOrderIndexBloomAdd( uint32_t *bloom, int bloomshift, char *str )
+{
+  int hashindex;
+  uint32_t trigram, hash0, hash1, bit;
+
+  if( !( str ) )
+    return;
+  for( ; ( str[0] ) && ( str[1] ) && ( str[2] ) ; str++ )
+  {
+    trigram = bsOrderIndexTrigram( str );
+    hash0 = ccHash32Int32Inline( trigram );
+    hash1 = ccHash32Int32Inline( trigram ^ 0x5bd1e995 ) | 0x1;
+    for( hashindex = 0 ; hashindex < BS_ORDER_INDEX_BLOOM_HASHES ; hashindex++ )
+    {
+      bit = ( hash0 + ( hashindex * hash1 ) ) & ( ( (uint32_t)1 << bloomshift ) - 1 );
+      bloom[ bit >> 5 ] |= (uint32_t)1 << ( bit & 31 );
+    }
+  }
+  return;
+}
+
+/* Returns 1 if all trigrams of str may be present */
+static int bsOrderIndexBloomTest( uint32_t *bloom, int bloomshift, char *str )
+{
+  int hashindex;
+  uint32_t trigram, hash0, hash1, bit;
+
+  for( ; ( str[0] ) && ( str[1] ) && ( str[2] ) ; str++ )
+  {
+    trigram = bsOrderIndexTrigram( str );
+    hash0 = ccHash32Int32Inline( trigram );
+    hash1 = ccHash32Int32Inline( trigram ^ 0x5bd1e995 ) | 0x1;
+    for( hashindex = 0 ; hashindex < BS_ORDER_INDEX_BLOOM_HASHES ; hashindex++ )
+    {
+      bit = ( hash0 + ( hashindex * hash1 ) ) & ( ( (uint32_t)1 << bloomshift ) - 1 );
+      if( !( bloom[ bit >> 5 ] & ( (uint32_t)1 << ( bit & 31 ) ) ) )
+        return 0;
+    }
+  }
+  return 1;
+}
+
+static int bsOrderIndexCmpInt64( int64_t *v0, int64_t *v1 )
+{
+  return ( *v0 > *v1 );
+}
+
+#define HSORT_MAIN bsOrderIndexSortInt64
+#define HSORT_CMP bsOrderIndexCmpInt64
+#define HSORT_TYPE int64_t
+#include "cchybridsort.h"
+#undef HSORT_MAIN
+#undef HSORT_CMP
+#undef HSORT_TYPE
+
+static int bsOrderIndexCmpFloat( float *v0, float *v1 )
+{
+  return ( *v0 > *v1 );
+}
+
+#define HSORT_MAIN bsOrderIndexSortFloat
+#define HSORT_CMP bsOrderIndexCmpFloat
+#define HSORT_TYPE float
+#include "cchybridsort.h"
+#undef HSORT_MAIN
+#undef HSORT_CMP
+#undef HSORT_TYPE
+
+static int bsOrderIndexUnique( void *list, int count, size_t size )
+{
+  int index, uniquecount;
+  char *data;
+
+  data = list;
+  uniquecount = 0;
+  for( index = 0 ; index < count ; index++ )
+  {
+    if( ( uniquecount ) && !( memcmp( &data[ ( uniquecount - 1 ) * size ], &data[ index * size ], size ) ) )
+      continue;
+    memmove( &data[ uniquecount * size ], &data[ index * size ], size );
+    uniquecount++;
+  }
+  return uniquecount;
+}
+
+
+/* Build the index record of an order inventory, returns the allocated record */
+static char *bsOrderIndexBuildRecord( int ordertype, int64_t orderid, bsxInventory *inv, size_t *retrecordsize )
+{
+  int itemindex, intcount, floatcount, bloomshift;
+  size_t textlength, recordsize;
+  bsxItem *item;
+  int64_t *intlist, *sorttmp;
+  float *floatlist, *floattmp;
+  uint32_t *bloom;
+  bsOrderIndexHeader *header;
+  char *record;
+
+  /* Size the bloom filter for about 8 bits per trigram */
+  textlength = 0;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    textlength += ( item->id ? strlen( item->id ) : 0 ) + ( item->name ? strlen( item->name ) : 0 ) + ( item->typename ? strlen( item->typename ) : 0 ) + ( item->colorname ? strlen( item->colorname ) : 0 ) + ( item->categoryname ? strlen( item->categoryname ) : 0 ) + ( item->comments ? strlen( item->comments ) : 0 ) + ( item->remarks ? strlen( item->remarks ) : 0 );
+  }
+  for( bloomshift = BS_ORDER_INDEX_BLOOM_SHIFT_MIN ; ( bloomshift < BS_ORDER_INDEX_BLOOM_SHIFT_MAX ) && ( ( (size_t)1 << bloomshift ) < ( textlength << 3 ) ) ; bloomshift++ );
+
+  recordsize = sizeof(bsOrderIndexHeader) + ( ( (size_t)1 << bloomshift ) >> 3 ) + ( 6 * inv->itemcount * sizeof(int64_t) ) + ( inv->itemcount * sizeof(float) ) + 0x8;
+  record = malloc( recordsize );
+  memset( record, 0, recordsize );
+  header = (bsOrderIndexHeader *)record;
+  header->magic = BS_ORDER_INDEX_MAGIC;
+  header->ordertype = ordertype;
+  header->orderid = orderid;
+  header->bloomshift = bloomshift;
+  bloom = ADDRESS( record, sizeof(bsOrderIndexHeader) );
+  intlist = ADDRESS( bloom, ( (size_t)1 << bloomshift ) >> 3 );
+
+  /* Gather every field searched by findorder */
+  intcount = 0;
+  floatlist = malloc( ( inv->itemcount + 1 ) * sizeof(float) );
+  floatcount = 0;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->id );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->name );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->typename );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->colorname );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->categoryname );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->comments );
+    bsOrderIndexBloomAdd( bloom, bloomshift, item->remarks );
+    intlist[intcount++] = item->boid;
+    intlist[intcount++] = item->colorid;
+    intlist[intcount++] = bsTranslateColorBl2Bo( item->colorid );
+    intlist[intcount++] = item->quantity;
+    intlist[intcount++] = item->lotid;
+    intlist[intcount++] = item->bolotid;
+    floatlist[floatcount++] = item->price;
+  }
+  sorttmp = malloc( ( intcount + 1 ) * sizeof(int64_t) );
+  bsOrderIndexSortInt64( intlist, sorttmp, intcount, (uint32_t)orderid );
+  free( sorttmp );
+  intcount = bsOrderIndexUnique( intlist, intcount, sizeof(int64_t) );
+  floattmp = malloc( ( floatcount + 1 ) * sizeof(float) );
+  bsOrderIndexSortFloat( floatlist, floattmp, floatcount, (uint32_t)orderid );
+  free( floattmp );
+  floatcount = bsOrderIndexUnique( floatlist, floatcount, sizeof(float) );
+  memcpy( &intlist[intcount], floatlist, floatcount * sizeof(float) );
+  free( floatlist );
+  header->intcount = intcount;
+  header->floatcount = floatcount;
+  *retrecordsize = bsOrderIndexRecordSize( header );
+
+  return record;
+}
+
+
+static inline uint32_t bsOrderIndexHash( int ordertype, int64_t orderid )
+{
+  return ccHash32Int64Inline( ( (uint64_t)orderid << 2 ) | (uint64_t)( ordertype & 0x3 ) );
+}
+
+int bsOrderIndexLoad( bsOrderIndex *orderindex, char *path )
+{
+  int recordcount;
+  size_t offset, recordsize;
+  uint32_t hashindex;
+  bsOrderIndexHeader *header, *slotheader;
+
+  DEBUG_SET_TRACKER();
+
+  memset( orderindex, 0, sizeof(bsOrderIndex) );
+  orderindex->data = ccFileLoad( path, 0, &orderindex->datasize );
+  if( !( orderindex->data ) )
+    return 0;
+
+  /* Count valid records, anything past the first invalid one is a torn write */
+  recordcount = 0;
+  for( offset = 0 ; offset + sizeof(bsOrderIndexHeader) <= orderindex->datasize ; offset += recordsize )
+  {
+    header = ADDRESS( orderindex->data, offset );
+    if( ( header->magic != BS_ORDER_INDEX_MAGIC ) || ( header->bloomshift < BS_ORDER_INDEX_BLOOM_SHIFT_MIN ) || ( header->bloomshift > BS_ORDER_INDEX_BLOOM_SHIFT_MAX ) || ( header->intcount < 0 ) || ( header->floatcount < 0 ) )
+      break;
+    recordsize = bsOrderIndexRecordSize( header );
+    if( offset + recordsize > orderindex->datasize )
+      break;
+    recordcount++;
+  }
+  orderindex->datasize = offset;
+  orderindex->storedcount = recordcount;
+
+  for( orderindex->hashmask = 255 ; orderindex->hashmask < 2 * (uint32_t)recordcount ; orderindex->hashmask = ( orderindex->hashmask << 1 ) | 0x1 );
+  orderindex->slottable = malloc( ( orderindex->hashmask + 1 ) * sizeof(void *) );
+  memset( orderindex->slottable, 0, ( orderindex->hashmask + 1 ) * sizeof(void *) );
+  for( offset = 0 ; offset < orderindex->datasize ; offset += bsOrderIndexRecordSize( header ) )
+  {
+    header = ADDRESS( orderindex->data, offset );
+    for( hashindex = bsOrderIndexHash( header->ordertype, header->orderid ) & orderindex->hashmask ; ; hashindex = ( hashindex + 1 ) & orderindex->hashmask )
+    {
+      slotheader = orderindex->slottable[hashindex];
+      if( !( slotheader ) )
+      {
+        orderindex->recordcount++;
+        orderindex->slottable[hashindex] = header;
+        break;
+      }
+      /* Later records replace earlier ones of the same order */
+      if( ( slotheader->ordertype == header->ordertype ) && ( slotheader->orderid == header->orderid ) )
+      {
+        orderindex->slottable[hashindex] = header;
+        break;
+      }
+    }
+  }
+
+  return 1;
+}
+
+
+/* Truncate a torn tail of the order index, and compact it when superseded records dominate */
+static void bsOrderIndexCheck( bsContext *context, size_t filesize )
+{
+  int hashindex;
+  size_t recordsize;
+  bsOrderIndex orderindex;
+  bsOrderIndexHeader *header;
+  ccGrowth growth;
+
+  DEBUG_SET_TRACKER();
+
+  context->orderindexsize = 0;
+  context->orderindexappendcount = 0;
+  context->orderindexlivecount = 0;
+  if( !( bsOrderIndexLoad( &orderindex, BS_ORDER_INDEX_FILE ) ) )
+    return;
+  if( ( orderindex.storedcount >= BS_ORDER_INDEX_COMPACT_MIN ) && ( orderindex.storedcount > 2 * orderindex.recordcount ) )
+  {
+    ccGrowthInit( &growth, orderindex.datasize );
+    for( hashindex = 0 ; hashindex <= orderindex.hashmask ; hashindex++ )
+    {
+      if( !( header = orderindex.slottable[hashindex] ) )
+        continue;
+      recordsize = bsOrderIndexRecordSize( header );
+      ccGrowthData( &growth, header, recordsize );
+    }
+    if( ( ccFileStore( BS_ORDER_INDEX_TEMP_FILE, growth.data, growth.offset, 1 ) ) && ( ccRenameFile( BS_ORDER_INDEX_TEMP_FILE, BS_ORDER_INDEX_FILE ) ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Compacted the order search index from %d to %d records.\n", orderindex.storedcount, orderindex.recordcount );
+      filesize = growth.offset;
+      orderindex.datasize = growth.offset;
+    }
+    ccGrowthFree( &growth );
+  }
+  else if( orderindex.datasize < filesize )
+  {
+    /* Rewrite the valid records, appending after a torn record would hide everything that follows */
+    if( ( ccFileStore( BS_ORDER_INDEX_TEMP_FILE, orderindex.data, orderindex.datasize, 1 ) ) && ( ccRenameFile( BS_ORDER_INDEX_TEMP_FILE, BS_ORDER_INDEX_FILE ) ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Truncated the order search index from %lld to %lld bytes.\n", (long long)filesize, (long long)orderindex.datasize );
+      filesize = orderindex.datasize;
+    }
+  }
+  context->orderindexsize = filesize;
+  context->orderindexlivecount = orderindex.recordcount;
+  bsOrderIndexFree( &orderindex );
+  return;
+}
+
+
+/* Append records to the order index, checking its tail first unless we wrote it last */
+static int bsOrderIndexAppend( bsContext *context, void *data, size_t datasize, int recordcount )
+{
+  int retval;
+  size_t filesize;
+  FILE *file;
+
+  if( !( ccFileStat( BS_ORDER_INDEX_FILE, &filesize, 0 ) ) )
+    filesize = 0;
+  /* Once as many records were appended as there were orders, superseded records may dominate */
+  if( ( filesize != context->orderindexsize ) || ( context->orderindexappendcount > CC_MAX( context->orderindexlivecount, BS_ORDER_INDEX_COMPACT_MIN ) ) )
+    bsOrderIndexCheck( context, filesize );
+
+  retval = 0;
+  file = fopen( BS_ORDER_INDEX_FILE, "ab" );
+  if( file )
+  {
+    if( fwrite( data, 1, datasize, file ) == datasize )
+      retval = 1;
+    fclose( file );
+  }
+  if( retval )
+  {
+    context->orderindexsize += datasize;
+    context->orderindexappendcount += recordcount;
+  }
+  else
+  {
+    /* Size unknown, check it on the next append */
+    context->orderindexsize = (size_t)-1;
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to update the order search index at \"" IO_RED "%s" IO_WHITE "\".\n", BS_ORDER_INDEX_FILE );
+  }
+
+  return retval;
+}
+
+
+int bsOrderIndexAdd( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv )
+{
+  int retval;
+  size_t recordsize;
+  char *record;
+
+  DEBUG_SET_TRACKER();
+
+  record = bsOrderIndexBuildRecord( ordertype, orderid, inv, &recordsize );
+  retval = bsOrderIndexAppend( context, record, recordsize, 1 );
+  free( record );
+
+  return retval;
+}
+
+
+int bsOrderIndexQueue( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv )
+{
+  size_t recordsize;
+  char *record;
+
+  DEBUG_SET_TRACKER();
+
+  record = bsOrderIndexBuildRecord( ordertype, orderid, inv, &recordsize );
+  ccGrowthData( &context->orderindexpending, record, recordsize );
+  free( record );
+
+  return 1;
+}
+
+
+void bsOrderDirCommit( bsContext *context )
+{
+  int recordcount;
+  size_t offset;
+  bsOrderIndexHeader *header;
+
+  DEBUG_SET_TRACKER();
+
+  if( context->orderindexpending.offset )
+  {
+    recordcount = 0;
+    for( offset = 0 ; offset < context->orderindexpending.offset ; offset += bsOrderIndexRecordSize( header ) )
+    {
+      header = ADDRESS( context->orderindexpending.data, offset );
+      recordcount++;
+    }
+    bsOrderIndexAppend( context, context->orderindexpending.data, context->orderindexpending.offset, recordcount );
+  }
+  if( context->ordermanifestpending.offset )
+    bsOrderManifestAppend( context, context->ordermanifestpending.data, context->ordermanifestpending.offset );
+  bsOrderDirDiscard( context );
+  return;
+}
+
+
+void bsOrderDirDiscard( bsContext *context )
+{
+  ccGrowthFree( &context->orderindexpending );
+  ccGrowthFree( &context->ordermanifestpending );
+  return;
+}
+
+
+void bsOrderIndexFree( bsOrderIndex *orderindex )
+{
+  free( orderindex->data );
+  free( orderindex->slottable );
+  memset( orderindex, 0, sizeof(bsOrderIndex) );
+  return;
+}
+
+
+int bsOrderIndexMatch( bsOrderIndex *orderindex, int ordertype, int64_t orderid, int termcount, char **termstring, int64_t *termint, float *termfloat )
+{
+  int termindex, low, high, mid;
+  uint32_t hashindex;
+  int64_t *intlist;
+  float *floatlist;
+  float tolerance;
+  uint32_t *bloom;
+  bsOrderIndexHeader *header;
+
+  if( !( orderindex->slottable ) )
+    return BS_ORDER_INDEX_MISSING;
+  for( hashindex = bsOrderIndexHash( ordertype, orderid ) & orderindex->hashmask ; ; hashindex = ( hashindex + 1 ) & orderindex->hashmask )
+  {
+    header = orderindex->slottable[hashindex];
+    if( !( header ) )
+      return BS_ORDER_INDEX_MISSING;
+    if( ( header->ordertype == ordertype ) && ( header->orderid == orderid ) )
+      break;
+  }
+  bloom = ADDRESS( header, sizeof(bsOrderIndexHeader) );
+  intlist = ADDRESS( bloom, ( (size_t)1 << header->bloomshift ) >> 3 );
+  floatlist = (float *)&intlist[ header->intcount ];
+
+  /* Every term must match some field, each check is a superset of what bsCmdFindInv() accepts */
+  for( termindex = 0 ; termindex < termcount ; termindex++ )
+  {
+    if( strlen( termstring[termindex] ) < 3 )
+      continue;
+    if( bsOrderIndexBloomTest( bloom, header->bloomshift, termstring[termindex] ) )
+      continue;
+    if( termint[termindex] >= 0 )
+    {
+      for( low = 0, high = header->intcount ; low < high ; )
+      {
+        mid = ( low + high ) >> 1;
+        if( intlist[mid] < termint[termindex] )
+          low = mid + 1;
+        else
+          high = mid;
+      }
+      if( ( low < header->intcount ) && ( intlist[low] == termint[termindex] ) )
+        continue;
+    }
+    if( termfloat[termindex] >= 0.0 )
+    {
+      tolerance = 0.002 + ( 0.0002 * termfloat[termindex] );
+      for( low = 0, high = header->floatcount ; low < high ; )
+      {
+        mid = ( low + high ) >> 1;
+        if( floatlist[mid] < ( termfloat[termindex] - tolerance ) )
+          low = mid + 1;
+        else
+          high = mid;
+      }
+      if( ( low < header->floatcount ) && ( floatlist[low] <= ( termfloat[termindex] + tolerance ) ) )
+        continue;
+    }
+    return BS_ORDER_INDEX_NOMATCH;
+  }
+
+  return BS_ORDER_INDEX_CANDIDATE;
+}
+
@@ -0,0 +1,899 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "mmatomic.h"
+#include "mmbitmap.h"
+#include "iolog.h"
+#include "debugtrack.h"
+#include "rand.h"
+
+#if CC_UNIX
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#elif CC_WINDOWS
+ #include <windows.h>
+ #include <direct.h>
+#else
+ #error Unknown/Unsupported platform!
+#endif
+
+#include "tcp.h"
+#include "tcphttp.h"
+#include "oauth.h"
+#include "exclperm.h"
+#include "journal.h"
+
+#include "bsx.h"
+#include "bsxpg.h"
+#include "json.h"
+#include "bsorder.h"
+#include "bricklink.h"
+#include "brickowl.h"
+#include "colortable.h"
+#include "bstranslation.h"
+
+#include "bricksync.h"
+
+
+////
+
+
+/*
+Checks the figures parsed from price guide pages against the expected.txt file next to them, then checks that the pages
+streamed through blPriceGuideExtractor give the same result as the buffered blHtmlParsePriceGuide().
+Built by ./compile-pgtest, which links every BrickSync module with BS_BENCH_BUILD defined to drop BrickSync's main().
+Run as ./bspgtest with the pages of testdata/priceguide as arguments ; the exit code is non-zero on any mismatch.
+
+Each page is first fed to the extractor in fragments of many sizes, then served by a loopback HTTP server and fetched through
+httpAddStreamQuery(), pipelined with and without chunked transfer-encoding, and one query at a time.
+
+Last, a random inventory is evaluated with the parsed price guides through bsPriceGuideSumCallback(), and the totals reduced
+from its columns are compared with running sums accumulated lot by lot.
+*/
+
+
+#define BS_PGTEST_DEFAULT_PORT (18935)
+#define BS_PGTEST_TIMEOUT (10000)
+#define BS_PGTEST_RANDOM_SPLITS (16)
+/* Replies are written in steps, so that they arrive over many receive buffers */
+#define BS_PGTEST_SEND_STEP (4096)
+#define BS_PGTEST_EXPECTED_FILE "expected.txt"
+#define BS_PGTEST_SUM_LOTS (5000)
+#define BS_PGTEST_SUM_ALTERNATES (24)
+
+typedef struct
+{
+  char *path;
+  char *data;
+  size_t size;
+  /* Result of the buffered parser */
+  int refresult;
+  bsxPriceGuide refpg[2];
+} bsPgTestPage;
+
+typedef struct _bsPgTest bsPgTest;
+
+typedef struct
+{
+  bsPgTest *test;
+  tcpLink *link;
+  char *recvdata;
+  size_t recvsize;
+  size_t recvalloc;
+  /* Output not yet written to the link */
+  ccGrowth output;
+  size_t outputoffset;
+  int deadflag;
+  mmListNode list;
+} bsPgTestLink;
+
+struct _bsPgTest
+{
+  bsPgTestPage *pagelist;
+  int pagecount;
+  int port;
+  randState randstate;
+  tcpContext tcp;
+  tcpLink *listenlink;
+  void *linklist;
+  int failcount;
+  int replycount;
+  int earlycount;
+};
+
+typedef struct
+{
+  bsPgTest *test;
+  bsPgTestPage *page;
+  int chunkedflag;
+  int stopflag;
+  blPriceGuideExtractor extractor;
+} bsPgTestQuery;
+
+
+////
+
+
+/* Fields of bsxPriceGuide in the order of expected.txt, the first two of each half are counts */
+static const size_t bsPgTestFieldOffset[12] =
+{
+  offsetof(bsxPriceGuide,salecount), offsetof(bsxPriceGuide,saleqty),
+  offsetof(bsxPriceGuide,saleminimum), offsetof(bsxPriceGuide,saleaverage),
+  offsetof(bsxPriceGuide,saleqtyaverage), offsetof(bsxPriceGuide,salemaximum),
+  offsetof(bsxPriceGuide,stockcount), offsetof(bsxPriceGuide,stockqty),
+  offsetof(bsxPriceGuide,stockminimum), offsetof(bsxPriceGuide,stockaverage),
+  offsetof(bsxPriceGuide,stockqtyaverage), offsetof(bsxPriceGuide,stockmaximum)
+};
+
+/* Find the line of expected.txt for the page, "<file name> <result> <12 new figures> <12 used figures>" */
+static char *bsPgTestFindExpected( char *expected, char *name )
+{
+  size_t namelength;
+  char *line;
+
+  namelength = strlen( name );
+  for( line = expected ; line ; )
+  {
+    if( ( strncmp( line, name, namelength ) == 0 ) && ( line[ namelength ] == ' ' ) )
+      return &line[ namelength ];
+    line = strchr( line, '\n' );
+    if( line )
+      line++;
+  }
+  return 0;
+}
+
+/* Assert the parsed figures against the expected ones, they are only given for pages that parse */
+static void bsPgTestCheckExpected( bsPgTest *test, bsPgTestPage *page )
+{
+  int sub, index, result, failcount;
+  float value, expectvalue;
+  size_t dirlength;
+  char *name, *path, *expected, *line, *end;
+  void *addr;
+
+  name = strrchr( page->path, '/' );
+  name = ( name ? name + 1 : page->path );
+  dirlength = name - page->path;
+  path = malloc( dirlength + sizeof(BS_PGTEST_EXPECTED_FILE) );
+  memcpy( path, page->path, dirlength );
+  memcpy( &path[ dirlength ], BS_PGTEST_EXPECTED_FILE, sizeof(BS_PGTEST_EXPECTED_FILE) );
+  expected = ccFileLoad( path, 1048576, 0 );
+  line = ( expected ? bsPgTestFindExpected( expected, name ) : 0 );
+  if( !( line ) )
+  {
+    printf( "FAIL: %s, no expected figures in %s\n", page->path, path );
+    test->failcount++;
+    free( path );
+    free( expected );
+    return;
+  }
+
+  failcount = 0;
+  result = (int)strtol( line, &end, 10 );
+  if( result != page->refresult )
+  {
+    printf( "FAIL: %s, parse result %d, expected %d\n", page->path, page->refresult, result );
+    failcount++;
+  }
+  else if( result )
+  {
+    for( sub = 0 ; sub < 2 ; sub++ )
+    {
+      for( index = 0 ; index < 12 ; index++ )
+      {
+        expectvalue = strtof( end, &end );
+        addr = ADDRESS( &page->refpg[sub], bsPgTestFieldOffset[index] );
+        value = ( ( ( index % 6 ) < 2 ) ? (float)*(int *)addr : *(float *)addr );
+        if( value != expectvalue )
+        {
+          printf( "FAIL: %s, %s figure %d is %.3f, expected %.3f\n", page->path, ( sub ? "used" : "new" ), index, value, expectvalue );
+          failcount++;
+        }
+      }
+    }
+  }
+  test->failcount += failcount;
+  free( path );
+  free( expected );
+  return;
+}
+
+static int bsPgTestMatch( bsPgTestPage *page, int result, bsxPriceGuide *pgnew, bsxPriceGuide *pgused )
+{
+  bsxPriceGuide pg[2];
+
+  if( result != page->refresult )
+    return 0;
+  pg[0] = *pgnew;
+  pg[1] = *pgused;
+  pg[0].modtime = page->refpg[0].modtime;
+  pg[1].modtime = page->refpg[1].modtime;
+  return ( memcmp( pg, page->refpg, 2 * sizeof(bsxPriceGuide) ) == 0 );
+}
+
+/* Feed a page in fragments from sizelist, cycled, stopping when the extractor needs no more data ; return bytes fed */
+static size_t bsPgTestStream( bsPgTestPage *page, int *sizelist, int sizecount, int *retresult, bsxPriceGuide *pgnew, bsxPriceGuide *pgused )
+{
+  int sizeindex, stopflag;
+  size_t offset, fragsize;
+  blPriceGuideExtractor extractor;
+
+  blPriceGuideExtractorInit( &extractor );
+  stopflag = 0;
+  for( offset = 0, sizeindex = 0 ; ( offset < page->size ) && !( stopflag ) ; offset += fragsize, sizeindex = ( sizeindex + 1 ) % sizecount )
+  {
+    fragsize = sizelist[ sizeindex ];
+    if( fragsize > page->size - offset )
+      fragsize = page->size - offset;
+    stopflag = blPriceGuideExtractorFeed( &extractor, &page->data[ offset ], (int)fragsize );
+  }
+  *retresult = blPriceGuideExtractorFinish( &extractor, pgnew, pgused );
+  return offset;
+}
+
+static void bsPgTestSplits( bsPgTest *test, bsPgTestPage *page )
+{
+  int index, splitindex, result, failcount;
+  int sizelist[64];
+  size_t offset;
+  bsxPriceGuide pgnew, pgused;
+  static const int fixedsizes[] = { 1, 2, 7, 15, 16, 17, 61, 509, 4096, 65536 };
+
+  failcount = 0;
+  for( index = 0 ; index < (int)( sizeof(fixedsizes) / sizeof(int) ) ; index++ )
+  {
+    bsPgTestStream( page, (int *)&fixedsizes[index], 1, &result, &pgnew, &pgused );
+    if( !( bsPgTestMatch( page, result, &pgnew, &pgused ) ) )
+    {
+      printf( "FAIL: %s, fragments of %d bytes don't match the buffered parser\n", page->path, fixedsizes[index] );
+      failcount++;
+    }
+  }
+  sizelist[0] = (int)page->size;
+  bsPgTestStream( page, sizelist, 1, &result, &pgnew, &pgused );
+  if( !( bsPgTestMatch( page, result, &pgnew, &pgused ) ) )
+  {
+    printf( "FAIL: %s, whole page doesn't match the buffered parser\n", page->path );
+    failcount++;
+  }
+  for( splitindex = 0 ; splitindex < BS_PGTEST_RANDOM_SPLITS ; splitindex++ )
+  {
+    for( index = 0 ; index < 64 ; index++ )
+      sizelist[index] = 1 + (int)( randInt( &test->randstate ) % ( ( splitindex & 1 ) ? 32 : 3000 ) );
+    bsPgTestStream( page, sizelist, 64, &result, &pgnew, &pgused );
+    if( !( bsPgTestMatch( page, result, &pgnew, &pgused ) ) )
+    {
+      printf( "FAIL: %s, random split %d doesn't match the buffered parser\n", page->path, splitindex );
+      failcount++;
+    }
+  }
+
+  sizelist[0] = 1;
+  offset = bsPgTestStream( page, sizelist, 1, &result, &pgnew, &pgused );
+  printf( "%s : %s, %d of %d bytes needed, %d mismatches\n", page->path, ( result ? "parsed" : "parse error" ), (int)offset, (int)page->size, failcount );
+  fflush( stdout );
+  test->failcount += failcount;
+  return;
+}
+
+
+////
+
+
+static void *bsPgTestIncoming( void *link, void *listenvalue )
+{
+  bsPgTest *test;
+  bsPgTestLink *tlink;
+
+  test = listenvalue;
+  tlink = calloc( 1, sizeof(bsPgTestLink) );
+  tlink->test = test;
+  tlink->link = link;
+  tlink->recvalloc = 65536;
+  tlink->recvdata = malloc( tlink->recvalloc );
+  ccGrowthInit( &tlink->output, 65536 );
+  mmListAdd( &test->linklist, tlink, offsetof(bsPgTestLink,list) );
+  tcpSetTimeout( &test->tcp, link, BS_PGTEST_TIMEOUT );
+  return tlink;
+}
+
+static void bsPgTestRecv( void *uservalue, tcpDataBuffer *recvbuf )
+{
+  bsPgTestLink *tlink;
+
+  tlink = uservalue;
+  if( tlink->recvsize + recvbuf->size + 1 > tlink->recvalloc )
+  {
+    tlink->recvalloc = CC_MAX( tlink->recvalloc << 1, tlink->recvsize + recvbuf->size + 1 );
+    tlink->recvdata = realloc( tlink->recvdata, tlink->recvalloc );
+  }
+  memcpy( &tlink->recvdata[ tlink->recvsize ], recvbuf->pointer, recvbuf->size );
+  tlink->recvsize += recvbuf->size;
+  tlink->recvdata[ tlink->recvsize ] = 0;
+  tcpFreeRecvBuffer( &tlink->test->tcp, tlink->link, recvbuf );
+  return;
+}
+
+static void bsPgTestSendReady( void *uservalue, size_t sendbuffered )
+{
+  return;
+}
+
+static void bsPgTestSendFinished( void *uservalue )
+{
+  return;
+}
+
+static void bsPgTestClosed( void *uservalue )
+{
+  bsPgTestLink *tlink;
+  tlink = uservalue;
+  tlink->deadflag = 1;
+  return;
+}
+
+/* Links are only flagged from the callbacks, the main loop does all the work */
+static tcpCallbackSet bsPgTestIO =
+{
+  .incoming = bsPgTestIncoming,
+  .recv = bsPgTestRecv,
+  .sendready = bsPgTestSendReady,
+  .sendwait = 0,
+  .sendfinished = bsPgTestSendFinished,
+  .timeout = bsPgTestClosed,
+  .closed = bsPgTestClosed,
+  .wake = 0
+};
+
+static void bsPgTestLinkFree( bsPgTest *test, bsPgTestLink *tlink )
+{
+  tcpClose( &test->tcp, tlink->link );
+  mmListRemove( tlink, offsetof(bsPgTestLink,list) );
+  ccGrowthFree( &tlink->output );
+  free( tlink->recvdata );
+  free( tlink );
+  return;
+}
+
+static void bsPgTestSend( bsPgTest *test, bsPgTestLink *tlink, char *data, size_t size )
+{
+  ccGrowthData( &tlink->output, data, size );
+  return;
+}
+
+/* Write the next step of pending output, return non-zero if more remains */
+static int bsPgTestFlushLink( bsPgTest *test, bsPgTestLink *tlink )
+{
+  size_t size;
+  tcpDataBuffer *sendbuf;
+
+  size = CC_MIN( (size_t)BS_PGTEST_SEND_STEP, tlink->output.offset - tlink->outputoffset );
+  if( size )
+  {
+    sendbuf = tcpAllocSendBuffer( &test->tcp, tlink->link, size );
+    memcpy( sendbuf->pointer, &tlink->output.data[ tlink->outputoffset ], size );
+    tcpQueueSendBuffer( &test->tcp, tlink->link, sendbuf, size );
+    tlink->outputoffset += size;
+  }
+  if( tlink->outputoffset < tlink->output.offset )
+    return 1;
+  tlink->output.offset = 0;
+  tlink->outputoffset = 0;
+  return 0;
+}
+
+/* Reply with the page, chunked in fragments of varying sizes or with a Content-Length */
+static void bsPgTestReply( bsPgTest *test, bsPgTestLink *tlink, bsPgTestPage *page, int chunkedflag )
+{
+  int chunkindex;
+  size_t offset, chunksize, headersize;
+  char header[512];
+  static const int chunksizes[] = { 1, 300, 4000, 17, 1500, 65536 };
+
+  if( !( chunkedflag ) )
+  {
+    headersize = snprintf( header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %d\r\nConnection: Keep-Alive\r\n\r\n", (int)page->size );
+    bsPgTestSend( test, tlink, header, headersize );
+    bsPgTestSend( test, tlink, page->data, page->size );
+    return;
+  }
+  headersize = snprintf( header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nTransfer-Encoding: chunked\r\nConnection: Keep-Alive\r\n\r\n" );
+  bsPgTestSend( test, tlink, header, headersize );
+  for( offset = 0, chunkindex = 0 ; offset < page->size ; offset += chunksize, chunkindex = ( chunkindex + 1 ) % (int)( sizeof(chunksizes) / sizeof(int) ) )
+  {
+    chunksize = CC_MIN( (size_t)chunksizes[ chunkindex ], page->size - offset );
+    headersize = snprintf( header, sizeof(header), "%x\r\n", (int)chunksize );
+    bsPgTestSend( test, tlink, header, headersize );
+    bsPgTestSend( test, tlink, &page->data[ offset ], chunksize );
+    bsPgTestSend( test, tlink, "\r\n", 2 );
+  }
+  bsPgTestSend( test, tlink, "0\r\n\r\n", 5 );
+  return;
+}
+
+/* Answer all complete requests, "GET /<page index>/<chunked flag> HTTP/1.1" */
+static void bsPgTestServe( bsPgTest *test, bsPgTestLink *tlink )
+{
+  int pageindex, chunkedflag;
+  size_t requestsize;
+  char *end;
+
+  for( ; ; )
+  {
+    end = ccStrFindStr( tlink->recvdata, "\r\n\r\n" );
+    if( !( end ) )
+      break;
+    requestsize = ( end + 4 ) - tlink->recvdata;
+    if( ( sscanf( tlink->recvdata, "GET /%d/%d ", &pageindex, &chunkedflag ) == 2 ) && ( (unsigned)pageindex < (unsigned)test->pagecount ) )
+      bsPgTestReply( test, tlink, &test->pagelist[ pageindex ], chunkedflag );
+    else
+      bsPgTestSend( test, tlink, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n", 45 );
+    tlink->recvsize -= requestsize;
+    memmove( tlink->recvdata, &tlink->recvdata[ requestsize ], tlink->recvsize + 1 );
+  }
+  return;
+}
+
+
+////
+
+
+static int bsPgTestFragment( void *uservalue, void *data, size_t datasize )
+{
+  bsPgTestQuery *tquery;
+
+  tquery = uservalue;
+  if( !( data ) )
+  {
+    blPriceGuideExtractorInit( &tquery->extractor );
+    tquery->stopflag = 0;
+    return 0;
+  }
+  tquery->stopflag = blPriceGuideExtractorFeed( &tquery->extractor, data, (int)datasize );
+  return tquery->stopflag;
+}
+
+static void bsPgTestQueryReply( void *uservalue, int resultcode, httpResponse *response )
+{
+  int result;
+  bsxPriceGuide pgnew, pgused;
+  bsPgTestQuery *tquery;
+  bsPgTest *test;
+
+  tquery = uservalue;
+  test = tquery->test;
+  test->replycount++;
+  result = blPriceGuideExtractorFinish( &tquery->extractor, &pgnew, &pgused );
+  if( ( resultcode != HTTP_RESULT_SUCCESS ) || !( response ) || ( response->httpcode != 200 ) )
+  {
+    printf( "FAIL: %s, HTTP query failed, result %d\n", tquery->page->path, resultcode );
+    test->failcount++;
+  }
+  else if( !( bsPgTestMatch( tquery->page, result, &pgnew, &pgused ) ) )
+  {
+    printf( "FAIL: %s, streamed %s reply doesn't match the buffered parser\n", tquery->page->path, ( tquery->chunkedflag ? "chunked" : "plain" ) );
+    test->failcount++;
+  }
+  else if( ( response->bodysize > tquery->page->size ) || ( !( tquery->stopflag ) && ( response->bodysize != tquery->page->size ) ) )
+  {
+    printf( "FAIL: %s, body of %d bytes for a page of %d bytes\n", tquery->page->path, (int)response->bodysize, (int)tquery->page->size );
+    test->failcount++;
+  }
+  else if( response->bodysize < tquery->page->size )
+    test->earlycount++;
+  free( tquery );
+  return;
+}
+
+static void bsPgTestQueue( bsPgTest *test, httpConnection *http, int pageindex, int chunkedflag )
+{
+  char querystring[256];
+  bsPgTestQuery *tquery;
+
+  tquery = calloc( 1, sizeof(bsPgTestQuery) );
+  tquery->test = test;
+  tquery->page = &test->pagelist[ pageindex ];
+  tquery->chunkedflag = chunkedflag;
+  blPriceGuideExtractorInit( &tquery->extractor );
+  snprintf( querystring, sizeof(querystring), "GET /%d/%d HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: Keep-Alive\r\n\r\n", pageindex, chunkedflag );
+  httpAddStreamQuery( http, querystring, strlen( querystring ), HTTP_QUERY_FLAGS_RETRY, (void *)tquery, bsPgTestQueryReply, bsPgTestFragment );
+  return;
+}
+
+/* Run the server and the client until all queries are answered */
+static int bsPgTestWait( bsPgTest *test, httpConnection *http )
+{
+  int pendingflag;
+  int64_t deadline;
+  bsPgTestLink *tlink, *tlinknext;
+
+  deadline = ccGetNanosecondsTime() + (int64_t)BS_PGTEST_TIMEOUT * 1000000;
+  for( ; ; )
+  {
+    tcpFlush( &test->tcp );
+    pendingflag = 0;
+    for( tlink = test->linklist ; tlink ; tlink = tlinknext )
+    {
+      tlinknext = tlink->list.next;
+      if( tlink->deadflag )
+      {
+        bsPgTestLinkFree( test, tlink );
+        continue;
+      }
+      bsPgTestServe( test, tlink );
+      pendingflag |= bsPgTestFlushLink( test, tlink );
+    }
+    httpProcess( http );
+    if( !( httpGetQueryQueueCount( http ) ) )
+      break;
+    if( ccGetNanosecondsTime() > deadline )
+    {
+      printf( "FAIL: Timeout with %d queries pending\n", httpGetQueryQueueCount( http ) );
+      test->failcount++;
+      return 0;
+    }
+    tcpWait( &test->tcp, ( pendingflag ? 1 : 100 ) );
+  }
+  return 1;
+}
+
+static void bsPgTestHttp( bsPgTest *test )
+{
+  int pageindex, querycount, earlycount;
+  httpConnection *http;
+
+  if( !( tcpInit( &test->tcp, 1, 0 ) ) )
+  {
+    printf( "FAIL: Failed to initialize TCP\n" );
+    test->failcount++;
+    return;
+  }
+  if( !( test->listenlink = tcpListen( &test->tcp, "127.0.0.1", test->port, test, &bsPgTestIO, 0 ) ) )
+  {
+    printf( "FAIL: Failed to listen on port %d\n", test->port );
+    test->failcount++;
+    tcpEnd( &test->tcp );
+    return;
+  }
+  http = httpOpen( &test->tcp, "127.0.0.1", test->port, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
+
+  /* Pipelined, the rest of a reply is skipped once the tables are parsed */
+  querycount = test->replycount;
+  earlycount = test->earlycount;
+  for( pageindex = 0 ; pageindex < test->pagecount ; pageindex++ )
+  {
+    bsPgTestQueue( test, http, pageindex, 0 );
+    bsPgTestQueue( test, http, pageindex, 1 );
+  }
+  bsPgTestWait( test, http );
+  printf( "Pipelined : %d replies, %d ended early\n", test->replycount - querycount, test->earlycount - earlycount );
+  fflush( stdout );
+
+  /* One query at a time, the link is closed once the tables are parsed */
+  querycount = test->replycount;
+  earlycount = test->earlycount;
+  for( pageindex = 0 ; pageindex < test->pagecount ; pageindex++ )
+  {
+    bsPgTestQueue( test, http, pageindex, pageindex & 1 );
+    if( !( bsPgTestWait( test, http ) ) )
+      break;
+  }
+  printf( "Sequential : %d replies, %d ended early\n", test->replycount - querycount, test->earlycount - earlycount );
+  if( test->replycount != 3 * test->pagecount )
+  {
+    printf( "FAIL: %d replies for %d queries\n", test->replycount, 3 * test->pagecount );
+    test->failcount++;
+  }
+
+  httpClose( http );
+  while( test->linklist )
+    bsPgTestLinkFree( test, test->linklist );
+  tcpClose( &test->tcp, test->listenlink );
+  tcpEnd( &test->tcp );
+  return;
+}
+
+
+////
+
+
+/* Running sums of a price guide evaluation, indexed as stock, new and total */
+typedef struct
+{
+  int lots[3];
+  int count[3];
+  double value[3];
+  double sale[3];
+  double price[3];
+  double pgq[3];
+  double pgp[3];
+  int stalelots;
+} bsPgTestSum;
+
+typedef struct
+{
+  int itemindex;
+  float unitprice;
+  int category;
+  int quantity;
+  double value;
+  double sale;
+  double price;
+  double pgq;
+  double pgp;
+} bsPgTestSumAlt;
+
+static void bsPgTestSumAdd( bsPgTestSum *sum, int category, int quantity, double value, double sale, double price, double pgq, double pgp, int sign )
+{
+  int pass, index;
+  for( pass = 0 ; pass < 2 ; pass++ )
+  {
+    index = ( pass ? 2 : category );
+    sum->lots[index] += sign;
+    sum->count[index] += sign * quantity;
+    sum->value[index] += (double)sign * value;
+    sum->sale[index] += (double)sign * sale;
+    sum->price[index] += (double)sign * price;
+    sum->pgq[index] += (double)sign * value * pgq;
+    sum->pgp[index] += (double)sign * value * pgp;
+  }
+  return;
+}
+
+/* Same evaluation as bsPriceGuideSumCallback(), lot by lot */
+static void bsPgTestSumLot( bsPgTestSum *sum, bsPgTestSumAlt *altlist, bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg )
+{
+  int category;
+  float unitprice;
+  double pgq, pgp, value, sale, price;
+  bsxItem *stockitem;
+  bsPgTestSumAlt *alt;
+
+  stockitem = bsxFindMatchItem( context->inventory, item );
+  pgq = ( pg->stockqty ? fmin( (double)pg->saleqty / (double)pg->stockqty, 8.0 ) : 8.0 );
+  pgp = 0.0;
+  if( pg->stockqtyaverage > 0.01 )
+    pgp = (double)pg->saleqtyaverage / (double)pg->stockqtyaverage;
+  pgp = fmin( pgp, 3.0 );
+  if( pg->modtime < ( context->curtime - BS_PRICEGUIDE_CACHETIME_DEFAULT ) )
+    sum->stalelots++;
+  unitprice = ( pg->saleqty ? pg->saleqtyaverage : pg->stockqtyaverage );
+  value = (double)item->quantity * (double)unitprice;
+  sale = (double)item->quantity * (double)pg->stockqtyaverage;
+  price = ( stockitem ? (double)item->quantity * (double)stockitem->price : 0.0 );
+  category = ( ( ( stockitem ) && ( stockitem->quantity > 0 ) ) ? 0 : 1 );
+
+  if( item->alternateid )
+  {
+    alt = &altlist[ item->alternateid ];
+    if( alt->itemindex >= 0 )
+    {
+      if( ( unitprice < 0.0001 ) || ( unitprice >= alt->unitprice ) )
+        return;
+      bsPgTestSumAdd( sum, alt->category, alt->quantity, alt->value, alt->sale, alt->price, alt->pgq, alt->pgp, -1 );
+    }
+    alt->itemindex = (int)bsxGetItemListIndex( inv, item );
+    alt->unitprice = unitprice;
+    alt->category = category;
+    alt->quantity = item->quantity;
+    alt->value = value;
+    alt->sale = sale;
+    alt->price = price;
+    alt->pgq = pgq;
+    alt->pgp = pgp;
+  }
+  bsPgTestSumAdd( sum, category, item->quantity, value, sale, price, pgq, pgp, 1 );
+  return;
+}
+
+static void bsPgTestSumCheck( bsPgTest *test, char *name, double value, double refvalue )
+{
+  /* The columns are reduced in a different order, allow for rounding */
+  if( fabs( value - refvalue ) <= 1e-9 * fmax( 1.0, fmax( fabs( value ), fabs( refvalue ) ) ) )
+    return;
+  printf( "FAIL: price guide sum %s is %.9f, running sum %.9f\n", name, value, refvalue );
+  test->failcount++;
+  return;
+}
+
+/* Evaluate a random inventory with the parsed price guides, compare bsPriceGuideState with running sums */
+static void bsPgTestSumState( bsPgTest *test )
+{
+  int pageindex, itemindex, pgcount, altindex, index;
+  bsContext *context;
+  bsxInventory *inv, *stockinv;
+  bsxItem item;
+  bsxItem *newitem;
+  bsxPriceGuide *pglist, *pg;
+  bsPriceGuideState pgstate;
+  bsPgTestSum sum;
+  bsPgTestSumAlt altlist[ BS_PGTEST_SUM_ALTERNATES + 1 ];
+  char idbuffer[32];
+
+  /* Price guides of all pages parsed, both conditions */
+  pglist = malloc( 2 * test->pagecount * sizeof(bsxPriceGuide) );
+  pgcount = 0;
+  for( pageindex = 0 ; pageindex < test->pagecount ; pageindex++ )
+  {
+    if( !( test->pagelist[ pageindex ].refresult ) )
+      continue;
+    pglist[ pgcount++ ] = test->pagelist[ pageindex ].refpg[0];
+    pglist[ pgcount++ ] = test->pagelist[ pageindex ].refpg[1];
+  }
+  if( !( pgcount ) )
+  {
+    free( pglist );
+    return;
+  }
+
+  context = malloc( sizeof(bsContext) );
+  memset( context, 0, sizeof(bsContext) );
+  context->curtime = time( 0 );
+  inv = bsxNewInventory();
+  stockinv = bsxNewInventory();
+  for( itemindex = 0 ; itemindex < BS_PGTEST_SUM_LOTS ; itemindex++ )
+  {
+    bsxClearItem( &item );
+    snprintf( idbuffer, sizeof(idbuffer), "%d", 3000 + (int)( randInt( &test->randstate ) % 2000 ) );
+    item.id = idbuffer;
+    item.typeid = 'P';
+    item.colorid = 1 + (int)( randInt( &test->randstate ) % 8 );
+    item.condition = ( randInt( &test->randstate ) % 4 ? 'N' : 'U' );
+    item.quantity = 1 + (int)( randInt( &test->randstate ) % 200 );
+    item.alternateid = ( randInt( &test->randstate ) % 4 ? 0 : 1 + (int)( randInt( &test->randstate ) % BS_PGTEST_SUM_ALTERNATES ) );
+    bsxAddCopyItem( inv, &item );
+    /* Some lots are in stock, some were but are sold out */
+    if( randInt( &test->randstate ) % 2 )
+    {
+      item.quantity = (int)( randInt( &test->randstate ) % 50 );
+      item.alternateid = 0;
+      item.price = (float)( 1 + randInt( &test->randstate ) % 5000 ) / 100.0f;
+      bsxAddCopyItem( stockinv, &item );
+    }
+  }
+  context->inventory = stockinv;
+
+  bsPriceGuideInitState( &pgstate, inv, BS_PRICEGUIDE_CACHETIME_DEFAULT, 1, 0 );
+  memset( &sum, 0, sizeof(bsPgTestSum) );
+  for( altindex = 0 ; altindex <= BS_PGTEST_SUM_ALTERNATES ; altindex++ )
+    altlist[ altindex ].itemindex = -1;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    newitem = &inv->itemlist[ itemindex ];
+    pg = &pglist[ randInt( &test->randstate ) % pgcount ];
+    pg->modtime = ( randInt( &test->randstate ) % 8 ? context->curtime : 0 );
+    bsPgTestSumLot( &sum, altlist, context, inv, newitem, pg );
+    bsPriceGuideSumCallback( context, inv, newitem, pg, &pgstate );
+  }
+  bsPriceGuideFinishState( &pgstate );
+  for( index = 0 ; index < 3 ; index++ )
+  {
+    if( sum.value[index] > 0.001 )
+    {
+      sum.pgq[index] /= sum.value[index];
+      sum.pgp[index] /= sum.value[index];
+    }
+  }
+
+  if( ( pgstate.stocklots != sum.lots[0] ) || ( pgstate.newlots != sum.lots[1] ) || ( pgstate.totallots != sum.lots[2] ) || ( pgstate.stockcount != sum.count[0] ) || ( pgstate.newcount != sum.count[1] ) || ( pgstate.totalcount != sum.count[2] ) || ( pgstate.stalelots != sum.stalelots ) )
+  {
+    printf( "FAIL: price guide sum counts, lots %d %d %d, running %d %d %d\n", pgstate.stocklots, pgstate.newlots, pgstate.totallots, sum.lots[0], sum.lots[1], sum.lots[2] );
+    test->failcount++;
+  }
+  bsPgTestSumCheck( test, "stockvalue", pgstate.stockvalue, sum.value[0] );
+  bsPgTestSumCheck( test, "stocksale", pgstate.stocksale, sum.sale[0] );
+  bsPgTestSumCheck( test, "stockprice", pgstate.stockprice, sum.price[0] );
+  bsPgTestSumCheck( test, "stockpgq", pgstate.stockpgq, sum.pgq[0] );
+  bsPgTestSumCheck( test, "stockpgp", pgstate.stockpgp, sum.pgp[0] );
+  bsPgTestSumCheck( test, "newvalue", pgstate.newvalue, sum.value[1] );
+  bsPgTestSumCheck( test, "newsale", pgstate.newsale, sum.sale[1] );
+  bsPgTestSumCheck( test, "newprice", pgstate.newprice, sum.price[1] );
+  bsPgTestSumCheck( test, "newpgq", pgstate.newpgq, sum.pgq[1] );
+  bsPgTestSumCheck( test, "newpgp", pgstate.newpgp, sum.pgp[1] );
+  bsPgTestSumCheck( test, "totalvalue", pgstate.totalvalue, sum.value[2] );
+  bsPgTestSumCheck( test, "totalsale", pgstate.totalsale, sum.sale[2] );
+  bsPgTestSumCheck( test, "totalprice", pgstate.totalprice, sum.price[2] );
+  bsPgTestSumCheck( test, "totalpgq", pgstate.totalpgq, sum.pgq[2] );
+  bsPgTestSumCheck( test, "totalpgp", pgstate.totalpgp, sum.pgp[2] );
+  printf( "Price guide sums : %d lots, %d stock, %d new, %d stale, total value %.2f\n", inv->itemcount, pgstate.stocklots, pgstate.newlots, pgstate.stalelots, pgstate.totalvalue );
+
+  bsxFreeInventory( inv );
+  bsxFreeInventory( stockinv );
+  free( context );
+  free( pglist );
+  return;
+}
+
+
+////
+
+
+int main( int argc, char **argv )
+{
+  int argindex, pageindex;
+  int32_t readint;
+  bsPgTest test;
+  bsPgTestPage *page;
+
+  memset( &test, 0, sizeof(bsPgTest) );
+  test.port = BS_PGTEST_DEFAULT_PORT;
+  test.pagelist = malloc( argc * sizeof(bsPgTestPage) );
+  for( argindex = 1 ; argindex < argc ; argindex++ )
+  {
+    if( !( strcmp( argv[ argindex ], "-port" ) ) && ( argindex + 1 < argc ) )
+    {
+      if( !( ccStrParseInt32( argv[ ++argindex ], &readint ) ) )
+        goto usage;
+      test.port = readint;
+      continue;
+    }
+    page = &test.pagelist[ test.pagecount ];
+    page->path = argv[ argindex ];
+    page->data = ccFileLoad( page->path, 16*1048576, &page->size );
+    if( !( page->data ) )
+    {
+      fprintf( stderr, "ERROR: Failed to load %s\n", page->path );
+      return 1;
+    }
+    test.pagecount++;
+  }
+  if( !( test.pagecount ) )
+    goto usage;
+
+  mmInit();
+  randSeed( &test.randstate, 1 );
+  for( pageindex = 0 ; pageindex < test.pagecount ; pageindex++ )
+  {
+    page = &test.pagelist[ pageindex ];
+    page->refresult = blHtmlParsePriceGuide( &page->refpg[0], &page->refpg[1], page->data, (int)page->size );
+    bsPgTestCheckExpected( &test, page );
+    bsPgTestSplits( &test, page );
+  }
+  bsPgTestHttp( &test );
+  bsPgTestSumState( &test );
+
+  for( pageindex = 0 ; pageindex < test.pagecount ; pageindex++ )
+    free( test.pagelist[ pageindex ].data );
+  free( test.pagelist );
+  printf( "%s : %d failures\n", ( test.failcount ? "FAILED" : "PASSED" ), test.failcount );
+  return ( test.failcount ? 1 : 0 );
+
+  usage:
+  fprintf( stderr, "Usage: %s [-port N] page.html ...\n", argv[0] );
+  return 1;
+}
@@ -39,6 +39,7 @@
 #include "iolog.h"
 #include "debugtrack.h"
 #include "rand.h"
+#include "mmthread.h"
 
 #if CC_UNIX
  #include <sys/types.h>
@@ -72,46 +73,168 @@
 ////
 
 
+int bsPriceGuideCacheRead( bsContext *context, bsxItem *item, bsxPriceGuide *pg )
+{
+  int retval;
+  char *pgpath;
+
+  if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_DATABASE )
+    return bsxPriceGuideDbRead( &context->priceguidedb, pg, item->typeid, item->id, item->colorid, item->condition );
+  pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags );
+  retval = bsxReadPriceGuide( pg, pgpath, item->condition );
+  free( pgpath );
+  return retval;
+}
+
+
+int bsPriceGuideCacheWrite( bsContext *context, bsxItem *item, bsxPriceGuide *pgnew, bsxPriceGuide *pgused )
+{
+  int retval;
+  char *pgpath;
+
+  if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_DATABASE )
+  {
+    if( bsxPriceGuideDbWrite( &context->priceguidedb, pgnew, pgused, item->typeid, item->id, item->colorid ) )
+      return 1;
+    ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", context->priceguidedbpath );
+    return 0;
+  }
+  pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags | BSX_PRICEGUIDE_FLAGS_MKDIR );
+  retval = bsxWritePriceGuide( pgnew, pgused, pgpath, item->typeid, item->id, item->colorid );
+  if( !( retval ) )
+    ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", pgpath );
+  free( pgpath );
+  return retval;
+}
+
+
+#define BS_PRICEGUIDE_LOOKUP_MISS (0)
+#define BS_PRICEGUIDE_LOOKUP_FOUND (1)
+#define BS_PRICEGUIDE_LOOKUP_SKIP (2)
+
+typedef struct
+{
+  bsContext *context;
+  bsxInventory *inv;
+  int itemstart;
+  int itemend;
+  bsxPriceGuide *pglist;
+  char *statuslist;
+} bsPriceGuideLookupJob;
+
+/* Worker threads only read the cache, all callbacks are run afterwards from the calling thread */
+static void *bsPriceGuideLookupThread( void *value )
+{
+  int itemindex;
+  bsxItem *item;
+  bsPriceGuideLookupJob *job;
+
+  job = value;
+  for( itemindex = job->itemstart ; itemindex < job->itemend ; itemindex++ )
+  {
+    item = &job->inv->itemlist[itemindex];
+    job->statuslist[itemindex] = BS_PRICEGUIDE_LOOKUP_SKIP;
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    job->statuslist[itemindex] = BS_PRICEGUIDE_LOOKUP_MISS;
+    if( bsPriceGuideCacheRead( job->context, item, &job->pglist[itemindex] ) )
+      job->statuslist[itemindex] = BS_PRICEGUIDE_LOOKUP_FOUND;
+  }
+
+  return 0;
+}
+
+
 /* Fetch price guide for all items slightly outdated */
 int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cachetime, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) )
 {
-  int retval, itemindex, fetchcount;
+  int retval, itemindex, fetchcount, stalecount;
+  int threadcount, threadindex;
   int64_t updatetime;
-  char *pgpath;
   bsxItem *item;
-  bsxPriceGuide pg;
+  bsxPriceGuide *pglist;
+  char *statuslist;
+  mtThread threadlist[BS_PRICEGUIDE_LOOKUP_THREAD_MAX];
+  int createdlist[BS_PRICEGUIDE_LOOKUP_THREAD_MAX];
+  bsPriceGuideLookupJob joblist[BS_PRICEGUIDE_LOOKUP_THREAD_MAX];
 
   DEBUG_SET_TRACKER();
 
   updatetime = context->curtime - cachetime;
 
   ioPrintf( &context->output, 0, BSMSG_INFO "Looking up price guide cache for " IO_GREEN "%d" IO_DEFAULT " items.\n", inv->itemcount );
+
+  /* Read the cache for all items, spread over threads for large inventories */
+  pglist = malloc( ( inv->itemcount + 1 ) * sizeof(bsxPriceGuide) );
+  statuslist = malloc( inv->itemcount + 1 );
+  threadcount = inv->itemcount / BS_PRICEGUIDE_LOOKUP_THREAD_ITEMS;
+  if( threadcount > context->cpucorecount )
+    threadcount = context->cpucorecount;
+  if( threadcount > BS_PRICEGUIDE_LOOKUP_THREAD_MAX )
+    threadcount = BS_PRICEGUIDE_LOOKUP_THREAD_MAX;
+  if( threadcount < 1 )
+    threadcount = 1;
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+  {
+    joblist[threadindex].context = context;
+    joblist[threadindex].inv = inv;
+    joblist[threadindex].itemstart = (int)( ( (int64_t)inv->itemcount * threadindex ) / threadcount );
+    joblist[threadindex].itemend = (int)( ( (int64_t)inv->itemcount * ( threadindex + 1 ) ) / threadcount );
+    joblist[threadindex].pglist = pglist;
+    joblist[threadindex].statuslist = statuslist;
+  }
+  if( threadcount > 1 )
+  {
+    /* Jobs of threads that couldn't be created are performed right here */
+    for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+    {
+      createdlist[threadindex] = mtThreadCreate( &threadlist[threadindex], bsPriceGuideLookupThread, &joblist[threadindex], MT_THREAD_FLAGS_JOINABLE, 0, 0 );
+      if( !( createdlist[threadindex] ) )
+        bsPriceGuideLookupThread( &joblist[threadindex] );
+    }
+    for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+    {
+      if( createdlist[threadindex] )
+        mtThreadJoin( &threadlist[threadindex] );
+    }
+  }
+  else
+    bsPriceGuideLookupThread( &joblist[0] );
+
+  /* Replay results in inventory order, callbacks accumulate in the same order as a serial lookup */
   fetchcount = 0;
+  stalecount = 0;
   for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
   {
     item = &inv->itemlist[itemindex];
-    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+    if( statuslist[itemindex] == BS_PRICEGUIDE_LOOKUP_SKIP )
       continue;
-    pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags );
-    if( bsxReadPriceGuide( &pg, pgpath, item->condition ) )
+    if( ( statuslist[itemindex] == BS_PRICEGUIDE_LOOKUP_FOUND ) && ( pglist[itemindex].modtime >= updatetime ) )
     {
-      if( pg.modtime >= updatetime )
-      {
-        if( callback )
-          callback( context, inv, item, &pg, callbackpointer );
-      }
-      else
-        item->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+      if( callback )
+        callback( context, inv, item, &pglist[itemindex], callbackpointer );
+    }
+    else if( ( statuslist[itemindex] == BS_PRICEGUIDE_LOOKUP_FOUND ) && ( context->priceguideservestaleflag ) )
+    {
+      /* Serve the outdated entry now, the main loop refreshes it when idle */
+      if( callback )
+        callback( context, inv, item, &pglist[itemindex], callbackpointer );
+      bsPriceGuideRefreshQueueItem( context, item, cachetime );
+      stalecount++;
     }
     else
       item->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
-    free( pgpath );
     if( item->flags & BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE )
     {
       ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Item flagged for price guide update: \"%s\", color %d, condition %s.\n", ( item->id ? item->id : item->name ), item->colorid, ( item->condition ? "New" : "Used" ) );
       fetchcount++;
     }
   }
+  free( statuslist );
+  free( pglist );
+
+  if( stalecount )
+    ioPrintf( &context->output, 0, BSMSG_INFO "Served " IO_YELLOW "%d" IO_DEFAULT " items from outdated price guide data, a refresh has been queued.\n", stalecount );
 
   retval = 1;
   if( fetchcount )
@@ -127,7 +250,370 @@ int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cac
 ////
 
 
-void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int showaltflag, int removealtflag )
+static void bsPriceGuideRefreshPush( bsPriceGuideRefresh *refresh, bsPriceGuideRefreshEntry *entry )
+{
+  int index, parent;
+
+  if( refresh->entrycount >= refresh->entryalloc )
+  {
+    refresh->entryalloc = ( refresh->entryalloc ? refresh->entryalloc << 1 : 1024 );
+    refresh->entrylist = realloc( refresh->entrylist, refresh->entryalloc * sizeof(bsPriceGuideRefreshEntry) );
+  }
+  for( index = refresh->entrycount++ ; index ; index = parent )
+  {
+    parent = ( index - 1 ) >> 1;
+    if( refresh->entrylist[parent].priority >= entry->priority )
+      break;
+    refresh->entrylist[index] = refresh->entrylist[parent];
+  }
+  refresh->entrylist[index] = *entry;
+  return;
+}
+
+static int bsPriceGuideRefreshPop( bsPriceGuideRefresh *refresh, bsPriceGuideRefreshEntry *entry )
+{
+  int index, child;
+  bsPriceGuideRefreshEntry *last;
+
+  if( !( refresh->entrycount ) )
+    return 0;
+  *entry = refresh->entrylist[0];
+  refresh->entrycount--;
+  last = &refresh->entrylist[ refresh->entrycount ];
+  for( index = 0 ; ; index = child )
+  {
+    child = ( index << 1 ) + 1;
+    if( child >= refresh->entrycount )
+      break;
+    if( ( child + 1 < refresh->entrycount ) && ( refresh->entrylist[child+1].priority > refresh->entrylist[child].priority ) )
+      child++;
+    if( last->priority >= refresh->entrylist[child].priority )
+      break;
+    refresh->entrylist[index] = refresh->entrylist[child];
+  }
+  refresh->entrylist[index] = *last;
+  return 1;
+}
+
+/* Drop all queued entries, except those served stale to a command if keepstaleflag is set */
+static void bsPriceGuideRefreshClear( bsPriceGuideRefresh *refresh, int keepstaleflag )
+{
+  int entryindex, entrycount;
+  bsPriceGuideRefreshEntry *entry;
+
+  entrycount = refresh->entrycount;
+  refresh->entrycount = 0;
+  refresh->stalecount = 0;
+  for( entryindex = 0 ; entryindex < entrycount ; entryindex++ )
+  {
+    entry = &refresh->entrylist[entryindex];
+    if( ( keepstaleflag ) && ( entry->priority >= BS_PRICEGUIDE_REFRESH_PRIORITY_STALE ) )
+    {
+      /* All such entries share the same priority, the compacted list remains a valid heap */
+      refresh->entrylist[ refresh->entrycount++ ] = *entry;
+      refresh->stalecount++;
+    }
+    else
+      free( entry->id );
+  }
+  return;
+}
+
+/* Queue tracked lots with aging price guide data, stalest and most valuable lots first */
+/* Each call scans a chunk of the inventory from the scan cursor, the whole scan is spread over ticks */
+static void bsPriceGuideRefreshScan( bsContext *context )
+{
+  int itemindex, itemend, idlen;
+  int64_t age, agemin;
+  bsxItem *item;
+  bsxInventory *inv;
+  bsxPriceGuide pg;
+  bsPriceGuideRefreshEntry entry;
+  bsPriceGuideRefresh *refresh;
+
+  DEBUG_SET_TRACKER();
+
+  refresh = &context->pgrefresh;
+  agemin = ( (int64_t)context->priceguidecachetime * BS_PRICEGUIDE_REFRESH_AGE_PERCENT ) / 100;
+  inv = context->inventory;
+  itemend = CC_MIN( refresh->scanindex + BS_PRICEGUIDE_REFRESH_SCAN_CHUNK, inv->itemcount );
+  for( itemindex = refresh->scanindex ; itemindex < itemend ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || !( item->id ) )
+      continue;
+    age = context->priceguidecachetime;
+    if( bsPriceGuideCacheRead( context, item, &pg ) )
+      age = context->curtime - pg.modtime;
+    if( age < agemin )
+      continue;
+    entry.priority = ( (double)age / (double)CC_MAX( context->priceguidecachetime, 1 ) ) * ( 1.0 + log1p( (double)item->quantity * (double)item->price ) );
+    entry.updatetime = context->curtime - agemin;
+    entry.colorid = item->colorid;
+    entry.typeid = item->typeid;
+    idlen = strlen( item->id ) + 1;
+    entry.id = malloc( idlen );
+    memcpy( entry.id, item->id, idlen );
+    bsPriceGuideRefreshPush( refresh, &entry );
+  }
+  refresh->scanindex = itemend;
+  if( itemend >= inv->itemcount )
+  {
+    refresh->scanactiveflag = 0;
+    refresh->scantime = context->curtime + BS_PRICEGUIDE_REFRESH_SCAN_INTERVAL;
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Background price guide refresh queued %d items.\n", refresh->entrycount );
+  }
+
+  return;
+}
+
+
+void bsPriceGuideRefreshTick( bsContext *context )
+{
+  int hourlybudget, batchmax, updatedflag;
+  bsxItem item;
+  bsxItem *fetchitem;
+  bsxInventory *inv;
+  bsxPriceGuide pg;
+  bsPriceGuideRefreshEntry entry;
+  bsPriceGuideRefresh *refresh;
+
+  refresh = &context->pgrefresh;
+  /* Entries served stale are refreshed under a default budget when background refresh is disabled */
+  hourlybudget = refresh->hourlybudget;
+  if( !( hourlybudget ) && ( refresh->stalecount ) )
+    hourlybudget = BS_PRICEGUIDE_REFRESH_STALE_BUDGET;
+  if( !( hourlybudget ) || ( context->curtime < refresh->ticktime ) )
+    return;
+
+  DEBUG_SET_TRACKER();
+
+  refresh->ticktime = context->curtime + BS_PRICEGUIDE_REFRESH_TICK_INTERVAL;
+
+  /* Accumulate the request budget, never more than one hour worth */
+  if( refresh->budgettime )
+    refresh->budget += (double)( context->curtime - refresh->budgettime ) * ( (double)hourlybudget / 3600.0 );
+  refresh->budgettime = context->curtime;
+  if( refresh->budget > (double)hourlybudget )
+    refresh->budget = (double)hourlybudget;
+  if( refresh->budget < 1.0 )
+    return;
+
+  /* Rescan the inventory once per scan interval, a chunk per tick */
+  if( refresh->hourlybudget )
+  {
+    if( !( refresh->scanactiveflag ) && ( context->curtime >= refresh->scantime ) )
+    {
+      bsPriceGuideRefreshClear( refresh, 1 );
+      refresh->scanindex = 0;
+      refresh->scanactiveflag = 1;
+    }
+    if( refresh->scanactiveflag )
+      bsPriceGuideRefreshScan( context );
+  }
+  batchmax = CC_MIN( (int)refresh->budget, BS_PRICEGUIDE_REFRESH_BATCH_MAX );
+
+  /* Build a batch of outdated entries, stale ones first, skipping any refreshed since queued */
+  inv = bsxNewInventory();
+  while( ( inv->itemcount < batchmax ) && ( bsPriceGuideRefreshPop( refresh, &entry ) ) )
+  {
+    if( entry.priority >= BS_PRICEGUIDE_REFRESH_PRIORITY_STALE )
+      refresh->stalecount--;
+    memset( &item, 0, sizeof(bsxItem) );
+    item.typeid = entry.typeid;
+    item.id = entry.id;
+    item.colorid = entry.colorid;
+    item.condition = 'N';
+    if( !( bsxFindItem( inv, item.typeid, item.id, item.colorid, item.condition ) ) && ( !( bsPriceGuideCacheRead( context, &item, &pg ) ) || ( pg.modtime < entry.updatetime ) ) )
+    {
+      fetchitem = bsxAddCopyItem( inv, &item );
+      fetchitem->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+    }
+    free( entry.id );
+  }
+
+  if( inv->itemcount )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Background refresh of price guide for %d items, %d queued.\n", inv->itemcount, refresh->entrycount );
+    /* The temporary inventory is not worth saving, preserve the flag of the tracked inventory */
+    updatedflag = context->contextflags & BS_CONTEXT_FLAGS_UPDATED_INVENTORY;
+    bsBrickLinkFetchPriceGuide( context, inv, 0, 0 );
+    context->contextflags = ( context->contextflags & ~BS_CONTEXT_FLAGS_UPDATED_INVENTORY ) | updatedflag;
+    refresh->budget -= (double)inv->itemcount;
+    refresh->refreshcount += inv->itemcount;
+  }
+  bsxFreeInventory( inv );
+
+  return;
+}
+
+
+/* Queue the price guide of item for refresh ahead of any other entry, until it is more recent than cachetime */
+void bsPriceGuideRefreshQueueItem( bsContext *context, bsxItem *item, int cachetime )
+{
+  int idlen;
+  bsPriceGuideRefreshEntry entry;
+
+  if( !( item->id ) )
+    return;
+  entry.priority = BS_PRICEGUIDE_REFRESH_PRIORITY_STALE;
+  entry.updatetime = context->curtime - cachetime;
+  entry.colorid = item->colorid;
+  entry.typeid = item->typeid;
+  idlen = strlen( item->id ) + 1;
+  entry.id = malloc( idlen );
+  memcpy( entry.id, item->id, idlen );
+  bsPriceGuideRefreshPush( &context->pgrefresh, &entry );
+  context->pgrefresh.stalecount++;
+  return;
+}
+
+
+void bsPriceGuideRefreshFree( bsContext *context )
+{
+  bsPriceGuideRefreshClear( &context->pgrefresh, 0 );
+  free( context->pgrefresh.entrylist );
+  context->pgrefresh.entrylist = 0;
+  context->pgrefresh.entryalloc = 0;
+  return;
+}
+
+
+////
+
+
+enum
+{
+  BS_PRICEGUIDE_ROW_NEW,
+  BS_PRICEGUIDE_ROW_STOCK,
+  /* Alternate replaced by a cheaper one */
+  BS_PRICEGUIDE_ROW_DROPPED
+};
+
+static void bsPriceGuideAllocRows( bsPriceGuideState *pgstate, int rowalloc )
+{
+  pgstate->rowalloc = rowalloc;
+  pgstate->rowquantity = realloc( pgstate->rowquantity, rowalloc * sizeof(int) );
+  pgstate->rowcategory = realloc( pgstate->rowcategory, rowalloc * sizeof(char) );
+  pgstate->rowvalue = realloc( pgstate->rowvalue, rowalloc * sizeof(double) );
+  pgstate->rowsale = realloc( pgstate->rowsale, rowalloc * sizeof(double) );
+  pgstate->rowprice = realloc( pgstate->rowprice, rowalloc * sizeof(double) );
+  pgstate->rowpgq = realloc( pgstate->rowpgq, rowalloc * sizeof(double) );
+  pgstate->rowpgp = realloc( pgstate->rowpgp, rowalloc * sizeof(double) );
+  return;
+}
+
+static void bsPriceGuideFreeRows( bsPriceGuideState *pgstate )
+{
+  free( pgstate->rowquantity );
+  free( pgstate->rowcategory );
+  free( pgstate->rowvalue );
+  free( pgstate->rowsale );
+  free( pgstate->rowprice );
+  free( pgstate->rowpgq );
+  free( pgstate->rowpgp );
+  pgstate->rowquantity = 0;
+  pgstate->rowcategory = 0;
+  pgstate->rowvalue = 0;
+  pgstate->rowsale = 0;
+  pgstate->rowprice = 0;
+  pgstate->rowpgq = 0;
+  pgstate->rowpgp = 0;
+  pgstate->rowcount = 0;
+  pgstate->rowalloc = 0;
+  return;
+}
+
+static int bsPriceGuideAddRow( bsPriceGuideState *pgstate, int quantity, double value, double sale, double price, double pgq, double pgp, int category )
+{
+  int rowindex;
+
+  if( pgstate->rowcount >= pgstate->rowalloc )
+    bsPriceGuideAllocRows( pgstate, ( pgstate->rowalloc << 1 ) + 16 );
+  rowindex = pgstate->rowcount++;
+  pgstate->rowquantity[rowindex] = quantity;
+  pgstate->rowcategory[rowindex] = (char)category;
+  pgstate->rowvalue[rowindex] = value;
+  pgstate->rowsale[rowindex] = sale;
+  pgstate->rowprice[rowindex] = price;
+  pgstate->rowpgq[rowindex] = value * pgq;
+  pgstate->rowpgp[rowindex] = value * pgp;
+  return rowindex;
+}
+
+/* Sum of column[] weighted by mask[], over four independent accumulators so that the loop is pipelined and vectorized */
+static double bsPriceGuideMaskedSum( const double *column, const double *mask, int rowcount )
+{
+  int rowindex;
+  double sum0, sum1, sum2, sum3;
+
+  sum0 = 0.0;
+  sum1 = 0.0;
+  sum2 = 0.0;
+  sum3 = 0.0;
+  for( rowindex = 0 ; rowindex + 4 <= rowcount ; rowindex += 4 )
+  {
+    sum0 += column[rowindex+0] * mask[rowindex+0];
+    sum1 += column[rowindex+1] * mask[rowindex+1];
+    sum2 += column[rowindex+2] * mask[rowindex+2];
+    sum3 += column[rowindex+3] * mask[rowindex+3];
+  }
+  for( ; rowindex < rowcount ; rowindex++ )
+    sum0 += column[rowindex] * mask[rowindex];
+  return ( sum0 + sum1 ) + ( sum2 + sum3 );
+}
+
+/* Reduce the rows to the stock, new and total sums ; floating point sums are reassociated, they may differ from a running sum in the last bits */
+static void bsPriceGuideReduceRows( bsPriceGuideState *pgstate )
+{
+  int rowindex, rowcount, category;
+  double *stockmask, *newmask;
+
+  rowcount = pgstate->rowcount;
+  stockmask = malloc( ( rowcount + 1 ) * sizeof(double) );
+  newmask = malloc( ( rowcount + 1 ) * sizeof(double) );
+  for( rowindex = 0 ; rowindex < rowcount ; rowindex++ )
+  {
+    category = pgstate->rowcategory[rowindex];
+    stockmask[rowindex] = ( category == BS_PRICEGUIDE_ROW_STOCK ? 1.0 : 0.0 );
+    newmask[rowindex] = ( category == BS_PRICEGUIDE_ROW_NEW ? 1.0 : 0.0 );
+    if( category == BS_PRICEGUIDE_ROW_STOCK )
+    {
+      pgstate->stocklots++;
+      pgstate->stockcount += pgstate->rowquantity[rowindex];
+    }
+    else if( category == BS_PRICEGUIDE_ROW_NEW )
+    {
+      pgstate->newlots++;
+      pgstate->newcount += pgstate->rowquantity[rowindex];
+    }
+  }
+
+  pgstate->stockvalue = bsPriceGuideMaskedSum( pgstate->rowvalue, stockmask, rowcount );
+  pgstate->stocksale = bsPriceGuideMaskedSum( pgstate->rowsale, stockmask, rowcount );
+  pgstate->stockprice = bsPriceGuideMaskedSum( pgstate->rowprice, stockmask, rowcount );
+  pgstate->stockpgq = bsPriceGuideMaskedSum( pgstate->rowpgq, stockmask, rowcount );
+  pgstate->stockpgp = bsPriceGuideMaskedSum( pgstate->rowpgp, stockmask, rowcount );
+  pgstate->newvalue = bsPriceGuideMaskedSum( pgstate->rowvalue, newmask, rowcount );
+  pgstate->newsale = bsPriceGuideMaskedSum( pgstate->rowsale, newmask, rowcount );
+  pgstate->newprice = bsPriceGuideMaskedSum( pgstate->rowprice, newmask, rowcount );
+  pgstate->newpgq = bsPriceGuideMaskedSum( pgstate->rowpgq, newmask, rowcount );
+  pgstate->newpgp = bsPriceGuideMaskedSum( pgstate->rowpgp, newmask, rowcount );
+  free( stockmask );
+  free( newmask );
+
+  pgstate->totallots = pgstate->stocklots + pgstate->newlots;
+  pgstate->totalcount = pgstate->stockcount + pgstate->newcount;
+  pgstate->totalvalue = pgstate->stockvalue + pgstate->newvalue;
+  pgstate->totalsale = pgstate->stocksale + pgstate->newsale;
+  pgstate->totalprice = pgstate->stockprice + pgstate->newprice;
+  pgstate->totalpgq = pgstate->stockpgq + pgstate->newpgq;
+  pgstate->totalpgp = pgstate->stockpgp + pgstate->newpgp;
+  return;
+}
+
+
+void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int cachetime, int showaltflag, int removealtflag )
 {
   int altindex;
   bsPriceGuideAlt *alt;
@@ -136,6 +622,7 @@ void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int s
 
   memset( pgstate, 0, sizeof(bsPriceGuideState) );
   pgstate->inv = inv;
+  pgstate->cachetime = cachetime;
   pgstate->showaltflag = showaltflag;
   pgstate->removealtflag = removealtflag;
   pgstate->altcount = 256;
@@ -145,6 +632,8 @@ void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int s
     alt = &pgstate->altlist[ altindex ];
     alt->itemindex = -1;
   }
+  /* Each lot adds at most one row */
+  bsPriceGuideAllocRows( pgstate, inv->itemcount + 16 );
   return;
 }
 
@@ -157,6 +646,8 @@ void bsPriceGuideFinishState( bsPriceGuideState *pgstate )
     free( pgstate->altlist );
     pgstate->altlist = 0;
   }
+  bsPriceGuideReduceRows( pgstate );
+  bsPriceGuideFreeRows( pgstate );
   if( pgstate->stockvalue > 0.001 )
   {
     pgstate->stockpgq /= pgstate->stockvalue;
@@ -177,9 +668,9 @@ void bsPriceGuideFinishState( bsPriceGuideState *pgstate )
 
 
 
-static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, int quantity, double value, double sale, double price, double pgq, double pgp, int stockflag, int itemindex )
+/* Return 0 if the item is rejected as an alternate, otherwise drop the row of the alternate it replaces */
+static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, double value, int itemindex )
 {
-  double itemvalue, itemsale, itemprice;
   bsxInventory *inv;
   bsxItem *remitem;
   bsPriceGuideAlt *alt;
@@ -209,47 +700,13 @@ static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, int
       bsxRemoveItem( inv, remitem );
     else
       remitem->status = 'E';
-    itemvalue = (double)alt->quantity * (double)alt->value;
-    itemsale = (double)alt->quantity * (double)alt->sale;
-    itemprice = (double)alt->quantity * (double)alt->price;
-    if( alt->stockflag )
-    {
-      pgstate->stocklots--;
-      pgstate->stockcount -= alt->quantity;
-      pgstate->stockvalue -= itemvalue;
-      pgstate->stocksale -= itemsale;
-      pgstate->stockprice -= itemprice;
-      pgstate->stockpgq -= itemvalue * alt->pgq;
-      pgstate->stockpgp -= itemvalue * alt->pgp;
-    }
-    else
-    {
-      pgstate->newlots--;
-      pgstate->newcount -= alt->quantity;
-      pgstate->newvalue -= itemvalue;
-      pgstate->newsale -= itemsale;
-      pgstate->newprice -= itemprice;
-      pgstate->newpgq -= itemvalue * alt->pgq;
-      pgstate->newpgp -= itemvalue * alt->pgp;
-    }
-    pgstate->totallots--;
-    pgstate->totalcount -= alt->quantity;
-    pgstate->totalvalue -= itemvalue;
-    pgstate->totalsale -= itemsale;
-    pgstate->totalprice -= itemprice;
-    pgstate->totalpgq -= itemvalue * alt->pgq;
-    pgstate->totalpgp -= itemvalue * alt->pgp;
+    pgstate->rowcategory[ alt->rowindex ] = BS_PRICEGUIDE_ROW_DROPPED;
   }
 
-  /* Accept new alt */
-  alt->quantity = quantity;
+  /* Accept new alt, its row is added by the caller */
   alt->value = value;
-  alt->sale = sale;
-  alt->price = price;
-  alt->pgq = pgq;
-  alt->pgp = pgp;
-  alt->stockflag = stockflag;
   alt->itemindex = itemindex;
+  alt->rowindex = pgstate->rowcount;
 
   return 1;
 }
@@ -295,6 +752,11 @@ void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *it
   }
   if( !( stockitem ) )
     ccGrowthPrintf( &growth, " New" );
+  if( pg->modtime < ( context->curtime - pgstate->cachetime ) )
+  {
+    ccGrowthPrintf( &growth, " Stale" );
+    pgstate->stalelots++;
+  }
   bsxSetItemComments( item, growth.data, growth.offset );
   ccGrowthFree( &growth );
 
@@ -320,38 +782,12 @@ void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *it
   /* Validate item if alternate */
   if( item->alternateid )
   {
-    if( !( bsPriceGuideHandleAlt( pgstate, item->alternateid, item->quantity, item->price, pg->stockqtyaverage, ( stockflag ? stockitem->price : 0.0 ), pgq, pgp, stockflag, bsxGetItemListIndex( inv, item ) ) ) )
+    if( !( bsPriceGuideHandleAlt( pgstate, item->alternateid, item->price, bsxGetItemListIndex( inv, item ) ) ) )
       return;
   }
 
   /* Add to total */
-  if( stockflag )
-  {
-    pgstate->stocklots++;
-    pgstate->stockcount += item->quantity;
-    pgstate->stockvalue += itemvalue;
-    pgstate->stocksale += itemsale;
-    pgstate->stockprice += itemprice;
-    pgstate->stockpgq += itemvalue * pgq;
-    pgstate->stockpgp += itemvalue * pgp;
-  }
-  else
-  {
-    pgstate->newlots++;
-    pgstate->newcount += item->quantity;
-    pgstate->newvalue += itemvalue;
-    pgstate->newsale += itemsale;
-    pgstate->newprice += itemprice;
-    pgstate->newpgq += itemvalue * pgq;
-    pgstate->newpgp += itemvalue * pgp;
-  }
-  pgstate->totallots++;
-  pgstate->totalcount += item->quantity;
-  pgstate->totalvalue += itemvalue;
-  pgstate->totalsale += itemsale;
-  pgstate->totalprice += itemprice;
-  pgstate->totalpgq += itemvalue * pgq;
-  pgstate->totalpgp += itemvalue * pgp;
+  bsPriceGuideAddRow( pgstate, item->quantity, itemvalue, itemsale, itemprice, pgq, pgp, ( stockflag ? BS_PRICEGUIDE_ROW_STOCK : BS_PRICEGUIDE_ROW_NEW ) );
 
   return;
 }
@@ -361,8 +797,10 @@ void bsPriceGuideListRangeCallback( bsContext *context, bsxInventory *inv, bsxIt
 {
   float *listrange;
   float itemratio;
+  bsPriceGuideListRange *range;
 
-  listrange = callbackpointer;
+  range = callbackpointer;
+  listrange = range->listrange;
 
   if( !( pg->saleqty ) || ( pg->saleqtyaverage < 0.001 ) )
     return;
@@ -370,7 +808,7 @@ void bsPriceGuideListRangeCallback( bsContext *context, bsxInventory *inv, bsxIt
   if( ( itemratio >= listrange[0] ) && ( itemratio <= listrange[1] ) )
     return;
 
-  ioPrintf( &context->output, 0, BSMSG_INFO "Item \"" IO_CYAN "%s" IO_DEFAULT "\" (" IO_GREEN "%s" IO_DEFAULT "), color \"" IO_CYAN "%s" IO_DEFAULT "\", quantity " IO_CYAN "%d" IO_DEFAULT "; item price " IO_YELLOW "%.3f" IO_DEFAULT ", price guide " IO_CYAN "%.3f" IO_DEFAULT ", price ratio of %s%.3f" IO_DEFAULT ".\n", ( item->name ? item->name : "???" ), ( item->id ? item->id : "???" ), item->colorname, item->quantity, item->price, pg->saleqtyaverage, ( itemratio < listrange[0] ? IO_MAGENTA : IO_RED ), itemratio );
+  ioPrintf( &context->output, 0, BSMSG_INFO "Item \"" IO_CYAN "%s" IO_DEFAULT "\" (" IO_GREEN "%s" IO_DEFAULT "), color \"" IO_CYAN "%s" IO_DEFAULT "\", quantity " IO_CYAN "%d" IO_DEFAULT "; item price " IO_YELLOW "%.3f" IO_DEFAULT ", price guide " IO_CYAN "%.3f" IO_DEFAULT ", price ratio of %s%.3f" IO_DEFAULT "%s.\n", ( item->name ? item->name : "???" ), ( item->id ? item->id : "???" ), item->colorname, item->quantity, item->price, pg->saleqtyaverage, ( itemratio < listrange[0] ? IO_MAGENTA : IO_RED ), itemratio, ( pg->modtime < ( context->curtime - range->cachetime ) ? " (" IO_YELLOW "stale" IO_DEFAULT ")" : "" ) );
 
   return;
 }
@@ -137,7 +137,7 @@ static inline char bsResolveDecideItemType( bsxItem *item, char forceitemtype, i
 
 
 /* Queue a batch of queries to lookup BOID for lots of inventory, flag to skip items with known bolotid */
-static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist, bsxInventory *inv, int resolveflags, char forceitemtype, int fallbacktypeflag )
+static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist, bsxInventory *inv, int resolveflags, int *lookupcounts, char forceitemtype, int fallbacktypeflag )
 {
   int itemindex;
   char itemtypeid;
@@ -175,6 +175,14 @@ static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist,
     itemtypeid = bsResolveDecideItemType( item, forceitemtype, fallbacktypeflag );
     if( !( itemtypeid ) )
       continue;
+    /* Don't ask again for BLIDs that BrickOwl recently didn't know about, count them as failed lookups */
+    if( !( resolveflags & BS_RESOLVE_FLAGS_FORCEQUERY ) && ( translationNegativeCheck( &context->translationnegative, itemtypeid, item->id, context->curtime ) ) )
+    {
+      lookupcounts[2] += item->quantity;
+      lookupcounts[3]++;
+      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skipped BOID lookup for \"%s\", item type '%c', lookup failed recently.\n", item->id, itemtypeid );
+      continue;
+    }
     switch( itemtypeid )
     {
       case 'P':
@@ -256,7 +264,7 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
   {
     /* Queue BOID resolutions for the inventory */
     if( !( tracker.failureflag ) )
-      bsQueueBrickOwlLookupBoid( context, &worklist, inv, resolveflags, forceitemtype, fallbacktypeflag );
+      bsQueueBrickOwlLookupBoid( context, &worklist, inv, resolveflags, lookupcounts, forceitemtype, fallbacktypeflag );
     if( !( context->brickowl.querycount ) )
       break;
     if( context->brickowl.querycount <= waitcount )
@@ -289,6 +297,7 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
         {
           /* Add the BLID<->BOID in the translation database */
           translationTableRegisterEntry( &context->translationtable, item->typeid, item->id, item->boid );
+          translationNegativeClear( &context->translationnegative, itemtypeid, item->id );
           lookupcounts[0] += item->quantity;
           lookupcounts[1]++;
           if( ( resolveflags & ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTSUCCESS ) ) == ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTSUCCESS ) )
@@ -298,6 +307,7 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
         }
         else
         {
+          translationNegativeRegister( &context->translationnegative, itemtypeid, item->id, context->curtime, context->brickowl.lookupretry, BS_BRICKOWL_LOOKUP_RETRY_MAX );
           lookupcounts[2] += item->quantity;
           lookupcounts[3]++;
           if( ( resolveflags & ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) ) == ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) )
@@ -311,6 +321,7 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
   }
   bsxSortInventory( inv, BSX_SORT_ID, 0 );
   mmBitMapFree( &worklist.bitmap );
+  translationNegativeSave( &context->translationnegative );
 
   return ( tracker.failureflag ? 0 : 1 );
 }
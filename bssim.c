@@ -0,0 +1,2211 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <signal.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "mmatomic.h"
+#include "mmbitmap.h"
+#include "mmhash.h"
+#include "iolog.h"
+#include "debugtrack.h"
+#include "rand.h"
+
+#if CC_UNIX
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#elif CC_WINDOWS
+ #include <windows.h>
+ #include <direct.h>
+#else
+ #error Unknown/Unsupported platform!
+#endif
+
+#include "tcp.h"
+#include "tcphttp.h"
+#include "oauth.h"
+#include "exclperm.h"
+#include "journal.h"
+
+#include "bsx.h"
+#include "bsxpg.h"
+#include "json.h"
+#include "bsorder.h"
+#include "bricklink.h"
+#include "brickowl.h"
+#include "colortable.h"
+#include "bstranslation.h"
+
+#include "bricksync.h"
+
+
+////
+
+
+/*
+Local simulator of the BrickLink and BrickOwl store APIs, for end-to-end benchmarks of check and sync cycles.
+Built by ./compile-sim, which links every BrickSync module with BS_BENCH_BUILD defined to drop BrickSync's main().
+
+One plain HTTP port serves both APIs, /api/store/v1/... is BrickLink and /v1/... is BrickOwl.
+Point bricklink.apiserver/apiport and brickowl.apiserver/apiport of bricksync.conf.txt at it.
+Loopback servers are spoken to over plain HTTP, a simulator on another host also needs apissl = 0.
+OAuth headers and BrickOwl keys must be present but are never verified.
+
+Both stores start from the same .bsx inventory, such as one written by bsbench -g, unless -boempty is given.
+BrickOwl IDs come from a synthetic catalog built from the BrickLink IDs seen, id_lookup always succeeds.
+Orders can be generated at regular intervals, alternating between both stores, the stock is decremented accordingly.
+
+Request parsing is done here, tcphttp.c only implements the client side of HTTP.
+All callbacks run from tcpWait() on the main thread, replies are held back until their simulated latency expires.
+*/
+
+
+#define BS_SIM_DEFAULT_PORT (8042)
+#define BS_SIM_LINK_TIMEOUT (120000)
+#define BS_SIM_HEADER_MAX (65536)
+#define BS_SIM_PARAM_MAX (2048)
+#define BS_SIM_HASH_BITS (12)
+#define BS_SIM_HASH_PAGE_BITS (4)
+#define BS_SIM_BRICKLINK_LOTID_BASE (100000000)
+#define BS_SIM_BRICKOWL_LOTID_BASE (200000000)
+#define BS_SIM_BRICKLINK_ORDERID_BASE (9000000)
+#define BS_SIM_BRICKOWL_ORDERID_BASE (4000000)
+#define BS_SIM_BOID_BASE (100000)
+#define BS_SIM_ORDER_QUANTITY_MAX (3)
+#define BS_SIM_CURRENCY "USD"
+
+enum
+{
+  BS_SIM_SERVICE_BRICKLINK,
+  BS_SIM_SERVICE_BRICKOWL,
+
+  BS_SIM_SERVICE_COUNT
+};
+
+static const char *bsSimServiceName[BS_SIM_SERVICE_COUNT] = { "BrickLink", "BrickOwl" };
+
+enum
+{
+  BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_LIST,
+  BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_CREATE,
+  BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_UPDATE,
+  BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_DELETE,
+  BS_SIM_ENDPOINT_BRICKLINK_ORDER_LIST,
+  BS_SIM_ENDPOINT_BRICKLINK_ORDER_ITEMS,
+  BS_SIM_ENDPOINT_BRICKOWL_TOKEN_DETAILS,
+  BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_LIST,
+  BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_CREATE,
+  BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_UPDATE,
+  BS_SIM_ENDPOINT_BRICKOWL_ORDER_LIST,
+  BS_SIM_ENDPOINT_BRICKOWL_ORDER_VIEW,
+  BS_SIM_ENDPOINT_BRICKOWL_ORDER_ITEMS,
+  BS_SIM_ENDPOINT_BRICKOWL_ID_LOOKUP,
+  BS_SIM_ENDPOINT_BRICKOWL_CATALOG_EDIT,
+  BS_SIM_ENDPOINT_UNKNOWN,
+
+  BS_SIM_ENDPOINT_COUNT
+};
+
+static const char *bsSimEndpointName[BS_SIM_ENDPOINT_COUNT] =
+{
+  [BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_LIST] = "bl_inventory_list",
+  [BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_CREATE] = "bl_inventory_create",
+  [BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_UPDATE] = "bl_inventory_update",
+  [BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_DELETE] = "bl_inventory_delete",
+  [BS_SIM_ENDPOINT_BRICKLINK_ORDER_LIST] = "bl_order_list",
+  [BS_SIM_ENDPOINT_BRICKLINK_ORDER_ITEMS] = "bl_order_items",
+  [BS_SIM_ENDPOINT_BRICKOWL_TOKEN_DETAILS] = "bo_token_details",
+  [BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_LIST] = "bo_inventory_list",
+  [BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_CREATE] = "bo_inventory_create",
+  [BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_UPDATE] = "bo_inventory_update",
+  [BS_SIM_ENDPOINT_BRICKOWL_ORDER_LIST] = "bo_order_list",
+  [BS_SIM_ENDPOINT_BRICKOWL_ORDER_VIEW] = "bo_order_view",
+  [BS_SIM_ENDPOINT_BRICKOWL_ORDER_ITEMS] = "bo_order_items",
+  [BS_SIM_ENDPOINT_BRICKOWL_ID_LOOKUP] = "bo_id_lookup",
+  [BS_SIM_ENDPOINT_BRICKOWL_CATALOG_EDIT] = "bo_catalog_edit",
+  [BS_SIM_ENDPOINT_UNKNOWN] = "unknown"
+};
+
+typedef struct
+{
+  int port;
+  char *invpath;
+  /* Save both stores as PREFIX-bricklink.bsx and PREFIX-brickowl.bsx on exit */
+  char *saveprefix;
+  /* Base latency of every reply plus a random jitter, in milliseconds */
+  int latency;
+  int jitter;
+  /* Extra latency per lot listed by inventory replies, in microseconds */
+  int lotlatency;
+  /* Requests of a connection processed concurrently, replies always leave in order */
+  int pipeline;
+  /* Close connections after that many requests, announced through Keep-Alive: max=N */
+  int keepalive;
+  /* Percentages of requests answered by a 500 error or by closing the connection */
+  double errorrate;
+  double droprate;
+  /* Requests per second accepted by each service, zero for no limit */
+  int ratelimit;
+  int orderinterval;
+  int orderlots;
+  int duration;
+  int boemptyflag;
+  int verboseflag;
+  uint64_t seed;
+} bsSimConfig;
+
+typedef struct
+{
+  int64_t count;
+  int64_t errorcount;
+  int64_t limitcount;
+  int64_t dropcount;
+  int64_t failcount;
+  int64_t bytes;
+} bsSimStats;
+
+typedef struct
+{
+  char typeid;
+  char *id;
+  char *name;
+} bsSimCatalogItem;
+
+typedef struct
+{
+  int service;
+  int64_t id;
+  int64_t date;
+  bsxInventory *inv;
+} bsSimOrder;
+
+typedef struct
+{
+  double tokens;
+  int64_t lasttime;
+} bsSimBucket;
+
+typedef struct
+{
+  bsSimConfig config;
+  tcpContext tcp;
+  tcpLink *listenlink;
+  void *linklist;
+  int linkcount;
+  int64_t linktotal;
+  randState randstate;
+  /* Zeroed, only passed to the parsers which report their errors there */
+  ioLog output;
+
+  bsxInventory *blinv;
+  bsxInventory *boinv;
+  /* LotID to item index, for BrickLink lots, BrickOwl lots and BrickOwl external IDs */
+  void *bllottable;
+  void *bolottable;
+  void *boexttable;
+  int64_t bllotnext;
+  int64_t bolotnext;
+
+  /* Synthetic catalog, BOID is BS_SIM_BOID_BASE plus the index */
+  bsSimCatalogItem *cataloglist;
+  int catalogcount;
+  int catalogalloc;
+  void *catalogtable;
+
+  bsSimOrder *orderlist;
+  int ordercount;
+  int orderalloc;
+  int64_t ordernext[BS_SIM_SERVICE_COUNT];
+  int64_t ordertime;
+  int orderservice;
+
+  bsSimBucket bucket[BS_SIM_SERVICE_COUNT];
+  bsSimStats stats[BS_SIM_ENDPOINT_COUNT];
+  int64_t starttime;
+} bsSim;
+
+typedef struct _bsSimReply bsSimReply;
+
+struct _bsSimReply
+{
+  bsSimReply *next;
+  int64_t readytime;
+  int closeflag;
+  size_t size;
+  char *data;
+};
+
+typedef struct
+{
+  bsSim *sim;
+  tcpLink *link;
+  mmListNode list;
+  char *recvdata;
+  size_t recvsize;
+  size_t recvalloc;
+  int requestcount;
+  int pendingcount;
+  /* No more requests are processed, the link is closed once all replies are sent */
+  int closeflag;
+  /* Set from the tcp callbacks, acted upon by the main loop */
+  int finishedflag;
+  int deadflag;
+  int64_t lastreadytime;
+  bsSimReply *replyfirst;
+  bsSimReply *replylast;
+} bsSimLink;
+
+typedef struct
+{
+  char *method;
+  char *path;
+  int pathlength;
+  char *params;
+  int paramslength;
+  char *body;
+  int bodylength;
+  int authflag;
+  int closeflag;
+} bsSimRequest;
+
+typedef struct
+{
+  int code;
+  char *status;
+  ccGrowth body;
+  /* Lots listed in the reply, for the per-lot latency */
+  int lotcount;
+} bsSimResponse;
+
+static volatile int bsSimQuitFlag = 0;
+
+
+////
+
+
+typedef struct
+{
+  int64_t lotid;
+  int itemindex;
+} bsSimLotEntry;
+
+static void bsSimLotHashClearEntry( void *entry )
+{
+  bsSimLotEntry *lotentry;
+  lotentry = entry;
+  lotentry->lotid = -1;
+  return;
+}
+
+static int bsSimLotHashEntryValid( void *entry )
+{
+  bsSimLotEntry *lotentry;
+  lotentry = entry;
+  return ( lotentry->lotid != -1 ? 1 : 0 );
+}
+
+static uint32_t bsSimLotHashEntryKey( void *entry )
+{
+  bsSimLotEntry *lotentry;
+  lotentry = entry;
+  return ccHash32Int64Inline( (uint64_t)lotentry->lotid );
+}
+
+static int bsSimLotHashEntryCmp( void *entry, void *entryref )
+{
+  bsSimLotEntry *lotentry, *lotentryref;
+  lotentry = entry;
+  if( lotentry->lotid == -1 )
+    return MM_HASH_ENTRYCMP_INVALID;
+  lotentryref = entryref;
+  if( lotentry->lotid == lotentryref->lotid )
+    return MM_HASH_ENTRYCMP_FOUND;
+  return MM_HASH_ENTRYCMP_SKIP;
+}
+
+static mmHashAccess bsSimLotHashAccess =
+{
+  .clearentry = bsSimLotHashClearEntry,
+  .entryvalid = bsSimLotHashEntryValid,
+  .entrykey = bsSimLotHashEntryKey,
+  .entrycmp = bsSimLotHashEntryCmp,
+  .entrylist = 0
+};
+
+
+typedef struct
+{
+  char typeid;
+  char *id;
+  int catalogindex;
+} bsSimCatalogEntry;
+
+static void bsSimCatalogHashClearEntry( void *entry )
+{
+  bsSimCatalogEntry *catentry;
+  catentry = entry;
+  catentry->id = 0;
+  return;
+}
+
+static int bsSimCatalogHashEntryValid( void *entry )
+{
+  bsSimCatalogEntry *catentry;
+  catentry = entry;
+  return ( catentry->id ? 1 : 0 );
+}
+
+static uint32_t bsSimCatalogHashEntryKey( void *entry )
+{
+  bsSimCatalogEntry *catentry;
+  catentry = entry;
+  return ccHash32Data( catentry->id, strlen( catentry->id ) ) ^ (uint32_t)catentry->typeid;
+}
+
+static int bsSimCatalogHashEntryCmp( void *entry, void *entryref )
+{
+  bsSimCatalogEntry *catentry, *catentryref;
+  catentry = entry;
+  if( !( catentry->id ) )
+    return MM_HASH_ENTRYCMP_INVALID;
+  catentryref = entryref;
+  if( ( catentry->typeid == catentryref->typeid ) && !( strcmp( catentry->id, catentryref->id ) ) )
+    return MM_HASH_ENTRYCMP_FOUND;
+  return MM_HASH_ENTRYCMP_SKIP;
+}
+
+static mmHashAccess bsSimCatalogHashAccess =
+{
+  .clearentry = bsSimCatalogHashClearEntry,
+  .entryvalid = bsSimCatalogHashEntryValid,
+  .entrykey = bsSimCatalogHashEntryKey,
+  .entrycmp = bsSimCatalogHashEntryCmp,
+  .entrylist = 0
+};
+
+
+static void *bsSimHashCreate( const mmHashAccess *access, size_t entrysize )
+{
+  void *hashtable;
+  hashtable = malloc( mmHashRequiredSize( entrysize, BS_SIM_HASH_BITS, BS_SIM_HASH_PAGE_BITS ) );
+  mmHashInit( hashtable, access, entrysize, BS_SIM_HASH_BITS, BS_SIM_HASH_PAGE_BITS, 0x0 );
+  return hashtable;
+}
+
+static void *bsSimHashGrow( void *hashtable, const mmHashAccess *access, size_t entrysize )
+{
+  int hashbits;
+  void *newtable;
+  if( mmHashGetStatus( hashtable, &hashbits ) == MM_HASH_STATUS_MUSTGROW )
+  {
+    hashbits++;
+    newtable = malloc( mmHashRequiredSize( entrysize, hashbits, BS_SIM_HASH_PAGE_BITS ) );
+    mmHashResize( newtable, hashtable, access, hashbits, BS_SIM_HASH_PAGE_BITS );
+    free( hashtable );
+    hashtable = newtable;
+  }
+  return hashtable;
+}
+
+static void bsSimLotAdd( void **hashtable, int64_t lotid, int itemindex )
+{
+  bsSimLotEntry entry;
+  if( lotid == -1 )
+    return;
+  entry.lotid = lotid;
+  entry.itemindex = itemindex;
+  mmHashDirectReplaceEntry( *hashtable, &bsSimLotHashAccess, &entry, 1 );
+  *hashtable = bsSimHashGrow( *hashtable, &bsSimLotHashAccess, sizeof(bsSimLotEntry) );
+  return;
+}
+
+static void bsSimLotRemove( void *hashtable, int64_t lotid )
+{
+  bsSimLotEntry entry;
+  if( lotid == -1 )
+    return;
+  entry.lotid = lotid;
+  mmHashDirectDeleteEntry( hashtable, &bsSimLotHashAccess, &entry, 0 );
+  return;
+}
+
+static bsxItem *bsSimLotFind( void *hashtable, bsxInventory *inv, int64_t lotid )
+{
+  bsSimLotEntry entry;
+  bsxItem *item;
+  if( lotid == -1 )
+    return 0;
+  entry.lotid = lotid;
+  if( !( mmHashDirectReadEntry( hashtable, &bsSimLotHashAccess, &entry ) ) )
+    return 0;
+  item = &inv->itemlist[ entry.itemindex ];
+  if( item->flags & BSX_ITEM_FLAGS_DELETED )
+    return 0;
+  return item;
+}
+
+/* Return the BOID of the item, adding it to the catalog when not known yet */
+static int64_t bsSimCatalogLookup( bsSim *sim, char typeid, char *id, char *name )
+{
+  bsSimCatalogEntry entry;
+  bsSimCatalogItem *catitem;
+  entry.typeid = typeid;
+  entry.id = id;
+  if( mmHashDirectReadEntry( sim->catalogtable, &bsSimCatalogHashAccess, &entry ) )
+    return BS_SIM_BOID_BASE + entry.catalogindex;
+  if( sim->catalogcount >= sim->catalogalloc )
+  {
+    sim->catalogalloc = CC_MAX( 4096, sim->catalogalloc << 1 );
+    sim->cataloglist = realloc( sim->cataloglist, sim->catalogalloc * sizeof(bsSimCatalogItem) );
+  }
+  catitem = &sim->cataloglist[ sim->catalogcount ];
+  catitem->typeid = typeid;
+  catitem->id = strdup( id );
+  catitem->name = ( name ? strdup( name ) : 0 );
+  entry.id = catitem->id;
+  entry.catalogindex = sim->catalogcount;
+  mmHashDirectAddEntry( sim->catalogtable, &bsSimCatalogHashAccess, &entry, 0 );
+  sim->catalogtable = bsSimHashGrow( sim->catalogtable, &bsSimCatalogHashAccess, sizeof(bsSimCatalogEntry) );
+  sim->catalogcount++;
+  return BS_SIM_BOID_BASE + entry.catalogindex;
+}
+
+static bsSimCatalogItem *bsSimCatalogGet( bsSim *sim, int64_t boid )
+{
+  int64_t catalogindex;
+  catalogindex = boid - BS_SIM_BOID_BASE;
+  if( ( catalogindex < 0 ) || ( catalogindex >= sim->catalogcount ) )
+    return 0;
+  return &sim->cataloglist[ catalogindex ];
+}
+
+
+////
+
+
+static int bsSimHexValue( char c )
+{
+  if( ( c >= '0' ) && ( c <= '9' ) )
+    return c - '0';
+  if( ( c >= 'a' ) && ( c <= 'f' ) )
+    return c - 'a' + 10;
+  if( ( c >= 'A' ) && ( c <= 'F' ) )
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* Find the parameter in a query string or urlencoded form, decoded into buffer */
+static int bsSimGetParam( char *params, int paramslength, char *name, char *buffer, int buffersize )
+{
+  int offset, namelength, pairlength, keylength, index, writeindex, high, low;
+  char *pair;
+
+  namelength = strlen( name );
+  for( offset = 0 ; offset < paramslength ; offset += pairlength + 1 )
+  {
+    pair = &params[ offset ];
+    pairlength = ccSeqFindChar( pair, paramslength - offset, '&' );
+    if( pairlength < 0 )
+      pairlength = paramslength - offset;
+    keylength = ccSeqFindChar( pair, pairlength, '=' );
+    if( keylength < 0 )
+      keylength = pairlength;
+    if( ( keylength != namelength ) || ( memcmp( pair, name, namelength ) ) )
+      continue;
+    writeindex = 0;
+    for( index = keylength + 1 ; ( index < pairlength ) && ( writeindex < buffersize - 1 ) ; index++ )
+    {
+      if( pair[ index ] == '+' )
+        buffer[ writeindex++ ] = ' ';
+      else if( ( pair[ index ] == '%' ) && ( index + 2 < pairlength ) && ( ( high = bsSimHexValue( pair[ index + 1 ] ) ) >= 0 ) && ( ( low = bsSimHexValue( pair[ index + 2 ] ) ) >= 0 ) )
+      {
+        buffer[ writeindex++ ] = (char)( ( high << 4 ) | low );
+        index += 2;
+      }
+      else
+        buffer[ writeindex++ ] = pair[ index ];
+    }
+    buffer[ writeindex ] = 0;
+    return 1;
+  }
+
+  return 0;
+}
+
+static int bsSimGetParamInt64( char *params, int paramslength, char *name, int64_t *retint )
+{
+  char buffer[64];
+  if( !( bsSimGetParam( params, paramslength, name, buffer, sizeof(buffer) ) ) )
+    return 0;
+  return ccStrParseInt64( buffer, retint );
+}
+
+static int bsSimGetParamDouble( char *params, int paramslength, char *name, double *retdouble )
+{
+  char buffer[64];
+  if( !( bsSimGetParam( params, paramslength, name, buffer, sizeof(buffer) ) ) )
+    return 0;
+  return ccStrParseDouble( buffer, retdouble );
+}
+
+
+/* Return 1 when a full request was parsed, 0 if more data is needed, -1 on malformed requests */
+static int bsSimParseRequest( bsSimLink *slink, bsSimRequest *request, size_t *retsize )
+{
+  int headersize, linelength;
+  int32_t contentlength;
+  char *data, *end, *line, *next, *string;
+
+  data = slink->recvdata;
+  if( !( end = ccStrFindStr( data, "\r\n\r\n" ) ) )
+    return ( slink->recvsize > BS_SIM_HEADER_MAX ? -1 : 0 );
+  headersize = (int)( end - data ) + 4;
+
+  /* Wait for the whole body before touching the buffer */
+  contentlength = 0;
+  if( ( string = ccSeqFindStrIgnoreCaseSkip( data, headersize, "\ncontent-length:" ) ) )
+  {
+    string = ccStrNextWordSameLine( string );
+    if( !( ccStrParseInt32( string, &contentlength ) ) || ( contentlength < 0 ) )
+      return -1;
+  }
+  if( slink->recvsize < (size_t)headersize + (size_t)contentlength )
+    return 0;
+
+  memset( request, 0, sizeof(bsSimRequest) );
+  data[ headersize - 2 ] = 0;
+  for( line = data ; line ; line = next )
+  {
+    linelength = ccSeqFindChar( line, (int)( &data[ headersize - 2 ] - line ), '\n' );
+    next = 0;
+    if( linelength >= 0 )
+    {
+      line[ linelength ] = 0;
+      next = &line[ linelength + 1 ];
+    }
+    else
+      linelength = strlen( line );
+    if( ( linelength > 0 ) && ( line[ linelength - 1 ] == '\r' ) )
+      line[ linelength - 1 ] = 0;
+    if( line == data )
+    {
+      /* Request line, "METHOD /path?params HTTP/1.1" */
+      request->method = line;
+      if( !( string = strchr( line, ' ' ) ) )
+        return -1;
+      *string = 0;
+      request->path = string + 1;
+      if( !( string = strchr( request->path, ' ' ) ) )
+        return -1;
+      *string = 0;
+      request->pathlength = strlen( request->path );
+      if( ( string = strchr( request->path, '?' ) ) )
+      {
+        *string = 0;
+        request->params = string + 1;
+        request->paramslength = strlen( request->params );
+        request->pathlength = (int)( string - request->path );
+      }
+    }
+    else if( ccStrCmpWordIgnoreCase( line, "authorization:" ) )
+      request->authflag = 1;
+    else if( ( string = ccStrCmpWordIgnoreCase( line, "connection:" ) ) )
+    {
+      if( ccSeqFindStrIgnoreCaseSkip( string, strlen( string ), "close" ) )
+        request->closeflag = 1;
+    }
+  }
+  if( !( request->method ) )
+    return -1;
+  request->body = &data[ headersize ];
+  request->bodylength = contentlength;
+
+  *retsize = (size_t)headersize + (size_t)contentlength;
+  return 1;
+}
+
+
+////
+
+
+static void bsSimPrintString( ccGrowth *growth, char *string )
+{
+  char *encodedstring;
+  encodedstring = 0;
+  if( string )
+    encodedstring = jsonEncodeEscapeString( string, strlen( string ), 0 );
+  ccGrowthPrintf( growth, "\"%s\"", ( encodedstring ? encodedstring : "" ) );
+  free( encodedstring );
+  return;
+}
+
+static void bsSimPrintDate( ccGrowth *growth, int64_t date )
+{
+  time_t rawtime;
+  struct tm timeinfo;
+  rawtime = (time_t)date;
+#if CC_WINDOWS
+  gmtime_s( &timeinfo, &rawtime );
+#else
+  gmtime_r( &rawtime, &timeinfo );
+#endif
+  ccGrowthPrintf( growth, "\"%04d-%02d-%02dT%02d:%02d:%02d.000Z\"", timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec );
+  return;
+}
+
+static char *bsSimBrickLinkTypeName( char typeid )
+{
+  switch( typeid )
+  {
+    case 'P':
+      return "PART";
+    case 'S':
+      return "SET";
+    case 'M':
+      return "MINIFIG";
+    case 'B':
+      return "BOOK";
+    case 'G':
+      return "GEAR";
+    case 'C':
+      return "CATALOG";
+    case 'I':
+      return "INSTRUCTION";
+    case 'O':
+      return "ORIGINAL_BOX";
+    default:
+      break;
+  }
+  return "PART";
+}
+
+static char *bsSimBrickOwlTypeName( char typeid )
+{
+  switch( typeid )
+  {
+    case 'P':
+      return "Part";
+    case 'S':
+      return "Set";
+    case 'M':
+      return "Minifigure";
+    case 'B':
+      return "Book";
+    case 'G':
+      return "Gear";
+    case 'C':
+      return "Catalog";
+    case 'I':
+      return "Instructions";
+    case 'O':
+      return "Packaging";
+    case '#':
+      return "Minibuild";
+    default:
+      break;
+  }
+  return "Part";
+}
+
+static char bsSimBrickOwlTypeId( char *typestring )
+{
+  if( !( strcmp( typestring, "Part" ) ) || !( strcmp( typestring, "Sticker" ) ) )
+    return 'P';
+  else if( !( strcmp( typestring, "Set" ) ) )
+    return 'S';
+  else if( !( strcmp( typestring, "Minifigure" ) ) )
+    return 'M';
+  else if( !( strcmp( typestring, "Book" ) ) )
+    return 'B';
+  else if( !( strcmp( typestring, "Gear" ) ) )
+    return 'G';
+  else if( !( strcmp( typestring, "Catalog" ) ) )
+    return 'C';
+  else if( !( strcmp( typestring, "Instructions" ) ) )
+    return 'I';
+  else if( !( strcmp( typestring, "Packaging" ) ) )
+    return 'O';
+  else if( !( strcmp( typestring, "Minibuild" ) ) )
+    return '#';
+  return 0;
+}
+
+static void bsSimBrickLinkPrintMeta( ccGrowth *growth, int code, char *message, char *description )
+{
+  ccGrowthPrintf( growth, "\"meta\":{\"description\":\"%s\",\"message\":\"%s\",\"code\":%d}", description, message, code );
+  return;
+}
+
+static void bsSimBrickLinkPrintLot( ccGrowth *growth, bsxItem *item )
+{
+  ccGrowthPrintf( growth, "{\"inventory_id\":" CC_LLD ",\"item\":{\"no\":", (long long)item->lotid );
+  bsSimPrintString( growth, item->id );
+  ccGrowthPrintf( growth, ",\"name\":" );
+  bsSimPrintString( growth, item->name );
+  ccGrowthPrintf( growth, ",\"type\":\"%s\",\"category_id\":%d},\"color_id\":%d,\"color_name\":", bsSimBrickLinkTypeName( item->typeid ), item->categoryid, item->colorid );
+  bsSimPrintString( growth, item->colorname );
+  ccGrowthPrintf( growth, ",\"quantity\":%d,\"new_or_used\":\"%c\"", item->quantity, item->condition );
+  if( item->typeid == 'S' )
+    ccGrowthPrintf( growth, ",\"completeness\":\"%c\"", item->completeness );
+  ccGrowthPrintf( growth, ",\"unit_price\":\"%.4f\",\"bind_id\":0,\"description\":", item->price );
+  bsSimPrintString( growth, item->comments );
+  ccGrowthPrintf( growth, ",\"remarks\":" );
+  bsSimPrintString( growth, item->remarks );
+  ccGrowthPrintf( growth, ",\"bulk\":%d,\"is_retain\":%s,\"is_stock_room\":false", CC_MAX( item->bulk, 1 ), ( item->stockflags & BSX_ITEM_STOCKFLAGS_RETAIN ? "true" : "false" ) );
+  ccGrowthPrintf( growth, ",\"my_cost\":\"%.4f\",\"sale_rate\":%d", item->mycost, item->sale );
+  ccGrowthPrintf( growth, ",\"tier_quantity1\":%d,\"tier_price1\":\"%.4f\",\"tier_quantity2\":%d,\"tier_price2\":\"%.4f\",\"tier_quantity3\":%d,\"tier_price3\":\"%.4f\"}", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3 );
+  return;
+}
+
+static void bsSimBrickOwlPrintBoid( ccGrowth *growth, bsxItem *item )
+{
+  int bocolor;
+  bocolor = bsTranslateColorBl2Bo( item->colorid );
+  if( ( item->typeid == 'P' ) || ( bocolor > 0 ) )
+    ccGrowthPrintf( growth, "\"boid\":\"" CC_LLD "-%d\"", (long long)item->boid, CC_MAX( bocolor, 0 ) );
+  else
+    ccGrowthPrintf( growth, "\"boid\":\"" CC_LLD "\"", (long long)item->boid );
+  return;
+}
+
+static void bsSimBrickOwlPrintLot( ccGrowth *growth, bsxItem *item )
+{
+  ccGrowthPrintf( growth, "{\"lot_id\":\"" CC_LLD "\",", (long long)item->bolotid );
+  bsSimBrickOwlPrintBoid( growth, item );
+  ccGrowthPrintf( growth, ",\"type\":\"%s\",\"con\":\"%s\",\"full_con\":", bsSimBrickOwlTypeName( item->typeid ), ( item->condition == 'N' ? "new" : "used" ) );
+  if( item->condition == 'N' )
+    ccGrowthPrintf( growth, "\"new\"" );
+  else if( item->usedgrade )
+    ccGrowthPrintf( growth, "\"used%c\"", item->usedgrade - 'A' + 'a' );
+  else
+    ccGrowthPrintf( growth, "null" );
+  ccGrowthPrintf( growth, ",\"qty\":\"%d\",\"price\":\"%.3f\",\"base_price\":\"%.3f\",\"url\":\"https://bssim.brickowl.com/store/" CC_LLD "\"", item->quantity, item->price, item->price, (long long)item->bolotid );
+  ccGrowthPrintf( growth, ",\"public_note\":" );
+  bsSimPrintString( growth, item->comments );
+  ccGrowthPrintf( growth, ",\"personal_note\":" );
+  bsSimPrintString( growth, item->remarks );
+  ccGrowthPrintf( growth, ",\"sale_percent\":\"%d\",\"bulk_qty\":\"%d\",\"my_cost\":\"%.3f\",\"for_sale\":\"1\"", item->sale, CC_MAX( item->bulk, 1 ), item->mycost );
+  if( item->lotid != -1 )
+    ccGrowthPrintf( growth, ",\"external_lot_ids\":{\"other\":\"" CC_LLD "\"}", (long long)item->lotid );
+  else
+    ccGrowthPrintf( growth, ",\"external_lot_ids\":[]" );
+  if( item->tq1 )
+  {
+    ccGrowthPrintf( growth, ",\"tier_price\":[[\"%d\",\"%.3f\"]", item->tq1, item->tp1 );
+    if( item->tq2 )
+    {
+      ccGrowthPrintf( growth, ",[\"%d\",\"%.3f\"]", item->tq2, item->tp2 );
+      if( item->tq3 )
+        ccGrowthPrintf( growth, ",[\"%d\",\"%.3f\"]", item->tq3, item->tp3 );
+    }
+    ccGrowthPrintf( growth, "]" );
+  }
+  else
+    ccGrowthPrintf( growth, ",\"tier_price\":null" );
+  ccGrowthPrintf( growth, "}" );
+  return;
+}
+
+
+////
+
+
+static void bsSimRespond( bsSimResponse *response, int code, char *status )
+{
+  response->code = code;
+  response->status = status;
+  return;
+}
+
+static void bsSimBrickLinkFail( bsSimResponse *response, int code, char *status, char *message, char *description )
+{
+  response->body.offset = 0;
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, code, message, description );
+  ccGrowthPrintf( &response->body, "}" );
+  bsSimRespond( response, code, status );
+  return;
+}
+
+static void bsSimBrickOwlFail( bsSimResponse *response, int code, char *status, char *description )
+{
+  response->body.offset = 0;
+  ccGrowthPrintf( &response->body, "{\"error\":{\"status\":\"%s\"}}", description );
+  bsSimRespond( response, code, status );
+  return;
+}
+
+static void bsSimBrickLinkRemoveLot( bsSim *sim, bsxItem *item )
+{
+  bsSimLotRemove( sim->bllottable, item->lotid );
+  bsxRemoveItem( sim->blinv, item );
+  return;
+}
+
+/* Parse the JSON body of a BrickLink inventory POST or PUT into a temporary inventory */
+static bsxInventory *bsSimBrickLinkReadBody( bsSim *sim, bsSimRequest *request )
+{
+  int listflag;
+  char *string;
+  bsxInventory *inv;
+
+  listflag = ( ( request->bodylength > 0 ) && ( request->body[0] == '[' ) );
+  string = ccStrAllocPrintf( ( listflag ? "{\"data\":%.*s}" : "{\"data\":[%.*s]}" ), request->bodylength, request->body );
+  inv = bsxNewInventory();
+  if( !( blReadInventory( inv, string, &sim->output ) ) || !( inv->itemcount ) )
+  {
+    bsxFreeInventory( inv );
+    inv = 0;
+  }
+  free( string );
+  return inv;
+}
+
+static void bsSimBrickLinkInventoryList( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int itemindex, firstflag;
+  bsxItem *item;
+
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, 200, "OK", "OK" );
+  ccGrowthPrintf( &response->body, ",\"data\":[" );
+  firstflag = 1;
+  item = sim->blinv->itemlist;
+  for( itemindex = 0 ; itemindex < sim->blinv->itemcount ; itemindex++, item++ )
+  {
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    if( ( item->quantity <= 0 ) && !( item->stockflags & BSX_ITEM_STOCKFLAGS_RETAIN ) )
+      continue;
+    if( !( firstflag ) )
+      ccGrowthPrintf( &response->body, "," );
+    bsSimBrickLinkPrintLot( &response->body, item );
+    firstflag = 0;
+    response->lotcount++;
+  }
+  ccGrowthPrintf( &response->body, "]}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickLinkInventoryCreate( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int itemindex;
+  bsxInventory *inv;
+  bsxItem *item, *newitem;
+
+  if( !( inv = bsSimBrickLinkReadBody( sim, request ) ) )
+  {
+    bsSimBrickLinkFail( response, 400, "Bad Request", "INVALID_REQUEST_BODY", "A request has been made with a malformed JSON body." );
+    return;
+  }
+  newitem = 0;
+  item = inv->itemlist;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++, item++ )
+  {
+    if( !( item->id ) || !( item->typeid ) || ( item->quantity <= 0 ) )
+      continue;
+    item->lotid = sim->bllotnext++;
+    newitem = bsxAddCopyItem( sim->blinv, item );
+    newitem->boid = bsSimCatalogLookup( sim, newitem->typeid, newitem->id, newitem->name );
+    bsSimLotAdd( &sim->bllottable, newitem->lotid, sim->blinv->itemcount - 1 );
+  }
+  if( !( newitem ) )
+    bsSimBrickLinkFail( response, 400, "Bad Request", "INVALID_VALUE", "Invalid item, type or quantity." );
+  else
+  {
+    ccGrowthPrintf( &response->body, "{" );
+    bsSimBrickLinkPrintMeta( &response->body, 201, "OK", "OK" );
+    ccGrowthPrintf( &response->body, ",\"data\":" );
+    bsSimBrickLinkPrintLot( &response->body, newitem );
+    ccGrowthPrintf( &response->body, "}" );
+    bsSimRespond( response, 201, "Created" );
+  }
+  bsxFreeInventory( inv );
+  return;
+}
+
+static void bsSimBrickLinkInventoryUpdate( bsSim *sim, bsSimRequest *request, bsSimResponse *response, int64_t lotid )
+{
+  int quantity;
+  bsxInventory *inv;
+  bsxItem *item, *update;
+
+  if( !( item = bsSimLotFind( sim->bllottable, sim->blinv, lotid ) ) )
+  {
+    bsSimBrickLinkFail( response, 404, "Not Found", "RESOURCE_NOT_FOUND", "Resource not found." );
+    return;
+  }
+  if( !( inv = bsSimBrickLinkReadBody( sim, request ) ) )
+  {
+    bsSimBrickLinkFail( response, 400, "Bad Request", "INVALID_REQUEST_BODY", "A request has been made with a malformed JSON body." );
+    return;
+  }
+  update = &inv->itemlist[0];
+
+  /* The parser leaves no trace of absent fields, look for them in the body */
+  if( ccSeqFindStr( request->body, request->bodylength, "\"quantity\"" ) )
+  {
+    /* Quantities of updates are relative */
+    quantity = item->quantity + update->quantity;
+    if( quantity < 0 )
+    {
+      bsSimBrickLinkFail( response, 400, "Bad Request", "INVALID_VALUE", "Quantity would become negative." );
+      bsxFreeInventory( inv );
+      return;
+    }
+    bsxSetItemQuantity( sim->blinv, item, quantity );
+  }
+  if( ccSeqFindStr( request->body, request->bodylength, "\"description\"" ) )
+    bsxSetItemComments( item, update->comments, -1 );
+  if( ccSeqFindStr( request->body, request->bodylength, "\"remarks\"" ) )
+    bsxSetItemRemarks( item, update->remarks, -1 );
+  if( ccSeqFindStr( request->body, request->bodylength, "\"unit_price\"" ) )
+  {
+    quantity = item->quantity;
+    bsxSetItemQuantity( sim->blinv, item, 0 );
+    item->price = update->price;
+    bsxSetItemQuantity( sim->blinv, item, quantity );
+  }
+  if( ccSeqFindStr( request->body, request->bodylength, "\"bulk\"" ) )
+    item->bulk = update->bulk;
+  if( ccSeqFindStr( request->body, request->bodylength, "\"my_cost\"" ) )
+    item->mycost = update->mycost;
+  if( ccSeqFindStr( request->body, request->bodylength, "\"sale_rate\"" ) )
+    item->sale = update->sale;
+  if( ccSeqFindStr( request->body, request->bodylength, "\"is_retain\"" ) )
+    item->stockflags = ( item->stockflags & ~BSX_ITEM_STOCKFLAGS_RETAIN ) | ( update->stockflags & BSX_ITEM_STOCKFLAGS_RETAIN );
+  if( ccSeqFindStr( request->body, request->bodylength, "\"tier_quantity1\"" ) )
+  {
+    item->tq1 = update->tq1;
+    item->tp1 = update->tp1;
+    item->tq2 = update->tq2;
+    item->tp2 = update->tp2;
+    item->tq3 = update->tq3;
+    item->tp3 = update->tp3;
+  }
+
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, 200, "OK", "OK" );
+  ccGrowthPrintf( &response->body, ",\"data\":" );
+  bsSimBrickLinkPrintLot( &response->body, item );
+  ccGrowthPrintf( &response->body, "}" );
+  bsSimRespond( response, 200, "OK" );
+
+  /* Like BrickLink, lots running out of stock are gone unless retained */
+  if( ( item->quantity <= 0 ) && !( item->stockflags & BSX_ITEM_STOCKFLAGS_RETAIN ) )
+    bsSimBrickLinkRemoveLot( sim, item );
+
+  bsxFreeInventory( inv );
+  return;
+}
+
+static void bsSimBrickLinkInventoryDelete( bsSim *sim, bsSimRequest *request, bsSimResponse *response, int64_t lotid )
+{
+  bsxItem *item;
+
+  if( !( item = bsSimLotFind( sim->bllottable, sim->blinv, lotid ) ) )
+  {
+    bsSimBrickLinkFail( response, 404, "Not Found", "RESOURCE_NOT_FOUND", "Resource not found." );
+    return;
+  }
+  bsSimBrickLinkRemoveLot( sim, item );
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, 204, "OK", "OK" );
+  ccGrowthPrintf( &response->body, ",\"data\":{}}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickLinkPrintOrder( ccGrowth *growth, bsSimOrder *order )
+{
+  ccGrowthPrintf( growth, "{\"order_id\":" CC_LLD ",\"date_ordered\":", (long long)order->id );
+  bsSimPrintDate( growth, order->date );
+  ccGrowthPrintf( growth, ",\"date_status_changed\":" );
+  bsSimPrintDate( growth, order->date );
+  ccGrowthPrintf( growth, ",\"seller_name\":\"bssim\",\"store_name\":\"BrickSync Simulator\",\"buyer_name\":\"buyer" CC_LLD "\"", (long long)order->id );
+  ccGrowthPrintf( growth, ",\"total_count\":%d,\"unique_count\":%d,\"status\":\"PENDING\"", order->inv->partcount, order->inv->itemcount );
+  ccGrowthPrintf( growth, ",\"payment\":{\"method\":\"PayPal\",\"currency_code\":\"" BS_SIM_CURRENCY "\",\"status\":\"None\"}" );
+  ccGrowthPrintf( growth, ",\"cost\":{\"currency_code\":\"" BS_SIM_CURRENCY "\",\"subtotal\":\"%.4f\",\"grand_total\":\"%.4f\",\"shipping\":\"0.0000\",\"vat_amount\":\"0.0000\"}", order->inv->totalprice, order->inv->totalprice );
+  ccGrowthPrintf( growth, ",\"disp_cost\":{\"currency_code\":\"" BS_SIM_CURRENCY "\",\"subtotal\":\"%.4f\",\"grand_total\":\"%.4f\"}}", order->inv->totalprice, order->inv->totalprice );
+  return;
+}
+
+static bsSimOrder *bsSimFindOrder( bsSim *sim, int service, int64_t orderid )
+{
+  int orderindex;
+  for( orderindex = 0 ; orderindex < sim->ordercount ; orderindex++ )
+  {
+    if( ( sim->orderlist[ orderindex ].service == service ) && ( sim->orderlist[ orderindex ].id == orderid ) )
+      return &sim->orderlist[ orderindex ];
+  }
+  return 0;
+}
+
+static void bsSimBrickLinkOrderList( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int orderindex, firstflag;
+  bsSimOrder *order;
+
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, 200, "OK", "OK" );
+  ccGrowthPrintf( &response->body, ",\"data\":[" );
+  firstflag = 1;
+  /* Most recent orders first */
+  for( orderindex = sim->ordercount - 1 ; orderindex >= 0 ; orderindex-- )
+  {
+    order = &sim->orderlist[ orderindex ];
+    if( order->service != BS_SIM_SERVICE_BRICKLINK )
+      continue;
+    if( !( firstflag ) )
+      ccGrowthPrintf( &response->body, "," );
+    bsSimBrickLinkPrintOrder( &response->body, order );
+    firstflag = 0;
+  }
+  ccGrowthPrintf( &response->body, "]}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickLinkOrderItems( bsSim *sim, bsSimRequest *request, bsSimResponse *response, int64_t orderid )
+{
+  int itemindex;
+  bsSimOrder *order;
+  bsxItem *item;
+
+  if( !( order = bsSimFindOrder( sim, BS_SIM_SERVICE_BRICKLINK, orderid ) ) )
+  {
+    bsSimBrickLinkFail( response, 404, "Not Found", "RESOURCE_NOT_FOUND", "Resource not found." );
+    return;
+  }
+  ccGrowthPrintf( &response->body, "{" );
+  bsSimBrickLinkPrintMeta( &response->body, 200, "OK", "OK" );
+  ccGrowthPrintf( &response->body, ",\"data\":[[" );
+  item = order->inv->itemlist;
+  for( itemindex = 0 ; itemindex < order->inv->itemcount ; itemindex++, item++ )
+  {
+    if( itemindex )
+      ccGrowthPrintf( &response->body, "," );
+    bsSimBrickLinkPrintLot( &response->body, item );
+  }
+  ccGrowthPrintf( &response->body, "]]}" );
+  response->lotcount = order->inv->itemcount;
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+
+////
+
+
+static void bsSimBrickOwlTokenDetails( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  ccGrowthPrintf( &response->body, "{\"username\":\"bssim\",\"store_details\":{\"name\":\"BrickSync Simulator\",\"base_currency\":\"" BS_SIM_CURRENCY "\"}}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlInventoryList( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int itemindex, firstflag, activeonlyflag;
+  int64_t readint;
+  bsxItem *item;
+
+  activeonlyflag = 1;
+  if( ( bsSimGetParamInt64( request->params, request->paramslength, "active_only", &readint ) ) && !( readint ) )
+    activeonlyflag = 0;
+  ccGrowthPrintf( &response->body, "[" );
+  firstflag = 1;
+  item = sim->boinv->itemlist;
+  for( itemindex = 0 ; itemindex < sim->boinv->itemcount ; itemindex++, item++ )
+  {
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    if( ( activeonlyflag ) && ( item->quantity <= 0 ) )
+      continue;
+    if( !( firstflag ) )
+      ccGrowthPrintf( &response->body, "," );
+    bsSimBrickOwlPrintLot( &response->body, item );
+    firstflag = 0;
+    response->lotcount++;
+  }
+  ccGrowthPrintf( &response->body, "]" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+/* Condition strings of inventory/create and inventory/update */
+static void bsSimBrickOwlSetCondition( bsxItem *item, char *condition )
+{
+  if( !( strncmp( condition, "new", 3 ) ) )
+  {
+    item->condition = 'N';
+    item->usedgrade = 0;
+  }
+  else if( !( strncmp( condition, "used", 4 ) ) )
+  {
+    item->condition = 'U';
+    item->usedgrade = 0;
+    if( condition[4] == 'n' )
+      item->usedgrade = 'N';
+    else if( condition[4] == 'g' )
+      item->usedgrade = 'G';
+    else if( condition[4] == 'a' )
+      item->usedgrade = 'A';
+  }
+  if( item->typeid == 'S' )
+  {
+    if( ( condition[0] ) && ( condition[ strlen( condition ) - 1 ] == 'c' ) )
+      item->completeness = 'C';
+    else if( ( condition[0] ) && ( condition[ strlen( condition ) - 1 ] == 'i' ) )
+      item->completeness = 'B';
+    else
+      item->completeness = 'S';
+  }
+  return;
+}
+
+/* Form fields shared by inventory/create and inventory/update */
+static int bsSimBrickOwlApplyFields( bsSim *sim, bsxItem *item, char *params, int paramslength )
+{
+  int tierindex, tierquantity;
+  float tierprice;
+  int64_t readint;
+  double readdouble;
+  char *string, *next;
+  char buffer[BS_SIM_PARAM_MAX];
+
+  if( bsSimGetParamDouble( params, paramslength, "price", &readdouble ) )
+  {
+    readint = item->quantity;
+    bsxSetItemQuantity( sim->boinv, item, 0 );
+    item->price = (float)readdouble;
+    bsxSetItemQuantity( sim->boinv, item, (int)readint );
+  }
+  if( bsSimGetParam( params, paramslength, "public_note", buffer, sizeof(buffer) ) )
+    bsxSetItemComments( item, buffer, -1 );
+  if( bsSimGetParam( params, paramslength, "personal_note", buffer, sizeof(buffer) ) )
+    bsxSetItemRemarks( item, buffer, -1 );
+  if( bsSimGetParamInt64( params, paramslength, "bulk_qty", &readint ) )
+    item->bulk = ( readint > 1 ? (int)readint : 0 );
+  if( bsSimGetParamDouble( params, paramslength, "my_cost", &readdouble ) )
+    item->mycost = (float)readdouble;
+  if( bsSimGetParamInt64( params, paramslength, "sale_percent", &readint ) )
+    item->sale = (int)readint;
+  if( bsSimGetParam( params, paramslength, "condition", buffer, sizeof(buffer) ) )
+    bsSimBrickOwlSetCondition( item, buffer );
+  if( bsSimGetParam( params, paramslength, "tier_price", buffer, sizeof(buffer) ) )
+  {
+    item->tq1 = item->tq2 = item->tq3 = 0;
+    item->tp1 = item->tp2 = item->tp3 = 0.0f;
+    if( strcmp( buffer, "remove" ) )
+    {
+      /* "quantity:price,quantity:price,..." */
+      string = buffer;
+      for( tierindex = 0 ; ( string ) && ( tierindex < 3 ) ; tierindex++ )
+      {
+        if( ( next = strchr( string, ',' ) ) )
+          *next++ = 0;
+        if( sscanf( string, "%d:%f", &tierquantity, &tierprice ) != 2 )
+          return 0;
+        if( tierindex == 0 )
+        {
+          item->tq1 = tierquantity;
+          item->tp1 = tierprice;
+        }
+        else if( tierindex == 1 )
+        {
+          item->tq2 = tierquantity;
+          item->tp2 = tierprice;
+        }
+        else
+        {
+          item->tq3 = tierquantity;
+          item->tp3 = tierprice;
+        }
+        string = next;
+      }
+    }
+  }
+  return 1;
+}
+
+static void bsSimBrickOwlInventoryCreate( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int bocolor;
+  int64_t boid, readint;
+  bsxItem *item;
+  bsSimCatalogItem *catitem;
+
+  if( !( bsSimGetParamInt64( request->body, request->bodylength, "boid", &boid ) ) || !( catitem = bsSimCatalogGet( sim, boid ) ) )
+  {
+    bsSimBrickOwlFail( response, 400, "Bad Request", "Invalid BOID" );
+    return;
+  }
+  if( !( bsSimGetParamInt64( request->body, request->bodylength, "quantity", &readint ) ) || ( readint <= 0 ) )
+  {
+    bsSimBrickOwlFail( response, 400, "Bad Request", "Invalid quantity" );
+    return;
+  }
+  item = bsxNewItem( sim->boinv );
+  item->typeid = catitem->typeid;
+  bsxSetItemId( item, catitem->id, -1 );
+  bsxSetItemName( item, catitem->name, -1 );
+  item->boid = boid;
+  item->colorid = 0;
+  bocolor = 0;
+  if( bsSimGetParamInt64( request->body, request->bodylength, "color_id", &readint ) )
+  {
+    bocolor = (int)readint;
+    item->colorid = CC_MAX( bsTranslateColorBo2Bl( bocolor ), 0 );
+  }
+  item->lotid = -1;
+  bsSimGetParamInt64( request->body, request->bodylength, "external_id", &item->lotid );
+  item->bolotid = sim->bolotnext++;
+  bsxSetItemQuantity( sim->boinv, item, (int)readint );
+  if( !( bsSimBrickOwlApplyFields( sim, item, request->body, request->bodylength ) ) )
+  {
+    bsxRemoveItem( sim->boinv, item );
+    bsSimBrickOwlFail( response, 400, "Bad Request", "Invalid tier_price" );
+    return;
+  }
+  bsSimLotAdd( &sim->bolottable, item->bolotid, sim->boinv->itemcount - 1 );
+  bsSimLotAdd( &sim->boexttable, item->lotid, sim->boinv->itemcount - 1 );
+  ccGrowthPrintf( &response->body, "{\"status\":\"Success\",\"lot_id\":\"" CC_LLD "\"}", (long long)item->bolotid );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlInventoryUpdate( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int64_t readint;
+  bsxItem *item;
+
+  item = 0;
+  if( bsSimGetParamInt64( request->body, request->bodylength, "lot_id", &readint ) )
+    item = bsSimLotFind( sim->bolottable, sim->boinv, readint );
+  else if( bsSimGetParamInt64( request->body, request->bodylength, "external_id", &readint ) )
+    item = bsSimLotFind( sim->boexttable, sim->boinv, readint );
+  if( !( item ) )
+  {
+    bsSimBrickOwlFail( response, 404, "Not Found", "Lot not found" );
+    return;
+  }
+  /* BrickOwl keeps lots without stock around */
+  if( bsSimGetParamInt64( request->body, request->bodylength, "relative_quantity", &readint ) )
+    bsxSetItemQuantity( sim->boinv, item, CC_MAX( item->quantity + (int)readint, 0 ) );
+  else if( bsSimGetParamInt64( request->body, request->bodylength, "absolute_quantity", &readint ) )
+    bsxSetItemQuantity( sim->boinv, item, CC_MAX( (int)readint, 0 ) );
+  if( !( bsSimBrickOwlApplyFields( sim, item, request->body, request->bodylength ) ) )
+  {
+    bsSimBrickOwlFail( response, 400, "Bad Request", "Invalid tier_price" );
+    return;
+  }
+  ccGrowthPrintf( &response->body, "{\"status\":\"Success\"}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlPrintOrder( ccGrowth *growth, bsSimOrder *order )
+{
+  ccGrowthPrintf( growth, "{\"order_id\":\"" CC_LLD "\",\"order_date\":\"" CC_LLD "\",\"order_time\":\"" CC_LLD "\"", (long long)order->id, (long long)order->date, (long long)order->date );
+  ccGrowthPrintf( growth, ",\"total_quantity\":\"%d\",\"total_lots\":\"%d\",\"base_order_total\":\"%.2f\",\"status\":\"Pending\",\"status_id\":\"%d\"", order->inv->partcount, order->inv->itemcount, order->inv->totalprice, BO_ORDER_STATUS_PENDING );
+  ccGrowthPrintf( growth, ",\"sub_total\":\"%.2f\",\"payment_currency\":\"" BS_SIM_CURRENCY "\",\"payment_total\":\"%.2f\",\"buyer_name\":\"buyer" CC_LLD "\",\"ship_total\":\"0.00\",\"tax_amount\":\"0.00\"}", order->inv->totalprice, order->inv->totalprice, (long long)order->id );
+  return;
+}
+
+static void bsSimBrickOwlOrderList( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int orderindex, listcount;
+  int64_t ordertime, limit;
+  bsSimOrder *order;
+
+  ordertime = 0;
+  bsSimGetParamInt64( request->params, request->paramslength, "order_time", &ordertime );
+  limit = 500;
+  bsSimGetParamInt64( request->params, request->paramslength, "limit", &limit );
+  ccGrowthPrintf( &response->body, "[" );
+  listcount = 0;
+  for( orderindex = sim->ordercount - 1 ; ( orderindex >= 0 ) && ( listcount < limit ) ; orderindex-- )
+  {
+    order = &sim->orderlist[ orderindex ];
+    if( ( order->service != BS_SIM_SERVICE_BRICKOWL ) || ( order->date < ordertime ) )
+      continue;
+    if( listcount )
+      ccGrowthPrintf( &response->body, "," );
+    bsSimBrickOwlPrintOrder( &response->body, order );
+    listcount++;
+  }
+  ccGrowthPrintf( &response->body, "]" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static bsSimOrder *bsSimBrickOwlRequestOrder( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int64_t orderid;
+  bsSimOrder *order;
+
+  order = 0;
+  if( bsSimGetParamInt64( request->params, request->paramslength, "order_id", &orderid ) )
+    order = bsSimFindOrder( sim, BS_SIM_SERVICE_BRICKOWL, orderid );
+  if( !( order ) )
+    bsSimBrickOwlFail( response, 404, "Not Found", "Order not found" );
+  return order;
+}
+
+static void bsSimBrickOwlOrderView( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  bsSimOrder *order;
+
+  if( !( order = bsSimBrickOwlRequestOrder( sim, request, response ) ) )
+    return;
+  bsSimBrickOwlPrintOrder( &response->body, order );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlOrderItems( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  int itemindex;
+  bsSimOrder *order;
+  bsxItem *item;
+
+  if( !( order = bsSimBrickOwlRequestOrder( sim, request, response ) ) )
+    return;
+  ccGrowthPrintf( &response->body, "[" );
+  item = order->inv->itemlist;
+  for( itemindex = 0 ; itemindex < order->inv->itemcount ; itemindex++, item++ )
+  {
+    if( itemindex )
+      ccGrowthPrintf( &response->body, "," );
+    ccGrowthPrintf( &response->body, "{\"name\":" );
+    bsSimPrintString( &response->body, item->name );
+    ccGrowthPrintf( &response->body, ",\"type\":\"%s\",", bsSimBrickOwlTypeName( item->typeid ) );
+    bsSimBrickOwlPrintBoid( &response->body, item );
+    ccGrowthPrintf( &response->body, ",\"lot_id\":\"" CC_LLD "\",\"ordered_quantity\":\"%d\",\"base_price\":\"%.3f\",\"condition\":\"%s\"", (long long)item->bolotid, item->quantity, item->price, ( item->condition == 'N' ? "New" : "Used" ) );
+    ccGrowthPrintf( &response->body, ",\"public_note\":" );
+    bsSimPrintString( &response->body, item->comments );
+    ccGrowthPrintf( &response->body, ",\"personal_note\":" );
+    bsSimPrintString( &response->body, item->remarks );
+    if( item->lotid != -1 )
+      ccGrowthPrintf( &response->body, ",\"bl_lot_id\":\"" CC_LLD "\",\"external_lot_ids\":{\"other\":\"" CC_LLD "\"}}", (long long)item->lotid, (long long)item->lotid );
+    else
+      ccGrowthPrintf( &response->body, ",\"bl_lot_id\":null,\"external_lot_ids\":[]}" );
+  }
+  ccGrowthPrintf( &response->body, "]" );
+  response->lotcount = order->inv->itemcount;
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlIdLookup( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  char typeid;
+  int64_t boid;
+  char id[BS_SIM_PARAM_MAX];
+  char typestring[64];
+
+  if( !( bsSimGetParam( request->params, request->paramslength, "id", id, sizeof(id) ) ) || !( id[0] ) || !( bsSimGetParam( request->params, request->paramslength, "type", typestring, sizeof(typestring) ) ) || !( typeid = bsSimBrickOwlTypeId( typestring ) ) )
+  {
+    bsSimBrickOwlFail( response, 400, "Bad Request", "Invalid id or type" );
+    return;
+  }
+  boid = bsSimCatalogLookup( sim, typeid, id, 0 );
+  ccGrowthPrintf( &response->body, "{\"boids\":[\"" CC_LLD "\"]}", (long long)boid );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+static void bsSimBrickOwlCatalogEdit( bsSim *sim, bsSimRequest *request, bsSimResponse *response )
+{
+  ccGrowthPrintf( &response->body, "{\"status\":\"Success\"}" );
+  bsSimRespond( response, 200, "OK" );
+  return;
+}
+
+
+////
+
+
+static int bsSimRateCheck( bsSim *sim, int service, int64_t now )
+{
+  bsSimBucket *bucket;
+
+  if( !( sim->config.ratelimit ) )
+    return 1;
+  bucket = &sim->bucket[ service ];
+  bucket->tokens += (double)( now - bucket->lasttime ) * 0.000000001 * (double)sim->config.ratelimit;
+  if( bucket->tokens > (double)sim->config.ratelimit )
+    bucket->tokens = (double)sim->config.ratelimit;
+  bucket->lasttime = now;
+  if( bucket->tokens < 1.0 )
+    return 0;
+  bucket->tokens -= 1.0;
+  return 1;
+}
+
+static int bsSimRoute( bsSimRequest *request, int *retservice, int64_t *retid )
+{
+  char *path, *end;
+  int64_t readint;
+
+  path = request->path;
+  *retid = -1;
+  if( !( strncmp( path, "/api/store/v1/", 14 ) ) )
+  {
+    *retservice = BS_SIM_SERVICE_BRICKLINK;
+    path += 14;
+    if( !( strcmp( path, "inventories" ) ) )
+    {
+      if( !( strcmp( request->method, "GET" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_LIST;
+      if( !( strcmp( request->method, "POST" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_CREATE;
+    }
+    else if( !( strncmp( path, "inventories/", 12 ) ) && ( ccStrParseInt64( path + 12, &readint ) ) )
+    {
+      *retid = readint;
+      if( !( strcmp( request->method, "PUT" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_UPDATE;
+      if( !( strcmp( request->method, "DELETE" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_DELETE;
+    }
+    else if( !( strcmp( path, "orders" ) ) )
+    {
+      if( !( strcmp( request->method, "GET" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_ORDER_LIST;
+    }
+    else if( !( strncmp( path, "orders/", 7 ) ) && ( end = strchr( path + 7, '/' ) ) && !( strcmp( end, "/items" ) ) && ( ccSeqParseInt64( path + 7, (int)( end - ( path + 7 ) ), &readint ) ) )
+    {
+      *retid = readint;
+      if( !( strcmp( request->method, "GET" ) ) )
+        return BS_SIM_ENDPOINT_BRICKLINK_ORDER_ITEMS;
+    }
+  }
+  else if( !( strncmp( path, "/v1/", 4 ) ) )
+  {
+    *retservice = BS_SIM_SERVICE_BRICKOWL;
+    path += 4;
+    if( !( strcmp( path, "token/details" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_TOKEN_DETAILS;
+    else if( !( strcmp( path, "inventory/list" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_LIST;
+    else if( !( strcmp( path, "inventory/create" ) ) && !( strcmp( request->method, "POST" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_CREATE;
+    else if( !( strcmp( path, "inventory/update" ) ) && !( strcmp( request->method, "POST" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_UPDATE;
+    else if( !( strcmp( path, "order/list" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_ORDER_LIST;
+    else if( !( strcmp( path, "order/view" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_ORDER_VIEW;
+    else if( !( strcmp( path, "order/items" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_ORDER_ITEMS;
+    else if( !( strcmp( path, "catalog/id_lookup" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_ID_LOOKUP;
+    else if( !( strcmp( path, "catalog_edit/basic_edit" ) ) && !( strcmp( request->method, "POST" ) ) )
+      return BS_SIM_ENDPOINT_BRICKOWL_CATALOG_EDIT;
+  }
+  return BS_SIM_ENDPOINT_UNKNOWN;
+}
+
+static void bsSimDispatch( bsSim *sim, bsSimRequest *request, bsSimResponse *response, int endpoint, int64_t id )
+{
+  switch( endpoint )
+  {
+    case BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_LIST:
+      bsSimBrickLinkInventoryList( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_CREATE:
+      bsSimBrickLinkInventoryCreate( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_UPDATE:
+      bsSimBrickLinkInventoryUpdate( sim, request, response, id );
+      break;
+    case BS_SIM_ENDPOINT_BRICKLINK_INVENTORY_DELETE:
+      bsSimBrickLinkInventoryDelete( sim, request, response, id );
+      break;
+    case BS_SIM_ENDPOINT_BRICKLINK_ORDER_LIST:
+      bsSimBrickLinkOrderList( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKLINK_ORDER_ITEMS:
+      bsSimBrickLinkOrderItems( sim, request, response, id );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_TOKEN_DETAILS:
+      bsSimBrickOwlTokenDetails( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_LIST:
+      bsSimBrickOwlInventoryList( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_CREATE:
+      bsSimBrickOwlInventoryCreate( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_INVENTORY_UPDATE:
+      bsSimBrickOwlInventoryUpdate( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_ORDER_LIST:
+      bsSimBrickOwlOrderList( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_ORDER_VIEW:
+      bsSimBrickOwlOrderView( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_ORDER_ITEMS:
+      bsSimBrickOwlOrderItems( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_ID_LOOKUP:
+      bsSimBrickOwlIdLookup( sim, request, response );
+      break;
+    case BS_SIM_ENDPOINT_BRICKOWL_CATALOG_EDIT:
+      bsSimBrickOwlCatalogEdit( sim, request, response );
+      break;
+    default:
+      ccGrowthPrintf( &response->body, "{\"error\":\"Not found\"}" );
+      bsSimRespond( response, 404, "Not Found" );
+      break;
+  }
+  return;
+}
+
+
+////
+
+
+/* Queue the reply to the request, return zero if the connection must be dropped */
+static int bsSimProcessRequest( bsSim *sim, bsSimLink *slink, bsSimRequest *request, int64_t now )
+{
+  int endpoint, service, headersize, closeflag;
+  int64_t id, delay, readytime;
+  char key[256];
+  char header[512];
+  bsSimStats *stats;
+  bsSimReply *reply;
+  bsSimResponse response;
+
+  service = BS_SIM_SERVICE_BRICKLINK;
+  endpoint = bsSimRoute( request, &service, &id );
+  stats = &sim->stats[ endpoint ];
+  stats->count++;
+  if( ( sim->config.droprate > 0.0 ) && ( (double)randFloat( &sim->randstate ) * 100.0 < sim->config.droprate ) )
+  {
+    stats->dropcount++;
+    return 0;
+  }
+
+  ccGrowthInit( &response.body, 4096 );
+  response.lotcount = 0;
+  if( endpoint == BS_SIM_ENDPOINT_UNKNOWN )
+  {
+    bsSimDispatch( sim, request, &response, endpoint, id );
+    stats->failcount++;
+  }
+  else if( ( service == BS_SIM_SERVICE_BRICKLINK ) && !( request->authflag ) )
+  {
+    bsSimBrickLinkFail( &response, 401, "Unauthorized", "BAD_OAUTH_REQUEST", "No OAuth authorization header." );
+    stats->failcount++;
+  }
+  else if( ( service == BS_SIM_SERVICE_BRICKOWL ) && !( bsSimGetParam( request->params, request->paramslength, "key", key, sizeof(key) ) ) && !( bsSimGetParam( request->body, request->bodylength, "key", key, sizeof(key) ) ) )
+  {
+    bsSimBrickOwlFail( &response, 401, "Unauthorized", "Missing key" );
+    stats->failcount++;
+  }
+  else if( !( bsSimRateCheck( sim, service, now ) ) )
+  {
+    if( service == BS_SIM_SERVICE_BRICKLINK )
+      bsSimBrickLinkFail( &response, 429, "Too Many Requests", "TOO_MANY_REQUESTS", "Rate limit exceeded." );
+    else
+      bsSimBrickOwlFail( &response, 429, "Too Many Requests", "Rate limit exceeded" );
+    stats->limitcount++;
+  }
+  else if( ( sim->config.errorrate > 0.0 ) && ( (double)randFloat( &sim->randstate ) * 100.0 < sim->config.errorrate ) )
+  {
+    if( service == BS_SIM_SERVICE_BRICKLINK )
+      bsSimBrickLinkFail( &response, 500, "Internal Server Error", "INTERNAL_SERVER_ERROR", "Simulated server error." );
+    else
+      bsSimBrickOwlFail( &response, 500, "Internal Server Error", "Simulated server error" );
+    stats->errorcount++;
+  }
+  else
+  {
+    bsSimDispatch( sim, request, &response, endpoint, id );
+    if( response.code >= 400 )
+      stats->failcount++;
+  }
+
+  slink->requestcount++;
+  closeflag = request->closeflag;
+  if( ( sim->config.keepalive ) && ( slink->requestcount >= sim->config.keepalive ) )
+    closeflag = 1;
+  if( closeflag )
+    headersize = snprintf( header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", response.code, response.status, (int)response.body.offset );
+  else if( sim->config.keepalive )
+    headersize = snprintf( header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: Keep-Alive\r\nKeep-Alive: timeout=%d, max=%d\r\n\r\n", response.code, response.status, (int)response.body.offset, BS_SIM_LINK_TIMEOUT / 1000, sim->config.keepalive - slink->requestcount );
+  else
+    headersize = snprintf( header, sizeof(header), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: Keep-Alive\r\n\r\n", response.code, response.status, (int)response.body.offset );
+
+  reply = malloc( sizeof(bsSimReply) + headersize + response.body.offset );
+  reply->next = 0;
+  reply->closeflag = closeflag;
+  reply->size = headersize + response.body.offset;
+  reply->data = ADDRESS( reply, sizeof(bsSimReply) );
+  memcpy( reply->data, header, headersize );
+  memcpy( ADDRESS( reply->data, headersize ), response.body.data, response.body.offset );
+  stats->bytes += reply->size;
+  ccGrowthFree( &response.body );
+
+  /* Replies leave in order, a slow reply holds back the ones pipelined after it */
+  delay = (int64_t)sim->config.latency * 1000000;
+  if( sim->config.jitter )
+    delay += (int64_t)( randInt( &sim->randstate ) % ( (uint64_t)sim->config.jitter * 1000 + 1 ) ) * 1000;
+  delay += (int64_t)response.lotcount * (int64_t)sim->config.lotlatency * 1000;
+  readytime = CC_MAX( now + delay, slink->lastreadytime );
+  slink->lastreadytime = readytime;
+  reply->readytime = readytime;
+  if( slink->replylast )
+    slink->replylast->next = reply;
+  else
+    slink->replyfirst = reply;
+  slink->replylast = reply;
+  slink->pendingcount++;
+  if( closeflag )
+    slink->closeflag = 1;
+
+  if( sim->config.verboseflag )
+    printf( "%s %s%s%.*s -> %d, %d bytes, %d lots, %.3f ms\n", request->method, request->path, ( request->paramslength ? "?" : "" ), request->paramslength, ( request->params ? request->params : "" ), response.code, (int)reply->size, response.lotcount, (double)delay / 1000000.0 );
+
+  return 1;
+}
+
+/* Process the requests received while the pipeline has room, return zero if the link must be closed */
+static int bsSimLinkProcess( bsSim *sim, bsSimLink *slink, int64_t now )
+{
+  int result;
+  size_t requestsize;
+  bsSimRequest request;
+
+  while( !( slink->closeflag ) && ( slink->pendingcount < sim->config.pipeline ) )
+  {
+    result = bsSimParseRequest( slink, &request, &requestsize );
+    if( !( result ) )
+      break;
+    if( result < 0 )
+      return 0;
+    if( !( bsSimProcessRequest( sim, slink, &request, now ) ) )
+      return 0;
+    slink->recvsize -= requestsize;
+    memmove( slink->recvdata, &slink->recvdata[ requestsize ], slink->recvsize );
+    slink->recvdata[ slink->recvsize ] = 0;
+  }
+  return 1;
+}
+
+static void bsSimLinkFree( bsSim *sim, bsSimLink *slink )
+{
+  bsSimReply *reply, *next;
+
+  tcpClose( &sim->tcp, slink->link );
+  mmListRemove( slink, offsetof(bsSimLink,list) );
+  for( reply = slink->replyfirst ; reply ; reply = next )
+  {
+    next = reply->next;
+    free( reply );
+  }
+  free( slink->recvdata );
+  free( slink );
+  sim->linkcount--;
+  return;
+}
+
+/* Send the replies due, admit more requests, close the link when done ; return the time of the next reply due */
+static int64_t bsSimLinkUpdate( bsSim *sim, bsSimLink *slink, int64_t now )
+{
+  int sentcount;
+  tcpDataBuffer *sendbuf;
+  bsSimReply *reply;
+
+  /* Links closed by the peer are still released with tcpClose() */
+  if( slink->deadflag )
+  {
+    bsSimLinkFree( sim, slink );
+    return 0;
+  }
+  for( ; ; )
+  {
+    if( !( bsSimLinkProcess( sim, slink, now ) ) )
+    {
+      bsSimLinkFree( sim, slink );
+      return 0;
+    }
+    for( sentcount = 0 ; ( reply = slink->replyfirst ) && ( reply->readytime <= now ) ; sentcount++ )
+    {
+      sendbuf = tcpAllocSendBuffer( &sim->tcp, slink->link, reply->size );
+      memcpy( sendbuf->pointer, reply->data, reply->size );
+      tcpQueueSendBuffer( &sim->tcp, slink->link, sendbuf, reply->size );
+      slink->finishedflag = 0;
+      slink->replyfirst = reply->next;
+      if( !( slink->replyfirst ) )
+        slink->replylast = 0;
+      slink->pendingcount--;
+      free( reply );
+    }
+    if( !( sentcount ) )
+      break;
+  }
+  /* Close once the last reply has left */
+  if( ( slink->closeflag ) && !( slink->replyfirst ) && ( slink->finishedflag ) )
+  {
+    bsSimLinkFree( sim, slink );
+    return 0;
+  }
+  return ( slink->replyfirst ? slink->replyfirst->readytime : 0 );
+}
+
+
+////
+
+
+static void *bsSimIncoming( void *link, void *listenvalue )
+{
+  bsSim *sim;
+  bsSimLink *slink;
+
+  sim = listenvalue;
+  slink = calloc( 1, sizeof(bsSimLink) );
+  slink->sim = sim;
+  slink->link = link;
+  slink->recvalloc = 65536;
+  slink->recvdata = malloc( slink->recvalloc );
+  slink->recvdata[0] = 0;
+  mmListAdd( &sim->linklist, slink, offsetof(bsSimLink,list) );
+  sim->linkcount++;
+  sim->linktotal++;
+  tcpSetTimeout( &sim->tcp, link, BS_SIM_LINK_TIMEOUT );
+  return slink;
+}
+
+static void bsSimRecv( void *uservalue, tcpDataBuffer *recvbuf )
+{
+  bsSimLink *slink;
+
+  slink = uservalue;
+  if( slink->recvsize + recvbuf->size + 1 > slink->recvalloc )
+  {
+    slink->recvalloc = CC_MAX( slink->recvalloc << 1, slink->recvsize + recvbuf->size + 1 );
+    slink->recvdata = realloc( slink->recvdata, slink->recvalloc );
+  }
+  memcpy( &slink->recvdata[ slink->recvsize ], recvbuf->pointer, recvbuf->size );
+  slink->recvsize += recvbuf->size;
+  slink->recvdata[ slink->recvsize ] = 0;
+  tcpFreeRecvBuffer( &slink->sim->tcp, slink->link, recvbuf );
+  return;
+}
+
+static void bsSimSendReady( void *uservalue, size_t sendbuffered )
+{
+  return;
+}
+
+static void bsSimSendFinished( void *uservalue )
+{
+  bsSimLink *slink;
+  slink = uservalue;
+  slink->finishedflag = 1;
+  return;
+}
+
+static void bsSimTimeout( void *uservalue )
+{
+  bsSimLink *slink;
+  slink = uservalue;
+  slink->deadflag = 1;
+  return;
+}
+
+static void bsSimClosed( void *uservalue )
+{
+  bsSimLink *slink;
+  slink = uservalue;
+  slink->deadflag = 1;
+  return;
+}
+
+/* Links are only flagged from the callbacks, the main loop does all the work */
+static tcpCallbackSet bsSimIO =
+{
+  .incoming = bsSimIncoming,
+  .recv = bsSimRecv,
+  .sendready = bsSimSendReady,
+  .sendwait = 0,
+  .sendfinished = bsSimSendFinished,
+  .timeout = bsSimTimeout,
+  .closed = bsSimClosed,
+  .wake = 0
+};
+
+
+////
+
+
+/* A buyer takes a few random lots from one store */
+static void bsSimGenerateOrder( bsSim *sim, int service )
+{
+  int attemptindex, lotcount, quantity;
+  bsxInventory *inv;
+  bsxItem *item, *orderitem;
+  bsSimOrder *order;
+
+  inv = ( service == BS_SIM_SERVICE_BRICKLINK ? sim->blinv : sim->boinv );
+  if( !( inv->itemcount ) || ( inv->partcount <= 0 ) )
+    return;
+  if( sim->ordercount >= sim->orderalloc )
+  {
+    sim->orderalloc = CC_MAX( 64, sim->orderalloc << 1 );
+    sim->orderlist = realloc( sim->orderlist, sim->orderalloc * sizeof(bsSimOrder) );
+  }
+  order = &sim->orderlist[ sim->ordercount ];
+  order->service = service;
+  order->inv = bsxNewInventory();
+  lotcount = 1 + (int)( randInt( &sim->randstate ) % (uint64_t)sim->config.orderlots );
+  for( attemptindex = 0 ; ( attemptindex < 16 * lotcount ) && ( order->inv->itemcount < lotcount ) ; attemptindex++ )
+  {
+    item = &inv->itemlist[ randInt( &sim->randstate ) % (uint64_t)inv->itemcount ];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || ( item->quantity <= 0 ) )
+      continue;
+    if( ( service == BS_SIM_SERVICE_BRICKLINK ? bsxFindLotID( order->inv, item->lotid ) : bsxFindOwlLotID( order->inv, item->bolotid ) ) )
+      continue;
+    quantity = 1 + (int)( randInt( &sim->randstate ) % (uint64_t)CC_MIN( item->quantity, BS_SIM_ORDER_QUANTITY_MAX ) );
+    orderitem = bsxAddCopyItem( order->inv, item );
+    bsxSetItemQuantity( order->inv, orderitem, quantity );
+    bsxSetItemQuantity( inv, item, item->quantity - quantity );
+    if( ( service == BS_SIM_SERVICE_BRICKLINK ) && ( item->quantity <= 0 ) && !( item->stockflags & BSX_ITEM_STOCKFLAGS_RETAIN ) )
+      bsSimBrickLinkRemoveLot( sim, item );
+  }
+  if( !( order->inv->itemcount ) )
+  {
+    bsxFreeInventory( order->inv );
+    return;
+  }
+  order->id = sim->ordernext[ service ]++;
+  order->date = (int64_t)time( 0 );
+  sim->ordercount++;
+  printf( "Generated %s order #" CC_LLD ", %d lots, %d parts, %.2f " BS_SIM_CURRENCY "\n", bsSimServiceName[ service ], (long long)order->id, order->inv->itemcount, order->inv->partcount, order->inv->totalprice );
+  fflush( stdout );
+  return;
+}
+
+
+////
+
+
+static int bsSimLoadInventory( bsSim *sim, char *path )
+{
+  int itemindex;
+  int64_t lotidmax;
+  bsxInventory *inv;
+  bsxItem *item, *boitem;
+
+  inv = bsxNewInventory();
+  if( !( bsxLoadInventory( inv, path ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to load inventory at %s\n", path );
+    bsxFreeInventory( inv );
+    return 0;
+  }
+  lotidmax = BS_SIM_BRICKLINK_LOTID_BASE - 1;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+    lotidmax = CC_MAX( lotidmax, inv->itemlist[ itemindex ].lotid );
+  sim->bllotnext = lotidmax + 1;
+
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[ itemindex ];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || ( item->quantity <= 0 ) || !( item->id ) || !( item->typeid ) )
+      continue;
+    if( ( item->lotid == -1 ) || ( bsSimLotFind( sim->bllottable, sim->blinv, item->lotid ) ) )
+      item->lotid = sim->bllotnext++;
+    item->boid = bsSimCatalogLookup( sim, item->typeid, item->id, item->name );
+    item->bolotid = -1;
+    bsxAddCopyItem( sim->blinv, item );
+    bsSimLotAdd( &sim->bllottable, item->lotid, sim->blinv->itemcount - 1 );
+    /* BrickSync never uploads lots of colors unknown to BrickOwl */
+    if( ( sim->config.boemptyflag ) || ( bsTranslateColorBl2Bo( item->colorid ) == -1 ) )
+      continue;
+    boitem = bsxAddCopyItem( sim->boinv, item );
+    boitem->bolotid = sim->bolotnext++;
+    bsSimLotAdd( &sim->bolottable, boitem->bolotid, sim->boinv->itemcount - 1 );
+    bsSimLotAdd( &sim->boexttable, boitem->lotid, sim->boinv->itemcount - 1 );
+  }
+  bsxFreeInventory( inv );
+
+  return 1;
+}
+
+static void bsSimSaveInventory( bsSim *sim, char *prefix, char *suffix, bsxInventory *inv )
+{
+  char *path;
+  path = ccStrAllocPrintf( "%s-%s.bsx", prefix, suffix );
+  if( !( bsxSaveInventory( path, inv, 0, -1 ) ) )
+    fprintf( stderr, "ERROR: Failed to save inventory at %s\n", path );
+  else
+    printf( "Saved %d lots, %d parts in %s\n", inv->itemcount - inv->itemfreecount, inv->partcount, path );
+  free( path );
+  return;
+}
+
+static void bsSimPrintStats( bsSim *sim )
+{
+  int endpoint;
+  double seconds;
+  bsSimStats *stats, total;
+
+  seconds = (double)( ccGetNanosecondsTime() - sim->starttime ) / 1000000000.0;
+  memset( &total, 0, sizeof(bsSimStats) );
+  printf( "\n%-22s %10s %8s %8s %8s %8s %14s\n", "endpoint", "requests", "failed", "errors", "limited", "dropped", "bytes" );
+  for( endpoint = 0 ; endpoint < BS_SIM_ENDPOINT_COUNT ; endpoint++ )
+  {
+    stats = &sim->stats[ endpoint ];
+    total.count += stats->count;
+    total.failcount += stats->failcount;
+    total.errorcount += stats->errorcount;
+    total.limitcount += stats->limitcount;
+    total.dropcount += stats->dropcount;
+    total.bytes += stats->bytes;
+    if( !( stats->count ) )
+      continue;
+    printf( "%-22s %10lld %8lld %8lld %8lld %8lld %14lld\n", bsSimEndpointName[ endpoint ], (long long)stats->count, (long long)stats->failcount, (long long)stats->errorcount, (long long)stats->limitcount, (long long)stats->dropcount, (long long)stats->bytes );
+  }
+  printf( "%-22s %10lld %8lld %8lld %8lld %8lld %14lld\n", "total", (long long)total.count, (long long)total.failcount, (long long)total.errorcount, (long long)total.limitcount, (long long)total.dropcount, (long long)total.bytes );
+  printf( "%.1f seconds, %.1f requests/s, " CC_LLD " connections, %d orders\n", seconds, ( seconds > 0.0 ? (double)total.count / seconds : 0.0 ), (long long)sim->linktotal, sim->ordercount );
+  printf( "BrickLink store : %d lots, %d parts ; BrickOwl store : %d lots, %d parts\n", sim->blinv->itemcount - sim->blinv->itemfreecount, sim->blinv->partcount, sim->boinv->itemcount - sim->boinv->itemfreecount, sim->boinv->partcount );
+  return;
+}
+
+
+////
+
+
+static void bsSimSignal( int signum )
+{
+  bsSimQuitFlag = 1;
+  return;
+}
+
+static void bsSimUsage( char *progname )
+{
+  fprintf( stderr, "Usage: %s [options]\n", progname );
+  fprintf( stderr, "  -port N          Port to listen on (default %d)\n", BS_SIM_DEFAULT_PORT );
+  fprintf( stderr, "  -inv PATH        Initial inventory of both stores, in BrickStore .bsx format\n" );
+  fprintf( stderr, "  -boempty 1       Start with an empty BrickOwl store\n" );
+  fprintf( stderr, "  -latency MS      Latency of every reply (default 0)\n" );
+  fprintf( stderr, "  -jitter MS       Random latency added to every reply (default 0)\n" );
+  fprintf( stderr, "  -lotlatency US   Latency per lot listed by inventory replies (default 0)\n" );
+  fprintf( stderr, "  -pipeline N      Requests of a connection processed concurrently (default 8)\n" );
+  fprintf( stderr, "  -keepalive N     Close connections after N requests, zero for never (default 0)\n" );
+  fprintf( stderr, "  -errorrate PCT   Percentage of requests failing with a 500 error (default 0)\n" );
+  fprintf( stderr, "  -droprate PCT    Percentage of requests dropping the connection (default 0)\n" );
+  fprintf( stderr, "  -ratelimit N     Requests per second accepted by each service, zero for no limit (default 0)\n" );
+  fprintf( stderr, "  -orderinterval S Generate an order every S seconds, alternating between stores (default 0)\n" );
+  fprintf( stderr, "  -orderlots N     Maximum count of lots per generated order (default 5)\n" );
+  fprintf( stderr, "  -duration S      Exit after S seconds, zero to run until interrupted (default 0)\n" );
+  fprintf( stderr, "  -save PREFIX     Save both stores as PREFIX-bricklink.bsx and PREFIX-brickowl.bsx on exit\n" );
+  fprintf( stderr, "  -seed N          Seed of the random generator (default 1)\n" );
+  fprintf( stderr, "  -verbose 1       Print every request\n" );
+  return;
+}
+
+static int bsSimParseArgs( bsSimConfig *config, int argc, char **argv )
+{
+  int argindex;
+  int32_t readint;
+  int64_t readint64;
+  double readdouble;
+  char *arg, *value;
+
+  for( argindex = 1 ; argindex < argc ; argindex++ )
+  {
+    arg = argv[ argindex ];
+    if( argindex + 1 >= argc )
+      return 0;
+    value = argv[ ++argindex ];
+    if( !( strcmp( arg, "-inv" ) ) )
+      config->invpath = value;
+    else if( !( strcmp( arg, "-save" ) ) )
+      config->saveprefix = value;
+    else if( !( strcmp( arg, "-seed" ) ) )
+    {
+      if( !( ccStrParseInt64( value, &readint64 ) ) )
+        return 0;
+      config->seed = (uint64_t)readint64;
+    }
+    else if( !( strcmp( arg, "-errorrate" ) ) || !( strcmp( arg, "-droprate" ) ) )
+    {
+      if( !( ccStrParseDouble( value, &readdouble ) ) || ( readdouble < 0.0 ) || ( readdouble > 100.0 ) )
+        return 0;
+      if( !( strcmp( arg, "-errorrate" ) ) )
+        config->errorrate = readdouble;
+      else
+        config->droprate = readdouble;
+    }
+    else
+    {
+      if( !( ccStrParseInt32( value, &readint ) ) || ( readint < 0 ) )
+        return 0;
+      if( !( strcmp( arg, "-port" ) ) )
+        config->port = (int)readint;
+      else if( !( strcmp( arg, "-boempty" ) ) )
+        config->boemptyflag = (int)readint;
+      else if( !( strcmp( arg, "-latency" ) ) )
+        config->latency = (int)readint;
+      else if( !( strcmp( arg, "-jitter" ) ) )
+        config->jitter = (int)readint;
+      else if( !( strcmp( arg, "-lotlatency" ) ) )
+        config->lotlatency = (int)readint;
+      else if( !( strcmp( arg, "-pipeline" ) ) )
+        config->pipeline = CC_MAX( (int)readint, 1 );
+      else if( !( strcmp( arg, "-keepalive" ) ) )
+        config->keepalive = (int)readint;
+      else if( !( strcmp( arg, "-ratelimit" ) ) )
+        config->ratelimit = (int)readint;
+      else if( !( strcmp( arg, "-orderinterval" ) ) )
+        config->orderinterval = (int)readint;
+      else if( !( strcmp( arg, "-orderlots" ) ) )
+        config->orderlots = CC_MAX( (int)readint, 1 );
+      else if( !( strcmp( arg, "-duration" ) ) )
+        config->duration = (int)readint;
+      else if( !( strcmp( arg, "-verbose" ) ) )
+        config->verboseflag = (int)readint;
+      else
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+int main( int argc, char **argv )
+{
+  int service;
+  int64_t now, nexttime, readytime, waittime;
+  bsSim *sim;
+  bsSimLink *slink, *slinknext;
+
+  sim = calloc( 1, sizeof(bsSim) );
+  sim->config.port = BS_SIM_DEFAULT_PORT;
+  sim->config.pipeline = 8;
+  sim->config.orderlots = 5;
+  sim->config.seed = 1;
+  if( !( bsSimParseArgs( &sim->config, argc, argv ) ) )
+  {
+    bsSimUsage( argv[0] );
+    return 1;
+  }
+
+  mmInit();
+  randSeed( &sim->randstate, sim->config.seed );
+  sim->bllottable = bsSimHashCreate( &bsSimLotHashAccess, sizeof(bsSimLotEntry) );
+  sim->bolottable = bsSimHashCreate( &bsSimLotHashAccess, sizeof(bsSimLotEntry) );
+  sim->boexttable = bsSimHashCreate( &bsSimLotHashAccess, sizeof(bsSimLotEntry) );
+  sim->catalogtable = bsSimHashCreate( &bsSimCatalogHashAccess, sizeof(bsSimCatalogEntry) );
+  sim->blinv = bsxNewInventory();
+  sim->boinv = bsxNewInventory();
+  sim->bllotnext = BS_SIM_BRICKLINK_LOTID_BASE;
+  sim->bolotnext = BS_SIM_BRICKOWL_LOTID_BASE;
+  sim->ordernext[ BS_SIM_SERVICE_BRICKLINK ] = BS_SIM_BRICKLINK_ORDERID_BASE;
+  sim->ordernext[ BS_SIM_SERVICE_BRICKOWL ] = BS_SIM_BRICKOWL_ORDERID_BASE;
+  if( ( sim->config.invpath ) && !( bsSimLoadInventory( sim, sim->config.invpath ) ) )
+    return 1;
+
+  if( !( tcpInit( &sim->tcp, 1, 0 ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to initialize TCP\n" );
+    return 1;
+  }
+  if( !( sim->listenlink = tcpListen( &sim->tcp, 0, sim->config.port, sim, &bsSimIO, 0 ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to listen on port %d\n", sim->config.port );
+    tcpEnd( &sim->tcp );
+    return 1;
+  }
+  signal( SIGINT, bsSimSignal );
+  signal( SIGTERM, bsSimSignal );
+
+  printf( "Simulating the BrickLink and BrickOwl APIs on port %d\n", sim->config.port );
+  printf( "BrickLink store : %d lots, %d parts ; BrickOwl store : %d lots, %d parts\n", sim->blinv->itemcount, sim->blinv->partcount, sim->boinv->itemcount, sim->boinv->partcount );
+  fflush( stdout );
+
+  sim->starttime = ccGetNanosecondsTime();
+  for( service = 0 ; service < BS_SIM_SERVICE_COUNT ; service++ )
+  {
+    sim->bucket[ service ].tokens = (double)sim->config.ratelimit;
+    sim->bucket[ service ].lasttime = sim->starttime;
+  }
+  sim->ordertime = sim->starttime + (int64_t)sim->config.orderinterval * 1000000000;
+  while( !( bsSimQuitFlag ) )
+  {
+    now = ccGetNanosecondsTime();
+    if( ( sim->config.duration ) && ( ( now - sim->starttime ) >= (int64_t)sim->config.duration * 1000000000 ) )
+      break;
+    if( ( sim->config.orderinterval ) && ( now >= sim->ordertime ) )
+    {
+      bsSimGenerateOrder( sim, sim->orderservice );
+      sim->orderservice ^= 1;
+      sim->ordertime += (int64_t)sim->config.orderinterval * 1000000000;
+    }
+    nexttime = now + 100000000;
+    for( slink = sim->linklist ; slink ; slink = slinknext )
+    {
+      slinknext = slink->list.next;
+      readytime = bsSimLinkUpdate( sim, slink, now );
+      if( readytime )
+        nexttime = CC_MIN( nexttime, readytime );
+    }
+    waittime = ( nexttime - now ) / 1000000;
+    tcpWait( &sim->tcp, (long)CC_MAX( waittime, 1 ) );
+  }
+
+  bsSimPrintStats( sim );
+  if( sim->config.saveprefix )
+  {
+    bsSimSaveInventory( sim, sim->config.saveprefix, "bricklink", sim->blinv );
+    bsSimSaveInventory( sim, sim->config.saveprefix, "brickowl", sim->boinv );
+  }
+
+  while( sim->linklist )
+    bsSimLinkFree( sim, sim->linklist );
+  tcpClose( &sim->tcp, sim->listenlink );
+  tcpEnd( &sim->tcp );
+
+  return 0;
+}
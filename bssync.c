@@ -171,47 +171,47 @@ void bsSyncAddDeltaItem( bsContext *context, bsxInventory *deltainv, bsxItem *st
   if( item->quantity != stockitem->quantity )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_QUANTITY;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Adjust quantity by %+d%s\n", stockitem->quantity - item->quantity, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Adjust quantity by %+d%s\n", stockitem->quantity - item->quantity, itemstringbuffer );
     if( ( context->retainemptylotsflag ) && !( stockitem->quantity ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_STOCKROOM;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Move to Stockroom%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Move to Stockroom%s\n", itemstringbuffer );
     }
   }
   if( !( bsInvPriceEqual( item->price, stockitem->price ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_PRICE;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Price from %.3f to %.3f%s\n", item->price, stockitem->price, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Price from %.3f to %.3f%s\n", item->price, stockitem->price, itemstringbuffer );
   }
   if( !( ccStrCmpEqualTest( item->comments, stockitem->comments ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_COMMENTS;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Comments from \"%s\" to \"%s\"%s\n", item->comments, stockitem->comments, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Comments from \"%s\" to \"%s\"%s\n", item->comments, stockitem->comments, itemstringbuffer );
   }
   if( !( ccStrCmpEqualTest( item->remarks, stockitem->remarks ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_REMARKS;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Remarks from \"%s\" to \"%s\"%s\n", item->remarks, stockitem->remarks, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Remarks from \"%s\" to \"%s\"%s\n", item->remarks, stockitem->remarks, itemstringbuffer );
   }
   if( ( item->bulk != stockitem->bulk ) && ( ( item->bulk >= 2 ) || ( stockitem->bulk >= 2 ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_BULK;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Bulk Quantity from %d to %d%s\n", item->bulk, stockitem->bulk, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set Bulk Quantity from %d to %d%s\n", item->bulk, stockitem->bulk, itemstringbuffer );
   }
   if( ( stockitem->mycost > 0.0001 ) && !( bsInvPriceEqual( item->mycost, stockitem->mycost ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_MYCOST;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set MyCost from %.3f to %.3f%s\n", item->mycost, stockitem->mycost, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set MyCost from %.3f to %.3f%s\n", item->mycost, stockitem->mycost, itemstringbuffer );
   }
   if( ( deltamode == BS_SYNC_DELTA_MODE_BRICKOWL ) && ( stockitem->usedgrade ) && ( item->usedgrade != stockitem->usedgrade ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_USEDGRADE;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set UsedGrade from %c to %c%s\n", item->usedgrade, stockitem->usedgrade, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set UsedGrade from %c to %c%s\n", item->usedgrade, stockitem->usedgrade, itemstringbuffer );
   }
   if( !( bsInvItemTierEqual( item, stockitem ) ) )
   {
     updateflags |= BSX_ITEM_XFLAGS_UPDATE_TIERPRICES;
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set TierPrices from [[%d,%.3f],[%d,%.3f],[%d,%.3f]] to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]%s\n", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3, stockitem->tq1, stockitem->tp1, stockitem->tq2, stockitem->tp2, stockitem->tq3, stockitem->tp3, itemstringbuffer );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set TierPrices from [[%d,%.3f],[%d,%.3f],[%d,%.3f]] to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]%s\n", item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3, stockitem->tq1, stockitem->tp1, stockitem->tq2, stockitem->tp2, stockitem->tq3, stockitem->tp3, itemstringbuffer );
   }
 
 
@@ -279,7 +279,9 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
 
   DEBUG_SET_TRACKER();
 
+  itemstringbuffer[0] = 0;
   memset( stats, 0, sizeof(bsSyncStats) );
+  /* Not an arena inventory, kept as diffinv and added to until the next update */
   deltainv = bsxNewInventory();
   mmBitMapInit( &stockmap, stockinv->itemcount, 0 );
   for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
@@ -288,14 +290,15 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
     if( item->flags & BSX_ITEM_FLAGS_DELETED )
       continue;
 
-    bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
+    if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE ) )
+      bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
 
     /* Skip items flagged by '~' */
     if( bsInvItemFilterFlag( context, item ) )
     {
       stats->skipflag_partcount += item->quantity;
       stats->skipflag_lotcount++;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip item filtered out by '~'%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip item filtered out by '~'%s\n", itemstringbuffer );
       continue;
     }
 
@@ -303,7 +306,7 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
     if( !( item->quantity ) )
     {
 #if 0
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip zero quantity item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip zero quantity item%s\n", itemstringbuffer );
 #endif
       continue;
     }
@@ -313,7 +316,7 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
     {
       stats->skipunknown_partcount += item->quantity;
       stats->skipunknown_lotcount++;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip unknown item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip unknown item%s\n", itemstringbuffer );
       continue;
     }
 
@@ -352,7 +355,7 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
         deltaitem->flags |= BSX_ITEM_XFLAGS_TO_DELETE;
       stats->deleteorphan_partcount += item->quantity;
       stats->deleteorphan_lotcount++;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Delete orphan item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Delete orphan item%s\n", itemstringbuffer );
       continue;
     }
 
@@ -372,7 +375,7 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
         deltaitem->flags |= BSX_ITEM_XFLAGS_TO_DELETE;
       stats->deleteduplicate_partcount += item->quantity;
       stats->deleteduplicate_lotcount++;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Delete duplicate BLID item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Delete duplicate BLID item%s\n", itemstringbuffer );
       continue;
     }
 
@@ -395,7 +398,8 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
       stockitem = &stockinv->itemlist[ itemindex ];
       if( stockitem->flags & BSX_ITEM_FLAGS_DELETED )
         continue;
-      bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), stockitem );
+      if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE ) )
+        bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), stockitem );
 
       /* Ensure stockitem has unique ExtID */
       if( stockitem->extid == -1 )
@@ -405,14 +409,14 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
       {
         stats->skipunknown_partcount += stockitem->quantity;
         stats->skipunknown_lotcount++;
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip unknown item%s\n", itemstringbuffer );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip unknown item%s\n", itemstringbuffer );
         continue;
       }
 
       if( stockitem->quantity == 0 )
       {
 #if 0
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip zero quantity item%s\n", itemstringbuffer );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skip zero quantity item%s\n", itemstringbuffer );
 #endif
         continue;
       }
@@ -426,7 +430,7 @@ bsxInventory *bsSyncComputeDeltaInv( bsContext *context, bsxInventory *stockinv,
         bsSyncAddDeltaItem( context, deltainv, stockitem, item, itemstringbuffer, stats, deltamode );
       else
       {
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Create new item%s\n", itemstringbuffer );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Create new item%s\n", itemstringbuffer );
         stats->missing_partcount += stockitem->quantity;
         stats->missing_lotcount++;
         deltaitem = bsxAddCopyItem( deltainv, stockitem );
@@ -450,10 +454,12 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
   bsxItem *item, *stockitem, *deltaitem;
   bsxInventory *stockinv;
   char itemstringbuffer[512];
+  debugProfileScope profile;
 
-  DEBUG_SET_TRACKER();
+  DEBUG_PROFILE_BEGIN( &profile, "merge" );
 
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Listing all changes from merging inventory.\n" );
+  itemstringbuffer[0] = 0;
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Listing all changes from merging inventory.\n" );
 
   memset( stats, 0, sizeof(bsMergeInvStats) );
   stockinv = context->inventory;
@@ -465,7 +471,8 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
     if( item->quantity == 0 )
       continue;
 
-    bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
+    if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE ) )
+      bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
 
     stockitem = 0;
     if( item->bolotid >= 0 )
@@ -487,7 +494,12 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
       {
         if( stockitem->quantity < 0 )
         {
-          ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_WARNING "Negative quantity clamped to zero%s\n", itemstringbuffer );
+          if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_WARNING ) )
+          {
+            /* The item string is only built up front at the verbose level, warnings need it too */
+            bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
+            ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_WARNING "Negative quantity clamped to zero%s\n", itemstringbuffer );
+          }
           /* Don't try to remove more items than there are, in case lots are retained */
           bsxSetItemQuantity( inv, item, item->quantity - stockitem->quantity );
           bsxSetItemQuantity( stockinv, stockitem, 0 );
@@ -499,7 +511,7 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
 
       if( !( deleteflag ) )
       {
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Adjust quantity by %+d%s\n", item->quantity, itemstringbuffer );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Adjust quantity by %+d%s\n", item->quantity, itemstringbuffer );
         /* Add item to BrickLink update queue */
         if( mergeflags & BS_MERGE_FLAGS_UPDATE_BRICKLINK )
         {
@@ -532,7 +544,7 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
       }
       else
       {
-        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Deleting item with zero quantity%s\n", itemstringbuffer );
+        IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Deleting item with zero quantity%s\n", itemstringbuffer );
         /* Add item to BrickLink delete queue */
         if( mergeflags & BS_MERGE_FLAGS_UPDATE_BRICKLINK )
         {
@@ -580,17 +592,24 @@ int bsMergeInv( bsContext *context, bsxInventory *inv, bsMergeInvStats *stats, i
           deltaitem = bsxAddCopyItem( context->brickowl.diffinv, stockitem );
           deltaitem->flags |= BSX_ITEM_XFLAGS_TO_CREATE;
         }
-        else
+        else if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_WARNING ) )
+        {
+          bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
           ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_WARNING "Unknown BOID%s\n", itemstringbuffer );
+        }
       }
       /* Increment stats */
       stats->create_partcount += item->quantity;
       stats->create_lotcount++;
     }
-    else if( item->quantity < 0 )
+    else if( ( item->quantity < 0 ) && IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_WARNING ) )
+    {
+      bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
       ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_WARNING "Rejected negative quantity for new lot%s\n", itemstringbuffer );
+    }
   }
 
+  DEBUG_PROFILE_END( &profile );
   return 1;
 }
 
@@ -607,7 +626,8 @@ int bsMergeLoad( bsContext *context, bsxInventory *inv, bsMergeUpdateStats *stat
 
   DEBUG_SET_TRACKER();
 
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Listing all changes from merging inventory.\n" );
+  itemstringbuffer[0] = 0;
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Listing all changes from merging inventory.\n" );
 
   memset( stats, 0, sizeof(bsMergeUpdateStats) );
   stockinv = context->inventory;
@@ -617,7 +637,8 @@ int bsMergeLoad( bsContext *context, bsxInventory *inv, bsMergeUpdateStats *stat
     if( item->flags & BSX_ITEM_FLAGS_DELETED )
       continue;
 
-    bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
+    if( IO_LOG_ENABLED( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE ) )
+      bsSyncLogItemString( itemstringbuffer, sizeof(itemstringbuffer), item );
 
     stockitem = 0;
     if( item->lotid >= 0 )
@@ -626,7 +647,7 @@ int bsMergeLoad( bsContext *context, bsxInventory *inv, bsMergeUpdateStats *stat
       stockitem = bsxFindMatchItem( stockinv, item );
     if( !( stockitem ) )
     {
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Ignoring absent item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Ignoring absent item%s\n", itemstringbuffer );
       stats->missing_partcount += item->quantity;
       stats->missing_lotcount++;
       continue;
@@ -636,37 +657,37 @@ int bsMergeLoad( bsContext *context, bsxInventory *inv, bsMergeUpdateStats *stat
     if( ( mergeflags & BS_MERGE_FLAGS_PRICE ) && !( bsInvPriceEqual( item->price, stockitem->price ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_PRICE;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set price from %.3f to %.3f for item%s\n", stockitem->price, item->price, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set price from %.3f to %.3f for item%s\n", stockitem->price, item->price, itemstringbuffer );
     }
     if( ( mergeflags & BS_MERGE_FLAGS_COMMENTS ) && !( ccStrCmpEqualTest( item->comments, stockitem->comments ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_COMMENTS;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set comments from \"%s\" to \"%s\"%s\n", stockitem->comments, item->comments, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set comments from \"%s\" to \"%s\"%s\n", stockitem->comments, item->comments, itemstringbuffer );
     }
     if( ( mergeflags & BS_MERGE_FLAGS_REMARKS ) && !( ccStrCmpEqualTest( item->remarks, stockitem->remarks ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_REMARKS;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set remarks from \"%s\" to \"%s\"%s\n", stockitem->remarks, item->remarks, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set remarks from \"%s\" to \"%s\"%s\n", stockitem->remarks, item->remarks, itemstringbuffer );
     }
     if( ( mergeflags & BS_MERGE_FLAGS_BULK ) && ( item->bulk != stockitem->bulk ) && ( ( item->bulk >= 2 ) || ( stockitem->bulk >= 2 ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_BULK;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set bulk quantity from %d to %d%s\n", stockitem->bulk, item->bulk, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set bulk quantity from %d to %d%s\n", stockitem->bulk, item->bulk, itemstringbuffer );
     }
     if( ( mergeflags & BS_MERGE_FLAGS_MYCOST ) && ( item->mycost > 0.0001 ) && !( bsInvPriceEqual( item->mycost, stockitem->mycost ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_MYCOST;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set mycost from %.3f to %.3f%s\n", stockitem->mycost, item->mycost, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set mycost from %.3f to %.3f%s\n", stockitem->mycost, item->mycost, itemstringbuffer );
     }
     if( ( mergeflags & BS_MERGE_FLAGS_TIERPRICES ) && !( bsInvItemTierEqual( item, stockitem ) ) )
     {
       updateflags |= BSX_ITEM_XFLAGS_UPDATE_TIERPRICES;
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set TierPrices from [[%d,%.3f],[%d,%.3f],[%d,%.3f]] to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]%s\n", stockitem->tq1, stockitem->tp1, stockitem->tq2, stockitem->tp2, stockitem->tq3, stockitem->tp3, item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3, itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Set TierPrices from [[%d,%.3f],[%d,%.3f],[%d,%.3f]] to [[%d,%.3f],[%d,%.3f],[%d,%.3f]]%s\n", stockitem->tq1, stockitem->tp1, stockitem->tq2, stockitem->tp2, stockitem->tq3, stockitem->tp3, item->tq1, item->tp1, item->tq2, item->tp2, item->tq3, item->tp3, itemstringbuffer );
     }
 
     if( !( updateflags ) )
     {
-      ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skipping non-updated fields for item%s\n", itemstringbuffer );
+      IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skipping non-updated fields for item%s\n", itemstringbuffer );
       stats->match_partcount += stockitem->quantity;
       stats->match_lotcount++;
       continue;
@@ -741,7 +762,7 @@ int bsSyncBrickLink( bsContext *context, bsSyncStats *stats )
   if( ordertopdate >= context->bricklink.ordertopdate )
   {
     /* A new order has arrived! ABORT! ABORT!! */
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "INFO: BrickLink SYNC has been interrupted, new orders have to be processed.\n" );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_INFO, IO_MODEBIT_LOGONLY, "INFO: BrickLink SYNC has been interrupted, new orders have to be processed.\n" );
     context->stateflags |= BS_STATE_FLAGS_BRICKLINK_MUST_CHECK;
     bsxFreeInventory( inv );
     return 0;
@@ -753,7 +774,7 @@ int bsSyncBrickLink( bsContext *context, bsSyncStats *stats )
 
   /* Set the new deltainv, ready for an update */
   bsxFreeInventory( context->bricklink.diffinv );
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Listing all changes to be pushed to BrickLink.\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Listing all changes to be pushed to BrickLink.\n" );
   context->bricklink.diffinv = bsSyncComputeDeltaInv( context, context->inventory, inv, stats, BS_SYNC_DELTA_MODE_BRICKLINK );
   bsxFreeInventory( inv );
   return 1;
@@ -786,7 +807,7 @@ int bsSyncBrickOwl( bsContext *context, bsSyncStats *stats )
   if( ordertopdate >= context->brickowl.ordertopdate )
   {
     /* A new order has arrived! ABORT! ABORT!! */
-    ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "INFO: BrickOwl SYNC has been interrupted, new orders have to be processed.\n" );
+    IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_INFO, IO_MODEBIT_LOGONLY, "INFO: BrickOwl SYNC has been interrupted, new orders have to be processed.\n" );
     context->stateflags |= BS_STATE_FLAGS_BRICKOWL_MUST_CHECK;
     bsxFreeInventory( inv );
     return 0;
@@ -798,7 +819,7 @@ int bsSyncBrickOwl( bsContext *context, bsSyncStats *stats )
 
   /* Set the new deltainv, ready for an update */
   bsxFreeInventory( context->brickowl.diffinv );
-  ioPrintf( &context->output, IO_MODEBIT_LOGONLY, "LOG: Listing all changes to be pushed to BrickOwl.\n" );
+  IO_LOG_PRINTF( &context->output, IO_LOG_CATEGORY_SYNC, IO_LOG_LEVEL_VERBOSE, IO_MODEBIT_LOGONLY, "LOG: Listing all changes to be pushed to BrickOwl.\n" );
   context->brickowl.diffinv = bsSyncComputeDeltaInv( context, context->inventory, inv, stats, BS_SYNC_DELTA_MODE_BRICKOWL );
   bsxFreeInventory( inv );
   return 1;
@@ -69,6 +69,25 @@ typedef struct
 } translationStorage __attribute__ ((aligned(8)));
 
 
+#define TRANSLATION_INDEX_MAGIC (0x58444954)
+#define TRANSLATION_INDEX_VERSION (2)
+
+/* Index file header, followed by the BLID and BOID open-addressing tables of 1<<hashbits elements each */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t elementsize;
+  uint32_t hashbits;
+  /* Count of storage records covered by the index */
+  int32_t storagecount;
+  /* Rolling checksum of all storage records covered, detects a rewritten storage file */
+  uint32_t storagechecksum;
+  int32_t entrycount;
+  int32_t reserved[9];
+} translationIndexHeader __attribute__ ((aligned(8)));
+
+
 ////
 
 
@@ -223,9 +242,9 @@ static void *translationGrowHashTable( void *hashtable, mmHashAccess *access )
   {
     hashbits++;
     hashsize = mmHashRequiredSize( sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
-    newtable = malloc( hashsize );
+    newtable = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, hashsize );
     mmHashResize( newtable, hashtable, access, hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
-    free( hashtable );
+    mmAccountFree( MM_ACCOUNT_TRANSLATION, hashtable );
     hashtable = newtable;
   }
 
@@ -283,54 +302,431 @@ static int translationAddEntry( translationTable *table, translationElement *ref
 ////
 
 
-int translationTableInit( translationTable *table, const char *path )
+static inline uint32_t translationIndexKeyBlid( translationElement *element )
 {
-  int storageoffset;
-  int hashbits;
-  size_t hashsize;
-  void *filedata;
-  size_t filesize;
-  translationStorage *storage;
+  return ccHash32Data( (void *)element->blpack, TRANSLATION_BLPACK_LENGTH );
+}
+
+static inline uint32_t translationIndexKeyBoid( int64_t boid )
+{
+  return ccHash32Int64Inline( (uint64_t)boid );
+}
+
+/* Insert or replace element in the BLID open-addressing table, return 1 if the BLID was new */
+static int translationIndexInsertBlid( translationElement *blidtable, uint32_t hashmask, translationElement *element )
+{
+  int newflag;
+  uint32_t hashindex;
+  translationElement *slot;
+
+  newflag = 0;
+  for( hashindex = translationIndexKeyBlid( element ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+  {
+    slot = &blidtable[hashindex];
+    if( !( slot->blpack[0] ) )
+    {
+      newflag = 1;
+      break;
+    }
+    if( ccMemCmpInline( slot->blpack, element->blpack, TRANSLATION_BLPACK_LENGTH ) )
+      break;
+  }
+  *slot = *element;
+  return newflag;
+}
+
+/* Insert or replace element in the BOID open-addressing table */
+static void translationIndexInsertBoid( translationElement *boidtable, uint32_t hashmask, translationElement *element )
+{
+  uint32_t hashindex;
+  translationElement *slot;
+
+  for( hashindex = translationIndexKeyBoid( element->boid ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+  {
+    slot = &boidtable[hashindex];
+    if( !( slot->blpack[0] ) || ( slot->boid == element->boid ) )
+      break;
+  }
+  *slot = *element;
+  return;
+}
+
+/* Insert or replace element in both open-addressing tables, return 1 if the BLID was new */
+static int translationIndexInsert( translationElement *blidtable, translationElement *boidtable, uint32_t hashmask, translationElement *element )
+{
+  translationIndexInsertBoid( boidtable, hashmask, element );
+  return translationIndexInsertBlid( blidtable, hashmask, element );
+}
+
+static translationElement *translationIndexFindBlid( translationTable *table, translationElement *refelement )
+{
+  uint32_t hashindex;
+  translationElement *blidtable, *slot;
+
+  if( !( blidtable = table->indexblid ) )
+    return 0;
+  for( hashindex = translationIndexKeyBlid( refelement ) & table->indexhashmask ; ; hashindex = ( hashindex + 1 ) & table->indexhashmask )
+  {
+    slot = &blidtable[hashindex];
+    if( !( slot->blpack[0] ) )
+      return 0;
+    if( ccMemCmpInline( slot->blpack, refelement->blpack, TRANSLATION_BLPACK_LENGTH ) )
+      return slot;
+  }
+  return 0;
+}
+
+static translationElement *translationIndexFindBoid( translationTable *table, int64_t boid )
+{
+  uint32_t hashindex;
+  translationElement *boidtable, *slot;
+
+  if( !( boidtable = table->indexboid ) )
+    return 0;
+  for( hashindex = translationIndexKeyBoid( boid ) & table->indexhashmask ; ; hashindex = ( hashindex + 1 ) & table->indexhashmask )
+  {
+    slot = &boidtable[hashindex];
+    if( !( slot->blpack[0] ) )
+      return 0;
+    if( slot->boid == boid )
+      return slot;
+  }
+  return 0;
+}
+
+
+static void translationIndexSetTables( translationTable *table, void *indexdata )
+{
+  translationIndexHeader *header;
+  header = (translationIndexHeader *)indexdata;
+  table->indexhashmask = ( 1 << header->hashbits ) - 1;
+  table->indexblid = ADDRESS( indexdata, sizeof(translationIndexHeader) );
+  table->indexboid = ADDRESS( table->indexblid, ( (size_t)1 << header->hashbits ) * sizeof(translationElement) );
+  return;
+}
+
+
+static inline int translationStorageValid( translationStorage *storage )
+{
+  if( storage->element.boid <= 0 )
+    return 0;
+  if( !( storage->element.blpack[0] ) )
+    return 0;
+  return ( storage->checksum == translationCheckSum( &storage->element ) );
+}
+
+
+/* Read up to maxcount records following the first storagebase ones, stop at the first invalid record, returned buffer must be free()d */
+static translationStorage *translationLoadStorageTail( const char *path, int storagebase, int maxcount, int *retstoragecount )
+{
+  int storagecount;
+  FILE *file;
+  translationStorage *storagelist;
+
+  *retstoragecount = 0;
+  if( maxcount <= 0 )
+    return 0;
+  file = fopen( path, "rb" );
+  if( !( file ) )
+    return 0;
+  storagelist = malloc( maxcount * sizeof(translationStorage) );
+  storagecount = 0;
+  if( fseek( file, (long)storagebase * sizeof(translationStorage), SEEK_SET ) != -1 )
+    storagecount = (int)fread( storagelist, sizeof(translationStorage), maxcount, file );
+  fclose( file );
+  for( *retstoragecount = 0 ; *retstoragecount < storagecount ; (*retstoragecount)++ )
+  {
+    if( !( translationStorageValid( &storagelist[ *retstoragecount ] ) ) )
+      break;
+  }
+  return storagelist;
+}
+
+
+/* Fold the checksums of storagecount records in order, a rewritten or reordered storage file yields a different sum */
+static uint32_t translationStorageSum( uint32_t sum, translationStorage *storagelist, int storagecount )
+{
+  int storageindex;
+  for( storageindex = 0 ; storageindex < storagecount ; storageindex++ )
+  {
+    sum ^= (uint32_t)storagelist[storageindex].checksum;
+    sum *= 0x01000193;
+  }
+  return sum;
+}
+
+
+/* Failure to store the index is harmless, we will just rebuild it next time */
+static void translationIndexStore( translationTable *table, void *indexdata, size_t indexsize )
+{
+  char *temppath;
+  temppath = ccStrAllocPrintf( "%s.tmp", table->indexpath );
+  if( ccFileStore( temppath, indexdata, indexsize, 0 ) )
+    ccRenameFile( temppath, (char *)table->indexpath );
+  free( temppath );
+  return;
+}
+
+
+/* Insert the records appended since the mapped index was written, growing its tables if required */
+static void translationIndexCatchUp( translationTable *table, int filestoragecount )
+{
+  int tailcount, storageindex, hashbits;
+  uint32_t slotindex, oldhashmask;
+  size_t tablesize, indexsize;
+  void *indexdata;
+  translationStorage *taillist;
+  translationIndexHeader *header, *oldheader;
+  translationElement *oldblid, *oldboid;
 
   DEBUG_SET_TRACKER();
 
-  hashbits = TRANSLATION_DEFAULT_HASH_BITS;
-  hashsize = mmHashRequiredSize( sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
+  oldheader = (translationIndexHeader *)table->indexmap.data;
+  taillist = translationLoadStorageTail( table->path, oldheader->storagecount, filestoragecount - oldheader->storagecount, &tailcount );
+  if( !( tailcount ) )
+  {
+    if( taillist )
+      free( taillist );
+    return;
+  }
 
-  table->blidhashtable = malloc( hashsize );
-  mmHashInit( table->blidhashtable, &translationHashAccessBlid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
-  table->boidhashtable = malloc( hashsize );
-  mmHashInit( table->boidhashtable, &translationHashAccessBoid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
-  table->path = path;
-  table->storagecount = 0;
+  for( hashbits = oldheader->hashbits ; ( (size_t)1 << hashbits ) < ( 2 * (size_t)( oldheader->storagecount + tailcount ) ) ; hashbits++ );
+  tablesize = ( (size_t)1 << hashbits ) * sizeof(translationElement);
+  indexsize = sizeof(translationIndexHeader) + 2 * tablesize;
+  indexdata = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, indexsize );
+  if( hashbits == oldheader->hashbits )
+    memcpy( indexdata, table->indexmap.data, indexsize );
+  else
+  {
+    /* Both tables are rehashed separately, a BOID may still resolve to a record superseded for its BLID */
+    oldblid = table->indexblid;
+    oldboid = table->indexboid;
+    oldhashmask = table->indexhashmask;
+    memset( indexdata, 0, indexsize );
+    memcpy( indexdata, oldheader, sizeof(translationIndexHeader) );
+    ((translationIndexHeader *)indexdata)->hashbits = hashbits;
+    translationIndexSetTables( table, indexdata );
+    for( slotindex = 0 ; slotindex <= oldhashmask ; slotindex++ )
+    {
+      if( oldblid[slotindex].blpack[0] )
+        translationIndexInsertBlid( table->indexblid, table->indexhashmask, &oldblid[slotindex] );
+      if( oldboid[slotindex].blpack[0] )
+        translationIndexInsertBoid( table->indexboid, table->indexhashmask, &oldboid[slotindex] );
+    }
+  }
+  ccFileMapClose( &table->indexmap );
+
+  header = (translationIndexHeader *)indexdata;
+  translationIndexSetTables( table, indexdata );
+  for( storageindex = 0 ; storageindex < tailcount ; storageindex++ )
+    header->entrycount += translationIndexInsert( table->indexblid, table->indexboid, table->indexhashmask, &taillist[storageindex].element );
+  header->storagecount += tailcount;
+  header->storagechecksum = translationStorageSum( header->storagechecksum, taillist, tailcount );
+  table->indexalloc = indexdata;
+  table->storagecount = header->storagecount;
+  free( taillist );
+
+  translationIndexStore( table, indexdata, indexsize );
+  return;
+}
+
+
+/* Map the index file, return 0 if it's missing or if the storage records it covers have changed since it was built */
+static int translationIndexOpen( translationTable *table )
+{
+  int storagecount, coveredcount;
+  size_t filesize, tablesize;
+  translationIndexHeader *header;
+  translationStorage *storagelist;
+
+  DEBUG_SET_TRACKER();
+
+  /* A partial record at the end is the remain of an interrupted write, ignore it */
+  if( !( ccFileStat( (char *)table->path, &filesize, 0 ) ) )
+    filesize = 0;
+  storagecount = filesize / sizeof(translationStorage);
+
+  if( !( ccFileMapOpen( &table->indexmap, table->indexpath ) ) )
+    return 0;
+  header = (translationIndexHeader *)table->indexmap.data;
+  if( table->indexmap.size < sizeof(translationIndexHeader) )
+    goto invalid;
+  if( ( header->magic != TRANSLATION_INDEX_MAGIC ) || ( header->version != TRANSLATION_INDEX_VERSION ) || ( header->elementsize != sizeof(translationElement) ) || ( header->hashbits > 30 ) )
+    goto invalid;
+  tablesize = ( (size_t)1 << header->hashbits ) * sizeof(translationElement);
+  if( table->indexmap.size != sizeof(translationIndexHeader) + 2 * tablesize )
+    goto invalid;
+  if( ( header->storagecount < 0 ) || ( header->storagecount > storagecount ) )
+    goto invalid;
+  /* All covered records must still be valid and match the checksum stored when the index was written */
+  if( header->storagecount )
+  {
+    storagelist = translationLoadStorageTail( table->path, 0, header->storagecount, &coveredcount );
+    if( !( storagelist ) )
+      goto invalid;
+    if( ( coveredcount != header->storagecount ) || ( translationStorageSum( 0, storagelist, coveredcount ) != header->storagechecksum ) )
+    {
+      free( storagelist );
+      goto invalid;
+    }
+    free( storagelist );
+  }
+
+  translationIndexSetTables( table, table->indexmap.data );
+  table->storagecount = header->storagecount;
 
+  /* Records past the index are either newly registered ones or a corrupted tail, which new records will overwrite */
+  if( storagecount > header->storagecount )
+    translationIndexCatchUp( table, storagecount );
+  return 1;
+
+  invalid:
+  ccFileMapClose( &table->indexmap );
+  return 0;
+}
+
+
+/* Allocate and fill the index of all storage records, returned buffer must be freed with mmAccountFree() */
+static void *translationIndexCreate( translationStorage *storagelist, int storagecount, size_t *retindexsize )
+{
+  int storageindex, hashbits;
+  size_t tablesize, indexsize;
+  void *indexdata;
+  translationIndexHeader *header;
+  translationElement *indexblid, *indexboid;
+
+  for( hashbits = TRANSLATION_DEFAULT_HASH_BITS ; ( (size_t)1 << hashbits ) < ( 2 * (size_t)storagecount ) ; hashbits++ );
+  tablesize = ( (size_t)1 << hashbits ) * sizeof(translationElement);
+  indexsize = sizeof(translationIndexHeader) + 2 * tablesize;
+  indexdata = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, indexsize );
+  memset( indexdata, 0, indexsize );
+
+  header = (translationIndexHeader *)indexdata;
+  header->magic = TRANSLATION_INDEX_MAGIC;
+  header->version = TRANSLATION_INDEX_VERSION;
+  header->elementsize = sizeof(translationElement);
+  header->hashbits = hashbits;
+  header->storagecount = storagecount;
+  header->storagechecksum = translationStorageSum( 0, storagelist, storagecount );
+  indexblid = ADDRESS( indexdata, sizeof(translationIndexHeader) );
+  indexboid = ADDRESS( indexblid, tablesize );
+  for( storageindex = 0 ; storageindex < storagecount ; storageindex++ )
+    header->entrycount += translationIndexInsert( indexblid, indexboid, ( 1 << hashbits ) - 1, &storagelist[storageindex].element );
+
+  *retindexsize = indexsize;
+  return indexdata;
+}
+
+
+/* Build the index from all storage records, keep it in memory and write it to disk for the next launch */
+static void translationIndexBuild( translationTable *table, translationStorage *storagelist, int storagecount )
+{
+  size_t indexsize;
+  void *indexdata;
+
+  DEBUG_SET_TRACKER();
+
+  indexdata = translationIndexCreate( storagelist, storagecount, &indexsize );
+  translationIndexSetTables( table, indexdata );
+  table->indexalloc = indexdata;
+
+  translationIndexStore( table, indexdata, indexsize );
+
+  return;
+}
+
+
+/* Load the storage file and count the valid records, returned buffer must be free()d */
+static translationStorage *translationLoadStorage( const char *path, int *retstoragecount, size_t *retfilesize )
+{
+  int storagecount;
+  size_t storageoffset, filesize;
+  void *filedata;
+
+  storagecount = 0;
+  filesize = 0;
   filedata = ccFileLoad( path, 512*1048576, &filesize );
   if( filedata )
   {
-    for( storageoffset = 0 ; storageoffset < filesize ; storageoffset += sizeof(translationStorage) )
+    for( storageoffset = 0 ; storageoffset + sizeof(translationStorage) <= filesize ; storageoffset += sizeof(translationStorage) )
     {
-      storage = ADDRESS( filedata, storageoffset );
-      if( storage->element.boid <= 0 )
-        break;
-      if( !( storage->element.blpack[0] ) )
-        break;
-      if( storage->checksum != translationCheckSum( &storage->element ) )
+      if( !( translationStorageValid( ADDRESS( filedata, storageoffset ) ) ) )
         break;
-      translationAddEntry( table, &storage->element, 0 );
-      table->storagecount++;
+      storagecount++;
     }
-    free( filedata );
   }
+  *retstoragecount = storagecount;
+  if( retfilesize )
+    *retfilesize = filesize;
+  return (translationStorage *)filedata;
+}
+
+
+////
+
+
+int translationTableInit( translationTable *table, const char *path, const char *indexpath )
+{
+  int storagecount;
+  int hashbits;
+  size_t hashsize;
+  translationStorage *storagelist;
+
+  DEBUG_SET_TRACKER();
+
+  /* The hash tables only hold entries registered since the index was built */
+  hashbits = TRANSLATION_DEFAULT_HASH_BITS;
+  hashsize = mmHashRequiredSize( sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
+
+  table->blidhashtable = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, hashsize );
+  mmHashInit( table->blidhashtable, &translationHashAccessBlid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+  table->boidhashtable = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, hashsize );
+  mmHashInit( table->boidhashtable, &translationHashAccessBoid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+  table->path = path;
+  table->indexpath = indexpath;
+  table->storagecount = 0;
+  table->indexblid = 0;
+  table->indexboid = 0;
+  table->indexhashmask = 0;
+  table->indexalloc = 0;
+  memset( &table->indexmap, 0, sizeof(ccFileMap) );
+
+  /* Use the prebuilt index directly if it covers the whole storage file */
+  if( translationIndexOpen( table ) )
+    return 1;
+
+  /* Index is missing or stale, validate all storage records and rebuild it */
+  storagelist = translationLoadStorage( path, &storagecount, 0 );
+  translationIndexBuild( table, storagelist, storagecount );
+  table->storagecount = storagecount;
+  free( storagelist );
 
   return 1;
 }
 
 
+/* Lookup through entries registered since launch first, then the index */
+static translationElement *translationLookupBlid( translationTable *table, translationElement *refelement )
+{
+  if( mmHashDirectReadEntry( table->blidhashtable, &translationHashAccessBlid, refelement ) )
+    return refelement;
+  return translationIndexFindBlid( table, refelement );
+}
+
+static translationElement *translationLookupBoid( translationTable *table, translationElement *refelement )
+{
+  if( mmHashDirectReadEntry( table->boidhashtable, &translationHashAccessBoid, refelement ) )
+    return refelement;
+  return translationIndexFindBoid( table, refelement->boid );
+}
+
+
 int translationTableRegisterEntry( translationTable *table, char bltypeid, const char *blid, int64_t boid )
 {
   int i, storageflag;
   FILE *file;
   translationStorage storageelement;
+  translationElement lookupelement, *element;
 
   DEBUG_SET_TRACKER();
 
@@ -349,6 +745,15 @@ int translationTableRegisterEntry( translationTable *table, char bltypeid, const
   storageelement.element.blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
   storageelement.element.boid = boid;
 
+  /* Nothing to do if both directions already resolve to this entry */
+  lookupelement = storageelement.element;
+  if( ( element = translationLookupBlid( table, &lookupelement ) ) && ( translationCmpElement( element, &storageelement.element ) ) )
+  {
+    lookupelement = storageelement.element;
+    if( ( element = translationLookupBoid( table, &lookupelement ) ) && ( translationCmpElement( element, &storageelement.element ) ) )
+      return 1;
+  }
+
   if( !( translationAddEntry( table, &storageelement.element, &storageflag ) ) )
     return 0;
   if( storageflag )
@@ -375,7 +780,7 @@ int translationTableRegisterEntry( translationTable *table, char bltypeid, const
 int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const char *blid )
 {
   int i;
-  translationElement refelement;
+  translationElement refelement, *element;
 
   DEBUG_SET_TRACKER();
 
@@ -391,9 +796,9 @@ int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const cha
     refelement.blpack[i] = 0;
   refelement.blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
 
-  if( !( mmHashDirectReadEntry( table->blidhashtable, &translationHashAccessBlid, &refelement ) ) )
+  if( !( element = translationLookupBlid( table, &refelement ) ) )
     return -1;
-  return refelement.boid;
+  return element->boid;
 }
 
 
@@ -401,14 +806,15 @@ int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const cha
 char translationBOIDtoBLID( translationTable *table, int64_t boid, char *retblid, int blidbuffersize )
 {
   int i;
-  translationElement refelement;
+  translationElement refelement, *element;
 
   DEBUG_SET_TRACKER();
 
   refelement.boid = boid;
 
-  if( !( mmHashDirectReadEntry( table->boidhashtable, &translationHashAccessBoid, &refelement ) ) )
+  if( !( element = translationLookupBoid( table, &refelement ) ) )
     return 0;
+  refelement = *element;
 
   if( blidbuffersize <= 0 )
     return 0;
@@ -432,10 +838,562 @@ int translationTableEnd( translationTable *table )
 {
   DEBUG_SET_TRACKER();
 
-  free( table->blidhashtable );
-  free( table->boidhashtable );
+  mmAccountFree( MM_ACCOUNT_TRANSLATION, table->blidhashtable );
+  mmAccountFree( MM_ACCOUNT_TRANSLATION, table->boidhashtable );
+  if( table->indexalloc )
+    mmAccountFree( MM_ACCOUNT_TRANSLATION, table->indexalloc );
+  ccFileMapClose( &table->indexmap );
   memset( table, 0, sizeof(translationTable) );
   return 1;
 }
 
 
+////
+
+
+static int translationCmpStorageBlid( translationStorage *storage0, translationStorage *storage1 )
+{
+  return ( memcmp( storage0->element.blpack, storage1->element.blpack, TRANSLATION_BLPACK_LENGTH ) > 0 );
+}
+
+#define HSORT_MAIN translationSortStorageBlid
+#define HSORT_CMP translationCmpStorageBlid
+#define HSORT_TYPE translationStorage
+#include "cchybridsort.h"
+#undef HSORT_MAIN
+#undef HSORT_CMP
+#undef HSORT_TYPE
+
+
+/* Mark element as seen in a set of storage indices, return 1 if it was already present */
+static int translationSeenElement( int32_t *seenset, uint32_t hashmask, translationStorage *storagelist, int storageindex )
+{
+  uint32_t hashindex;
+  translationElement *element;
+
+  element = &storagelist[storageindex].element;
+  for( hashindex = ccHash32Data( element, sizeof(translationElement) ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+  {
+    if( !( seenset[hashindex] ) )
+    {
+      seenset[hashindex] = storageindex + 1;
+      return 0;
+    }
+    if( translationCmpElement( &storagelist[ seenset[hashindex] - 1 ].element, element ) )
+      return 1;
+  }
+  return 0;
+}
+
+
+/*
+Records that are current for both their BLID and BOID are written last, sorted by BLID.
+Records that are current for only one of the two keys are written first, preserving their
+order in the log, so that replaying the compacted file gives the exact same mappings.
+*/
+int translationTableCompact( translationTable *table, const char *temppath, const char *indextemppath, translationCompactStats *stats )
+{
+  int storageindex, storagecount, hashbits, partialcount, fullcount, blidflag, boidflag, compactcount;
+  int64_t loadtime;
+  size_t filesize, setsize, indexsize;
+  int32_t *seenset;
+  void *indexdata;
+  translationStorage *storagelist, *partiallist, *fulllist, *sorttemp;
+  translationStorage swapstorage;
+  translationElement lookupelement, *element;
+
+  DEBUG_SET_TRACKER();
+
+  memset( stats, 0, sizeof(translationCompactStats) );
+  loadtime = ccGetMicrosecondsTime();
+  storagelist = translationLoadStorage( table->path, &storagecount, &filesize );
+  stats->loadtime = ccGetMicrosecondsTime() - loadtime;
+  if( !( storagelist ) )
+  {
+    /* A missing or empty storage file is already compact */
+    if( !( ccFileStat( (char *)table->path, &filesize, 0 ) ) || !( filesize ) )
+      return 1;
+    return 0;
+  }
+  stats->storagecount = storagecount;
+  stats->storagesize = filesize;
+
+  for( hashbits = 4 ; ( (size_t)1 << hashbits ) < ( 2 * (size_t)storagecount ) ; hashbits++ );
+  setsize = (size_t)1 << hashbits;
+  seenset = malloc( setsize * sizeof(int32_t) );
+  memset( seenset, 0, setsize * sizeof(int32_t) );
+  partiallist = malloc( ( storagecount + 1 ) * sizeof(translationStorage) );
+  fulllist = malloc( ( storagecount + 1 ) * sizeof(translationStorage) );
+  partialcount = 0;
+  fullcount = 0;
+
+  /* Walk backwards to keep only the latest occurrence of each live record */
+  for( storageindex = storagecount - 1 ; storageindex >= 0 ; storageindex-- )
+  {
+    lookupelement = storagelist[storageindex].element;
+    element = translationLookupBlid( table, &lookupelement );
+    blidflag = ( ( element ) && ( translationCmpElement( element, &storagelist[storageindex].element ) ) );
+    lookupelement = storagelist[storageindex].element;
+    element = translationLookupBoid( table, &lookupelement );
+    boidflag = ( ( element ) && ( translationCmpElement( element, &storagelist[storageindex].element ) ) );
+    if( !( blidflag | boidflag ) )
+      continue;
+    if( translationSeenElement( seenset, setsize - 1, storagelist, storageindex ) )
+      continue;
+    if( blidflag & boidflag )
+      fulllist[ fullcount++ ] = storagelist[storageindex];
+    else
+      partiallist[ partialcount++ ] = storagelist[storageindex];
+  }
+  free( seenset );
+
+  /* Restore log order of partial records, they were gathered backwards */
+  for( storageindex = 0 ; storageindex < ( partialcount >> 1 ) ; storageindex++ )
+  {
+    swapstorage = partiallist[ storageindex ];
+    partiallist[ storageindex ] = partiallist[ partialcount - 1 - storageindex ];
+    partiallist[ partialcount - 1 - storageindex ] = swapstorage;
+  }
+  sorttemp = malloc( ( fullcount + 1 ) * sizeof(translationStorage) );
+  translationSortStorageBlid( fulllist, sorttemp, fullcount, (uint32_t)(((uintptr_t)fulllist)>>8) );
+  free( sorttemp );
+
+  /* Reuse the loaded file buffer to assemble the compacted storage */
+  memcpy( storagelist, partiallist, partialcount * sizeof(translationStorage) );
+  memcpy( &storagelist[ partialcount ], fulllist, fullcount * sizeof(translationStorage) );
+  free( partiallist );
+  free( fulllist );
+
+  stats->compactcount = partialcount + fullcount;
+  stats->compactsize = (size_t)stats->compactcount * sizeof(translationStorage);
+  if( !( ccFileStore( temppath, storagelist, stats->compactsize, 1 ) ) )
+  {
+    free( storagelist );
+    return 0;
+  }
+
+  /* Index the compacted storage now, so that it's swapped in with the storage file and never left describing the old one */
+  indexdata = translationIndexCreate( storagelist, stats->compactcount, &indexsize );
+  free( storagelist );
+  if( !( ccFileStore( indextemppath, indexdata, indexsize, 1 ) ) )
+  {
+    mmAccountFree( MM_ACCOUNT_TRANSLATION, indexdata );
+    return 0;
+  }
+  mmAccountFree( MM_ACCOUNT_TRANSLATION, indexdata );
+
+  /* Measure the same load and validation pass over the compacted file */
+  loadtime = ccGetMicrosecondsTime();
+  storagelist = translationLoadStorage( temppath, &compactcount, 0 );
+  stats->compactloadtime = ccGetMicrosecondsTime() - loadtime;
+  free( storagelist );
+  if( compactcount != stats->compactcount )
+    return 0;
+
+  return 1;
+}
+
+
+int translationTableReload( translationTable *table )
+{
+  const char *path, *indexpath;
+
+  DEBUG_SET_TRACKER();
+
+  path = table->path;
+  indexpath = table->indexpath;
+  translationTableEnd( table );
+  return translationTableInit( table, path, indexpath );
+}
+
+
+
+
+////
+
+
+#define TRANSLATION_NEGATIVE_MAGIC (0x4745484e)
+#define TRANSLATION_NEGATIVE_VERSION (1)
+#define TRANSLATION_NEGATIVE_HASH_BITS (8)
+
+/* Failed lookup of a BLID for a given query type, blpack holds the queried type instead of the BLID's own type */
+typedef struct
+{
+  char blpack[TRANSLATION_BLPACK_LENGTH];
+  int64_t retrytime;
+  int32_t failcount;
+  int32_t checksum;
+} translationNegativeEntry __attribute__ ((aligned(8)));
+
+/* Negative cache file header, followed by entrycount entries */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entrysize;
+  int32_t entrycount;
+} translationNegativeHeader __attribute__ ((aligned(8)));
+
+
+static int translationNegativePack( char *blpack, char querytypeid, const char *blid )
+{
+  int i;
+  if( !( querytypeid ) || !( blid ) || !( blid[0] ) )
+    return 0;
+  for( i = 0 ; blid[i] ; i++ )
+  {
+    if( i == TRANSLATION_BLID_LENGTH )
+      return 0;
+    blpack[i] = blid[i];
+  }
+  for( ; i < TRANSLATION_BLID_LENGTH ; i++ )
+    blpack[i] = 0;
+  blpack[ TRANSLATION_BLTYPEID_OFFSET ] = querytypeid;
+  return 1;
+}
+
+static inline int32_t translationNegativeCheckSum( translationNegativeEntry *entry )
+{
+  return (int32_t)ccHash32Data( (void *)entry, offsetof(translationNegativeEntry,checksum) );
+}
+
+/* Find the entry or the empty slot where it belongs */
+static translationNegativeEntry *translationNegativeSlot( translationNegativeEntry *entrytable, uint32_t hashmask, char *blpack )
+{
+  uint32_t hashindex;
+  translationNegativeEntry *slot;
+  for( hashindex = ccHash32Data( (void *)blpack, TRANSLATION_BLPACK_LENGTH ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+  {
+    slot = &entrytable[hashindex];
+    if( !( slot->blpack[0] ) || ccMemCmpInline( slot->blpack, blpack, TRANSLATION_BLPACK_LENGTH ) )
+      break;
+  }
+  return slot;
+}
+
+static void translationNegativeGrow( translationNegative *negative )
+{
+  uint32_t index, hashmask;
+  translationNegativeEntry *entrytable, *entry;
+
+  if( ( 2 * (uint32_t)( negative->entrycount + 1 ) ) <= negative->hashmask )
+    return;
+  hashmask = ( negative->hashmask << 1 ) | 0x1;
+  entrytable = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, ( (size_t)hashmask + 1 ) * sizeof(translationNegativeEntry) );
+  memset( entrytable, 0, ( (size_t)hashmask + 1 ) * sizeof(translationNegativeEntry) );
+  for( index = 0 ; index <= negative->hashmask ; index++ )
+  {
+    entry = &((translationNegativeEntry *)negative->entrytable)[index];
+    if( entry->blpack[0] )
+      *translationNegativeSlot( entrytable, hashmask, entry->blpack ) = *entry;
+  }
+  mmAccountFree( MM_ACCOUNT_TRANSLATION, negative->entrytable );
+  negative->entrytable = entrytable;
+  negative->hashmask = hashmask;
+  return;
+}
+
+
+int translationNegativeInit( translationNegative *negative, const char *path )
+{
+  int entryindex;
+  size_t filesize;
+  void *filedata;
+  translationNegativeHeader *header;
+  translationNegativeEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  negative->hashmask = ( 1 << TRANSLATION_NEGATIVE_HASH_BITS ) - 1;
+  negative->entrytable = mmAccountAlloc( MM_ACCOUNT_TRANSLATION, ( (size_t)negative->hashmask + 1 ) * sizeof(translationNegativeEntry) );
+  memset( negative->entrytable, 0, ( (size_t)negative->hashmask + 1 ) * sizeof(translationNegativeEntry) );
+  negative->entrycount = 0;
+  negative->path = path;
+  negative->dirtyflag = 0;
+
+  /* A missing or damaged cache only costs a few extra queries, ignore it */
+  filedata = ccFileLoad( path, 64*1048576, &filesize );
+  if( !( filedata ) )
+    return 1;
+  header = (translationNegativeHeader *)filedata;
+  if( ( filesize >= sizeof(translationNegativeHeader) ) && ( header->magic == TRANSLATION_NEGATIVE_MAGIC ) && ( header->version == TRANSLATION_NEGATIVE_VERSION ) && ( header->entrysize == sizeof(translationNegativeEntry) ) && ( header->entrycount >= 0 ) && ( filesize >= sizeof(translationNegativeHeader) + (size_t)header->entrycount * sizeof(translationNegativeEntry) ) )
+  {
+    entry = ADDRESS( filedata, sizeof(translationNegativeHeader) );
+    for( entryindex = 0 ; entryindex < header->entrycount ; entryindex++, entry++ )
+    {
+      if( !( entry->blpack[0] ) || ( entry->failcount <= 0 ) || ( entry->checksum != translationNegativeCheckSum( entry ) ) )
+        continue;
+      translationNegativeGrow( negative );
+      *translationNegativeSlot( negative->entrytable, negative->hashmask, entry->blpack ) = *entry;
+      negative->entrycount++;
+    }
+  }
+  free( filedata );
+
+  return 1;
+}
+
+
+/* Return 1 if the lookup of that BLID as querytypeid failed recently and shouldn't be retried yet */
+int translationNegativeCheck( translationNegative *negative, char querytypeid, const char *blid, int64_t curtime )
+{
+  char blpack[TRANSLATION_BLPACK_LENGTH];
+  translationNegativeEntry *entry;
+
+  if( !( negative->entrycount ) )
+    return 0;
+  if( !( translationNegativePack( blpack, querytypeid, blid ) ) )
+    return 0;
+  entry = translationNegativeSlot( negative->entrytable, negative->hashmask, blpack );
+  if( !( entry->blpack[0] ) || ( entry->failcount <= 0 ) )
+    return 0;
+  return ( curtime < entry->retrytime );
+}
+
+
+/* Record a failed lookup, the retry delay doubles with each consecutive failure up to retrymax */
+void translationNegativeRegister( translationNegative *negative, char querytypeid, const char *blid, int64_t curtime, int64_t retrybase, int64_t retrymax )
+{
+  int shift;
+  int64_t retrydelay;
+  char blpack[TRANSLATION_BLPACK_LENGTH];
+  translationNegativeEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  if( retrybase <= 0 )
+    return;
+  if( !( translationNegativePack( blpack, querytypeid, blid ) ) )
+    return;
+  translationNegativeGrow( negative );
+  entry = translationNegativeSlot( negative->entrytable, negative->hashmask, blpack );
+  if( !( entry->blpack[0] ) )
+  {
+    memcpy( entry->blpack, blpack, TRANSLATION_BLPACK_LENGTH );
+    entry->failcount = 0;
+    negative->entrycount++;
+  }
+  /* Same BLID failing again for other lots within the same pass */
+  else if( ( entry->failcount > 0 ) && ( curtime < entry->retrytime ) )
+    return;
+  entry->failcount++;
+  retrydelay = retrybase;
+  for( shift = 1 ; ( shift < entry->failcount ) && ( retrydelay < retrymax ) ; shift++ )
+    retrydelay <<= 1;
+  if( retrydelay > retrymax )
+    retrydelay = retrymax;
+  entry->retrytime = curtime + retrydelay;
+  entry->checksum = translationNegativeCheckSum( entry );
+  negative->dirtyflag = 1;
+  return;
+}
+
+
+/* Forget about previous failures after a successful lookup */
+void translationNegativeClear( translationNegative *negative, char querytypeid, const char *blid )
+{
+  char blpack[TRANSLATION_BLPACK_LENGTH];
+  translationNegativeEntry *entry;
+
+  if( !( negative->entrycount ) )
+    return;
+  if( !( translationNegativePack( blpack, querytypeid, blid ) ) )
+    return;
+  entry = translationNegativeSlot( negative->entrytable, negative->hashmask, blpack );
+  if( !( entry->blpack[0] ) || ( entry->failcount <= 0 ) )
+    return;
+  /* Keep the slot to preserve probe chains, it's dropped on the next save and load */
+  entry->failcount = 0;
+  entry->retrytime = 0;
+  entry->checksum = translationNegativeCheckSum( entry );
+  negative->dirtyflag = 1;
+  return;
+}
+
+
+/* Write the cache if modified, return 0 on failure */
+int translationNegativeSave( translationNegative *negative )
+{
+  int retval;
+  uint32_t index;
+  size_t datasize;
+  void *data;
+  char *temppath;
+  translationNegativeHeader *header;
+  translationNegativeEntry *entry, *dstentry;
+
+  DEBUG_SET_TRACKER();
+
+  if( !( negative->dirtyflag ) )
+    return 1;
+  datasize = sizeof(translationNegativeHeader) + (size_t)negative->entrycount * sizeof(translationNegativeEntry);
+  data = malloc( datasize );
+  header = (translationNegativeHeader *)data;
+  header->magic = TRANSLATION_NEGATIVE_MAGIC;
+  header->version = TRANSLATION_NEGATIVE_VERSION;
+  header->entrysize = sizeof(translationNegativeEntry);
+  header->entrycount = 0;
+  dstentry = ADDRESS( data, sizeof(translationNegativeHeader) );
+  for( index = 0 ; index <= negative->hashmask ; index++ )
+  {
+    entry = &((translationNegativeEntry *)negative->entrytable)[index];
+    if( !( entry->blpack[0] ) || ( entry->failcount <= 0 ) )
+      continue;
+    dstentry[ header->entrycount++ ] = *entry;
+  }
+  datasize = sizeof(translationNegativeHeader) + (size_t)header->entrycount * sizeof(translationNegativeEntry);
+
+  retval = 0;
+  temppath = ccStrAllocPrintf( "%s.tmp", negative->path );
+  if( ( ccFileStore( temppath, data, datasize, 0 ) ) && ( ccRenameFile( temppath, (char *)negative->path ) ) )
+  {
+    negative->dirtyflag = 0;
+    retval = 1;
+  }
+  free( temppath );
+  free( data );
+
+  return retval;
+}
+
+
+/* Count of BLIDs currently excluded from lookups */
+int translationNegativeCount( translationNegative *negative, int64_t curtime )
+{
+  int count;
+  uint32_t index;
+  translationNegativeEntry *entry;
+
+  count = 0;
+  for( index = 0 ; index <= negative->hashmask ; index++ )
+  {
+    entry = &((translationNegativeEntry *)negative->entrytable)[index];
+    if( ( entry->blpack[0] ) && ( entry->failcount > 0 ) && ( curtime < entry->retrytime ) )
+      count++;
+  }
+  return count;
+}
+
+
+int translationNegativeEnd( translationNegative *negative )
+{
+  DEBUG_SET_TRACKER();
+
+  mmAccountFree( MM_ACCOUNT_TRANSLATION, negative->entrytable );
+  memset( negative, 0, sizeof(translationNegative) );
+  return 1;
+}
+
+
+////
+
+
+void translationBatchInit( translationBatch *batch )
+{
+  batch->storagelist = 0;
+  batch->storagecount = 0;
+  batch->storagealloc = 0;
+  return;
+}
+
+
+int translationBatchAdd( translationBatch *batch, char bltypeid, const char *blid, int64_t boid )
+{
+  int i;
+  translationStorage *storage;
+
+  if( !( bltypeid ) || !( blid[0] ) || ( boid <= 0 ) )
+    return 0;
+  for( i = 0 ; blid[i] ; i++ )
+  {
+    if( i == TRANSLATION_BLID_LENGTH )
+      return 0;
+  }
+  if( batch->storagecount >= batch->storagealloc )
+  {
+    batch->storagealloc = ( batch->storagealloc ? batch->storagealloc << 1 : 4096 );
+    batch->storagelist = realloc( batch->storagelist, batch->storagealloc * sizeof(translationStorage) );
+  }
+  storage = &((translationStorage *)batch->storagelist)[ batch->storagecount++ ];
+  memset( storage, 0, sizeof(translationStorage) );
+  memcpy( storage->element.blpack, blid, i );
+  storage->element.blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
+  storage->element.boid = boid;
+  storage->checksum = translationCheckSum( &storage->element );
+  return 1;
+}
+
+
+void translationBatchFree( translationBatch *batch )
+{
+  free( batch->storagelist );
+  translationBatchInit( batch );
+  return;
+}
+
+
+int translationTableImport( translationTable *table, translationBatch *batch )
+{
+  int storageindex, newcount, uniquecount, hashbits;
+  size_t setsize;
+  int32_t *seenset;
+  FILE *file;
+  translationStorage *storagelist, *uniquelist;
+  translationElement lookupelement, *element;
+
+  DEBUG_SET_TRACKER();
+
+  /* Drop repeated entries within the batch, keeping the last occurrence so that the replay order is unchanged */
+  storagelist = batch->storagelist;
+  for( hashbits = 4 ; ( (size_t)1 << hashbits ) < ( 2 * (size_t)batch->storagecount ) ; hashbits++ );
+  setsize = (size_t)1 << hashbits;
+  seenset = malloc( setsize * sizeof(int32_t) );
+  memset( seenset, 0, setsize * sizeof(int32_t) );
+  uniquelist = malloc( ( batch->storagecount + 1 ) * sizeof(translationStorage) );
+  uniquecount = 0;
+  for( storageindex = batch->storagecount - 1 ; storageindex >= 0 ; storageindex-- )
+  {
+    if( !( translationSeenElement( seenset, setsize - 1, storagelist, storageindex ) ) )
+      uniquelist[ uniquecount++ ] = storagelist[storageindex];
+  }
+  free( seenset );
+  /* Restore batch order, entries were gathered backwards */
+  for( storageindex = 0 ; storageindex < uniquecount ; storageindex++ )
+    storagelist[storageindex] = uniquelist[ uniquecount - 1 - storageindex ];
+  free( uniquelist );
+  batch->storagecount = uniquecount;
+
+  /* Compact the batch down to entries that would change a mapping */
+  newcount = 0;
+  for( storageindex = 0 ; storageindex < batch->storagecount ; storageindex++ )
+  {
+    lookupelement = storagelist[storageindex].element;
+    if( ( element = translationLookupBlid( table, &lookupelement ) ) && ( translationCmpElement( element, &storagelist[storageindex].element ) ) )
+    {
+      lookupelement = storagelist[storageindex].element;
+      if( ( element = translationLookupBoid( table, &lookupelement ) ) && ( translationCmpElement( element, &storagelist[storageindex].element ) ) )
+        continue;
+    }
+    storagelist[ newcount++ ] = storagelist[storageindex];
+  }
+  batch->storagecount = newcount;
+  if( !( newcount ) )
+    return 0;
+
+  file = fopen( table->path, "r+b" );
+  if( !( file ) )
+    file = fopen( table->path, "wb" );
+  if( !( file ) )
+    return -1;
+  if( ( fseek( file, table->storagecount * sizeof(translationStorage), SEEK_SET ) == -1 ) || ( fwrite( storagelist, sizeof(translationStorage), newcount, file ) != (size_t)newcount ) )
+  {
+    fclose( file );
+    return -1;
+  }
+  fclose( file );
+
+  /* Index no longer covers the storage file, reloading rebuilds it in a single pass */
+  translationTableReload( table );
+
+  return newcount;
+}
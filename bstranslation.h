@@ -27,10 +27,17 @@ typedef struct
   void *boidhashtable;
   int storagecount;
   const char *path;
+  /* Prebuilt open-addressing index of the storage file, mapped or built in memory */
+  const char *indexpath;
+  void *indexblid;
+  void *indexboid;
+  uint32_t indexhashmask;
+  void *indexalloc;
+  ccFileMap indexmap;
 } translationTable;
 
 
-int translationTableInit( translationTable *table, const char *path );
+int translationTableInit( translationTable *table, const char *path, const char *indexpath );
 
 int translationTableRegisterEntry( translationTable *table, char bltypeid, const char *blid, int64_t boid );
 
@@ -39,3 +46,69 @@ char translationBOIDtoBLID( translationTable *table, int64_t boid, char *retblid
 
 int translationTableEnd( translationTable *table );
 
+
+typedef struct
+{
+  int storagecount;
+  int compactcount;
+  size_t storagesize;
+  size_t compactsize;
+  /* Time to load and validate the storage files in microseconds */
+  int64_t loadtime;
+  int64_t compactloadtime;
+} translationCompactStats;
+
+/* Write only the live entries of the storage file to temppath and their index to indextemppath, return 0 on failure */
+int translationTableCompact( translationTable *table, const char *temppath, const char *indextemppath, translationCompactStats *stats );
+
+/* Reload the table after its storage file was replaced */
+int translationTableReload( translationTable *table );
+
+
+/* Batch of entries to import in a single pass */
+typedef struct
+{
+  void *storagelist;
+  int storagecount;
+  int storagealloc;
+} translationBatch;
+
+void translationBatchInit( translationBatch *batch );
+/* Return 0 if the entry is invalid */
+int translationBatchAdd( translationBatch *batch, char bltypeid, const char *blid, int64_t boid );
+void translationBatchFree( translationBatch *batch );
+
+/* Append all entries not already known with a single write and rebuild the index once, return count of new entries or -1 on failure */
+int translationTableImport( translationTable *table, translationBatch *batch );
+
+
+
+////
+
+
+/* Cache of failed BOID lookups, to avoid querying again for BLIDs unknown to BrickOwl */
+typedef struct
+{
+  void *entrytable;
+  uint32_t hashmask;
+  int entrycount;
+  const char *path;
+  int dirtyflag;
+} translationNegative;
+
+
+int translationNegativeInit( translationNegative *negative, const char *path );
+
+/* Return 1 if the lookup of that BLID as querytypeid failed recently and shouldn't be retried yet */
+int translationNegativeCheck( translationNegative *negative, char querytypeid, const char *blid, int64_t curtime );
+/* Record a failed lookup, the retry delay doubles with each consecutive failure up to retrymax */
+void translationNegativeRegister( translationNegative *negative, char querytypeid, const char *blid, int64_t curtime, int64_t retrybase, int64_t retrymax );
+/* Forget about previous failures after a successful lookup */
+void translationNegativeClear( translationNegative *negative, char querytypeid, const char *blid );
+
+/* Write the cache if modified, return 0 on failure */
+int translationNegativeSave( translationNegative *negative );
+/* Count of BLIDs currently excluded from lookups */
+int translationNegativeCount( translationNegative *negative, int64_t curtime );
+
+int translationNegativeEnd( translationNegative *negative );
@@ -36,6 +36,7 @@
 #include "mm.h"
 #include "mmatomic.h"
 #include "mmbitmap.h"
+#include "iolog.h"
 
 /* For mkdir() */
 #if CC_UNIX
@@ -304,7 +305,7 @@ char *bsxReadString( char **readvalue, char *string, char *closestring )
   len = strlen( closestring );
   if( !( string = ccStrFindSeq( string, closestring, len ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   *string = 0;
@@ -322,7 +323,7 @@ char *bsxReadStringAlloc( char **readvalue, char *string, char *closestring )
   len = strlen( closestring );
   if( !( string = ccStrFindSeq( string, closestring, len ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   *string = 0;
@@ -343,13 +344,13 @@ char *bsxReadInt( int *readvalue, char *string, char *closestring )
   int64_t readint;
   if( !( xmlStrParseInt( string, &readint ) ) )
   {
-    printf( "ERROR: Failed to read int : %.*s\n", 32, string );
+    ioPrintf( 0, 0, "ERROR: Failed to read int : %.*s\n", 32, string );
     return 0;
   }
   *readvalue = (int)readint;
   if( !( string = ccStrFindStrSkip( string, closestring ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   return string;
@@ -360,13 +361,13 @@ char *bsxReadInt64( int64_t *readvalue, char *string, char *closestring )
   int64_t readint;
   if( !( xmlStrParseInt( string, &readint ) ) )
   {
-    printf( "ERROR: Failed to read int : %.*s\n", 32, string );
+    ioPrintf( 0, 0, "ERROR: Failed to read int : %.*s\n", 32, string );
     return 0;
   }
   *readvalue = (int64_t)readint;
   if( !( string = ccStrFindStrSkip( string, closestring ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   return string;
@@ -377,13 +378,13 @@ char *bsxReadFloat( float *readvalue, char *string, char *closestring )
   float readfloat;
   if( !( xmlStrParseFloat( string, &readfloat ) ) )
   {
-    printf( "ERROR: Failed to read int : %.*s\n", 32, string );
+    ioPrintf( 0, 0, "ERROR: Failed to read int : %.*s\n", 32, string );
     return 0;
   }
   *readvalue = (float)readfloat;
   if( !( string = ccStrFindStrSkip( string, closestring ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   return string;
@@ -394,7 +395,7 @@ char *bsxReadChar( char *readvalue, char *string, char *closestring )
   *readvalue = *string;
   if( !( string = ccStrFindStrSkip( string, closestring ) ) )
   {
-    printf( "BSX READ ERROR: Failed to locate matching %s\n", closestring );
+    ioPrintf( 0, 0, "BSX READ ERROR: Failed to locate matching %s\n", closestring );
     return 0;
   }
   return string;
@@ -404,6 +405,9 @@ char *bsxReadChar( char *readvalue, char *string, char *closestring )
 ////
 
 
+static void bsxTextIndexFree( bsxInventory *inv );
+
+
 bsxInventory *bsxNewInventory()
 {
   bsxInventory *inv;
@@ -413,6 +417,94 @@ bsxInventory *bsxNewInventory()
 }
 
 
+bsxInventory *bsxNewArenaInventory()
+{
+  bsxInventory *inv;
+  inv = bsxNewInventory();
+  inv->arenaflag = 1;
+  return inv;
+}
+
+
+////
+
+
+#define BSX_ARENA_NODE_SIZE (262144)
+#define BSX_ARENA_ITEMALLOC_MIN (256)
+
+struct bsxArena
+{
+  mmGrow grow;
+  /* Total size of the nodes, for memory accounting */
+  size_t nodebytes;
+};
+
+/* Allocations are rounded up to 8 bytes, item lists share the arena with strings */
+static void *bsxArenaAlloc( bsxInventory *inv, size_t bytes )
+{
+  void *mem;
+  mmGrowNode *node;
+  struct bsxArena *arena;
+
+  if( !( arena = inv->arena ) )
+  {
+    arena = malloc( sizeof(struct bsxArena) );
+    mmGrowInit( &arena->grow, BSX_ARENA_NODE_SIZE );
+    arena->nodebytes = sizeof(mmGrowNode) + BSX_ARENA_NODE_SIZE;
+    mmAccountAdd( MM_ACCOUNT_BSXARENA, (long)arena->nodebytes );
+    inv->arena = arena;
+  }
+  node = arena->grow.first;
+  mem = mmGrowAlloc( &arena->grow, ( bytes + 0x7 ) & ~(size_t)0x7 );
+  if( arena->grow.first != node )
+  {
+    node = arena->grow.first;
+    arena->nodebytes += sizeof(mmGrowNode) + node->size;
+    mmAccountAdd( MM_ACCOUNT_BSXARENA, (long)( sizeof(mmGrowNode) + node->size ) );
+  }
+  return mem;
+}
+
+static char *bsxArenaCopyString( bsxInventory *inv, char *string, int len )
+{
+  char *dst;
+  dst = bsxArenaAlloc( inv, len + 1 );
+  memcpy( dst, string, len );
+  dst[ len ] = 0;
+  return dst;
+}
+
+static void bsxArenaFree( bsxInventory *inv )
+{
+  struct bsxArena *arena;
+  if( !( arena = inv->arena ) )
+    return;
+  mmGrowFreeAll( &arena->grow );
+  mmAccountAdd( MM_ACCOUNT_BSXARENA, -(long)arena->nodebytes );
+  free( arena );
+  inv->arena = 0;
+  return;
+}
+
+/* Grow the item list, arena item lists are moved and the old list remains in the arena until teardown */
+static void bsxGrowItemList( bsxInventory *inv )
+{
+  bsxItem *itemlist;
+  if( !( inv->arenaflag ) )
+  {
+    inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
+    inv->itemlist = mmAccountRealloc( MM_ACCOUNT_BSXITEM, inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
+    return;
+  }
+  inv->itemalloc = intMax( BSX_ARENA_ITEMALLOC_MIN, inv->itemalloc << 1 );
+  itemlist = bsxArenaAlloc( inv, inv->itemalloc * sizeof(bsxItem) );
+  if( inv->itemcount )
+    memcpy( itemlist, inv->itemlist, inv->itemcount * sizeof(bsxItem) );
+  inv->itemlist = itemlist;
+  return;
+}
+
+
 static char *bsxReadItem( bsxItem *item, char *input, int *successflag )
 {
   int offset, itemflags;
@@ -437,7 +529,7 @@ static char *bsxReadItem( bsxItem *item, char *input, int *successflag )
     offset = ccStrFindChar( input, '<' );
     if( offset < 0 )
     {
-      printf( "ERROR: Failed to locate matching </Item>\n" );
+      ioPrintf( 0, 0, "ERROR: Failed to locate matching </Item>\n" );
       return 0;
     }
     input = &input[offset+1];
@@ -722,7 +814,7 @@ printf( "  Read AlternateID : %d\n", item->alternateid );
       offset = ccStrFindChar( input, '\n' );
       if( offset < 0 )
       {
-        printf( "ERROR: Failed to locate line break\n" );
+        ioPrintf( 0, 0, "ERROR: Failed to locate line break\n" );
         return 0;
       }
       input += offset;
@@ -731,7 +823,7 @@ printf( "  Read AlternateID : %d\n", item->alternateid );
 
   if( ( itemflags & 0xf ) != 0xf )
   {
-    printf( "ERROR: Incomplete item ( code 0x%x )\n", itemflags );
+    ioPrintf( 0, 0, "ERROR: Incomplete item ( code 0x%x )\n", itemflags );
     return 0;
   }
 
@@ -767,7 +859,7 @@ static char *bsxReadOrder( bsxInventory *inv, char *input )
     offset = ccStrFindChar( input, '<' );
     if( offset < 0 )
     {
-      printf( "ERROR: Failed to locate matching </Order>\n" );
+      ioPrintf( 0, 0, "ERROR: Failed to locate matching </Order>\n" );
       return 0;
     }
     input = &input[offset+1];
@@ -823,7 +915,7 @@ static char *bsxReadOrder( bsxInventory *inv, char *input )
       offset = ccStrFindChar( input, '\n' );
       if( offset < 0 )
       {
-        printf( "ERROR: Failed to locate line break\n" );
+        ioPrintf( 0, 0, "ERROR: Failed to locate line break\n" );
         return 0;
       }
       input += offset;
@@ -845,7 +937,7 @@ int bsxLoadInventory( bsxInventory *inv, char *path )
   char *ordersection, *inventorysection, *string;
 
   if( inv->xmldata )
-    printf( "WARNING: inv->xmldata already defined when bsxLoadInventory() is called\n" );
+    ioPrintf( 0, 0, "WARNING: inv->xmldata already defined when bsxLoadInventory() is called\n" );
 
   bsxEmptyInventory( inv );
   inv->xmldata = ccFileLoad( path, 16*1048576, &inv->xmlsize );
@@ -876,7 +968,7 @@ int bsxLoadInventory( bsxInventory *inv, char *path )
     if( bsxReadOrder( inv, ordersection ) )
       inv->orderblockflag = 1;
     else
-      printf( "WARNING: Failed to load BSX Order block\n" );
+      ioPrintf( 0, 0, "WARNING: Failed to load BSX Order block\n" );
   }
 
   /* Reader <Inventory> section */
@@ -888,10 +980,7 @@ int bsxLoadInventory( bsxInventory *inv, char *path )
   for( ; ; )
   {
     if( inv->itemcount >= inv->itemalloc )
-    {
-      inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
-      inv->itemlist = realloc( inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
-    }
+      bsxGrowItemList( inv );
     item = &inv->itemlist[ inv->itemcount ];
     if( !( string = bsxReadItem( item, string, &successflag ) ) )
       break;
@@ -911,19 +1000,19 @@ static void bsxFreeItem( bsxItem *item, int clearflag )
   if( item->flags & BSX_ITEM_FLAGS_DELETED )
     return;
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_ID )
-    free( item->id );
+    mmAccountFree( MM_ACCOUNT_STRING, item->id );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_NAME )
-    free( item->name );
+    mmAccountFree( MM_ACCOUNT_STRING, item->name );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_TYPENAME )
-    free( item->typename );
+    mmAccountFree( MM_ACCOUNT_STRING, item->typename );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_COLORNAME )
-    free( item->colorname );
+    mmAccountFree( MM_ACCOUNT_STRING, item->colorname );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME )
-    free( item->categoryname );
+    mmAccountFree( MM_ACCOUNT_STRING, item->categoryname );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_COMMENTS )
-    free( item->comments );
+    mmAccountFree( MM_ACCOUNT_STRING, item->comments );
   if( item->flags & BSX_ITEM_FLAGS_ALLOC_REMARKS )
-    free( item->remarks );
+    mmAccountFree( MM_ACCOUNT_STRING, item->remarks );
   if( clearflag )
   {
     bsxClearItem( item );
@@ -938,12 +1027,14 @@ void bsxEmptyInventory( bsxInventory *inv )
   int itemindex;
   bsxItem *item;
 
-  /* Free inventory section */
+  /* Free inventory section, strings held in the arena have no allocation flags */
   item = inv->itemlist;
   for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++, item++ )
     bsxFreeItem( item, 0 );
-  if( inv->itemlist )
-    free( inv->itemlist );
+  if( inv->arenaflag )
+    bsxArenaFree( inv );
+  else if( inv->itemlist )
+    mmAccountFree( MM_ACCOUNT_BSXITEM, inv->itemlist );
 
   /* Free order section */
   if( inv->order.service )
@@ -957,6 +1048,8 @@ void bsxEmptyInventory( bsxInventory *inv )
   if( inv->xmldata )
     free( inv->xmldata );
   inv->xmldata = 0;
+  bsxTextIndexFree( inv );
+  /* An emptied inventory is a regular heap inventory, even if it was an arena one */
   memset( inv, 0, sizeof(bsxInventory) );
 
   return;
@@ -974,6 +1067,54 @@ void bsxFreeInventory( bsxInventory *inv )
 }
 
 
+static void bsxDetachItemString( char **storage, int flag, bsxItem *item )
+{
+  int len;
+  char *dst;
+  if( !( *storage ) || ( item->flags & flag ) )
+    return;
+  len = strlen( *storage );
+  dst = mmAccountAlloc( MM_ACCOUNT_STRING, len + 1 );
+  memcpy( dst, *storage, len + 1 );
+  *storage = dst;
+  item->flags |= flag;
+  return;
+}
+
+void bsxDetachInventoryArena( bsxInventory *inv )
+{
+  int itemindex;
+  bsxItem *item, *itemlist;
+
+  if( !( inv->arenaflag ) )
+    return;
+  itemlist = 0;
+  if( inv->itemcount )
+  {
+    itemlist = mmAccountAlloc( MM_ACCOUNT_BSXITEM, inv->itemcount * sizeof(bsxItem) );
+    memcpy( itemlist, inv->itemlist, inv->itemcount * sizeof(bsxItem) );
+  }
+  item = itemlist;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++, item++ )
+  {
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    bsxDetachItemString( &item->id, BSX_ITEM_FLAGS_ALLOC_ID, item );
+    bsxDetachItemString( &item->name, BSX_ITEM_FLAGS_ALLOC_NAME, item );
+    bsxDetachItemString( &item->typename, BSX_ITEM_FLAGS_ALLOC_TYPENAME, item );
+    bsxDetachItemString( &item->colorname, BSX_ITEM_FLAGS_ALLOC_COLORNAME, item );
+    bsxDetachItemString( &item->categoryname, BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME, item );
+    bsxDetachItemString( &item->comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS, item );
+    bsxDetachItemString( &item->remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS, item );
+  }
+  bsxArenaFree( inv );
+  inv->itemlist = itemlist;
+  inv->itemalloc = inv->itemcount;
+  inv->arenaflag = 0;
+  return;
+}
+
+
 void bsxPackInventory( bsxInventory *inv )
 {
   int srcindex;
@@ -993,6 +1134,7 @@ void bsxPackInventory( bsxInventory *inv )
   }
   inv->itemcount = (int)( dstitem - inv->itemlist );
   inv->itemfreecount = 0;
+  bsxTextIndexFree( inv );
 
   return;
 }
@@ -1042,7 +1184,7 @@ int bsxSaveInventory( char *path, bsxInventory *inv, int fsyncflag, int sortcolu
   out = fopen( path, "w" );
   if( !( out ) )
   {
-    printf( "ERROR: Failed to open %s for writing\n", path );
+    ioPrintf( 0, 0, "ERROR: Failed to open %s for writing\n", path );
     return 0;
   }
 
@@ -1214,7 +1356,7 @@ static inline int bsxSortCmpString( bsxSortContext *sortcontext, bsxItem *item0,
     return 0;
   for( i = 0 ; ; i++ )
   {
-    if( s0[i] != s1[i] )
+    if( ( s0[i] != s1[i] ) || !( s0[i] ) )
       break;
   }
   return sortcontext->reverseflag ^ ( s1[i] < s0[i] );
@@ -1468,7 +1610,8 @@ int bsxSortInventory( bsxInventory *inv, int sortfield, int reverseflag )
     return 1;
 
   retvalue = 1;
-  tmp = malloc( inv->itemcount * sizeof(bsxItem) );
+  bsxTextIndexFree( inv );
+  tmp = mmAccountAlloc( MM_ACCOUNT_BSXITEM, inv->itemcount * sizeof(bsxItem) );
   sortcontext.reverseflag = reverseflag;
   switch( sortfield )
   {
@@ -1537,7 +1680,7 @@ int bsxSortInventory( bsxInventory *inv, int sortfield, int reverseflag )
       break;
   }
 
-  free( tmp );
+  mmAccountFree( MM_ACCOUNT_BSXITEM, tmp );
 
   return retvalue;
 }
@@ -1853,7 +1996,7 @@ bsxInventory *bsxDiffInventory( bsxInventory *dstinv, bsxInventory *srcinv )
 
   if( !( mmBitMapInit( &stockmap, dstinv->itemcount, 0 ) ) )
     return 0;
-  diffinv = bsxNewInventory();
+  diffinv = bsxNewArenaInventory();
   partcount = 0;
   srcitem = srcinv->itemlist;
   for( srcindex = 0 ; srcindex < srcinv->itemcount ; srcindex++, srcitem++ )
@@ -1916,7 +2059,7 @@ bsxInventory *bsxDiffInventoryByLotID( bsxInventory *dstinv, bsxInventory *srcin
 
   if( !( mmBitMapInit( &stockmap, dstinv->itemcount, 0 ) ) )
     return 0;
-  diffinv = bsxNewInventory();
+  diffinv = bsxNewArenaInventory();
   partcount = 0;
   srcitem = srcinv->itemlist;
   for( srcindex = 0 ; srcindex < srcinv->itemcount ; srcindex++, srcitem++ )
@@ -2160,10 +2303,7 @@ bsxItem *bsxNewItem( bsxInventory *inv )
 {
   bsxItem *item;
   if( inv->itemcount >= inv->itemalloc )
-  {
-    inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
-    inv->itemlist = realloc( inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
-  }
+    bsxGrowItemList( inv );
   item = &inv->itemlist[ inv->itemcount ];
   bsxClearItem( item );
 
@@ -2171,12 +2311,17 @@ bsxItem *bsxNewItem( bsxInventory *inv )
   return item;
 }
 
-static void bsxAddItemCopyString( bsxItem *item, char **dst, char *src, int allocflag )
+static void bsxAddItemCopyString( bsxInventory *inv, bsxItem *item, char **dst, char *src, int allocflag )
 {
   int len;
-  len = strlen( src ) + 1;
-  *dst = malloc( len );
-  memcpy( *dst, src, len );
+  len = strlen( src );
+  if( inv->arenaflag )
+  {
+    *dst = bsxArenaCopyString( inv, src, len );
+    return;
+  }
+  *dst = mmAccountAlloc( MM_ACCOUNT_STRING, len + 1 );
+  memcpy( *dst, src, len + 1 );
   item->flags |= allocflag;
   return;
 }
@@ -2185,27 +2330,24 @@ bsxItem *bsxAddItem( bsxInventory *inv, bsxItem *itemref )
 {
   bsxItem *item;
   if( inv->itemcount >= inv->itemalloc )
-  {
-    inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
-    inv->itemlist = realloc( inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
-  }
+    bsxGrowItemList( inv );
   item = &inv->itemlist[ inv->itemcount ];
   memcpy( item, itemref, sizeof(bsxItem) );
   item->flags = 0x0;
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_ID )
-    bsxAddItemCopyString( item, &item->id, itemref->id, BSX_ITEM_FLAGS_ALLOC_ID );
+    bsxAddItemCopyString( inv, item, &item->id, itemref->id, BSX_ITEM_FLAGS_ALLOC_ID );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_NAME )
-    bsxAddItemCopyString( item, &item->name, itemref->name, BSX_ITEM_FLAGS_ALLOC_NAME );
+    bsxAddItemCopyString( inv, item, &item->name, itemref->name, BSX_ITEM_FLAGS_ALLOC_NAME );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_TYPENAME )
-    bsxAddItemCopyString( item, &item->typename, itemref->typename, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
+    bsxAddItemCopyString( inv, item, &item->typename, itemref->typename, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_COLORNAME )
-    bsxAddItemCopyString( item, &item->colorname, itemref->colorname, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
+    bsxAddItemCopyString( inv, item, &item->colorname, itemref->colorname, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME )
-    bsxAddItemCopyString( item, &item->categoryname, itemref->categoryname, BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME );
+    bsxAddItemCopyString( inv, item, &item->categoryname, itemref->categoryname, BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_COMMENTS )
-    bsxAddItemCopyString( item, &item->comments, itemref->comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
+    bsxAddItemCopyString( inv, item, &item->comments, itemref->comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
   if( itemref->flags & BSX_ITEM_FLAGS_ALLOC_REMARKS )
-    bsxAddItemCopyString( item, &item->remarks, itemref->remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS );
+    bsxAddItemCopyString( inv, item, &item->remarks, itemref->remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS );
   inv->itemcount++;
   inv->partcount += item->quantity;
   inv->totalprice += (double)item->quantity * (double)item->price;
@@ -2217,27 +2359,24 @@ bsxItem *bsxAddCopyItem( bsxInventory *inv, bsxItem *itemref )
 {
   bsxItem *item;
   if( inv->itemcount >= inv->itemalloc )
-  {
-    inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
-    inv->itemlist = realloc( inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
-  }
+    bsxGrowItemList( inv );
   item = &inv->itemlist[ inv->itemcount ];
   memcpy( item, itemref, sizeof(bsxItem) );
   item->flags = 0x0;
   if( itemref->id )
-    bsxAddItemCopyString( item, &item->id, itemref->id, BSX_ITEM_FLAGS_ALLOC_ID );
+    bsxAddItemCopyString( inv, item, &item->id, itemref->id, BSX_ITEM_FLAGS_ALLOC_ID );
   if( itemref->name )
-    bsxAddItemCopyString( item, &item->name, itemref->name, BSX_ITEM_FLAGS_ALLOC_NAME );
+    bsxAddItemCopyString( inv, item, &item->name, itemref->name, BSX_ITEM_FLAGS_ALLOC_NAME );
   if( itemref->typename )
-    bsxAddItemCopyString( item, &item->typename, itemref->typename, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
+    bsxAddItemCopyString( inv, item, &item->typename, itemref->typename, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
   if( itemref->colorname )
-    bsxAddItemCopyString( item, &item->colorname, itemref->colorname, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
+    bsxAddItemCopyString( inv, item, &item->colorname, itemref->colorname, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
   if( itemref->categoryname )
-    bsxAddItemCopyString( item, &item->categoryname, itemref->categoryname, BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME );
+    bsxAddItemCopyString( inv, item, &item->categoryname, itemref->categoryname, BSX_ITEM_FLAGS_ALLOC_CATEGORYNAME );
   if( itemref->comments )
-    bsxAddItemCopyString( item, &item->comments, itemref->comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
+    bsxAddItemCopyString( inv, item, &item->comments, itemref->comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
   if( itemref->remarks )
-    bsxAddItemCopyString( item, &item->remarks, itemref->remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS );
+    bsxAddItemCopyString( inv, item, &item->remarks, itemref->remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS );
   inv->itemcount++;
   inv->partcount += item->quantity;
   inv->totalprice += (double)item->quantity * (double)item->price;
@@ -2257,16 +2396,17 @@ void bsxRemoveItem( bsxInventory *inv, bsxItem *item )
 }
 
 
-static void bsxSetItemString( bsxItem *item, size_t offset, char *string, int len, int flag )
+static void bsxSetItemString( bsxInventory *inv, bsxItem *item, size_t offset, char *string, int len, int flag )
 {
   char *dst, **storage;
   storage = ADDRESS( item, offset );
   if( item->flags & flag )
   {
-    free( *storage );
+    mmAccountFree( MM_ACCOUNT_STRING, *storage );
     item->flags &= ~flag;
   }
   *storage = 0;
+  item->flags |= BSX_ITEM_FLAGS_TEXT_MODIFIED;
   if( !( string ) || !( len ) )
     return;
   if( len < 0 )
@@ -2279,7 +2419,12 @@ static void bsxSetItemString( bsxItem *item, size_t offset, char *string, int le
   if( len > 255 )
     len = 255;
 #endif
-  dst = malloc( len + 1 );
+  if( ( inv ) && ( inv->arenaflag ) )
+  {
+    *storage = bsxArenaCopyString( inv, string, len );
+    return;
+  }
+  dst = mmAccountAlloc( MM_ACCOUNT_STRING, len + 1 );
   memcpy( dst, string, len );
   dst[ len ] = 0;
   *storage = dst;
@@ -2290,14 +2435,14 @@ static void bsxSetItemString( bsxItem *item, size_t offset, char *string, int le
 
 void bsxSetItemId( bsxItem *item, char *id, int len )
 {
-  bsxSetItemString( item, offsetof(bsxItem,id), id, len, BSX_ITEM_FLAGS_ALLOC_ID );
+  bsxSetItemString( 0, item, offsetof(bsxItem,id), id, len, BSX_ITEM_FLAGS_ALLOC_ID );
   return;
 }
 
 void bsxSetItemName( bsxItem *item, char *name, int len )
 {
   int i;
-  bsxSetItemString( item, offsetof(bsxItem,name), name, len, BSX_ITEM_FLAGS_ALLOC_NAME );
+  bsxSetItemString( 0, item, offsetof(bsxItem,name), name, len, BSX_ITEM_FLAGS_ALLOC_NAME );
 #if 0
   /* Correction for '&' crapping BrickStore */
   if( item->name )
@@ -2314,25 +2459,55 @@ void bsxSetItemName( bsxItem *item, char *name, int len )
 
 void bsxSetItemTypeName( bsxItem *item, char *typename, int len )
 {
-  bsxSetItemString( item, offsetof(bsxItem,typename), typename, len, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
+  bsxSetItemString( 0, item, offsetof(bsxItem,typename), typename, len, BSX_ITEM_FLAGS_ALLOC_TYPENAME );
   return;
 }
 
 void bsxSetItemColorName( bsxItem *item, char *colorname, int len )
 {
-  bsxSetItemString( item, offsetof(bsxItem,colorname), colorname, len, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
+  bsxSetItemString( 0, item, offsetof(bsxItem,colorname), colorname, len, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
   return;
 }
 
 void bsxSetItemComments( bsxItem *item, char *comments, int len )
 {
-  bsxSetItemString( item, offsetof(bsxItem,comments), comments, len, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
+  bsxSetItemString( 0, item, offsetof(bsxItem,comments), comments, len, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
   return;
 }
 
 void bsxSetItemRemarks( bsxItem *item, char *remarks, int len )
 {
-  bsxSetItemString( item, offsetof(bsxItem,remarks), remarks, len, BSX_ITEM_FLAGS_ALLOC_REMARKS );
+  bsxSetItemString( 0, item, offsetof(bsxItem,remarks), remarks, len, BSX_ITEM_FLAGS_ALLOC_REMARKS );
+  return;
+}
+
+void bsxSetInvItemId( bsxInventory *inv, bsxItem *item, char *id, int len )
+{
+  bsxSetItemString( inv, item, offsetof(bsxItem,id), id, len, BSX_ITEM_FLAGS_ALLOC_ID );
+  return;
+}
+
+void bsxSetInvItemName( bsxInventory *inv, bsxItem *item, char *name, int len )
+{
+  bsxSetItemString( inv, item, offsetof(bsxItem,name), name, len, BSX_ITEM_FLAGS_ALLOC_NAME );
+  return;
+}
+
+void bsxSetInvItemColorName( bsxInventory *inv, bsxItem *item, char *colorname, int len )
+{
+  bsxSetItemString( inv, item, offsetof(bsxItem,colorname), colorname, len, BSX_ITEM_FLAGS_ALLOC_COLORNAME );
+  return;
+}
+
+void bsxSetInvItemComments( bsxInventory *inv, bsxItem *item, char *comments, int len )
+{
+  bsxSetItemString( inv, item, offsetof(bsxItem,comments), comments, len, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
+  return;
+}
+
+void bsxSetInvItemRemarks( bsxInventory *inv, bsxItem *item, char *remarks, int len )
+{
+  bsxSetItemString( inv, item, offsetof(bsxItem,remarks), remarks, len, BSX_ITEM_FLAGS_ALLOC_REMARKS );
   return;
 }
 
@@ -2457,3 +2632,274 @@ void bsxVerifyItem( bsxItem *item )
   return;
 }
 
+
+
+////
+
+
+/* Reindexed items leave their old postings behind, rebuild when these accumulate */
+#define BSX_TEXTINDEX_STALE_MIN (4096)
+
+#define BSX_TEXTINDEX_TRIGRAM(s) ( (uint32_t)((unsigned char *)(s))[0] | ( (uint32_t)((unsigned char *)(s))[1] << 8 ) | ( (uint32_t)((unsigned char *)(s))[2] << 16 ) )
+
+typedef struct
+{
+  uint32_t trigram;
+  int count;
+  int alloc;
+  int *list;
+} bsxTextPosting;
+
+struct bsxTextIndex
+{
+  int itemcount;
+  int stalecount;
+  int postingcount;
+  uint32_t hashmask;
+  bsxTextPosting *postingtable;
+};
+
+
+static void bsxTextIndexFree( bsxInventory *inv )
+{
+  uint32_t hashindex;
+  struct bsxTextIndex *textindex;
+
+  textindex = inv->textindex;
+  if( !( textindex ) )
+    return;
+  for( hashindex = 0 ; hashindex <= textindex->hashmask ; hashindex++ )
+  {
+    if( textindex->postingtable[hashindex].list )
+      free( textindex->postingtable[hashindex].list );
+  }
+  free( textindex->postingtable );
+  free( textindex );
+  inv->textindex = 0;
+  return;
+}
+
+
+static bsxTextPosting *bsxTextIndexSlot( bsxTextPosting *postingtable, uint32_t hashmask, uint32_t trigram )
+{
+  uint32_t hashindex;
+  bsxTextPosting *posting;
+  for( hashindex = ccHash32Int32Inline( trigram ) & hashmask ; ; hashindex = ( hashindex + 1 ) & hashmask )
+  {
+    posting = &postingtable[hashindex];
+    if( ( posting->trigram == trigram ) || !( posting->trigram ) )
+      return posting;
+  }
+  return 0;
+}
+
+
+static void bsxTextIndexGrow( struct bsxTextIndex *textindex )
+{
+  uint32_t hashindex, hashmask;
+  bsxTextPosting *postingtable;
+
+  hashmask = ( textindex->hashmask << 1 ) | 0x1;
+  postingtable = malloc( ( hashmask + 1 ) * sizeof(bsxTextPosting) );
+  memset( postingtable, 0, ( hashmask + 1 ) * sizeof(bsxTextPosting) );
+  for( hashindex = 0 ; hashindex <= textindex->hashmask ; hashindex++ )
+  {
+    if( textindex->postingtable[hashindex].trigram )
+      *bsxTextIndexSlot( postingtable, hashmask, textindex->postingtable[hashindex].trigram ) = textindex->postingtable[hashindex];
+  }
+  free( textindex->postingtable );
+  textindex->postingtable = postingtable;
+  textindex->hashmask = hashmask;
+  return;
+}
+
+
+static void bsxTextIndexAdd( struct bsxTextIndex *textindex, uint32_t trigram, int itemindex )
+{
+  int low, high, mid;
+  bsxTextPosting *posting;
+
+  if( textindex->postingcount >= ( textindex->hashmask >> 1 ) )
+    bsxTextIndexGrow( textindex );
+  posting = bsxTextIndexSlot( textindex->postingtable, textindex->hashmask, trigram );
+  if( !( posting->trigram ) )
+  {
+    posting->trigram = trigram;
+    textindex->postingcount++;
+  }
+
+  /* Lists are kept sorted, items are usually indexed in order */
+  low = posting->count;
+  if( ( posting->count ) && ( posting->list[ posting->count - 1 ] >= itemindex ) )
+  {
+    low = 0;
+    high = posting->count - 1;
+    while( low <= high )
+    {
+      mid = ( low + high ) >> 1;
+      if( posting->list[mid] == itemindex )
+        return;
+      if( posting->list[mid] < itemindex )
+        low = mid + 1;
+      else
+        high = mid - 1;
+    }
+  }
+  if( posting->count >= posting->alloc )
+  {
+    posting->alloc = ( posting->alloc ? posting->alloc << 1 : 4 );
+    posting->list = realloc( posting->list, posting->alloc * sizeof(int) );
+  }
+  if( low < posting->count )
+    memmove( &posting->list[ low + 1 ], &posting->list[ low ], ( posting->count - low ) * sizeof(int) );
+  posting->list[ low ] = itemindex;
+  posting->count++;
+  return;
+}
+
+
+static void bsxTextIndexString( struct bsxTextIndex *textindex, char *string, int itemindex )
+{
+  if( !( string ) )
+    return;
+  for( ; ( string[0] ) && ( string[1] ) && ( string[2] ) ; string++ )
+    bsxTextIndexAdd( textindex, BSX_TEXTINDEX_TRIGRAM( string ), itemindex );
+  return;
+}
+
+
+static void bsxTextIndexItem( struct bsxTextIndex *textindex, bsxItem *item, int itemindex )
+{
+  item->flags &= ~BSX_ITEM_FLAGS_TEXT_MODIFIED;
+  if( item->flags & BSX_ITEM_FLAGS_DELETED )
+    return;
+  bsxTextIndexString( textindex, item->id, itemindex );
+  bsxTextIndexString( textindex, item->name, itemindex );
+  bsxTextIndexString( textindex, item->typename, itemindex );
+  bsxTextIndexString( textindex, item->colorname, itemindex );
+  bsxTextIndexString( textindex, item->categoryname, itemindex );
+  bsxTextIndexString( textindex, item->comments, itemindex );
+  bsxTextIndexString( textindex, item->remarks, itemindex );
+  return;
+}
+
+
+/* Index new items and reindex the modified ones */
+static struct bsxTextIndex *bsxTextIndexUpdate( bsxInventory *inv )
+{
+  int itemindex;
+  bsxItem *item;
+  struct bsxTextIndex *textindex;
+
+  textindex = inv->textindex;
+  if( ( textindex ) && ( ( textindex->itemcount > inv->itemcount ) || ( textindex->stalecount > ( textindex->itemcount >> 1 ) + BSX_TEXTINDEX_STALE_MIN ) ) )
+  {
+    bsxTextIndexFree( inv );
+    textindex = 0;
+  }
+  if( !( textindex ) )
+  {
+    textindex = malloc( sizeof(struct bsxTextIndex) );
+    memset( textindex, 0, sizeof(struct bsxTextIndex) );
+    textindex->hashmask = 4095;
+    textindex->postingtable = malloc( ( textindex->hashmask + 1 ) * sizeof(bsxTextPosting) );
+    memset( textindex->postingtable, 0, ( textindex->hashmask + 1 ) * sizeof(bsxTextPosting) );
+    inv->textindex = textindex;
+  }
+
+  item = inv->itemlist;
+  for( itemindex = 0 ; itemindex < textindex->itemcount ; itemindex++, item++ )
+  {
+    if( !( item->flags & BSX_ITEM_FLAGS_TEXT_MODIFIED ) )
+      continue;
+    bsxTextIndexItem( textindex, item, itemindex );
+    textindex->stalecount++;
+  }
+  for( ; itemindex < inv->itemcount ; itemindex++, item++ )
+    bsxTextIndexItem( textindex, item, itemindex );
+  textindex->itemcount = inv->itemcount;
+
+  return textindex;
+}
+
+
+int bsxTextIndexQuery( bsxInventory *inv, int termcount, char **termlist, int **retlist )
+{
+  int termindex, postingindex, postingcount, postingalloc, listindex, listcount, dstindex, low, high, mid;
+  int *list;
+  char *string;
+  bsxTextPosting *posting;
+  bsxTextPosting **postinglist;
+  struct bsxTextIndex *textindex;
+
+  *retlist = 0;
+  textindex = bsxTextIndexUpdate( inv );
+
+  /* Gather the posting lists of all trigrams */
+  postingcount = 0;
+  postingalloc = 0;
+  postinglist = 0;
+  for( termindex = 0 ; termindex < termcount ; termindex++ )
+  {
+    for( string = termlist[termindex] ; ( string[0] ) && ( string[1] ) && ( string[2] ) ; string++ )
+    {
+      posting = bsxTextIndexSlot( textindex->postingtable, textindex->hashmask, BSX_TEXTINDEX_TRIGRAM( string ) );
+      if( !( posting->count ) )
+      {
+        free( postinglist );
+        return 0;
+      }
+      if( postingcount >= postingalloc )
+      {
+        postingalloc = ( postingalloc ? postingalloc << 1 : 16 );
+        postinglist = realloc( postinglist, postingalloc * sizeof(bsxTextPosting *) );
+      }
+      postinglist[ postingcount++ ] = posting;
+    }
+  }
+  if( !( postingcount ) )
+    return -1;
+
+  /* Intersect starting from the shortest list */
+  for( postingindex = 1 ; postingindex < postingcount ; postingindex++ )
+  {
+    posting = postinglist[postingindex];
+    if( posting->count < postinglist[0]->count )
+    {
+      postinglist[postingindex] = postinglist[0];
+      postinglist[0] = posting;
+    }
+  }
+  listcount = postinglist[0]->count;
+  list = malloc( listcount * sizeof(int) );
+  memcpy( list, postinglist[0]->list, listcount * sizeof(int) );
+  for( postingindex = 1 ; ( postingindex < postingcount ) && ( listcount ) ; postingindex++ )
+  {
+    posting = postinglist[postingindex];
+    if( posting == postinglist[0] )
+      continue;
+    dstindex = 0;
+    low = 0;
+    for( listindex = 0 ; listindex < listcount ; listindex++ )
+    {
+      high = posting->count - 1;
+      while( low <= high )
+      {
+        mid = ( low + high ) >> 1;
+        if( posting->list[mid] < list[listindex] )
+          low = mid + 1;
+        else
+          high = mid - 1;
+      }
+      if( low >= posting->count )
+        break;
+      if( posting->list[low] == list[listindex] )
+        list[ dstindex++ ] = list[listindex];
+    }
+    listcount = dstindex;
+  }
+  free( postinglist );
+
+  *retlist = list;
+  return listcount;
+}
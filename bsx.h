@@ -117,6 +117,8 @@ typedef struct
 #define BSX_ITEM_FLAGS_ALLOC_COMMENTS (0x20)
 #define BSX_ITEM_FLAGS_ALLOC_REMARKS (0x40)
 #define BSX_ITEM_FLAGS_DELETED (0x80)
+/* A text field changed since the item was last indexed */
+#define BSX_ITEM_FLAGS_TEXT_MODIFIED (0x40000000)
 
 /* Flags meant for custom usage */
 #define BSX_ITEM_XFLAGS_TO_CREATE (0x100)
@@ -170,6 +172,13 @@ typedef struct
   int partcount;
   double totalprice;
   double totalorigprice;
+
+  /* Trigram index of text fields, built on the first search */
+  struct bsxTextIndex *textindex;
+
+  /* Arena inventories hold their item list and copied strings in an arena, released at once */
+  int arenaflag;
+  struct bsxArena *arena;
 } bsxInventory;
 
 
@@ -177,10 +186,14 @@ typedef struct
 
 
 bsxInventory *bsxNewInventory();
+/* For short-lived inventories built by copying items : strings are not freed individually */
+bsxInventory *bsxNewArenaInventory();
 int bsxLoadInventory( bsxInventory *inv, char *path );
 int bsxSaveInventory( char *path, bsxInventory *inv, int fsyncflag, int sortcolumn );
 void bsxEmptyInventory( bsxInventory *inv );
 void bsxFreeInventory( bsxInventory *inv );
+/* Move the item list and strings of an arena inventory to the heap, before keeping it as a long-lived inventory */
+void bsxDetachInventoryArena( bsxInventory *inv );
 
 /* If many items were deleted from inventory, repack the list */
 void bsxPackInventory( bsxInventory *inv );
@@ -297,8 +310,23 @@ void bsxSetItemColorName( bsxItem *item, char *colorname, int len );
 void bsxSetItemComments( bsxItem *item, char *comments, int len );
 void bsxSetItemRemarks( bsxItem *item, char *remarks, int len );
 
+/* Same as above, the string is copied in the arena of arena inventories */
+void bsxSetInvItemId( bsxInventory *inv, bsxItem *item, char *id, int len );
+void bsxSetInvItemName( bsxInventory *inv, bsxItem *item, char *name, int len );
+void bsxSetInvItemColorName( bsxInventory *inv, bsxItem *item, char *colorname, int len );
+void bsxSetInvItemComments( bsxInventory *inv, bsxItem *item, char *comments, int len );
+void bsxSetInvItemRemarks( bsxInventory *inv, bsxItem *item, char *remarks, int len );
+
 void bsxSetItemQuantity( bsxInventory *inv, bsxItem *item, int quantity );
 
+
+////
+
+
+/* Build the sorted list of item indices whose text fields may contain all the terms, for exact verification by the caller */
+/* Terms shorter than 3 chars are ignored, returns -1 if no term was usable, the list must be free()'d */
+int bsxTextIndexQuery( bsxInventory *inv, int termcount, char **termlist, int **retlist );
+
 size_t bsxGetItemListIndex( bsxInventory *inv, bsxItem *item );
 
 void bsxVerifyItem( bsxItem *item );
@@ -39,15 +39,17 @@
 #include "cryptsha1.h"
 
 
-/* For mkdir() */
+/* For mkdir() and utime() */
 #if CC_UNIX
  #include <sys/types.h>
  #include <sys/stat.h>
  #include <unistd.h>
+ #include <utime.h>
 #elif CC_WINDOWS
  #include <windows.h>
  #include <sys/types.h>
  #include <sys/stat.h>
+ #include <sys/utime.h>
  #include <direct.h>  // This ensures _mkdir is correctly recognized on Windows platforms.
 #else
  #error Unknown/Unsupported platform!
@@ -80,6 +82,26 @@ static int bsxPgMkDir( char *path )
 }
 
 
+static int bsxPgSetModTime( char *path, int64_t modtime )
+{
+  int retval;
+#if CC_UNIX
+  struct utimbuf timebuf;
+  timebuf.actime = (time_t)modtime;
+  timebuf.modtime = (time_t)modtime;
+  retval = utime( path, &timebuf );
+#elif CC_WINDOWS
+  struct _utimbuf timebuf;
+  timebuf.actime = (time_t)modtime;
+  timebuf.modtime = (time_t)modtime;
+  retval = _utime( path, &timebuf );
+#else
+ #error Unknown/Unsupported platform!
+#endif
+  return ( retval == 0 );
+}
+
+
 /* Returned string must be freed() */
 char *bsxPriceGuidePath( char *basepath, char itemtypeid, char *itemid, int itemcolorid, int flags )
 {
@@ -277,3 +299,374 @@ printf( "Writing Price Guide for : %c %s %d\n", itemtypeid, itemid, itemcolorid
 ////
 
 
+
+
+#define BSX_PRICEGUIDE_DB_MAGIC (0x42444750)
+#define BSX_PRICEGUIDE_DB_VERSION (1)
+#define BSX_PRICEGUIDE_DB_HASHBITS_MIN (12)
+#define BSX_PRICEGUIDE_DB_ID_LENGTH (40)
+
+/* The file is a header, followed by recordalloc records and the index of 1<<hashbits slots */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t recordsize;
+  uint32_t hashbits;
+  uint32_t recordcount;
+  uint32_t recordalloc;
+  /* Cleared while the file is open, the index is rebuilt if it wasn't closed properly */
+  uint32_t cleanflag;
+  uint32_t reserved[9];
+} bsxPriceGuideDbHeader;
+
+typedef struct
+{
+  /* Key, zero-padded */
+  char itemid[BSX_PRICEGUIDE_DB_ID_LENGTH];
+  int32_t colorid;
+  char typeid;
+  char reserved[3];
+  /* Data */
+  bsxPriceGuide pgnew;
+  bsxPriceGuide pgused;
+  uint32_t checksum;
+  uint32_t padding;
+} bsxPriceGuideRecord;
+
+#define BSX_PRICEGUIDE_DB_KEY_SIZE (offsetof(bsxPriceGuideRecord,pgnew))
+
+
+static size_t bsxPgDbFileSize( uint32_t hashbits )
+{
+  return sizeof(bsxPriceGuideDbHeader) + ( (size_t)1 << ( hashbits - 1 ) ) * sizeof(bsxPriceGuideRecord) + ( (size_t)1 << hashbits ) * sizeof(uint32_t);
+}
+
+static void bsxPgDbSetTables( bsxPriceGuideDb *pgdb )
+{
+  bsxPriceGuideDbHeader *header;
+  header = pgdb->map.data;
+  pgdb->records = ADDRESS( header, sizeof(bsxPriceGuideDbHeader) );
+  pgdb->slots = ADDRESS( pgdb->records, (size_t)header->recordalloc * sizeof(bsxPriceGuideRecord) );
+  pgdb->hashmask = ( 1 << header->hashbits ) - 1;
+  return;
+}
+
+static int bsxPgDbSetKey( bsxPriceGuideRecord *key, char itemtypeid, char *itemid, int itemcolorid )
+{
+  int length;
+  length = strlen( itemid );
+  if( ( length <= 0 ) || ( length >= BSX_PRICEGUIDE_DB_ID_LENGTH ) )
+    return 0;
+  memset( key, 0, BSX_PRICEGUIDE_DB_KEY_SIZE );
+  memcpy( key->itemid, itemid, length );
+  key->colorid = itemcolorid;
+  key->typeid = itemtypeid;
+  return 1;
+}
+
+static inline uint32_t bsxPgDbChecksum( bsxPriceGuideRecord *record )
+{
+  return ccHash32Data( record, offsetof(bsxPriceGuideRecord,checksum) );
+}
+
+/* Return the slot holding the key, or the empty slot where it belongs */
+static uint32_t *bsxPgDbFindSlot( bsxPriceGuideDb *pgdb, bsxPriceGuideRecord *key )
+{
+  uint32_t hashindex;
+  uint32_t *slot;
+  bsxPriceGuideRecord *record;
+  for( hashindex = ccHash32Data( key, BSX_PRICEGUIDE_DB_KEY_SIZE ) & pgdb->hashmask ; ; hashindex = ( hashindex + 1 ) & pgdb->hashmask )
+  {
+    slot = &pgdb->slots[hashindex];
+    if( !( *slot ) )
+      break;
+    record = &((bsxPriceGuideRecord *)pgdb->records)[ *slot - 1 ];
+    if( memcmp( record, key, BSX_PRICEGUIDE_DB_KEY_SIZE ) == 0 )
+      break;
+  }
+  return slot;
+}
+
+static void bsxPgDbBuildIndex( bsxPriceGuideDb *pgdb )
+{
+  uint32_t recordindex;
+  bsxPriceGuideDbHeader *header;
+  bsxPriceGuideRecord *record;
+  header = pgdb->map.data;
+  memset( pgdb->slots, 0, ( (size_t)pgdb->hashmask + 1 ) * sizeof(uint32_t) );
+  for( recordindex = 0 ; recordindex < header->recordcount ; recordindex++ )
+  {
+    record = &((bsxPriceGuideRecord *)pgdb->records)[recordindex];
+    if( record->checksum == bsxPgDbChecksum( record ) )
+      *bsxPgDbFindSlot( pgdb, record ) = recordindex + 1;
+  }
+  return;
+}
+
+static int bsxPgDbInitFile( bsxPriceGuideDb *pgdb )
+{
+  bsxPriceGuideDbHeader *header;
+  ccFileMapClose( &pgdb->map );
+  remove( pgdb->path );
+  if( !( ccFileMapOpenWrite( &pgdb->map, pgdb->path, bsxPgDbFileSize( BSX_PRICEGUIDE_DB_HASHBITS_MIN ) ) ) )
+    return 0;
+  header = pgdb->map.data;
+  memset( header, 0, sizeof(bsxPriceGuideDbHeader) );
+  header->magic = BSX_PRICEGUIDE_DB_MAGIC;
+  header->version = BSX_PRICEGUIDE_DB_VERSION;
+  header->recordsize = sizeof(bsxPriceGuideRecord);
+  header->hashbits = BSX_PRICEGUIDE_DB_HASHBITS_MIN;
+  header->recordcount = 0;
+  header->recordalloc = 1 << ( BSX_PRICEGUIDE_DB_HASHBITS_MIN - 1 );
+  bsxPgDbSetTables( pgdb );
+  memset( pgdb->slots, 0, ( (size_t)pgdb->hashmask + 1 ) * sizeof(uint32_t) );
+  return 1;
+}
+
+/* Double the capacity, records stay in place and the index is rebuilt past them */
+static int bsxPgDbGrow( bsxPriceGuideDb *pgdb )
+{
+  uint32_t hashbits;
+  bsxPriceGuideDbHeader *header;
+  header = pgdb->map.data;
+  hashbits = header->hashbits + 1;
+  if( hashbits > 30 )
+    return 0;
+  ccFileMapClose( &pgdb->map );
+  if( !( ccFileMapOpenWrite( &pgdb->map, pgdb->path, bsxPgDbFileSize( hashbits ) ) ) )
+    return 0;
+  header = pgdb->map.data;
+  header->hashbits = hashbits;
+  header->recordalloc = 1 << ( hashbits - 1 );
+  bsxPgDbSetTables( pgdb );
+  bsxPgDbBuildIndex( pgdb );
+  return 1;
+}
+
+
+int bsxPriceGuideDbOpen( bsxPriceGuideDb *pgdb, char *path )
+{
+  bsxPriceGuideDbHeader *header;
+
+  memset( pgdb, 0, sizeof(bsxPriceGuideDb) );
+  pgdb->path = path;
+  if( !( ccFileMapOpenWrite( &pgdb->map, path, sizeof(bsxPriceGuideDbHeader) ) ) )
+    return 0;
+  header = pgdb->map.data;
+  if( ( header->magic != BSX_PRICEGUIDE_DB_MAGIC ) || ( header->version != BSX_PRICEGUIDE_DB_VERSION ) || ( header->recordsize != sizeof(bsxPriceGuideRecord) ) || ( header->hashbits < BSX_PRICEGUIDE_DB_HASHBITS_MIN ) || ( header->hashbits > 30 ) || ( header->recordalloc != ( 1 << ( header->hashbits - 1 ) ) ) || ( header->recordcount > header->recordalloc ) || ( pgdb->map.size < bsxPgDbFileSize( header->hashbits ) ) )
+  {
+    /* Missing or unusable, start from scratch */
+    if( !( bsxPgDbInitFile( pgdb ) ) )
+      return 0;
+  }
+  else
+  {
+    bsxPgDbSetTables( pgdb );
+    if( !( header->cleanflag ) )
+      bsxPgDbBuildIndex( pgdb );
+  }
+  header = pgdb->map.data;
+  header->cleanflag = 0;
+  return 1;
+}
+
+
+void bsxPriceGuideDbClose( bsxPriceGuideDb *pgdb )
+{
+  bsxPriceGuideDbHeader *header;
+  if( !( pgdb->map.data ) )
+    return;
+  header = pgdb->map.data;
+  ccFileMapSync( &pgdb->map );
+  header->cleanflag = 1;
+  ccFileMapClose( &pgdb->map );
+  memset( pgdb, 0, sizeof(bsxPriceGuideDb) );
+  return;
+}
+
+
+int bsxPriceGuideDbRead( bsxPriceGuideDb *pgdb, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition )
+{
+  uint32_t *slot;
+  bsxPriceGuideRecord key, *record;
+
+  if( !( pgdb->map.data ) )
+    return 0;
+  if( !( bsxPgDbSetKey( &key, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  slot = bsxPgDbFindSlot( pgdb, &key );
+  if( !( *slot ) )
+    return 0;
+  record = &((bsxPriceGuideRecord *)pgdb->records)[ *slot - 1 ];
+  if( record->checksum != bsxPgDbChecksum( record ) )
+    return 0;
+  *pg = ( itemcondition == 'N' ? record->pgnew : record->pgused );
+  return 1;
+}
+
+
+int bsxPriceGuideDbWrite( bsxPriceGuideDb *pgdb, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid )
+{
+  uint32_t recordindex;
+  uint32_t *slot;
+  bsxPriceGuideDbHeader *header;
+  bsxPriceGuideRecord key, *record;
+
+  if( !( pgdb->map.data ) )
+    return 0;
+  if( !( bsxPgDbSetKey( &key, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  slot = bsxPgDbFindSlot( pgdb, &key );
+  if( *slot )
+    recordindex = *slot - 1;
+  else
+  {
+    header = pgdb->map.data;
+    if( header->recordcount >= header->recordalloc )
+    {
+      if( !( bsxPgDbGrow( pgdb ) ) )
+        return 0;
+      header = pgdb->map.data;
+      slot = bsxPgDbFindSlot( pgdb, &key );
+    }
+    recordindex = header->recordcount++;
+    *slot = recordindex + 1;
+  }
+  record = &((bsxPriceGuideRecord *)pgdb->records)[recordindex];
+  memcpy( record, &key, BSX_PRICEGUIDE_DB_KEY_SIZE );
+  record->pgnew = *pgnew;
+  record->pgused = *pgused;
+  record->padding = 0;
+  record->checksum = bsxPgDbChecksum( record );
+  return 1;
+}
+
+
+int bsxPriceGuideDbCount( bsxPriceGuideDb *pgdb )
+{
+  bsxPriceGuideDbHeader *header;
+  if( !( pgdb->map.data ) )
+    return 0;
+  header = pgdb->map.data;
+  return header->recordcount;
+}
+
+
+////
+
+
+static int bsxPgDbImportItem( bsxPriceGuideDb *pgdb, char *basepath, int flags, char itemtypeid, char *itemid, int itemcolorid )
+{
+  int retval;
+  char *path;
+  bsxPriceGuide pgnew, pgused;
+
+  path = bsxPriceGuidePath( basepath, itemtypeid, itemid, itemcolorid, flags );
+  retval = 0;
+  if( ( path ) && ( bsxReadPriceGuide( &pgnew, path, 'N' ) ) && ( bsxReadPriceGuide( &pgused, path, 'U' ) ) )
+    retval = bsxPriceGuideDbWrite( pgdb, &pgnew, &pgused, itemtypeid, itemid, itemcolorid );
+  free( path );
+  return retval;
+}
+
+/* Directory holding one subdirectory per item, each holding one subdirectory per color */
+static int bsxPgDbImportItemDir( bsxPriceGuideDb *pgdb, char *basepath, int flags, char itemtypeid, char *itemdirpath )
+{
+  int count, itemcolorid;
+  char *itemid, *colorname, *colordirpath;
+  ccDir *itemdir, *colordir;
+
+  count = 0;
+  if( !( itemdir = ccOpenDir( itemdirpath ) ) )
+    return 0;
+  while( ( itemid = ccReadDir( itemdir ) ) )
+  {
+    if( itemid[0] == '.' )
+      continue;
+    colordirpath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%s", itemdirpath, itemid );
+    if( ( colordir = ccOpenDir( colordirpath ) ) )
+    {
+      while( ( colorname = ccReadDir( colordir ) ) )
+      {
+        if( ccStrParseInt32( colorname, &itemcolorid ) )
+          count += bsxPgDbImportItem( pgdb, basepath, flags, itemtypeid, itemid, itemcolorid );
+      }
+      ccCloseDir( colordir );
+    }
+    free( colordirpath );
+  }
+  ccCloseDir( itemdir );
+  return count;
+}
+
+int bsxPriceGuideDbImport( bsxPriceGuideDb *pgdb, char *basepath, int flags )
+{
+  int count, prefix0, prefix1;
+  char *typename, *itemdirpath;
+  ccDir *typedir;
+  static const char hexdigits[] = "0123456789abcdef";
+
+  count = 0;
+  if( !( typedir = ccOpenDir( basepath ) ) )
+    return 0;
+  while( ( typename = ccReadDir( typedir ) ) )
+  {
+    if( !( typename[0] ) || ( typename[1] ) || ( typename[0] == '.' ) )
+      continue;
+    if( flags & BSX_PRICEGUIDE_FLAGS_BRICKSTORE )
+    {
+      itemdirpath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%c", basepath, typename[0] );
+      count += bsxPgDbImportItemDir( pgdb, basepath, flags, typename[0], itemdirpath );
+      free( itemdirpath );
+    }
+    else if( flags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
+    {
+      /* Items are spread over two levels of hexadecimal prefixes of their SHA-1 */
+      for( prefix0 = 0 ; prefix0 < 16 ; prefix0++ )
+      {
+        for( prefix1 = 0 ; prefix1 < 16 ; prefix1++ )
+        {
+          itemdirpath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%c" CC_DIR_SEPARATOR_STRING "%c" CC_DIR_SEPARATOR_STRING "%c", basepath, typename[0], hexdigits[prefix0], hexdigits[prefix1] );
+          count += bsxPgDbImportItemDir( pgdb, basepath, flags, typename[0], itemdirpath );
+          free( itemdirpath );
+        }
+      }
+    }
+  }
+  ccCloseDir( typedir );
+  return count;
+}
+
+
+int bsxPriceGuideDbExport( bsxPriceGuideDb *pgdb, char *basepath, int flags )
+{
+  int count;
+  uint32_t recordindex;
+  char *path;
+  bsxPriceGuideDbHeader *header;
+  bsxPriceGuideRecord *record;
+
+  if( !( pgdb->map.data ) )
+    return -1;
+  bsxPgMkDir( basepath );
+  header = pgdb->map.data;
+  count = 0;
+  for( recordindex = 0 ; recordindex < header->recordcount ; recordindex++ )
+  {
+    record = &((bsxPriceGuideRecord *)pgdb->records)[recordindex];
+    if( record->checksum != bsxPgDbChecksum( record ) )
+      continue;
+    path = bsxPriceGuidePath( basepath, record->typeid, record->itemid, record->colorid, flags | BSX_PRICEGUIDE_FLAGS_MKDIR );
+    if( !( bsxWritePriceGuide( &record->pgnew, &record->pgused, path, record->typeid, record->itemid, record->colorid ) ) )
+    {
+      free( path );
+      return -1;
+    }
+    /* Preserve the fetch time, BrickStore and BrickStock use the file's modification time */
+    bsxPgSetModTime( path, record->pgnew.modtime );
+    free( path );
+    count++;
+  }
+  return count;
+}
@@ -46,6 +46,8 @@ char *bsxPriceGuidePath( char *basepath, char itemtypeid, char *itemid, int item
 #define BSX_PRICEGUIDE_FLAGS_BRICKSTORE (0x1)
 #define BSX_PRICEGUIDE_FLAGS_BRICKSTOCK (0x2)
 #define BSX_PRICEGUIDE_FLAGS_MKDIR (0x4)
+/* Single-file cache, see bsxPriceGuideDb */
+#define BSX_PRICEGUIDE_FLAGS_DATABASE (0x8)
 
 
 int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition );
@@ -53,3 +55,31 @@ int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition );
 int bsxWritePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *path, char itemtypeid, char *itemid, int itemcolorid );
 
 
+
+
+////
+
+
+/* Single-file price guide cache, a memory-mapped array of fixed-size records with an open-addressing index */
+typedef struct
+{
+  char *path;
+  ccFileMap map;
+  void *records;
+  uint32_t *slots;
+  uint32_t hashmask;
+} bsxPriceGuideDb;
+
+int bsxPriceGuideDbOpen( bsxPriceGuideDb *pgdb, char *path );
+void bsxPriceGuideDbClose( bsxPriceGuideDb *pgdb );
+
+int bsxPriceGuideDbRead( bsxPriceGuideDb *pgdb, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition );
+int bsxPriceGuideDbWrite( bsxPriceGuideDb *pgdb, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid );
+
+/* Count of price guides stored */
+int bsxPriceGuideDbCount( bsxPriceGuideDb *pgdb );
+
+/* Import all price guides of a BrickStore/BrickStock cache directory, return count imported */
+int bsxPriceGuideDbImport( bsxPriceGuideDb *pgdb, char *basepath, int flags );
+/* Export all price guides to a BrickStore/BrickStock cache directory, return count exported or -1 on failure */
+int bsxPriceGuideDbExport( bsxPriceGuideDb *pgdb, char *basepath, int flags );
@@ -47,6 +47,7 @@
  #include <sys/utsname.h> /* For uname() */
  #include <dirent.h> /* For readdir() */
  #include <sys/statvfs.h> /* For statvfs( ) */
+ #include <sys/mman.h> /* For mmap() */
 #elif CC_WINDOWS
  #include <windows.h>
  #include <direct.h>
@@ -1657,6 +1658,176 @@ int ccRenameFile( char *oldpath, char *newpath )
 ////
 
 
+int ccFileMapOpen( ccFileMap *filemap, const char *path )
+{
+#if CC_UNIX
+  int fd;
+  struct stat filestat;
+  void *data;
+  memset( filemap, 0, sizeof(ccFileMap) );
+  if( ( fd = open( path, O_RDONLY ) ) == -1 )
+    return 0;
+  if( ( fstat( fd, &filestat ) != 0 ) || ( filestat.st_size <= 0 ) )
+  {
+    close( fd );
+    return 0;
+  }
+  data = mmap( 0, filestat.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( data == MAP_FAILED )
+    return 0;
+  filemap->data = data;
+  filemap->size = filestat.st_size;
+  return 1;
+#elif CC_WINDOWS
+  HANDLE file, mapping;
+  LARGE_INTEGER filesize;
+  void *data;
+  memset( filemap, 0, sizeof(ccFileMap) );
+  file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+  if( file == INVALID_HANDLE_VALUE )
+    return 0;
+  if( !( GetFileSizeEx( file, &filesize ) ) || ( filesize.QuadPart <= 0 ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  mapping = CreateFileMappingA( file, 0, PAGE_READONLY, 0, 0, 0 );
+  if( !( mapping ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+  if( !( data ) )
+  {
+    CloseHandle( mapping );
+    CloseHandle( file );
+    return 0;
+  }
+  filemap->data = data;
+  filemap->size = (size_t)filesize.QuadPart;
+  filemap->filehandle = (void *)file;
+  filemap->maphandle = (void *)mapping;
+  return 1;
+#else
+  memset( filemap, 0, sizeof(ccFileMap) );
+  return 0;
+#endif
+}
+
+int ccFileMapOpenWrite( ccFileMap *filemap, const char *path, size_t minsize )
+{
+#if CC_UNIX
+  int fd;
+  struct stat filestat;
+  void *data;
+  memset( filemap, 0, sizeof(ccFileMap) );
+  if( ( fd = open( path, O_RDWR | O_CREAT, 0644 ) ) == -1 )
+    return 0;
+  if( fstat( fd, &filestat ) != 0 )
+  {
+    close( fd );
+    return 0;
+  }
+  if( (size_t)filestat.st_size < minsize )
+  {
+    if( ftruncate( fd, minsize ) != 0 )
+    {
+      close( fd );
+      return 0;
+    }
+    filestat.st_size = minsize;
+  }
+  if( filestat.st_size <= 0 )
+  {
+    close( fd );
+    return 0;
+  }
+  data = mmap( 0, filestat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( data == MAP_FAILED )
+    return 0;
+  filemap->data = data;
+  filemap->size = filestat.st_size;
+  return 1;
+#elif CC_WINDOWS
+  HANDLE file, mapping;
+  LARGE_INTEGER filesize;
+  void *data;
+  memset( filemap, 0, sizeof(ccFileMap) );
+  file = CreateFileA( path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+  if( file == INVALID_HANDLE_VALUE )
+    return 0;
+  if( !( GetFileSizeEx( file, &filesize ) ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  if( (size_t)filesize.QuadPart < minsize )
+    filesize.QuadPart = minsize;
+  if( filesize.QuadPart <= 0 )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  /* The mapping extends the file to the requested size */
+  mapping = CreateFileMappingA( file, 0, PAGE_READWRITE, (DWORD)( filesize.QuadPart >> 32 ), (DWORD)( filesize.QuadPart & 0xffffffff ), 0 );
+  if( !( mapping ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  data = MapViewOfFile( mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0 );
+  if( !( data ) )
+  {
+    CloseHandle( mapping );
+    CloseHandle( file );
+    return 0;
+  }
+  filemap->data = data;
+  filemap->size = (size_t)filesize.QuadPart;
+  filemap->filehandle = (void *)file;
+  filemap->maphandle = (void *)mapping;
+  return 1;
+#else
+  memset( filemap, 0, sizeof(ccFileMap) );
+  return 0;
+#endif
+}
+
+void ccFileMapSync( ccFileMap *filemap )
+{
+  if( !( filemap->data ) )
+    return;
+#if CC_UNIX
+  msync( filemap->data, filemap->size, MS_SYNC );
+#elif CC_WINDOWS
+  FlushViewOfFile( filemap->data, 0 );
+  FlushFileBuffers( (HANDLE)filemap->filehandle );
+#endif
+  return;
+}
+
+void ccFileMapClose( ccFileMap *filemap )
+{
+  if( !( filemap->data ) )
+    return;
+#if CC_UNIX
+  munmap( filemap->data, filemap->size );
+#elif CC_WINDOWS
+  UnmapViewOfFile( filemap->data );
+  CloseHandle( (HANDLE)filemap->maphandle );
+  CloseHandle( (HANDLE)filemap->filehandle );
+#endif
+  memset( filemap, 0, sizeof(ccFileMap) );
+  return;
+}
+
+
+////
+
+
 struct _ccDir
 {
 #if CC_UNIX
@@ -1783,6 +1954,25 @@ int ccGetTimeOfDay( struct timeval *tv )
 }
 
 
+uint64_t ccGetNanosecondsTime()
+{
+#if CC_UNIX
+  struct timespec monotime;
+  clock_gettime( CLOCK_MONOTONIC, &monotime );
+  return ( (uint64_t)monotime.tv_sec * 1000000000 ) + (uint64_t)monotime.tv_nsec;
+#elif CC_WINDOWS
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return ( (uint64_t)( counter.QuadPart / frequency.QuadPart ) * 1000000000 ) + ( ( (uint64_t)( counter.QuadPart % frequency.QuadPart ) * 1000000000 ) / (uint64_t)frequency.QuadPart );
+#else
+  struct timeval lntime;
+  ccGetTimeOfDay( &lntime );
+  return ( (uint64_t)lntime.tv_sec * 1000000000 ) + ( (uint64_t)lntime.tv_usec * 1000 );
+#endif
+}
+
+
 void ccSleep( int milliseconds )
 {
 #if CC_UNIX
@@ -1854,6 +1854,27 @@ int ccRenameFile( char *oldpath, char *newpath );
 ////
 
 
+typedef struct
+{
+  void *data;
+  size_t size;
+  /* Platform handles, only used on Windows */
+  void *filehandle;
+  void *maphandle;
+} ccFileMap;
+
+/* Map a whole file read-only in memory, returns 0 on failure or if the file is empty */
+int ccFileMapOpen( ccFileMap *filemap, const char *path );
+/* Map a file read-write in memory, the file is created or extended to at least minsize bytes */
+int ccFileMapOpenWrite( ccFileMap *filemap, const char *path, size_t minsize );
+/* Flush modified pages of a writable mapping to disk */
+void ccFileMapSync( ccFileMap *filemap );
+void ccFileMapClose( ccFileMap *filemap );
+
+
+////
+
+
 typedef struct _ccDir ccDir;
 
 ccDir *ccOpenDir( char *path );
@@ -1888,12 +1909,8 @@ static inline CC_ALWAYSINLINE uint64_t ccGetMicrosecondsTime()
   return ( (uint64_t)lntime.tv_sec * 1000000 ) + (uint64_t)lntime.tv_usec;
 }
 
-static inline CC_ALWAYSINLINE uint64_t ccGetNanosecondsTime()
-{
-  struct timeval lntime;
-  ccGetTimeOfDay( &lntime );
-  return ( (uint64_t)lntime.tv_sec * 1000000000 ) + ( (uint64_t)lntime.tv_usec * 1000 );
-}
+/* Monotonic clock with nanosecond resolution, for measuring intervals */
+uint64_t ccGetNanosecondsTime();
 
 
 ////
@@ -65,48 +65,124 @@ static int64_t debugTrackerActivityTime = 0;
 static mtMutex debugTrackerMutex;
 static mtThread debugTrackerThread;
 
-static void *debugTrackerThreadMain( void *value )
+
+/* Open addressing table of sampled locations, must be a power of two */
+#define DEBUG_TRACKER_SAMPLE_HASH_SIZE (4096)
+
+static volatile int debugTrackerSampleRate = 0;
+static int debugTrackerSampleCount = 0;
+static int64_t debugTrackerSampleTotal = 0;
+static debugTrackerSample debugTrackerSampleTable[DEBUG_TRACKER_SAMPLE_HASH_SIZE];
+
+
+/* Must be called with debugTrackerMutex held */
+static void debugTrackerSampleThreads()
+{
+  int trackerindex;
+  uint32_t hashkey;
+  debugTracker *tracker;
+  debugTrackerEntry *entry;
+  debugTrackerSample *sample;
+
+  tracker = debugTrackerList;
+  for( trackerindex = 0 ; trackerindex < debugTrackerCount ; trackerindex++, tracker++ )
+  {
+    if( !( tracker->entrycount ) )
+      continue;
+    entry = &tracker->entry[ tracker->entrycount - 1 ];
+    hashkey = ( (uint32_t)( (uintptr_t)entry->file >> 3 ) ^ ( (uint32_t)entry->line * 2654435761U ) ) + (uint32_t)trackerindex;
+    for( ; ; hashkey++ )
+    {
+      sample = &debugTrackerSampleTable[ hashkey & ( DEBUG_TRACKER_SAMPLE_HASH_SIZE - 1 ) ];
+      if( !( sample->file ) )
+      {
+        /* Keep a quarter of the table free for probing, drop new locations beyond that */
+        if( debugTrackerSampleCount >= ( DEBUG_TRACKER_SAMPLE_HASH_SIZE - ( DEBUG_TRACKER_SAMPLE_HASH_SIZE >> 2 ) ) )
+          break;
+        sample->file = entry->file;
+        sample->line = entry->line;
+        sample->threadindex = trackerindex;
+        sample->count = 0;
+        debugTrackerSampleCount++;
+      }
+      else if( ( sample->file != entry->file ) || ( sample->line != entry->line ) || ( sample->threadindex != trackerindex ) )
+        continue;
+      sample->count++;
+      break;
+    }
+    debugTrackerSampleTotal++;
+  }
+  return;
+}
+
+
+static void debugTrackerWatchCheck( int64_t currenttime )
 {
-  int stallflag, trackerindex, entryindex;
-  int64_t activitytime, currenttime;
+  int trackerindex, entryindex;
+  int64_t activitytime;
   FILE *debugfile;
   debugTracker *tracker;
   debugTrackerEntry *entry;
 
-  for( ; ; )
+  mtMutexLock( &debugTrackerMutex );
+  activitytime = debugTrackerActivityTime;
+  mtMutexUnlock( &debugTrackerMutex );
+  if( currenttime > ( activitytime + debugTrackerStallTime ) )
   {
-    mtMutexLock( &debugTrackerMutex );
-    activitytime = debugTrackerActivityTime;
-    mtMutexUnlock( &debugTrackerMutex );
-    currenttime = ccGetMillisecondsTime();
-    if( currenttime > ( activitytime + debugTrackerStallTime ) )
+    printf( "\nWARNING: Watchdog timer kicked in, activity appears stalled since %.3f seconds.\n", (double)( currenttime - activitytime ) / 1000.0 );
+    tracker = debugTrackerList;
+    for( trackerindex = 0 ; trackerindex < debugTrackerCount ; trackerindex++, tracker++ )
+      printf( "Thread %d last activity : %.3f seconds ago.\n", trackerindex, (double)( currenttime - tracker->activitytime ) / 1000.0 );
+    printf( "You have encountered a bug and you can help fix it.\n" );
+    printf( "Please send the files \"debugtracker.txt\" and the latest log file (from /data/logs/) to alexis@rayforce.net\n" );
+    printf( "Thank you!\n" );
+    debugfile = fopen( "debugtracker.txt", "a" );
+    if( debugfile )
     {
-      printf( "\nWARNING: Watchdog timer kicked in, activity appears stalled since %.3f seconds.\n", (double)( currenttime - activitytime ) / 1000.0 );
+      fprintf( debugfile, "\nWARNING: Watchdog timer kicked in, activity appears stalled since %.3f seconds.\n", (double)( currenttime - activitytime ) / 1000.0 );
       tracker = debugTrackerList;
       for( trackerindex = 0 ; trackerindex < debugTrackerCount ; trackerindex++, tracker++ )
-        printf( "Thread %d last activity : %.3f seconds ago.\n", trackerindex, (double)( currenttime - tracker->activitytime ) / 1000.0 );
-      printf( "You have encountered a bug and you can help fix it.\n" );
-      printf( "Please send the files \"debugtracker.txt\" and the latest log file (from /data/logs/) to alexis@rayforce.net\n" );
-      printf( "Thank you!\n" );
-      debugfile = fopen( "debugtracker.txt", "a" );
-      if( debugfile )
       {
-        fprintf( debugfile, "\nWARNING: Watchdog timer kicked in, activity appears stalled since %.3f seconds.\n", (double)( currenttime - activitytime ) / 1000.0 );
-        tracker = debugTrackerList;
-        for( trackerindex = 0 ; trackerindex < debugTrackerCount ; trackerindex++, tracker++ )
+        fprintf( debugfile, "Thread %d last activity : %.3f seconds ago.\n", trackerindex, (double)( currenttime - tracker->activitytime ) / 1000.0 );
+        for( entryindex = 0 ; entryindex < tracker->entrycount ; entryindex++ )
         {
-          fprintf( debugfile, "Thread %d last activity : %.3f seconds ago.\n", trackerindex, (double)( currenttime - tracker->activitytime ) / 1000.0 );
-          for( entryindex = 0 ; entryindex < tracker->entrycount ; entryindex++ )
-          {
-            entry = &tracker->entry[entryindex];
-            fprintf( debugfile, "Log #%d : file %s, line %d\n", entryindex, entry->file, entry->line );
-          }
+          entry = &tracker->entry[entryindex];
+          fprintf( debugfile, "Log #%d : file %s, line %d\n", entryindex, entry->file, entry->line );
         }
-        fclose( debugfile );
       }
-      fflush( 0 );
+      fclose( debugfile );
+    }
+    fflush( 0 );
+  }
+  return;
+}
+
+
+static void *debugTrackerThreadMain( void *value )
+{
+  int samplerate;
+  int64_t currenttime, watchtime, sleeptime;
+
+  watchtime = 0;
+  for( ; ; )
+  {
+    currenttime = ccGetMillisecondsTime();
+    if( currenttime >= watchtime )
+    {
+      debugTrackerWatchCheck( currenttime );
+      watchtime = currenttime + debugTrackerWatchInterval;
+    }
+    sleeptime = watchtime - currenttime;
+    /* When sampling, wake up at the sample rate and record where each thread is */
+    samplerate = debugTrackerSampleRate;
+    if( samplerate > 0 )
+    {
+      mtMutexLock( &debugTrackerMutex );
+      debugTrackerSampleThreads();
+      mtMutexUnlock( &debugTrackerMutex );
+      sleeptime = CC_MIN( sleeptime, CC_MAX( 1000 / samplerate, 1 ) );
     }
-    ccSleep( debugTrackerWatchInterval );
+    ccSleep( (int)sleeptime );
   }
 
   return 0;
@@ -208,5 +284,288 @@ void debugTrackerClear()
 }
 
 
+
+
+void debugTrackerSetSampleRate( int samplerate )
+{
+  debugTrackerSampleRate = CC_MAX( samplerate, 0 );
+  return;
+}
+
+
+int debugTrackerGetSampleRate()
+{
+  return debugTrackerSampleRate;
+}
+
+
+static int debugTrackerSampleCmp( const void *p0, const void *p1 )
+{
+  const debugTrackerSample *s0, *s1;
+  s0 = p0;
+  s1 = p1;
+  if( s0->count != s1->count )
+    return ( s0->count < s1->count ? 1 : -1 );
+  return s0->threadindex - s1->threadindex;
+}
+
+int debugTrackerGetSamples( debugTrackerSample *samplelist, int maxcount, int64_t *rettotalcount )
+{
+  int hashindex, samplecount;
+  debugTrackerSample *sample, *sortlist;
+
+  if( !( debugTrackerInitFlag ) )
+  {
+    if( rettotalcount )
+      *rettotalcount = 0;
+    return 0;
+  }
+  /* Copy the table out of the lock, sort and truncate afterwards */
+  sortlist = malloc( DEBUG_TRACKER_SAMPLE_HASH_SIZE * sizeof(debugTrackerSample) );
+  samplecount = 0;
+  mtMutexLock( &debugTrackerMutex );
+  for( hashindex = 0 ; hashindex < DEBUG_TRACKER_SAMPLE_HASH_SIZE ; hashindex++ )
+  {
+    sample = &debugTrackerSampleTable[ hashindex ];
+    if( sample->file )
+      sortlist[ samplecount++ ] = *sample;
+  }
+  if( rettotalcount )
+    *rettotalcount = debugTrackerSampleTotal;
+  mtMutexUnlock( &debugTrackerMutex );
+  qsort( sortlist, samplecount, sizeof(debugTrackerSample), debugTrackerSampleCmp );
+  samplecount = CC_MIN( samplecount, maxcount );
+  memcpy( samplelist, sortlist, samplecount * sizeof(debugTrackerSample) );
+  free( sortlist );
+  return samplecount;
+}
+
+
+void debugTrackerResetSamples()
+{
+  if( !( debugTrackerInitFlag ) )
+    return;
+  mtMutexLock( &debugTrackerMutex );
+  memset( debugTrackerSampleTable, 0, DEBUG_TRACKER_SAMPLE_HASH_SIZE * sizeof(debugTrackerSample) );
+  debugTrackerSampleCount = 0;
+  debugTrackerSampleTotal = 0;
+  mtMutexUnlock( &debugTrackerMutex );
+  return;
+}
+
+////
+
+
+
+/* Histogram buckets: 4 sub-buckets per power of two, quantiles within 25% of the real value */
+#define DEBUG_PROFILE_PHASE_MAX (64)
+#define DEBUG_PROFILE_BUCKET_SUBSHIFT (2)
+#define DEBUG_PROFILE_BUCKET_COUNT (64<<DEBUG_PROFILE_BUCKET_SUBSHIFT)
+
+typedef struct
+{
+  char *name;
+  char *file;
+  int line;
+  int64_t count;
+  uint64_t total;
+  uint64_t max;
+  int64_t cyclecount;
+  uint64_t cycletotal;
+  uint32_t bucket[DEBUG_PROFILE_BUCKET_COUNT];
+} debugProfilePhase;
+
+static int debugProfileInitFlag = 0;
+static int debugProfilePhaseCount = 0;
+static debugProfilePhase debugProfilePhaseList[DEBUG_PROFILE_PHASE_MAX];
+static mtMutex debugProfileMutex;
+
+
+static inline int debugProfileBucketIndex( uint64_t value )
+{
+  int msb;
+  if( value < ( 1 << DEBUG_PROFILE_BUCKET_SUBSHIFT ) )
+    return (int)value;
+  msb = (int)ccLog2Int64( value );
+  return ( msb << DEBUG_PROFILE_BUCKET_SUBSHIFT ) | (int)( ( value >> ( msb - DEBUG_PROFILE_BUCKET_SUBSHIFT ) ) & ( ( 1 << DEBUG_PROFILE_BUCKET_SUBSHIFT ) - 1 ) );
+}
+
+/* Middle of the range covered by a bucket */
+static inline uint64_t debugProfileBucketValue( int bucketindex )
+{
+  int msb;
+  uint64_t base, width;
+  msb = bucketindex >> DEBUG_PROFILE_BUCKET_SUBSHIFT;
+  if( msb < DEBUG_PROFILE_BUCKET_SUBSHIFT )
+    return (uint64_t)bucketindex;
+  width = (uint64_t)1 << ( msb - DEBUG_PROFILE_BUCKET_SUBSHIFT );
+  base = (uint64_t)( ( 1 << DEBUG_PROFILE_BUCKET_SUBSHIFT ) | ( bucketindex & ( ( 1 << DEBUG_PROFILE_BUCKET_SUBSHIFT ) - 1 ) ) ) * width;
+  return base + ( width >> 1 );
+}
+
+static uint64_t debugProfileQuantile( debugProfilePhase *phase, double quantile )
+{
+  int bucketindex;
+  int64_t target, accum;
+  uint64_t value;
+
+  target = (int64_t)ceil( quantile * (double)phase->count );
+  if( target < 1 )
+    target = 1;
+  accum = 0;
+  for( bucketindex = 0 ; bucketindex < DEBUG_PROFILE_BUCKET_COUNT ; bucketindex++ )
+  {
+    accum += phase->bucket[ bucketindex ];
+    if( accum >= target )
+    {
+      value = debugProfileBucketValue( bucketindex );
+      return CC_MIN( value, phase->max );
+    }
+  }
+  return phase->max;
+}
+
+
+int debugProfileInit()
+{
+  mtMutexInit( &debugProfileMutex );
+  debugProfileInitFlag = 1;
+  return 1;
+}
+
+
+void debugProfileBegin( debugProfileScope *scope, char *name, char *file, int line )
+{
+  int phaseindex;
+  debugProfilePhase *phase;
+
+#if ENABLE_DEBUG_TRACKING
+  debugTrackerSet( file, line );
+#endif
+  scope->phaseindex = -1;
+  if( !( debugProfileInitFlag ) )
+    return;
+  mtMutexLock( &debugProfileMutex );
+  for( phaseindex = 0 ; phaseindex < debugProfilePhaseCount ; phaseindex++ )
+  {
+    phase = &debugProfilePhaseList[ phaseindex ];
+    if( ( phase->name == name ) || !( strcmp( phase->name, name ) ) )
+      break;
+  }
+  if( phaseindex == debugProfilePhaseCount )
+  {
+    if( debugProfilePhaseCount == DEBUG_PROFILE_PHASE_MAX )
+    {
+      mtMutexUnlock( &debugProfileMutex );
+      return;
+    }
+    phase = &debugProfilePhaseList[ phaseindex ];
+    memset( phase, 0, sizeof(debugProfilePhase) );
+    phase->name = name;
+    phase->file = file;
+    phase->line = line;
+    debugProfilePhaseCount++;
+  }
+  mtMutexUnlock( &debugProfileMutex );
+  scope->phaseindex = phaseindex;
+  scope->starttime = ccGetNanosecondsTime();
+  return;
+}
+
+
+void debugProfileEnd( debugProfileScope *scope )
+{
+  uint64_t elapsed;
+  debugProfilePhase *phase;
+
+  if( scope->phaseindex < 0 )
+    return;
+  elapsed = ccGetNanosecondsTime() - scope->starttime;
+  mtMutexLock( &debugProfileMutex );
+  phase = &debugProfilePhaseList[ scope->phaseindex ];
+  phase->count++;
+  phase->total += elapsed;
+  if( elapsed > phase->max )
+    phase->max = elapsed;
+  phase->cyclecount++;
+  phase->cycletotal += elapsed;
+  phase->bucket[ debugProfileBucketIndex( elapsed ) ]++;
+  mtMutexUnlock( &debugProfileMutex );
+  scope->phaseindex = -1;
+  return;
+}
+
+
+int debugProfileGetStats( debugProfileStat *statlist, int maxcount )
+{
+  int phaseindex, phasecount;
+  debugProfilePhase *phase;
+  debugProfileStat *stat;
+
+  if( !( debugProfileInitFlag ) )
+    return 0;
+  mtMutexLock( &debugProfileMutex );
+  phasecount = CC_MIN( debugProfilePhaseCount, maxcount );
+  for( phaseindex = 0 ; phaseindex < phasecount ; phaseindex++ )
+  {
+    phase = &debugProfilePhaseList[ phaseindex ];
+    stat = &statlist[ phaseindex ];
+    stat->name = phase->name;
+    stat->file = phase->file;
+    stat->line = phase->line;
+    stat->count = phase->count;
+    stat->total = phase->total;
+    stat->p50 = ( phase->count ? debugProfileQuantile( phase, 0.50 ) : 0 );
+    stat->p95 = ( phase->count ? debugProfileQuantile( phase, 0.95 ) : 0 );
+    stat->max = phase->max;
+    stat->cyclecount = phase->cyclecount;
+    stat->cycletotal = phase->cycletotal;
+  }
+  mtMutexUnlock( &debugProfileMutex );
+  return phasecount;
+}
+
+
+void debugProfileCycleReset()
+{
+  int phaseindex;
+
+  if( !( debugProfileInitFlag ) )
+    return;
+  mtMutexLock( &debugProfileMutex );
+  for( phaseindex = 0 ; phaseindex < debugProfilePhaseCount ; phaseindex++ )
+  {
+    debugProfilePhaseList[ phaseindex ].cyclecount = 0;
+    debugProfilePhaseList[ phaseindex ].cycletotal = 0;
+  }
+  mtMutexUnlock( &debugProfileMutex );
+  return;
+}
+
+
+/* Clear the statistics, keep the phases registered in place */
+void debugProfileReset()
+{
+  int phaseindex;
+  debugProfilePhase *phase;
+
+  if( !( debugProfileInitFlag ) )
+    return;
+  mtMutexLock( &debugProfileMutex );
+  for( phaseindex = 0 ; phaseindex < debugProfilePhaseCount ; phaseindex++ )
+  {
+    phase = &debugProfilePhaseList[ phaseindex ];
+    phase->count = 0;
+    phase->total = 0;
+    phase->max = 0;
+    phase->cyclecount = 0;
+    phase->cycletotal = 0;
+    memset( phase->bucket, 0, DEBUG_PROFILE_BUCKET_COUNT * sizeof(uint32_t) );
+  }
+  mtMutexUnlock( &debugProfileMutex );
+  return;
+}
+
+
 ////
 
@@ -44,6 +44,71 @@ void debugTrackerSet( char *file, int line );
 void debugTrackerActivity();
 void debugTrackerClear();
 
+/* Flat profile of the last tracker location of each thread, sampled by the watchdog thread */
+typedef struct
+{
+  char *file;
+  int line;
+  /* Threads are numbered in order of their first tracker location */
+  int threadindex;
+  int64_t count;
+} debugTrackerSample;
+
+/* Samples per second, zero stops sampling, accumulated samples are kept */
+void debugTrackerSetSampleRate( int samplerate );
+int debugTrackerGetSampleRate();
+/* Fill samplelist with up to maxcount locations sorted by decreasing count, return count of locations */
+int debugTrackerGetSamples( debugTrackerSample *samplelist, int maxcount, int64_t *rettotalcount );
+void debugTrackerResetSamples();
+
+
+////
+
+
+#ifndef ENABLE_DEBUG_PROFILE
+ #define ENABLE_DEBUG_PROFILE (1)
+#endif
+
+/* Scoped phase timer, lives on the stack of the timed code */
+typedef struct
+{
+  int phaseindex;
+  uint64_t starttime;
+} debugProfileScope;
+
+/* DEBUG_PROFILE_BEGIN() also records the location for the tracker, like DEBUG_SET_TRACKER() */
+#if ENABLE_DEBUG_PROFILE
+ #define DEBUG_PROFILE_BEGIN(scope,name) debugProfileBegin(scope,name,__FILE__,__LINE__)
+ #define DEBUG_PROFILE_END(scope) debugProfileEnd(scope)
+#else
+ #define DEBUG_PROFILE_BEGIN(scope,name) DEBUG_SET_TRACKER()
+ #define DEBUG_PROFILE_END(scope)
+#endif
+
+typedef struct
+{
+  char *name;
+  char *file;
+  int line;
+  /* Since startup or the last debugProfileReset(), in nanoseconds */
+  int64_t count;
+  uint64_t total;
+  uint64_t p50;
+  uint64_t p95;
+  uint64_t max;
+  /* Since the last debugProfileCycleReset() */
+  int64_t cyclecount;
+  uint64_t cycletotal;
+} debugProfileStat;
+
+int debugProfileInit();
+void debugProfileBegin( debugProfileScope *scope, char *name, char *file, int line );
+void debugProfileEnd( debugProfileScope *scope );
+/* Fill statlist with up to maxcount phases in order of first use, return count of phases */
+int debugProfileGetStats( debugProfileStat *statlist, int maxcount );
+void debugProfileCycleReset();
+void debugProfileReset();
+
 
 ////
 
@@ -34,6 +34,7 @@
 #include "cc.h"
 #include "ccstr.h"
 #include "mm.h"
+#include "mmatomic.h"
 #include "iolog.h"
 
 /* For mkdir() */
@@ -55,6 +56,21 @@
 
 #define IO_LOG_FORCE_FLUSH (1)
 
+/* Hand formatted records to a writer thread through a lock-free ring buffer */
+#ifdef MM_ATOMIC_SUPPORT
+ #define IO_LOG_ASYNC (1)
+#else
+ #define IO_LOG_ASYNC (0)
+#endif
+
+/* Count of records in the ring, must be a power of two */
+#define IO_LOG_RING_SIZE (4096)
+/* Records longer than this are allocated */
+#define IO_LOG_RECORD_INLINE (240)
+
+/* Writer thread sleeps this long at most when idle */
+#define IO_LOG_IDLE_WAIT (250)
+
 
 ////
 
@@ -152,6 +168,52 @@ char *ioStdinReadAlloc( int waitmilliseconds )
 ////
 
 
+#if IO_LOG_ASYNC
+
+typedef struct
+{
+  /* Record is ready for the writer when sequence equals its ring position + 1 */
+  mmAtomic32 sequence;
+  int modemask;
+  time_t curtime;
+  char *string;
+  char data[IO_LOG_RECORD_INLINE];
+} ioLogRecord;
+
+struct ioLogRing
+{
+  ioLog *log;
+  ioLogRecord *recordlist;
+  uint32_t mask;
+  /* Claimed by producers */
+  mmAtomic32 writeindex;
+  /* Owned by the writer thread */
+  uint32_t readindex;
+  /* Set while the writer thread waits for records */
+  mmAtomic32 sleepflag;
+
+  /* Protected by mutex */
+  uint32_t doneindex;
+  int waitercount;
+  int quitflag;
+  mtMutex mutex;
+  mtSignal signal;
+  mtSignal donesignal;
+
+  mtThread thread;
+};
+
+static void ioLogStartThread( ioLog *log );
+static void ioLogStopThread( ioLog *log );
+static void ioLogWaitRing( ioLog *log, uint32_t ticket );
+
+#endif
+
+
+/* Target of ioPrintf() calls without a log, the first log initialized */
+static ioLog *ioLogDefault = 0;
+
+
 static int ioLogReopen( ioLog *log, struct tm *timeinfo )
 {
   char *strpath;
@@ -201,6 +263,7 @@ int ioLogInit( ioLog *log, char *logpath, int flushinterval )
 #endif
 
   memset( log, 0, sizeof(ioLog) );
+  ioLogSetLevel( log, -1, IO_LOG_LEVEL_DEFAULT );
   log->logpath = strdup( logpath );
   log->curtime = time( 0 );
   log->flushinterval = flushinterval;
@@ -210,6 +273,11 @@ int ioLogInit( ioLog *log, char *logpath, int flushinterval )
 #if CC_UNIX
   printf( "\33[0m\33[40m\33[37m" );
 #endif
+#if IO_LOG_ASYNC
+  ioLogStartThread( log );
+#endif
+  if( !( ioLogDefault ) )
+    ioLogDefault = log;
 
   return 1;
 }
@@ -218,6 +286,11 @@ void ioLogEnd( ioLog *log )
 {
   if( !( log ) )
     return;
+  if( ioLogDefault == log )
+    ioLogDefault = 0;
+#if IO_LOG_ASYNC
+  ioLogStopThread( log );
+#endif
   free( log->logpath );
   log->logpath = 0;
   fclose( log->file );
@@ -225,8 +298,58 @@ void ioLogEnd( ioLog *log )
   return;
 }
 
+void ioLogSetLevel( ioLog *log, int category, int level )
+{
+  int categorybase, categorylast, levelindex;
+
+  categorybase = category;
+  categorylast = category;
+  if( category < 0 )
+  {
+    categorybase = 0;
+    categorylast = IO_LOG_CATEGORY_COUNT - 1;
+  }
+  for( category = categorybase ; category <= categorylast ; category++ )
+  {
+    for( levelindex = 0 ; levelindex < IO_LOG_LEVEL_COUNT ; levelindex++ )
+    {
+      if( levelindex <= level )
+        log->levelmask |= IO_LOG_BIT( category, levelindex );
+      else
+        log->levelmask &= ~IO_LOG_BIT( category, levelindex );
+    }
+  }
+  return;
+}
+
+int ioLogParseLevel( char *string )
+{
+  if( ccStrLowCmpWord( string, "off" ) )
+    return -1;
+  else if( ccStrLowCmpWord( string, "error" ) )
+    return IO_LOG_LEVEL_ERROR;
+  else if( ccStrLowCmpWord( string, "warning" ) )
+    return IO_LOG_LEVEL_WARNING;
+  else if( ccStrLowCmpWord( string, "info" ) )
+    return IO_LOG_LEVEL_INFO;
+  else if( ccStrLowCmpWord( string, "verbose" ) )
+    return IO_LOG_LEVEL_VERBOSE;
+  else if( ccStrLowCmpWord( string, "debug" ) )
+    return IO_LOG_LEVEL_DEBUG;
+  return -2;
+}
+
+
+/* Also a barrier, all prior output has been written when this returns */
 void ioLogFlush( ioLog *log )
 {
+#if IO_LOG_ASYNC
+  if( log->ring )
+  {
+    ioLogWaitRing( log, (uint32_t)mmAtomicRead32( &log->ring->writeindex ) );
+    return;
+  }
+#endif
   fflush( stdout );
   if( log->file )
     fflush( log->file );
@@ -235,6 +358,10 @@ void ioLogFlush( ioLog *log )
 
 void ioLogSetOutputFile( ioLog *log, FILE *outputfile )
 {
+#if IO_LOG_ASYNC
+  if( log->ring )
+    ioLogWaitRing( log, (uint32_t)mmAtomicRead32( &log->ring->writeindex ) );
+#endif
   log->outputfile = outputfile;
   return;
 }
@@ -473,32 +600,12 @@ static void ioPrintFileString( ioLog *log, FILE *file, char *string )
 }
 
 
-void ioPrintf( ioLog *log, int modemask, char *format, ... )
+/* Write a formatted string to stdout and the log files, from ioPrintf() or the writer thread */
+static void ioLogWrite( ioLog *log, int modemask, char *string, time_t curtime )
 {
-  char *string;
-  int strsize, allocsize;
-  va_list ap;
-  time_t curtime;
   struct tm timeinfo;
   char timebuf[64];
 
-  allocsize = 512;
-  string = malloc( allocsize );
-  for( ; ; )
-  {
-    va_start( ap, format );
-    strsize = vsnprintf( string, allocsize, format, ap );
-    va_end( ap );
-#if CC_WINDOWS
-    if( strsize == -1 )
-      strsize = allocsize << 1;
-#endif
-    if( strsize < allocsize )
-      break;
-    allocsize = strsize + 2;
-    string = realloc( string, allocsize );
-  }
-
   if( !( modemask & IO_MODEBIT_LOGONLY ) )
   {
     if( ( log ) && ( log->linemarker ) )
@@ -530,7 +637,6 @@ void ioPrintf( ioLog *log, int modemask, char *format, ... )
 
   if( log )
   {
-    curtime = time( 0 );
     if( ( curtime - log->curtime ) >= log->flushinterval )
       modemask |= IO_MODEBIT_FLUSH;
     log->curtime = curtime;
@@ -548,23 +654,18 @@ void ioPrintf( ioLog *log, int modemask, char *format, ... )
     /* Write to log file */
     if( ( log->file ) && !( modemask & IO_MODEBIT_NOLOG ) )
     {
-      /* Skip leading new lines */
-      if( !( modemask & IO_MODEBIT_LOGONLY ) )
-        for( ; *format == '\n' ; format++ );
-      if( *format )
+      if( !( modemask & IO_MODEBIT_NODATE ) )
       {
-        if( !( modemask & IO_MODEBIT_NODATE ) )
-        {
-          strftime( timebuf, 64, "%H:%M:%S", &timeinfo );
-          fprintf( log->file, "%s ", timebuf );
-        }
-        ioPrintFileString( log, log->file, string );
-        if( modemask & IO_MODEBIT_FLUSH )
-          fflush( log->file );
+        strftime( timebuf, 64, "%H:%M:%S", &timeinfo );
+        fprintf( log->file, "%s ", timebuf );
+      }
+      ioPrintFileString( log, log->file, string );
+      if( modemask & IO_MODEBIT_FLUSH )
+        fflush( log->file );
 #if IO_LOG_FORCE_FLUSH
+      else if( !( log->ring ) )
         fflush( log->file );
 #endif
-      }
     }
     if( ( modemask & IO_MODEBIT_OUTPUTFILE ) && ( log->outputfile ) )
     {
@@ -572,14 +673,266 @@ void ioPrintf( ioLog *log, int modemask, char *format, ... )
       if( modemask & IO_MODEBIT_FLUSH )
         fflush( log->outputfile );
 #if IO_LOG_FORCE_FLUSH
-      fflush( log->outputfile );
+      else if( !( log->ring ) )
+        fflush( log->outputfile );
 #endif
     }
   }
 
-  free( string );
+  return;
+}
+
+
+////
+
+
+#if IO_LOG_ASYNC
+
+static void *ioLogThreadMain( void *value )
+{
+  int writecount;
+  ioLog *log;
+  ioLogRecord *record;
+  struct ioLogRing *ring;
+
+  ring = value;
+  log = ring->log;
+  for( ; ; )
+  {
+    /* Drain all published records in order */
+    writecount = 0;
+    for( ; ; )
+    {
+      record = &ring->recordlist[ ring->readindex & ring->mask ];
+      if( (uint32_t)mmAtomicRead32( &record->sequence ) != ring->readindex + 1 )
+        break;
+      ioLogWrite( log, record->modemask, record->string, record->curtime );
+      if( record->string != record->data )
+        free( record->string );
+      mmAtomicBarrierWrite32( &record->sequence, (int32_t)( ring->readindex + ring->mask + 1 ) );
+      ring->readindex++;
+      writecount++;
+    }
+#if IO_LOG_FORCE_FLUSH
+    if( writecount )
+    {
+      if( log->file )
+        fflush( log->file );
+      if( log->outputfile )
+        fflush( log->outputfile );
+    }
+#endif
 
+    mtMutexLock( &ring->mutex );
+    ring->doneindex = ring->readindex;
+    if( ring->waitercount )
+      mtSignalBroadcast( &ring->donesignal );
+    record = &ring->recordlist[ ring->readindex & ring->mask ];
+    if( (uint32_t)mmAtomicRead32( &record->sequence ) != ring->readindex + 1 )
+    {
+      if( ring->quitflag )
+      {
+        mtMutexUnlock( &ring->mutex );
+        break;
+      }
+      /* Producers check sleepflag after publishing, we check the ring after setting it */
+      mmAtomicWrite32( &ring->sleepflag, 1 );
+      mmBarrier();
+      if( (uint32_t)mmAtomicRead32( &record->sequence ) != ring->readindex + 1 )
+        mtSignalWaitTimeout( &ring->signal, &ring->mutex, IO_LOG_IDLE_WAIT );
+      mmAtomicWrite32( &ring->sleepflag, 0 );
+    }
+    mtMutexUnlock( &ring->mutex );
+  }
+
+  return 0;
+}
+
+
+static void ioLogStartThread( ioLog *log )
+{
+  uint32_t recordindex;
+  struct ioLogRing *ring;
+
+  ring = malloc( sizeof(struct ioLogRing) );
+  memset( ring, 0, sizeof(struct ioLogRing) );
+  ring->mask = IO_LOG_RING_SIZE - 1;
+  ring->recordlist = malloc( IO_LOG_RING_SIZE * sizeof(ioLogRecord) );
+  for( recordindex = 0 ; recordindex < IO_LOG_RING_SIZE ; recordindex++ )
+    mmAtomicWrite32( &ring->recordlist[recordindex].sequence, (int32_t)recordindex );
+  mmAtomicWrite32( &ring->writeindex, 0 );
+  mmAtomicWrite32( &ring->sleepflag, 0 );
+  mtMutexInit( &ring->mutex );
+  mtSignalInit( &ring->signal );
+  mtSignalInit( &ring->donesignal );
+  ring->log = log;
+  /* Producers only use the ring once the writer thread exists, else output stays synchronous */
+  if( !( mtThreadCreate( &ring->thread, ioLogThreadMain, ring, MT_THREAD_FLAGS_JOINABLE, 0, 0 ) ) )
+  {
+    mtMutexDestroy( &ring->mutex );
+    mtSignalDestroy( &ring->signal );
+    mtSignalDestroy( &ring->donesignal );
+    free( ring->recordlist );
+    free( ring );
+    ioPrintf( log, IO_MODEBIT_FLUSH, "LOG ERROR : Failed to start the log writer thread, output is written synchronously.\n" );
+    return;
+  }
+  mmBarrier();
+  log->ring = ring;
   return;
 }
 
 
+static void ioLogStopThread( ioLog *log )
+{
+  struct ioLogRing *ring;
+
+  ring = log->ring;
+  if( !( ring ) )
+    return;
+  mtMutexLock( &ring->mutex );
+  ring->quitflag = 1;
+  mtSignalBroadcast( &ring->signal );
+  mtMutexUnlock( &ring->mutex );
+  mtThreadJoin( &ring->thread );
+  mtMutexDestroy( &ring->mutex );
+  mtSignalDestroy( &ring->signal );
+  mtSignalDestroy( &ring->donesignal );
+  free( ring->recordlist );
+  free( ring );
+  log->ring = 0;
+  fflush( stdout );
+  return;
+}
+
+
+static void ioLogWakeThread( struct ioLogRing *ring )
+{
+  mmBarrier();
+  if( mmAtomicRead32( &ring->sleepflag ) )
+  {
+    mtMutexLock( &ring->mutex );
+    mtSignalBroadcast( &ring->signal );
+    mtMutexUnlock( &ring->mutex );
+  }
+  return;
+}
+
+
+/* Wait until the writer thread has written all records up to ticket */
+static void ioLogWaitRing( ioLog *log, uint32_t ticket )
+{
+  struct ioLogRing *ring;
+
+  ring = log->ring;
+  ioLogWakeThread( ring );
+  mtMutexLock( &ring->mutex );
+  ring->waitercount++;
+  while( (int32_t)( ring->doneindex - ticket ) < 0 )
+    mtSignalWaitTimeout( &ring->donesignal, &ring->mutex, IO_LOG_IDLE_WAIT );
+  ring->waitercount--;
+  mtMutexUnlock( &ring->mutex );
+  return;
+}
+
+
+/* Claim the next record, copy the string and publish it, returns the ticket to wait for */
+static uint32_t ioLogPushRing( ioLog *log, int modemask, char *string, int strsize, time_t curtime )
+{
+  uint32_t writeindex;
+  int32_t seqdiff;
+  ioLogRecord *record;
+  struct ioLogRing *ring;
+
+  ring = log->ring;
+  for( ; ; )
+  {
+    writeindex = (uint32_t)mmAtomicRead32( &ring->writeindex );
+    record = &ring->recordlist[ writeindex & ring->mask ];
+    seqdiff = (int32_t)( (uint32_t)mmAtomicRead32( &record->sequence ) - writeindex );
+    if( !( seqdiff ) )
+    {
+      if( (uint32_t)mmAtomicCmpXchg32( &ring->writeindex, (int32_t)writeindex, (int32_t)( writeindex + 1 ) ) == writeindex )
+        break;
+    }
+    else if( seqdiff < 0 )
+    {
+      /* Ring is full, wait for the writer thread to catch up */
+      ioLogWaitRing( log, writeindex - ring->mask );
+    }
+  }
+
+  record->modemask = modemask;
+  record->curtime = curtime;
+  if( strsize < IO_LOG_RECORD_INLINE )
+  {
+    memcpy( record->data, string, strsize + 1 );
+    record->string = record->data;
+  }
+  else
+  {
+    record->string = malloc( strsize + 1 );
+    memcpy( record->string, string, strsize + 1 );
+  }
+  mmAtomicBarrierWrite32( &record->sequence, (int32_t)( writeindex + 1 ) );
+  ioLogWakeThread( ring );
+
+  return writeindex + 1;
+}
+
+#endif
+
+
+void ioPrintf( ioLog *log, int modemask, char *format, ... )
+{
+  char *string;
+  int strsize, allocsize;
+  va_list ap;
+  char buffer[IO_LOG_RECORD_INLINE];
+#if IO_LOG_ASYNC
+  uint32_t ticket;
+#endif
+
+  if( !( log ) )
+    log = ioLogDefault;
+  string = buffer;
+  allocsize = IO_LOG_RECORD_INLINE;
+  for( ; ; )
+  {
+    va_start( ap, format );
+    strsize = vsnprintf( string, allocsize, format, ap );
+    va_end( ap );
+#if CC_WINDOWS
+    if( strsize == -1 )
+      strsize = allocsize << 1;
+#endif
+    if( strsize < allocsize )
+      break;
+    allocsize = strsize + 2;
+    string = ( string == buffer ? malloc( allocsize ) : realloc( string, allocsize ) );
+  }
+
+  /* Skip log file writes of strings made only of leading new lines */
+  if( !( modemask & IO_MODEBIT_LOGONLY ) )
+    for( ; *format == '\n' ; format++ );
+  if( !( *format ) )
+    modemask |= IO_MODEBIT_NOLOG;
+
+#if IO_LOG_ASYNC
+  if( ( log ) && ( log->ring ) )
+  {
+    ticket = ioLogPushRing( log, modemask, string, strsize, time( 0 ) );
+    if( modemask & IO_MODEBIT_FLUSH )
+      ioLogWaitRing( log, ticket );
+  }
+  else
+    ioLogWrite( log, modemask, string, time( 0 ) );
+#else
+  ioLogWrite( log, modemask, string, time( 0 ) );
+#endif
+
+  if( string != buffer )
+    free( string );
+
+  return;
+}
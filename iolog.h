@@ -44,6 +44,10 @@ typedef struct
   int endlinecount;
   int linemarker;
   FILE *outputfile;
+  /* Asynchronous writer, see iolog.c */
+  struct ioLogRing *ring;
+  /* Enabled log levels of each category, one bit per pair */
+  uint32_t levelmask;
 } ioLog;
 
 int ioLogInit( ioLog *log, char *logpath, int flushinterval );
@@ -52,9 +56,50 @@ void ioLogFlush( ioLog *log );
 
 void ioLogSetOutputFile( ioLog *log, FILE *outputfile );
 
+/* A null target prints to the first initialized log, or to stdout alone if there's none */
 void ioPrintf( ioLog *target, int modemask, char *format, ... );
 
 
+/* Log categories */
+enum
+{
+  IO_LOG_CATEGORY_SYNC,
+  IO_LOG_CATEGORY_APPLY,
+  IO_LOG_CATEGORY_NET,
+  IO_LOG_CATEGORY_ORDER,
+
+  IO_LOG_CATEGORY_COUNT
+};
+
+/* Log levels, a category logs all levels up to the one it is set to */
+enum
+{
+  IO_LOG_LEVEL_ERROR,
+  IO_LOG_LEVEL_WARNING,
+  IO_LOG_LEVEL_INFO,
+  IO_LOG_LEVEL_VERBOSE,
+  IO_LOG_LEVEL_DEBUG,
+
+  IO_LOG_LEVEL_COUNT
+};
+
+/* Default level of all categories */
+#define IO_LOG_LEVEL_DEFAULT (IO_LOG_LEVEL_VERBOSE)
+
+#define IO_LOG_BIT(category,level) ( (uint32_t)1 << ( ( (category) * IO_LOG_LEVEL_COUNT ) + (level) ) )
+
+/* Test before doing any work for a log message, a single branch when disabled */
+#define IO_LOG_ENABLED(log,category,level) ( (log)->levelmask & IO_LOG_BIT(category,level) )
+
+/* Same as ioPrintf(), arguments are only evaluated if the category is enabled at that level */
+#define IO_LOG_PRINTF(log,category,level,modemask,...) do { if( IO_LOG_ENABLED(log,category,level) ) ioPrintf( log, modemask, __VA_ARGS__ ); } while( 0 )
+
+/* Set the level of a category, -1 disables it, all categories if category is -1 */
+void ioLogSetLevel( ioLog *log, int category, int level );
+/* Parse a level name, returns -2 if unknown */
+int ioLogParseLevel( char *string );
+
+
 #define IO_MODEBIT_LOGONLY (0x1)
 #define IO_MODEBIT_NODATE (0x2)
 #define IO_MODEBIT_FLUSH (0x4)
@@ -226,7 +226,7 @@ void journalFree( journalDef *journal )
 ////
 
 
-int journalExecute( char *journalpath, char *tempjournalpath, ioLog *log, journalEntry *entryarray, int entrycount )
+static int journalExecuteEntries( char *journalpath, char *tempjournalpath, ioLog *log, journalEntry *entryarray, int entrycount )
 {
 #if CC_UNIX
   int fd;
@@ -310,6 +310,18 @@ int journalExecute( char *journalpath, char *tempjournalpath, ioLog *log, journa
 }
 
 
+int journalExecute( char *journalpath, char *tempjournalpath, ioLog *log, journalEntry *entryarray, int entrycount )
+{
+  int retval;
+  debugProfileScope profile;
+
+  DEBUG_PROFILE_BEGIN( &profile, "journal" );
+  retval = journalExecuteEntries( journalpath, tempjournalpath, log, entryarray, entrycount );
+  DEBUG_PROFILE_END( &profile );
+  return retval;
+}
+
+
 int journalReplay( char *journalpath )
 {
   int offset;
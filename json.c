@@ -358,7 +358,7 @@ jsonTokenBuffer *jsonLexParse( char *string, ioLog *log )
   parser.linecount = 0;
   parser.log = log;
 
-  buf = malloc( sizeof(jsonTokenBuffer) );
+  buf = mmAccountAlloc( MM_ACCOUNT_JSONTOKEN, sizeof(jsonTokenBuffer) );
   buf->tokencount = 0;
   buf->next = 0;
   buflist = buf;
@@ -367,7 +367,7 @@ jsonTokenBuffer *jsonLexParse( char *string, ioLog *log )
   {
     if( buf->tokencount >= JSON_TOKEN_BUFFER_SIZE )
     {
-      bufnext = malloc( sizeof(jsonTokenBuffer) );
+      bufnext = mmAccountAlloc( MM_ACCOUNT_JSONTOKEN, sizeof(jsonTokenBuffer) );
       bufnext->tokencount = 0;
       bufnext->next = 0;
       buf->next = bufnext;
@@ -400,7 +400,7 @@ void jsonLexFree( jsonTokenBuffer *buf )
   for( ; buf ; buf = next )
   {
     next = buf->next;
-    free( buf );
+    mmAccountFree( MM_ACCOUNT_JSONTOKEN, buf );
   }
   return;
 }
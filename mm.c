@@ -51,7 +51,15 @@
 #include <assert.h>
 
 
+/* Allocation sizes for MM_ACCOUNT, before mm.h redefines malloc() */
+#if defined(__APPLE__)
+ #include <malloc/malloc.h>
+#else
+ #include <malloc.h>
+#endif
+
 #include "mm.h"
+#include "mmatomic.h"
 
 
 #if MM_UNIX
@@ -3374,6 +3382,140 @@ void mmFree( void *unused, void *v, size_t bytes MM_PARAMS )
 
 
 
+////
+
+
+
+#if MM_ACCOUNT
+
+typedef struct
+{
+#ifdef MM_ATOMIC_SUPPORT
+  mmAtomicL livebytes;
+  mmAtomicL peakbytes;
+#else
+  long livebytes;
+  long peakbytes;
+#endif
+} mmAccountCounter;
+
+static mmAccountCounter mmAccountTable[MM_ACCOUNT_COUNT];
+
+static char *mmAccountNameTable[MM_ACCOUNT_COUNT] =
+{
+  [MM_ACCOUNT_BSXITEM] = "bsx items",
+  [MM_ACCOUNT_STRING] = "bsx strings",
+  [MM_ACCOUNT_BSXARENA] = "bsx arenas",
+  [MM_ACCOUNT_JSONTOKEN] = "json tokens",
+  [MM_ACCOUNT_HTTPBUFFER] = "http buffers",
+  [MM_ACCOUNT_TCPBUFFER] = "tcp buffers",
+  [MM_ACCOUNT_TRANSLATION] = "translation tables",
+  [MM_ACCOUNT_REPLY] = "query replies"
+};
+
+/* Size of a heap allocation, as seen by the allocator */
+static size_t mmAccountSize( void *v )
+{
+#if MM_DEBUG
+  mmChunk *chunk;
+  chunk = ADDRESS( v, -(int)sizeof(mmChunk) );
+  return chunk->size;
+#elif MM_WINDOWS
+  return _msize( v );
+#elif MM_OSX
+  return malloc_size( v );
+#else
+  return malloc_usable_size( v );
+#endif
+}
+
+
+void mmAccountAdd( int tag, long bytes )
+{
+  mmAccountCounter *counter;
+#ifdef MM_ATOMIC_SUPPORT
+  long livebytes, peakbytes;
+#endif
+
+  counter = &mmAccountTable[tag];
+#ifdef MM_ATOMIC_SUPPORT
+  livebytes = mmAtomicAddReadL( &counter->livebytes, bytes );
+  if( bytes <= 0 )
+    return;
+  for( peakbytes = mmAtomicReadL( &counter->peakbytes ) ; livebytes > peakbytes ; peakbytes = mmAtomicReadL( &counter->peakbytes ) )
+  {
+    if( mmAtomicCmpXchgL( &counter->peakbytes, peakbytes, livebytes ) == peakbytes )
+      break;
+  }
+#else
+  mtMutexLock( &mmGlobalMutex );
+  counter->livebytes += bytes;
+  if( counter->livebytes > counter->peakbytes )
+    counter->peakbytes = counter->livebytes;
+  mtMutexUnlock( &mmGlobalMutex );
+#endif
+  return;
+}
+
+
+void *MM_FUNC(AccountAlloc)( int tag, size_t bytes MM_PARAMS )
+{
+  void *v;
+  v = mmAlloc( 0, bytes MM_PASSPARAMS );
+  if( v )
+    mmAccountAdd( tag, (long)mmAccountSize( v ) );
+  return v;
+}
+
+
+void *MM_FUNC(AccountRealloc)( int tag, void *v, size_t bytes MM_PARAMS )
+{
+  long oldbytes;
+  oldbytes = ( v ? (long)mmAccountSize( v ) : 0 );
+  v = mmRealloc( 0, v, bytes MM_PASSPARAMS );
+  if( v )
+    mmAccountAdd( tag, (long)mmAccountSize( v ) - oldbytes );
+  return v;
+}
+
+
+void MM_FUNC(AccountFree)( int tag, void *v MM_PARAMS )
+{
+  if( !( v ) )
+    return;
+  mmAccountAdd( tag, -(long)mmAccountSize( v ) );
+  mmFree( 0, v, 0 MM_PASSPARAMS );
+  return;
+}
+
+
+char *mmAccountGetName( int tag )
+{
+  return mmAccountNameTable[tag];
+}
+
+
+void mmAccountGetStats( int tag, mmAccountStats *stats )
+{
+  mmAccountCounter *counter;
+
+  counter = &mmAccountTable[tag];
+#ifdef MM_ATOMIC_SUPPORT
+  stats->livebytes = mmAtomicReadL( &counter->livebytes );
+  stats->peakbytes = mmAtomicReadL( &counter->peakbytes );
+#else
+  mtMutexLock( &mmGlobalMutex );
+  stats->livebytes = counter->livebytes;
+  stats->peakbytes = counter->peakbytes;
+  mtMutexUnlock( &mmGlobalMutex );
+#endif
+  return;
+}
+
+#endif
+
+
+
 /**
  * Private function to add the sorted memory item in the linked list.
  */
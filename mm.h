@@ -45,6 +45,11 @@ extern "C" {
 
 #define MM_ALLOC_CHECK (1)
 
+/* Count live and peak bytes of tagged allocations per subsystem, build with -DMM_ACCOUNT=1 */
+#ifndef MM_ACCOUNT
+ #define MM_ACCOUNT (0)
+#endif
+
 
 #define MM_DEBUG_GUARD_BYTES (32)
 #define MM_DEBUG_MMAP (1)
@@ -782,6 +787,57 @@ static inline void *mmReallocCheck( void *p, size_t size, char *file, int line )
 #endif
 
 
+////
+
+
+/* Subsystems of tagged allocations */
+enum
+{
+  MM_ACCOUNT_BSXITEM,
+  MM_ACCOUNT_STRING,
+  MM_ACCOUNT_BSXARENA,
+  MM_ACCOUNT_JSONTOKEN,
+  MM_ACCOUNT_HTTPBUFFER,
+  MM_ACCOUNT_TCPBUFFER,
+  MM_ACCOUNT_TRANSLATION,
+  MM_ACCOUNT_REPLY,
+
+  MM_ACCOUNT_COUNT
+};
+
+#if MM_ACCOUNT
+
+typedef struct
+{
+  long livebytes;
+  long peakbytes;
+} mmAccountStats;
+
+/* Memory of a tagged allocation must be released with mmAccountFree() of the same tag */
+void *MM_FUNC(AccountAlloc)( int tag, size_t bytes MM_PARAMS );
+void *MM_FUNC(AccountRealloc)( int tag, void *v, size_t bytes MM_PARAMS );
+void MM_FUNC(AccountFree)( int tag, void *v MM_PARAMS );
+/* Account for memory obtained by other means, such as block allocators, bytes is negative on release */
+void mmAccountAdd( int tag, long bytes );
+char *mmAccountGetName( int tag );
+void mmAccountGetStats( int tag, mmAccountStats *stats );
+
+ #if MM_DEBUG
+  #define mmAccountAlloc(t,x) MM_FUNC(AccountAlloc)(t,x,__FILE__,__LINE__)
+  #define mmAccountRealloc(t,x,y) MM_FUNC(AccountRealloc)(t,x,y,__FILE__,__LINE__)
+  #define mmAccountFree(t,x) MM_FUNC(AccountFree)(t,x,__FILE__,__LINE__)
+ #endif
+
+#else
+
+ #define mmAccountAlloc(t,x) malloc(x)
+ #define mmAccountRealloc(t,x,y) realloc(x,y)
+ #define mmAccountFree(t,x) free(x)
+ #define mmAccountAdd(t,x)
+
+#endif
+
+
 
 
 ////
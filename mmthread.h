@@ -102,8 +102,10 @@ typedef struct
   pthread_t pthread;
 } mtThread;
 
-static inline void mtThreadCreate( mtThread *thread, void *(*threadmain)( void *value ), void *value, int flags, void *stack, size_t stacksize )
+/* Returns 0 if the thread couldn't be created */
+static inline int mtThreadCreate( mtThread *thread, void *(*threadmain)( void *value ), void *value, int flags, void *stack, size_t stacksize )
 {
+  int retval;
   pthread_attr_t attr;
 
   pthread_attr_init( &attr );
@@ -115,10 +117,10 @@ static inline void mtThreadCreate( mtThread *thread, void *(*threadmain)( void *
     pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_JOINABLE );
   else
     pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
-  pthread_create( &thread->pthread, &attr, threadmain, value );
+  retval = ( pthread_create( &thread->pthread, &attr, threadmain, value ) == 0 );
   pthread_attr_destroy( &attr );
 
-  return;
+  return retval;
 }
 
 static inline void mtThreadExit()
@@ -388,14 +390,20 @@ static DWORD WINAPI mtWinThreadMain( void *launchdata )
   return 0;
 }
 
-static inline void mtThreadCreate( mtThread *thread, void *(*threadmain)( void *value ), void *value, int flags, void *stack, size_t stacksize )
+/* Returns 0 if the thread couldn't be created */
+static inline int mtThreadCreate( mtThread *thread, void *(*threadmain)( void *value ), void *value, int flags, void *stack, size_t stacksize )
 {
   mtWinThreadLaunch *launch;
   launch = (mtWinThreadLaunch *)malloc( sizeof(mtWinThreadLaunch) );
   launch->threadmain = threadmain;
   launch->value = value;
   thread->winthread = CreateThread( (LPSECURITY_ATTRIBUTES)0, stacksize, mtWinThreadMain, (void *)launch, 0, &thread->threadidentifier );
-  return;
+  if( !( thread->winthread ) )
+  {
+    free( (void *)launch );
+    return 0;
+  }
+  return 1;
 }
 
 static inline void mtThreadExit()
@@ -700,6 +700,7 @@ static tcpBuffer *tcpBufferAllocate( tcpContext *context, size_t size )
     buf = mmBlockAlloc( &context->bufferblock );
     buf->bufsize = TCP_BUFFER_DEFAULT_SIZE;
   }
+  mmAccountAdd( MM_ACCOUNT_TCPBUFFER, (long)( sizeof(tcpBuffer) + buf->bufsize ) );
   buf->publicbuffer.size = buf->bufsize;
   buf->publicbuffer.pointer = buf->data;
   buf->publicbuffer.useroffset = 0;
@@ -711,6 +712,7 @@ static void tcpBufferFree( tcpContext *context, tcpBuffer *buf )
 {
   DEBUG_SET_TRACKER();
 
+  mmAccountAdd( MM_ACCOUNT_TCPBUFFER, -(long)( sizeof(tcpBuffer) + buf->bufsize ) );
   if( buf->bufsize > TCP_BUFFER_DEFAULT_SIZE )
   {
     free( buf );
@@ -858,7 +860,7 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
 }
 
 
-tcpLink *tcpListen( tcpContext *context, int port, void *listenvalue, tcpCallbackSet *netio, int sslflag )
+tcpLink *tcpListen( tcpContext *context, char *address, int port, void *listenvalue, tcpCallbackSet *netio, int sslflag )
 {
   int a;
   tcpLink *link;
@@ -895,6 +897,8 @@ tcpLink *tcpListen( tcpContext *context, int port, void *listenvalue, tcpCallbac
 
   sinInterface.sin_family = AF_INET;
   sinInterface.sin_addr.s_addr = INADDR_ANY;
+  if( ( address ) && ( ( sinInterface.sin_addr.s_addr = inet_addr( address ) ) == INADDR_NONE ) )
+    goto error;
   sinInterface.sin_port = htons( port );
 #if CC_WINDOWS
   if( bind( link->socket, (struct sockaddr *)&sinInterface, sizeof(struct sockaddr_in) ) == SOCKET_ERROR )
@@ -109,8 +109,8 @@ char *tcpResolveName( char *address, int listenflag );
 /* Open link to server */
 tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *uservalue, tcpCallbackSet *netio, int sslflag );
 
-/* Listen for connections */
-tcpLink *tcpListen( tcpContext *context, int port, void *uservalue, tcpCallbackSet *netio, int sslflag );
+/* Listen for connections, on the IPv4 interface address or on all interfaces if address is null */
+tcpLink *tcpListen( tcpContext *context, char *address, int port, void *uservalue, tcpCallbackSet *netio, int sslflag );
 
 /* Set timeout for link */
 void tcpSetTimeout( tcpContext *context, tcpLink *link, int milliseconds );
@@ -29,6 +29,7 @@
 #include <math.h>
 #include <limits.h>
 #include <float.h>
+#include <time.h>
 
 #include "cpuconfig.h"
 
@@ -111,12 +112,25 @@ typedef struct
   /* HTTP pipelining index */
   int pipelineindex;
 
+  /* Endpoint statistics the query accumulates to, timestamps are only taken if set or if the connection is traced */
+  httpEndpointStats *endpoint;
+  uint64_t addtime;
+  uint64_t sendtime;
+  uint64_t recvtime;
+
+  /* Replayed trace entry answering the query, -1 if none, and the time its reply is due */
+  int replayindex;
+  uint64_t replaytime;
+
   httpResponse response;
 
   /* User value set by httpAddQuery() call */
   void *uservalue;
   /* User callback */
   void (*querycallback)( void *uservalue, int resultcode, httpResponse *response );
+  /* Optional user callback for body fragments, and offset of the body data not yet given to it */
+  int (*fragmentcallback)( void *uservalue, void *data, size_t datasize );
+  size_t streamoffset;
   /* Return status for query callback, HTTP_RESULT_xxx */
   int resultcode;
 
@@ -139,6 +153,8 @@ typedef struct
 #define HTTP_QUERY_FLAGS_SENT (0x40000)
 /* Abort pending query, return NOREPLY */
 #define HTTP_QUERY_FLAGS_ABORTED (0x80000)
+/* Query callback has been called, the rest of the reply is skipped */
+#define HTTP_QUERY_FLAGS_DISPATCHED (0x100000)
 
 enum
 {
@@ -323,6 +339,565 @@ tcpCallbackSet httpConnectionIO =
 
 
 
+const uint64_t httpStatsBucketLimit[HTTP_STATS_BUCKET_COUNT] =
+{
+  5000000LL, 10000000LL, 25000000LL, 50000000LL, 100000000LL, 250000000LL, 500000000LL,
+  1000000000LL, 2500000000LL, 5000000000LL, 10000000000LL, 30000000000LL, UINT64_MAX
+};
+
+static void httpTimeStatsAdd( httpTimeStats *stats, uint64_t starttime, uint64_t endtime )
+{
+  int bucketindex;
+  uint64_t duration;
+
+  duration = ( endtime > starttime ? endtime - starttime : 0 );
+  for( bucketindex = 0 ; bucketindex < HTTP_STATS_BUCKET_COUNT-1 ; bucketindex++ )
+  {
+    if( duration <= httpStatsBucketLimit[bucketindex] )
+      break;
+  }
+  stats->bucket[bucketindex]++;
+  stats->count++;
+  stats->total += duration;
+  if( duration > stats->max )
+    stats->max = duration;
+  return;
+}
+
+static httpEndpointStats *httpMatchEndpoint( httpConnection *http, char *querystring, size_t querylen )
+{
+  int index;
+  size_t pathlen, prefixlen;
+  char *path;
+  httpEndpointStats *endpoint;
+
+  /* Skip the method of the request line */
+  path = memchr( querystring, ' ', querylen );
+  if( !( path ) )
+    return 0;
+  path++;
+  pathlen = querylen - (size_t)( path - querystring );
+  for( index = 0 ; index < http->endpointcount ; index++ )
+  {
+    endpoint = &http->endpointlist[index];
+    prefixlen = strlen( endpoint->pathprefix );
+    if( ( prefixlen <= pathlen ) && !( memcmp( path, endpoint->pathprefix, prefixlen ) ) )
+      return endpoint;
+  }
+  return 0;
+}
+
+static void httpEndpointAccumQuery( httpEndpointStats *endpoint, httpQuery *query, int resultcode, httpResponse *response )
+{
+  int httpclass;
+  uint64_t endtime;
+
+  DEBUG_SET_TRACKER();
+
+  endpoint->querycount++;
+  if( (unsigned)resultcode < HTTP_RESULT_COUNT )
+    endpoint->resultcount[resultcode]++;
+  if( query->sendtime )
+  {
+    httpTimeStatsAdd( &endpoint->queuewait, query->addtime, query->sendtime );
+    if( query->recvtime )
+      httpTimeStatsAdd( &endpoint->firstbyte, query->sendtime, query->recvtime );
+  }
+  if( response )
+  {
+    endtime = ccGetNanosecondsTime();
+    if( query->recvtime )
+      httpTimeStatsAdd( &endpoint->transfer, query->recvtime, endtime );
+    httpclass = response->httpcode / 100;
+    if( ( httpclass < 1 ) || ( httpclass > 5 ) )
+      httpclass = 0;
+    endpoint->httpclasscount[httpclass]++;
+    endpoint->bodysizetotal += response->bodysize;
+    if( response->bodysize > endpoint->bodysizemax )
+      endpoint->bodysizemax = response->bodysize;
+  }
+  return;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+
+/*
+A trace file is a httpTraceFileHeader followed by one record per completed query.
+Each httpTraceRecord is followed by the query, the reply header and the reply body.
+The query is stored as sent, except that credentials are masked.
+The reply header is stored one line per "\r\n", and the body is stored after any chunked encoding is removed.
+Times are in nanoseconds since the start of the recording, or zero if never reached.
+Fields are in the native byte order of the recording machine, and replay refuses any other order.
+*/
+
+#define HTTP_TRACE_MAGIC "BSHTTPTR"
+#define HTTP_TRACE_VERSION (1)
+#define HTTP_TRACE_BYTEORDER (0x01020304)
+
+#define HTTP_TRACE_REDACTED "REDACTED"
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteorder;
+  /* Unix time of the start of the recording */
+  int64_t starttime;
+} httpTraceFileHeader;
+
+typedef struct
+{
+  int64_t addtime;
+  int64_t sendtime;
+  int64_t recvtime;
+  int64_t endtime;
+  int32_t channel;
+  /* HTTP_RESULT_xxx given to the query callback, the reply is empty unless HTTP_RESULT_SUCCESS */
+  int32_t resultcode;
+  int32_t httpcode;
+  uint32_t querylength;
+  uint32_t headerlength;
+  uint32_t bodysize;
+} httpTraceRecord;
+
+typedef struct
+{
+  httpTraceRecord record;
+  char *query;
+  char *header;
+  char *body;
+  int usedflag;
+} httpTraceEntry;
+
+struct httpTrace
+{
+  int replayflag;
+
+  /* Recording */
+  FILE *file;
+  int errorflag;
+  uint64_t basetime;
+
+  /* Replay, the whole trace is held in memory */
+  void *data;
+  httpTraceEntry *entrylist;
+  int entrycount;
+  /* All entries before entryfirst have been used */
+  int entryfirst;
+  int timepercent;
+
+  int64_t querycount;
+  int64_t misscount;
+};
+
+
+static inline int httpReplayActive( httpConnection *http )
+{
+  return ( ( http->trace ) && ( http->trace->replayflag ) );
+}
+
+/* Does line begin with the header name, which must be lowercase? */
+static int httpTraceMatchName( char *line, size_t linelength, char *name )
+{
+  size_t index;
+  char c;
+
+  for( index = 0 ; name[index] ; index++ )
+  {
+    if( index >= linelength )
+      return 0;
+    c = line[index];
+    if( ( c >= 'A' ) && ( c <= 'Z' ) )
+      c += 'a' - 'A';
+    if( c != name[index] )
+      return 0;
+  }
+  return 1;
+}
+
+static int httpTraceSecretParam( char *name, size_t length )
+{
+  if( ( length == 3 ) && !( memcmp( name, "key", 3 ) ) )
+    return 1;
+  if( ( length == 8 ) && !( memcmp( name, "password", 8 ) ) )
+    return 1;
+  if( ( length >= 6 ) && !( memcmp( name, "oauth_", 6 ) ) )
+    return 1;
+  return 0;
+}
+
+/* Append "name=value&..." parameters to growth, masking the values of secret ones */
+static void httpTraceRedactParams( ccGrowth *growth, char *params, size_t length )
+{
+  size_t offset, end;
+  char *param, *separator, *equal;
+
+  for( offset = 0 ; ; offset = end + 1 )
+  {
+    param = &params[offset];
+    separator = memchr( param, '&', length - offset );
+    end = ( separator ? (size_t)( separator - params ) : length );
+    equal = memchr( param, '=', end - offset );
+    if( ( equal ) && ( httpTraceSecretParam( param, (size_t)( equal - param ) ) ) )
+    {
+      ccGrowthData( growth, param, (size_t)( equal - param ) + 1 );
+      ccGrowthData( growth, HTTP_TRACE_REDACTED, sizeof(HTTP_TRACE_REDACTED)-1 );
+    }
+    else
+      ccGrowthData( growth, param, end - offset );
+    if( !( separator ) )
+      break;
+    ccGrowthData( growth, "&", 1 );
+  }
+  return;
+}
+
+/* Append query to growth without its credentials : the authorization header, cookies, the key and OAuth parameters */
+static void httpTraceRedactQuery( ccGrowth *growth, char *query, size_t length )
+{
+  size_t headerlength, linelength;
+  char *line, *lineend, *params, *paramsend, *body;
+
+  body = ccSeqFindStrSkip( query, (int)length, "\r\n\r\n" );
+  headerlength = ( body ? (size_t)( body - query ) : length );
+  for( line = query ; line < &query[ headerlength ] ; line += linelength )
+  {
+    lineend = memchr( line, '\n', &query[ headerlength ] - line );
+    linelength = ( lineend ? (size_t)( lineend + 1 - line ) : (size_t)( &query[ headerlength ] - line ) );
+    if( line == query )
+    {
+      /* Request line, the path keeps its parameters but not their secret values */
+      params = memchr( line, '?', linelength );
+      paramsend = ( params ? memchr( params, ' ', &line[ linelength ] - params ) : 0 );
+      if( !( paramsend ) )
+        ccGrowthData( growth, line, linelength );
+      else
+      {
+        ccGrowthData( growth, line, (size_t)( params + 1 - line ) );
+        httpTraceRedactParams( growth, params + 1, (size_t)( paramsend - ( params + 1 ) ) );
+        ccGrowthData( growth, paramsend, (size_t)( &line[ linelength ] - paramsend ) );
+      }
+    }
+    else if( httpTraceMatchName( line, linelength, "authorization:" ) )
+      ccGrowthPrintf( growth, "Authorization: " HTTP_TRACE_REDACTED "\r\n" );
+    else if( httpTraceMatchName( line, linelength, "cookie:" ) )
+      ccGrowthPrintf( growth, "Cookie: " HTTP_TRACE_REDACTED "\r\n" );
+    else
+      ccGrowthData( growth, line, linelength );
+  }
+  if( body )
+  {
+    /* Form bodies are parameters too, JSON bodies are kept as is */
+    if( ( body < &query[ length ] ) && ( body[0] != '{' ) && ( body[0] != '[' ) )
+      httpTraceRedactParams( growth, body, (size_t)( &query[ length ] - body ) );
+    else
+      ccGrowthData( growth, body, (size_t)( &query[ length ] - body ) );
+  }
+  return;
+}
+
+/* Append the parsed reply header to growth, httpParseHeader() has replaced its line breaks by null bytes */
+static void httpTraceCopyHeader( ccGrowth *growth, char *header, size_t headerlength )
+{
+  size_t offset, linelength;
+  char *line;
+
+  for( offset = 0 ; offset < headerlength ; offset += linelength + 1 )
+  {
+    line = &header[offset];
+    for( linelength = 0 ; ( offset + linelength < headerlength ) && ( line[linelength] ) && ( line[linelength] != '\r' ) && ( line[linelength] != '\n' ) ; linelength++ );
+    if( !( linelength ) )
+      continue;
+    if( httpTraceMatchName( line, linelength, "set-cookie:" ) )
+      ccGrowthPrintf( growth, "Set-Cookie: " HTTP_TRACE_REDACTED "\r\n" );
+    else
+    {
+      ccGrowthData( growth, line, linelength );
+      ccGrowthData( growth, "\r\n", 2 );
+    }
+  }
+  ccGrowthData( growth, "\r\n", 2 );
+  return;
+}
+
+static inline int64_t httpTraceTime( httpTrace *trace, uint64_t timestamp )
+{
+  return ( timestamp > trace->basetime ? (int64_t)( timestamp - trace->basetime ) : 0 );
+}
+
+static void httpTraceRecordQuery( httpConnection *http, httpQuery *query, int resultcode, httpResponse *response )
+{
+  int writeflag;
+  httpTrace *trace;
+  httpTraceRecord record;
+  ccGrowth querygrowth, headergrowth;
+
+  DEBUG_SET_TRACKER();
+
+  trace = http->trace;
+  if( trace->errorflag )
+    return;
+  ccGrowthInit( &querygrowth, (int)query->querylength + 64 );
+  httpTraceRedactQuery( &querygrowth, query->querystring, query->querylength );
+  ccGrowthInit( &headergrowth, 1024 );
+  if( response )
+    httpTraceCopyHeader( &headergrowth, response->header, response->headerlength );
+
+  memset( &record, 0, sizeof(httpTraceRecord) );
+  record.addtime = httpTraceTime( trace, query->addtime );
+  record.sendtime = httpTraceTime( trace, query->sendtime );
+  record.recvtime = httpTraceTime( trace, query->recvtime );
+  record.endtime = httpTraceTime( trace, ccGetNanosecondsTime() );
+  record.channel = http->tracechannel;
+  record.resultcode = resultcode;
+  record.httpcode = ( response ? response->httpcode : 0 );
+  record.querylength = (uint32_t)querygrowth.offset;
+  record.headerlength = (uint32_t)headergrowth.offset;
+  record.bodysize = ( response ? (uint32_t)response->bodysize : 0 );
+  writeflag = ( fwrite( &record, sizeof(httpTraceRecord), 1, trace->file ) == 1 );
+  writeflag &= ( fwrite( querygrowth.data, 1, record.querylength, trace->file ) == record.querylength );
+  writeflag &= ( fwrite( headergrowth.data, 1, record.headerlength, trace->file ) == record.headerlength );
+  if( record.bodysize )
+    writeflag &= ( fwrite( response->body, 1, record.bodysize, trace->file ) == record.bodysize );
+  if( !( writeflag ) )
+    trace->errorflag = 1;
+  trace->querycount++;
+
+  ccGrowthFree( &querygrowth );
+  ccGrowthFree( &headergrowth );
+  return;
+}
+
+/* Length of the request line, or of its method and path only */
+static size_t httpTraceRequestLength( char *query, size_t length, int pathflag )
+{
+  int spacecount;
+  size_t index;
+  char c;
+
+  spacecount = 0;
+  for( index = 0 ; index < length ; index++ )
+  {
+    c = query[index];
+    if( ( c == '\r' ) || ( c == '\n' ) )
+      break;
+    if( ( pathflag ) && ( ( c == '?' ) || ( ( c == ' ' ) && ( ++spacecount == 2 ) ) ) )
+      break;
+  }
+  return index;
+}
+
+/* Pick the entry answering a query just sent : the first unused one with the same request line, else with the same method and path */
+static void httpReplayMatchQuery( httpConnection *http, httpQuery *query )
+{
+  int index, pathflag;
+  size_t requestlength;
+  int64_t delay;
+  httpTrace *trace;
+  httpTraceEntry *entry;
+  ccGrowth growth;
+
+  DEBUG_SET_TRACKER();
+
+  trace = http->trace;
+  ccGrowthInit( &growth, (int)query->querylength + 64 );
+  httpTraceRedactQuery( &growth, query->querystring, query->querylength );
+  entry = 0;
+  for( pathflag = 0 ; ( pathflag < 2 ) && !( entry ) ; pathflag++ )
+  {
+    requestlength = httpTraceRequestLength( growth.data, growth.offset, pathflag );
+    for( index = trace->entryfirst ; index < trace->entrycount ; index++ )
+    {
+      entry = &trace->entrylist[index];
+      if( !( entry->usedflag ) && ( entry->record.channel == http->tracechannel ) && ( httpTraceRequestLength( entry->query, entry->record.querylength, pathflag ) == requestlength ) && !( memcmp( entry->query, growth.data, requestlength ) ) )
+        break;
+      entry = 0;
+    }
+  }
+  ccGrowthFree( &growth );
+
+  trace->querycount++;
+  query->replaytime = query->sendtime;
+  if( !( entry ) )
+  {
+    query->replayindex = -1;
+    trace->misscount++;
+    return;
+  }
+  entry->usedflag = 1;
+  query->replayindex = index;
+  for( ; ( trace->entryfirst < trace->entrycount ) && ( trace->entrylist[ trace->entryfirst ].usedflag ) ; trace->entryfirst++ );
+  if( ( entry->record.sendtime ) && ( entry->record.endtime > entry->record.sendtime ) )
+  {
+    delay = ( ( entry->record.endtime - entry->record.sendtime ) / 100 ) * trace->timepercent;
+    query->replaytime += (uint64_t)delay;
+  }
+  return;
+}
+
+/* Rebuild the reply of entry as a server would send it, with a content length */
+static void httpReplayBuildReply( ccGrowth *growth, httpTraceEntry *entry )
+{
+  size_t offset, linelength;
+  char *line, *lineend;
+
+  for( offset = 0 ; offset < entry->record.headerlength ; offset += linelength )
+  {
+    line = &entry->header[offset];
+    lineend = memchr( line, '\n', entry->record.headerlength - offset );
+    linelength = ( lineend ? (size_t)( lineend + 1 - line ) : entry->record.headerlength - offset );
+    if( ( linelength <= 2 ) || ( httpTraceMatchName( line, linelength, "content-length:" ) ) || ( httpTraceMatchName( line, linelength, "transfer-encoding:" ) ) || ( httpTraceMatchName( line, linelength, "connection:" ) ) || ( httpTraceMatchName( line, linelength, "keep-alive:" ) ) )
+      continue;
+    ccGrowthData( growth, line, linelength );
+  }
+  ccGrowthPrintf( growth, "Content-Length: %d\r\nConnection: keep-alive\r\n\r\n", (int)entry->record.bodysize );
+  ccGrowthData( growth, entry->body, entry->record.bodysize );
+  return;
+}
+
+
+httpTrace *httpTraceOpenRecord( char *path )
+{
+  httpTrace *trace;
+  httpTraceFileHeader fileheader;
+
+  DEBUG_SET_TRACKER();
+
+  trace = malloc( sizeof(httpTrace) );
+  memset( trace, 0, sizeof(httpTrace) );
+  trace->file = fopen( path, "wb" );
+  if( !( trace->file ) )
+  {
+    free( trace );
+    return 0;
+  }
+  memset( &fileheader, 0, sizeof(httpTraceFileHeader) );
+  memcpy( fileheader.magic, HTTP_TRACE_MAGIC, 8 );
+  fileheader.version = HTTP_TRACE_VERSION;
+  fileheader.byteorder = HTTP_TRACE_BYTEORDER;
+  fileheader.starttime = (int64_t)time( 0 );
+  if( fwrite( &fileheader, sizeof(httpTraceFileHeader), 1, trace->file ) != 1 )
+  {
+    fclose( trace->file );
+    free( trace );
+    return 0;
+  }
+  trace->basetime = ccGetNanosecondsTime();
+  return trace;
+}
+
+
+httpTrace *httpTraceOpenReplay( char *path, int timepercent )
+{
+  int entryalloc;
+  size_t datasize, offset;
+  long filesize;
+  char *data;
+  FILE *file;
+  httpTrace *trace;
+  httpTraceFileHeader *fileheader;
+  httpTraceEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  file = fopen( path, "rb" );
+  if( !( file ) )
+    return 0;
+  fseek( file, 0, SEEK_END );
+  filesize = ftell( file );
+  fseek( file, 0, SEEK_SET );
+  if( filesize < (long)sizeof(httpTraceFileHeader) )
+  {
+    fclose( file );
+    return 0;
+  }
+  datasize = (size_t)filesize;
+  data = malloc( datasize );
+  if( fread( data, 1, datasize, file ) != datasize )
+  {
+    free( data );
+    fclose( file );
+    return 0;
+  }
+  fclose( file );
+  fileheader = (httpTraceFileHeader *)data;
+  if( ( memcmp( fileheader->magic, HTTP_TRACE_MAGIC, 8 ) ) || ( fileheader->version != HTTP_TRACE_VERSION ) || ( fileheader->byteorder != HTTP_TRACE_BYTEORDER ) )
+  {
+    free( data );
+    return 0;
+  }
+
+  trace = malloc( sizeof(httpTrace) );
+  memset( trace, 0, sizeof(httpTrace) );
+  trace->replayflag = 1;
+  trace->data = data;
+  trace->timepercent = CC_MAX( timepercent, 0 );
+  entryalloc = 0;
+  for( offset = sizeof(httpTraceFileHeader) ; offset < datasize ; )
+  {
+    if( trace->entrycount >= entryalloc )
+    {
+      entryalloc = CC_MAX( 256, entryalloc << 1 );
+      trace->entrylist = realloc( trace->entrylist, entryalloc * sizeof(httpTraceEntry) );
+    }
+    entry = &trace->entrylist[ trace->entrycount ];
+    /* Records are packed, their fields may be unaligned */
+    if( datasize - offset < sizeof(httpTraceRecord) )
+      goto error;
+    memcpy( &entry->record, &data[offset], sizeof(httpTraceRecord) );
+    offset += sizeof(httpTraceRecord);
+    if( ( datasize - offset ) < (size_t)entry->record.querylength + (size_t)entry->record.headerlength + (size_t)entry->record.bodysize )
+      goto error;
+    entry->query = &data[offset];
+    offset += entry->record.querylength;
+    entry->header = &data[offset];
+    offset += entry->record.headerlength;
+    entry->body = &data[offset];
+    offset += entry->record.bodysize;
+    entry->usedflag = 0;
+    trace->entrycount++;
+  }
+
+  return trace;
+
+  error:
+  httpTraceClose( trace );
+  return 0;
+}
+
+
+void httpTraceClose( httpTrace *trace )
+{
+  DEBUG_SET_TRACKER();
+
+  if( trace->file )
+    fclose( trace->file );
+  if( trace->entrylist )
+    free( trace->entrylist );
+  if( trace->data )
+    free( trace->data );
+  free( trace );
+  return;
+}
+
+
+void httpTraceGetCounts( httpTrace *trace, int64_t *retquerycount, int64_t *retmisscount )
+{
+  *retquerycount = trace->querycount;
+  *retmisscount = trace->misscount;
+  return;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+
 httpConnection *httpOpen( tcpContext *tcp, char *address, int port, int flags )
 {
   httpConnection *http;
@@ -352,7 +927,7 @@ httpConnection *httpOpen( tcpContext *tcp, char *address, int port, int flags )
 }
 
 
-int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int queryflags, void *queryuservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ) )
+int httpAddStreamQuery( httpConnection *http, char *querystring, size_t querylen, int queryflags, void *queryuservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ), int (*fragmentcallback)( void *uservalue, void *data, size_t datasize ) )
 {
   httpQuery *query;
 
@@ -367,8 +942,16 @@ int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int
   query->querystring = 0;
   query->querylength = 0;
   query->pipelineindex = 0;
+  query->endpoint = ( http->endpointcount ? httpMatchEndpoint( http, querystring, querylen ) : 0 );
+  query->addtime = ( ( query->endpoint ) || ( http->trace ) ? ccGetNanosecondsTime() : 0 );
+  query->sendtime = 0;
+  query->recvtime = 0;
+  query->replayindex = -1;
+  query->replaytime = 0;
   query->uservalue = queryuservalue;
   query->querycallback = querycallback;
+  query->fragmentcallback = fragmentcallback;
+  query->streamoffset = 0;
   query->resultcode = HTTP_RESULT_SUCCESS;
   memset( &query->response, 0, sizeof(httpResponse) );
   mmListDualAddLast( &http->querywaitlist, query, offsetof(httpQuery,list) );
@@ -376,7 +959,7 @@ int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int
 
   /* Store querystring, keep along as we may need it to resend query */
   query->querylength = querylen;
-  query->querystring = malloc( query->querylength );
+  query->querystring = mmAccountAlloc( MM_ACCOUNT_HTTPBUFFER, query->querylength );
   memcpy( query->querystring, querystring, query->querylength );
 
 #if TCPHTTP_DEBUG
@@ -386,6 +969,11 @@ int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int
   return 1;
 }
 
+int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int queryflags, void *queryuservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ) )
+{
+  return httpAddStreamQuery( http, querystring, querylen, queryflags, queryuservalue, querycallback, 0 );
+}
+
 
 static void httpCloseLink( httpConnection *http )
 {
@@ -424,23 +1012,27 @@ static void httpFreeQuery( httpConnection *http, httpQuery *query )
 
   http->queryqueuecount--;
   if( query->querystring )
-    free( query->querystring );
+    mmAccountFree( MM_ACCOUNT_HTTPBUFFER, query->querystring );
   if( query->data )
-    free( query->data );
+    mmAccountFree( MM_ACCOUNT_HTTPBUFFER, query->data );
   free( query );
   return;
 }
 
-static void httpFinishFreeQuery( httpConnection *http, httpQuery *query )
+/* Call the user callback of a query, once */
+static void httpDispatchQuery( httpConnection *http, httpQuery *query )
 {
   DEBUG_SET_TRACKER();
 
-#if TCPHTTP_DEBUG
-  TCPHTTP_DEBUG_PRINTF( "TcpHttp: httpFinishFreeQuery() called, status : %d %d\n", query->status, query->response.httpcode );
-#endif
-
+  query->flags |= HTTP_QUERY_FLAGS_DISPATCHED;
   if( ( query->status == HTTP_QUERY_STATUS_FAILED ) || ( query->status == HTTP_QUERY_STATUS_ERROR ) )
+  {
+    if( query->endpoint )
+      httpEndpointAccumQuery( query->endpoint, query, query->resultcode, 0 );
+    if( ( http->trace ) && !( http->trace->replayflag ) )
+      httpTraceRecordQuery( http, query, query->resultcode, 0 );
     query->querycallback( query->uservalue, query->resultcode, 0 );
+  }
   else
   {
     query->response.body = ADDRESS( query->data, query->response.headerlength );
@@ -448,10 +1040,28 @@ static void httpFinishFreeQuery( httpConnection *http, httpQuery *query )
 #if HTTP_APPEND_ZERO_BYTE
     ((char *)query->response.body)[ query->response.bodysize ] = 0;
 #endif
+    if( query->endpoint )
+      httpEndpointAccumQuery( query->endpoint, query, HTTP_RESULT_SUCCESS, &query->response );
+    /* Record before the callback, which may modify the body in place */
+    if( ( http->trace ) && !( http->trace->replayflag ) )
+      httpTraceRecordQuery( http, query, HTTP_RESULT_SUCCESS, &query->response );
     query->querycallback( query->uservalue, HTTP_RESULT_SUCCESS, &query->response );
     /* Reset count of retry failures */
     http->retryfailurecount = 0;
   }
+  return;
+}
+
+static void httpFinishFreeQuery( httpConnection *http, httpQuery *query )
+{
+  DEBUG_SET_TRACKER();
+
+#if TCPHTTP_DEBUG
+  TCPHTTP_DEBUG_PRINTF( "TcpHttp: httpFinishFreeQuery() called, status : %d %d\n", query->status, query->response.httpcode );
+#endif
+
+  if( !( query->flags & HTTP_QUERY_FLAGS_DISPATCHED ) )
+    httpDispatchQuery( http, query );
   /* Remove from list and free */
   mmListDualRemove( ( query->flags & HTTP_QUERY_FLAGS_SENT ? &http->querysentlist : &http->querywaitlist ), query, offsetof(httpQuery,list) );
   httpFreeQuery( http, query );
@@ -732,7 +1342,7 @@ static inline int httpAllocData( httpQuery *query, size_t datasize )
   {
     query->dataalloc = intMax( 4096, intMax( datasize, query->dataalloc << 1 ) );
 #endif
-    query->data = realloc( query->data, query->dataalloc );
+    query->data = mmAccountRealloc( MM_ACCOUNT_HTTPBUFFER, query->data, query->dataalloc );
     if( !( query->data ) )
       return 0;
   }
@@ -855,6 +1465,19 @@ static int httpParseRecvChunk( httpQuery *query, void **retbufdata, size_t *retb
     if( copysize > bufsize )
       copysize = bufsize;
 
+    /* The body of a dispatched query is only skipped */
+    if( query->flags & HTTP_QUERY_FLAGS_DISPATCHED )
+    {
+      bufdata = ADDRESS( bufdata, copysize );
+      bufsize -= copysize;
+      query->chunksize -= copysize;
+      if( !( query->chunksize ) )
+      {
+        query->status = HTTP_QUERY_STATUS_SKIPLINE;
+        query->chunkoffset = query->dataoffset;
+      }
+      continue;
+    }
     httpAllocData( query, query->dataoffset + copysize );
     memcpy( ADDRESS( query->data, query->dataoffset ), bufdata, copysize );
 
@@ -881,206 +1504,253 @@ static int httpParseRecvChunk( httpQuery *query, void **retbufdata, size_t *retb
   return 1;
 }
 
-static int httpParseRecvData( httpConnection *http )
+/* Parse a buffer of received data, return zero on error */
+static int httpParseRecvBuffer( httpConnection *http, void *bufdata, size_t bufsize )
 {
-  int parsecode;
-  size_t bufsize, copysize, headerbreak;
+  int parsecode, streamflag;
+  char streamchar;
+  size_t copysize, headerbreak;
   httpQuery *query;
-  void *bufdata;
-  tcpDataBuffer *recvbuf, *recvbufnext;
 
   DEBUG_SET_TRACKER();
 
-  /* TODO: Why do we refuse to process already received buffers when the connection is closing? */
-  if( http->status == HTTP_CONNECTION_STATUS_CLOSING )
-    return 1;
-
-  /* Loop through all buffers */
-  for( recvbuf = http->recvbuflist.first ; recvbuf ; recvbuf = recvbufnext )
-  {
-    recvbufnext = recvbuf->userlist.next;
-    bufdata = recvbuf->pointer;
-    bufsize = recvbuf->size;
-
 #if TCPHTTP_DEBUG
-    TCPHTTP_DEBUG_PRINTF( "TcpHttp: Read buffer of %d bytes\n", (int)bufsize );
+  TCPHTTP_DEBUG_PRINTF( "TcpHttp: Read buffer of %d bytes\n", (int)bufsize );
 #endif
 
 #if 0
-    TCPHTTP_DEBUG_PRINTF( "=========== RECV BEGIN ===========\n" );
-    TCPHTTP_DEBUG_PRINTF( "%.*s\n", (int)bufsize, (char *)bufdata );
-    TCPHTTP_DEBUG_PRINTF( "=========== RECV END ===========\n" );
+  TCPHTTP_DEBUG_PRINTF( "=========== RECV BEGIN ===========\n" );
+  TCPHTTP_DEBUG_PRINTF( "%.*s\n", (int)bufsize, (char *)bufdata );
+  TCPHTTP_DEBUG_PRINTF( "=========== RECV END ===========\n" );
 #endif
 
-    /* A single buffer can overlap multiple queries */
-    for( ; bufsize ; )
+  /* A single buffer can overlap multiple queries */
+  for( ; bufsize ; )
+  {
+    query = http->querysentlist.first;
+    if( !( query ) )
     {
-      query = http->querysentlist.first;
-      if( !( query ) )
+      TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: We have no pending query and the server is sending us data.\n" );
+      return 0;
+    }
+
+    /* If we haven't started the content yet, get HTTP header */
+    if( query->status == HTTP_QUERY_STATUS_WAITHEADER )
+    {
+      if( ( query->addtime ) && !( query->recvtime ) )
+        query->recvtime = ccGetNanosecondsTime();
+      /* Queue stuff in our buffer */
+      headerbreak = httpFindHeaderLength( bufdata, bufsize );
+      if( !( headerbreak ) )
+        headerbreak = bufsize;
+      /* Careful about infinitely long headers */
+      if( ( query->dataoffset + headerbreak ) >= 65536 )
       {
-        TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: We have no pending query and the server is sending us data.\n" );
+        TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Header way too long.\n" );
+        query->status = HTTP_QUERY_STATUS_ERROR;
+        query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
         return 0;
       }
+      httpAllocData( query, query->dataoffset + headerbreak + 4096 );
+      memcpy( ADDRESS( query->data, query->dataoffset ), bufdata, headerbreak );
+      query->dataoffset += headerbreak;
 
-      /* If we haven't started the content yet, get HTTP header */
-      if( query->status == HTTP_QUERY_STATUS_WAITHEADER )
+      /* Attempt to parse header */
+      parsecode = httpParseHeader( &query->response, query->data, query->dataoffset );
+      if( parsecode == -1 )
       {
-        /* Queue stuff in our buffer */
-        headerbreak = httpFindHeaderLength( bufdata, bufsize );
-        if( !( headerbreak ) )
-          headerbreak = bufsize;
-        /* Careful about infinitely long headers */
-        if( ( query->dataoffset + headerbreak ) >= 65536 )
-        {
-          TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Header way too long.\n" );
-          query->status = HTTP_QUERY_STATUS_ERROR;
-          query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
-          return 0;
-        }
-        httpAllocData( query, query->dataoffset + headerbreak + 4096 );
-        memcpy( ADDRESS( query->data, query->dataoffset ), bufdata, headerbreak );
-        query->dataoffset += headerbreak;
+        TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Parse error in HTTP header sent by server.\n" );
+        query->status = HTTP_QUERY_STATUS_ERROR;
+        query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
+        httpFinishFreeQuery( http, query );
+        return 0;
+      }
+      else if( parsecode == 0 )
+      {
+        /* Not enough data to read header yet */
+        continue;
+      }
 
-        /* Attempt to parse header */
-        parsecode = httpParseHeader( &query->response, query->data, query->dataoffset );
-        if( parsecode == -1 )
+      /* Header has been read */
+      if( query->response.chunkedflag )
+      {
+        query->flags |= HTTP_QUERY_FLAGS_CHUNKED;
+        query->response.contentlength = 0;
+        query->chunkoffset = query->response.headerlength;
+        query->chunksize = 0;
+      }
+      else
+      {
+        if( query->response.contentlength < 0 )
+          query->flags |= HTTP_QUERY_FLAGS_NOCONTENTLENGTH;
+        else if( query->response.contentlength >= (1024*1048576) )
         {
-          TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Parse error in HTTP header sent by server.\n" );
+          TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Content length way too long.\n" );
           query->status = HTTP_QUERY_STATUS_ERROR;
           query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
-          httpFinishFreeQuery( http, query );
           return 0;
         }
-        else if( parsecode == 0 )
-        {
-          /* Not enough data to read header yet */
-          continue;
-        }
-
-        /* Header has been read */
-        if( query->response.chunkedflag )
-        {
-          query->flags |= HTTP_QUERY_FLAGS_CHUNKED;
-          query->response.contentlength = 0;
-          query->chunkoffset = query->response.headerlength;
-          query->chunksize = 0;
-        }
-        else
-        {
-          if( query->response.contentlength < 0 )
-            query->flags |= HTTP_QUERY_FLAGS_NOCONTENTLENGTH;
-          else if( query->response.contentlength >= (1024*1048576) )
-          {
-            TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Content length way too long.\n" );
-            query->status = HTTP_QUERY_STATUS_ERROR;
-            query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
-            return 0;
-          }
-          query->response.contentlength = query->response.contentlength;
-        }
-        query->status = HTTP_QUERY_STATUS_WAITCONTENT;
+        query->response.contentlength = query->response.contentlength;
+      }
+      query->status = HTTP_QUERY_STATUS_WAITCONTENT;
 
-        /* Update keep-alive settings */
-        if( query->response.keepaliveflag )
-        {
-          http->serverflags |= HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING;
-          http->keepalivemax = query->pipelineindex + query->response.keepalivemax;
-          if( http->keepalivemax < 1 )
-            http->keepalivemax = 1;
-          if( http->keepalivemax > HTTP_KEEP_ALIVE_MAX_COUNT )
-            http->keepalivemax = HTTP_KEEP_ALIVE_MAX_COUNT;
-        }
-        else
-        {
-          http->serverflags &= ~( HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
+      /* Update keep-alive settings */
+      if( query->response.keepaliveflag )
+      {
+        http->serverflags |= HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING;
+        http->keepalivemax = query->pipelineindex + query->response.keepalivemax;
+        if( http->keepalivemax < 1 )
           http->keepalivemax = 1;
-        }
-        http->serverflags &= http->flags;
-
-        /* Allocate content buffer */
-        httpAllocData( query, query->response.headerlength + ( ( query->flags & ( HTTP_QUERY_FLAGS_NOCONTENTLENGTH | HTTP_QUERY_FLAGS_CHUNKED ) ) ? 1048576 : query->response.contentlength ) );
-        query->dataoffset = query->response.headerlength;
-        /* Skip header to get remaining data */
-        bufdata = ADDRESS( bufdata, query->response.headerlength );
-        bufsize -= query->response.headerlength;
+        if( http->keepalivemax > HTTP_KEEP_ALIVE_MAX_COUNT )
+          http->keepalivemax = HTTP_KEEP_ALIVE_MAX_COUNT;
       }
+      else
+      {
+        http->serverflags &= ~( HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
+        http->keepalivemax = 1;
+      }
+      http->serverflags &= http->flags;
+
+      /* Allocate content buffer */
+      httpAllocData( query, query->response.headerlength + ( ( query->flags & ( HTTP_QUERY_FLAGS_NOCONTENTLENGTH | HTTP_QUERY_FLAGS_CHUNKED ) ) ? 1048576 : query->response.contentlength ) );
+      query->dataoffset = query->response.headerlength;
+      /* Tell the fragment callback that a body starts, again if the query is retried */
+      query->streamoffset = query->response.headerlength;
+      if( query->fragmentcallback )
+        query->fragmentcallback( query->uservalue, 0, 0 );
+      /* Skip header to get remaining data */
+      bufdata = ADDRESS( bufdata, query->response.headerlength );
+      bufsize -= query->response.headerlength;
+    }
 
-      /* Prepare to copy memory to buffer */
-      if( query->flags & HTTP_QUERY_FLAGS_CHUNKED )
+    /* Prepare to copy memory to buffer */
+    if( query->flags & HTTP_QUERY_FLAGS_CHUNKED )
+    {
+      if( !( httpParseRecvChunk( query, &bufdata, &bufsize ) ) )
       {
-        if( !( httpParseRecvChunk( query, &bufdata, &bufsize ) ) )
-        {
-          TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Failed to parse chunked transfer-encoding reply.\n" );
-          query->status = HTTP_QUERY_STATUS_ERROR;
-          query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
-          return 0;
-        }
+        TCPHTTP_DEBUG_PRINTF( "HTTP ERROR: Failed to parse chunked transfer-encoding reply.\n" );
+        query->status = HTTP_QUERY_STATUS_ERROR;
+        query->resultcode = HTTP_RESULT_BADFORMAT_ERROR;
+        return 0;
+      }
+    }
+    else
+    {
+      if( query->flags & HTTP_QUERY_FLAGS_NOCONTENTLENGTH )
+      {
+        httpAllocData( query, query->dataoffset + bufsize );
+        copysize = bufsize;
       }
       else
       {
-        if( query->flags & HTTP_QUERY_FLAGS_NOCONTENTLENGTH )
-        {
-          httpAllocData( query, query->dataoffset + bufsize );
+        copysize = ( query->response.contentlength + query->response.headerlength ) - query->dataoffset;
+        if( copysize > bufsize )
           copysize = bufsize;
-        }
-        else
-        {
-          copysize = ( query->response.contentlength + query->response.headerlength ) - query->dataoffset;
-          if( copysize > bufsize )
-            copysize = bufsize;
-        }
-        /* Copy buffer to content */
+      }
+      /* Copy buffer to content, the body of a dispatched query is only skipped */
+      if( !( query->flags & HTTP_QUERY_FLAGS_DISPATCHED ) )
         memcpy( ADDRESS( query->data, query->dataoffset ), bufdata, copysize );
-        query->dataoffset += copysize;
-        bufdata = ADDRESS( bufdata, copysize );
-        bufsize -= copysize;
-        if( !( query->flags & HTTP_QUERY_FLAGS_NOCONTENTLENGTH ) )
-        {
+      query->dataoffset += copysize;
+      bufdata = ADDRESS( bufdata, copysize );
+      bufsize -= copysize;
+      if( !( query->flags & HTTP_QUERY_FLAGS_NOCONTENTLENGTH ) )
+      {
 #if TCPHTTP_DEBUG
-          TCPHTTP_DEBUG_PRINTF( "TcpHttp : Is query %p complete? Received %d == Total %d ( %d + %d )\n", query, (int)query->dataoffset, (int)query->response.contentlength + (int)query->response.headerlength, (int)query->response.contentlength, (int)query->response.headerlength );
+        TCPHTTP_DEBUG_PRINTF( "TcpHttp : Is query %p complete? Received %d == Total %d ( %d + %d )\n", query, (int)query->dataoffset, (int)query->response.contentlength + (int)query->response.headerlength, (int)query->response.contentlength, (int)query->response.headerlength );
 #endif
-          if( query->dataoffset == ( query->response.contentlength + query->response.headerlength ) )
-          {
-            query->status = HTTP_QUERY_STATUS_COMPLETE;
-            query->resultcode = HTTP_RESULT_SUCCESS;
-          }
+        if( query->dataoffset == ( query->response.contentlength + query->response.headerlength ) )
+        {
+          query->status = HTTP_QUERY_STATUS_COMPLETE;
+          query->resultcode = HTTP_RESULT_SUCCESS;
         }
       }
+    }
 
-      /* Is our query complete? */
-      if( query->status == HTTP_QUERY_STATUS_COMPLETE )
+    /* Give new body data to the fragment callback, which may end the query early */
+    if( ( query->fragmentcallback ) && !( query->flags & HTTP_QUERY_FLAGS_DISPATCHED ) && ( query->dataoffset > query->streamoffset ) )
+    {
+      streamflag = query->fragmentcallback( query->uservalue, ADDRESS( query->data, query->streamoffset ), query->dataoffset - query->streamoffset );
+      query->streamoffset = query->dataoffset;
+      if( ( streamflag ) && ( query->status != HTTP_QUERY_STATUS_COMPLETE ) )
       {
 #if TCPHTTP_DEBUG
-        TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p complete, %d bytes\n", query, (int)( query->dataoffset - query->response.headerlength ) );
-        TCPHTTP_DEBUG_PRINTF( "==== Query Headers ====\n%.*s\n", (int)query->response.headerlength, (char *)query->data );
-#endif
-        httpFinishFreeQuery( http, query );
-
-#if TCPHTTP_DEBUG
-        TCPHTTP_DEBUG_PRINTF( "TcpHttp : Callback dispatched, %d queries pending ( first %p )\n", http->queryqueuecount, http->querysentlist.first );
+        TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p ended by fragment callback, %d bytes\n", query, (int)( query->dataoffset - query->response.headerlength ) );
 #endif
-        /* If we have no pending sent queries, clear flush status */
-        if( ( http->status == HTTP_CONNECTION_STATUS_FLUSH ) && !( http->querysentlist.first ) )
-          http->status = HTTP_CONNECTION_STATUS_READY;
-
-        if( !( http->serverflags & HTTP_CONNECTION_FLAGS_KEEPALIVE ) && ( http->sentquerycount ) )
+        if( ( query->flags & HTTP_QUERY_FLAGS_NOCONTENTLENGTH ) || ( !( query->list.next ) && !( http->querywaitlist.first ) ) )
         {
-          /* Connection is not keep-alive, and hasn't yet reconnected : close it and reconnect */
+          /* No other reply is expected from the link, close it instead of receiving the rest */
+          query->status = HTTP_QUERY_STATUS_COMPLETE;
+          query->resultcode = HTTP_RESULT_SUCCESS;
+          httpFinishFreeQuery( http, query );
           if( http->status != HTTP_CONNECTION_STATUS_CLOSED )
             http->status = HTTP_CONNECTION_STATUS_CLOSING;
+          return 1;
         }
-        else if( http->sentquerycount >= http->keepalivemax )
-        {
-          /* Handle keep-alive max parameter, is it time to close the connection? */
-          if( !( http->querysentlist.first ) && ( http->status != HTTP_CONNECTION_STATUS_CLOSED ) )
-            http->status = HTTP_CONNECTION_STATUS_CLOSING;
-        }
+        /* Pipelined replies follow, dispatch now and skip the rest of the reply without buffering it */
+        /* Appending the zero byte may overwrite a partial chunk size line, preserve it */
+        streamchar = ((char *)query->data)[ query->dataoffset ];
+        httpDispatchQuery( http, query );
+        ((char *)query->data)[ query->dataoffset ] = streamchar;
+      }
+    }
+
+    /* Is our query complete? */
+    if( query->status == HTTP_QUERY_STATUS_COMPLETE )
+    {
+#if TCPHTTP_DEBUG
+      TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p complete, %d bytes\n", query, (int)( query->dataoffset - query->response.headerlength ) );
+      TCPHTTP_DEBUG_PRINTF( "==== Query Headers ====\n%.*s\n", (int)query->response.headerlength, (char *)query->data );
+#endif
+      httpFinishFreeQuery( http, query );
+
+#if TCPHTTP_DEBUG
+      TCPHTTP_DEBUG_PRINTF( "TcpHttp : Callback dispatched, %d queries pending ( first %p )\n", http->queryqueuecount, http->querysentlist.first );
+#endif
+      /* If we have no pending sent queries, clear flush status */
+      if( ( http->status == HTTP_CONNECTION_STATUS_FLUSH ) && !( http->querysentlist.first ) )
+        http->status = HTTP_CONNECTION_STATUS_READY;
+
+      if( !( http->serverflags & HTTP_CONNECTION_FLAGS_KEEPALIVE ) && ( http->sentquerycount ) )
+      {
+        /* Connection is not keep-alive, and hasn't yet reconnected : close it and reconnect */
+        if( http->status != HTTP_CONNECTION_STATUS_CLOSED )
+          http->status = HTTP_CONNECTION_STATUS_CLOSING;
+      }
+      else if( http->sentquerycount >= http->keepalivemax )
+      {
+        /* Handle keep-alive max parameter, is it time to close the connection? */
+        if( !( http->querysentlist.first ) && ( http->status != HTTP_CONNECTION_STATUS_CLOSED ) )
+          http->status = HTTP_CONNECTION_STATUS_CLOSING;
       }
     }
+  }
+
+  return 1;
+}
+
+static int httpParseRecvData( httpConnection *http )
+{
+  tcpDataBuffer *recvbuf, *recvbufnext;
+
+  DEBUG_SET_TRACKER();
+
+  /* TODO: Why do we refuse to process already received buffers when the connection is closing? */
+  if( http->status == HTTP_CONNECTION_STATUS_CLOSING )
+    return 1;
+
+  /* Loop through all buffers */
+  for( recvbuf = http->recvbuflist.first ; recvbuf ; recvbuf = recvbufnext )
+  {
+    recvbufnext = recvbuf->userlist.next;
+    if( !( httpParseRecvBuffer( http, recvbuf->pointer, recvbuf->size ) ) )
+      return 0;
 
     /* Free TCP buffer */
     mmListDualRemove( &http->recvbuflist, recvbuf, offsetof(tcpDataBuffer,userlist) );
     tcpFreeRecvBuffer( http->tcp, http->link, recvbuf );
+    /* A query ended early by its fragment callback closes the link, drop what follows */
+    if( http->status == HTTP_CONNECTION_STATUS_CLOSING )
+      break;
   }
 
   return 1;
@@ -1107,10 +1777,20 @@ static void httpSendQueries( httpConnection *http )
 
     /* Pipelining index for query since last reconnect */
     query->pipelineindex = http->sentquerycount;
-    /* Queue send query */
-    tcpbuffer = tcpAllocSendBuffer( http->tcp, http->link, query->querylength );
-    memcpy( tcpbuffer->pointer, query->querystring, query->querylength );
-    tcpQueueSendBuffer( http->tcp, http->link, tcpbuffer, query->querylength );
+    /* Queue send query, or pick its reply from the trace being replayed */
+    if( httpReplayActive( http ) )
+    {
+      query->sendtime = ccGetNanosecondsTime();
+      httpReplayMatchQuery( http, query );
+    }
+    else
+    {
+      tcpbuffer = tcpAllocSendBuffer( http->tcp, http->link, query->querylength );
+      memcpy( tcpbuffer->pointer, query->querystring, query->querylength );
+      tcpQueueSendBuffer( http->tcp, http->link, tcpbuffer, query->querylength );
+      if( query->addtime )
+        query->sendtime = ccGetNanosecondsTime();
+    }
 
 #if TCPHTTP_DEBUG
     TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p sent, %d bytes, pipelining index %d / %d\n", query, (int)query->querylength, query->pipelineindex, http->keepalivemax );
@@ -1130,6 +1810,8 @@ static void httpSendQueries( httpConnection *http )
   }
 
   /* Adjust link timeout if we are toggling idle state */
+  if( !( http->link ) )
+    return;
   switch( http->status )
   {
     case HTTP_CONNECTION_STATUS_READY:
@@ -1160,6 +1842,58 @@ static void httpSendQueries( httpConnection *http )
 }
 
 
+/* Feed the recorded replies that are due for sent queries, in order */
+static int httpReplayRecv( httpConnection *http )
+{
+  uint64_t curtime;
+  httpQuery *query;
+  httpTraceEntry *entry;
+  ccGrowth growth;
+
+  DEBUG_SET_TRACKER();
+
+  if( http->status == HTTP_CONNECTION_STATUS_CLOSING )
+    return 1;
+  curtime = ccGetNanosecondsTime();
+  for( ; ; )
+  {
+    query = http->querysentlist.first;
+    if( !( query ) || ( query->replaytime > curtime ) )
+      break;
+    entry = ( query->replayindex >= 0 ? &http->trace->entrylist[ query->replayindex ] : 0 );
+    if( !( entry ) || ( entry->record.resultcode != HTTP_RESULT_SUCCESS ) )
+    {
+      /* No recorded reply, or the recorded query failed : fail it the same way */
+      query->status = HTTP_QUERY_STATUS_FAILED;
+      query->resultcode = ( entry ? entry->record.resultcode : HTTP_RESULT_NOREPLY_ERROR );
+      if( entry )
+        http->errorcount++;
+      httpFinishFreeQuery( http, query );
+    }
+    else
+    {
+      ccGrowthInit( &growth, entry->record.headerlength + entry->record.bodysize + 256 );
+      httpReplayBuildReply( &growth, entry );
+      if( !( httpParseRecvBuffer( http, growth.data, growth.offset ) ) )
+      {
+        ccGrowthFree( &growth );
+        return 0;
+      }
+      ccGrowthFree( &growth );
+      /* The whole reply was given, the query must be complete */
+      if( http->querysentlist.first == query )
+        return 0;
+    }
+    if( ( http->status == HTTP_CONNECTION_STATUS_FLUSH ) && !( http->querysentlist.first ) )
+      http->status = HTTP_CONNECTION_STATUS_READY;
+    if( http->status == HTTP_CONNECTION_STATUS_CLOSING )
+      break;
+  }
+
+  return 1;
+}
+
+
 /* Attempt to reconnect, return zero is status remains nolink */
 static int httpAttemptConnect( httpConnection *http )
 {
@@ -1187,8 +1921,15 @@ static int httpAttemptConnect( httpConnection *http )
     goto connecterror;
 
   /* Reconnect */
-  http->link = tcpConnect( http->tcp, http->address, http->port, http, &httpConnectionIO, http->flags & HTTP_CONNECTION_FLAGS_SSL );
-  if( http->link )
+  if( !( httpReplayActive( http ) ) )
+    http->link = tcpConnect( http->tcp, http->address, http->port, http, &httpConnectionIO, http->flags & HTTP_CONNECTION_FLAGS_SSL );
+  if( httpReplayActive( http ) )
+  {
+    /* A replayed connection has no link, it is ready right away */
+    http->status = HTTP_CONNECTION_STATUS_READY;
+    http->flags |= HTTP_CONNECTION_FLAGS_IDLE;
+  }
+  else if( http->link )
   {
     http->status = HTTP_CONNECTION_STATUS_CONNECTING;
     tcpSetTimeout( http->tcp, http->link, http->waitingtimeout );
@@ -1216,6 +1957,12 @@ static int httpAttemptConnect( httpConnection *http )
   for( query = http->querysentlist.first ; query ; query = querynext )
   {
     querynext = query->list.next;
+    /* Query already dispatched by its fragment callback, the rest of the reply isn't needed */
+    if( query->flags & HTTP_QUERY_FLAGS_DISPATCHED )
+    {
+      httpFinishFreeQuery( http, query );
+      continue;
+    }
     /* If we tried too many times to reconnect, abort */
     if( http->retryfailurecount >= HTTP_FAILED_RETRY_MAXIMUM )
       break;
@@ -1231,8 +1978,9 @@ static int httpAttemptConnect( httpConnection *http )
     query->dataalloc = 0;
     query->dataoffset = 0;
     if( query->data )
-      free( query->data );
+      mmAccountFree( MM_ACCOUNT_HTTPBUFFER, query->data );
     query->data = 0;
+    query->recvtime = 0;
 
 #if TCPHTTP_DEBUG
     TCPHTTP_DEBUG_PRINTF( "TcpHttp : Queued for retry %p\n", query );
@@ -1260,7 +2008,7 @@ static int httpAttemptConnect( httpConnection *http )
     httpFailQueryList( http, http->querywaitlist.first, &http->querywaitlist, HTTP_RESULT_TRYAGAIN_ERROR );
   }
 
-  return ( http->status == HTTP_CONNECTION_STATUS_CONNECTING ? 1 : 0 );
+  return ( ( http->status == HTTP_CONNECTION_STATUS_CONNECTING ) || ( http->status == HTTP_CONNECTION_STATUS_READY ) ? 1 : 0 );
 }
 
 
@@ -1271,8 +2019,8 @@ int httpProcess( httpConnection *http )
 
   DEBUG_SET_TRACKER();
 
-  /* Parse buffered incoming data */
-  if( !( httpParseRecvData( http ) ) )
+  /* Parse buffered incoming data, or the replies of the trace being replayed */
+  if( !( httpReplayActive( http ) ? httpReplayRecv( http ) : httpParseRecvData( http ) ) )
   {
 #if TCPHTTP_DEBUG
     TCPHTTP_DEBUG_PRINTF( "TcpHttp : Received data parse error.\n" );
@@ -1297,7 +2045,7 @@ int httpProcess( httpConnection *http )
         query->resultcode = HTTP_RESULT_SUCCESS;
         httpFinishFreeQuery( http, query );
       }
-      else
+      else if( !( query->flags & HTTP_QUERY_FLAGS_DISPATCHED ) )
         http->errorcount++;
     }
   }
@@ -1388,6 +2136,40 @@ int httpGetStatus( httpConnection *http )
 }
 
 
+void httpSetEndpointStats( httpConnection *http, httpEndpointStats *endpointlist, int endpointcount )
+{
+  http->endpointlist = endpointlist;
+  http->endpointcount = endpointcount;
+  return;
+}
+
+
+void httpSetTrace( httpConnection *http, httpTrace *trace, int channel )
+{
+  http->trace = trace;
+  http->tracechannel = channel;
+  return;
+}
+
+
+/* Milliseconds until the next replayed reply is due, 1 if one is due now, -1 if none is pending */
+int httpGetReplayWait( httpConnection *http )
+{
+  uint64_t curtime;
+  httpQuery *query;
+
+  if( !( httpReplayActive( http ) ) )
+    return -1;
+  query = http->querysentlist.first;
+  if( !( query ) )
+    return ( http->querywaitlist.first ? 1 : -1 );
+  curtime = ccGetNanosecondsTime();
+  if( query->replaytime <= curtime )
+    return 1;
+  return (int)( ( ( query->replaytime - curtime ) + 999999 ) / 1000000 );
+}
+
+
 void httpSetWakeCallback( httpConnection *http, void (*wake)( tcpContext *tcp, httpConnection *http, void *wakecontext ), void *wakecontext )
 {
   http->wake = wake;
@@ -22,6 +22,8 @@
  */
 
 typedef struct httpConnection httpConnection;
+typedef struct httpEndpointStats httpEndpointStats;
+typedef struct httpTrace httpTrace;
 
 struct httpConnection
 {
@@ -49,6 +51,14 @@ struct httpConnection
   void (*wake)( tcpContext *tcp, httpConnection *http, void *wakecontext );
   void *wakecontext;
 
+  /* Optional per-endpoint statistics */
+  httpEndpointStats *endpointlist;
+  int endpointcount;
+
+  /* Optional traffic trace, recorded or replayed, channel tells apart the connections sharing it */
+  httpTrace *trace;
+  int tracechannel;
+
   int queryqueuecount;
   mmListDualHead querywaitlist;
   mmListDualHead querysentlist;
@@ -102,6 +112,10 @@ void httpSetTimeout( httpConnection *http, int idletimeout, int waitingtimeout )
 /* Queue a query for connection, querycallback() is called when finished */
 int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int queryflags, void *queryuservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ) );
 
+/* Same, fragmentcallback() also receives the body as it arrives ; a null fragment starts the body, again if the query is retried */
+/* Returning non-zero from fragmentcallback() finishes the query with the body received so far, the rest is skipped or the link closed */
+int httpAddStreamQuery( httpConnection *http, char *querystring, size_t querylen, int queryflags, void *queryuservalue, void (*querycallback)( void *uservalue, int resultcode, httpResponse *response ), int (*fragmentcallback)( void *uservalue, void *data, size_t datasize ) );
+
 /* Write queries, parse received data, call querycallback() for queries as appropriate */
 int httpProcess( httpConnection *http );
 
@@ -153,3 +167,70 @@ enum
 };
 
 
+
+
+////
+
+
+/* Upper bounds of time histogram buckets in nanoseconds, the last bucket is unbounded */
+#define HTTP_STATS_BUCKET_COUNT (13)
+
+extern const uint64_t httpStatsBucketLimit[HTTP_STATS_BUCKET_COUNT];
+
+typedef struct
+{
+  int64_t count;
+  /* Times in nanoseconds */
+  uint64_t total;
+  uint64_t max;
+  /* Not cumulative, each bucket counts samples above the limit of the previous one */
+  int64_t bucket[HTTP_STATS_BUCKET_COUNT];
+} httpTimeStats;
+
+/* Statistics for the queries whose request path begins with pathprefix */
+struct httpEndpointStats
+{
+  char *name;
+  char *pathprefix;
+
+  int64_t querycount;
+  /* Count of completed queries per HTTP_RESULT_xxx */
+  int64_t resultcount[HTTP_RESULT_COUNT];
+  /* Count of replies per HTTP code class, index 1 to 5 for 1xx to 5xx, index 0 for anything else */
+  int64_t httpclasscount[6];
+  /* From httpAddQuery() to the query being written to the link */
+  httpTimeStats queuewait;
+  /* From the query being written to the first byte of its reply */
+  httpTimeStats firstbyte;
+  /* From the first byte of the reply to its completion */
+  httpTimeStats transfer;
+  /* Size of reply bodies */
+  int64_t bodysizetotal;
+  int64_t bodysizemax;
+};
+
+/* Match queries added from now on against endpointlist, first matching prefix wins, queries matching none aren't tracked */
+void httpSetEndpointStats( httpConnection *http, httpEndpointStats *endpointlist, int endpointcount );
+
+
+////
+
+
+/* Open a trace recording the queries and replies of the connections attached to it, credentials are redacted */
+httpTrace *httpTraceOpenRecord( char *path );
+
+/* Open a recorded trace to answer the queries of the connections attached to it, the network is never used */
+/* Replies are held back for timepercent percents of their recorded time, 100 for the original timing, 0 for none */
+httpTrace *httpTraceOpenReplay( char *path, int timepercent );
+
+/* Close trace, once all connections attached to it have been closed */
+void httpTraceClose( httpTrace *trace );
+
+/* Returns the count of queries recorded or replayed, and of replayed queries that had no recorded match */
+void httpTraceGetCounts( httpTrace *trace, int64_t *retquerycount, int64_t *retmisscount );
+
+/* Attach trace to connection, before any query is added */
+void httpSetTrace( httpConnection *http, httpTrace *trace, int channel );
+
+/* Milliseconds until the next replayed reply of connection is due, -1 if none is pending */
+int httpGetReplayWait( httpConnection *http );